@@ -7,6 +7,7 @@
 
 #include "command.h"
 #include "memory.h"
+#include "mpool.h"
 #include "prefix.h"
 #include "hash.h"
 #include "frrevent.h"
@@ -25,6 +26,8 @@
 #include "bgpd/bgp_mplsvpn.h"
 #include "bgpd/bgp_updgrp.h"
 
+DEFINE_MPOOL(BGP_ADJ_IN, sizeof(struct bgp_adj_in));
+
 /* BGP advertise attribute is used for pack same attribute update into
    one packet.  To do that we maintain attribute hash in struct
    peer.  */
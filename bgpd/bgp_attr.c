@@ -880,8 +880,8 @@ bool attrhash_cmp(const void *p1, const void *p2)
 
 static void attrhash_init(void)
 {
-	attrhash =
-		hash_create(attrhash_key_make, attrhash_cmp, "BGP Attributes");
+	attrhash = hash_create_open(HASH_INITIAL_SIZE, attrhash_key_make,
+				    attrhash_cmp, "BGP Attributes");
 }
 
 /*
@@ -29,6 +29,7 @@
 #include "lib_errors.h"
 #include "zclient.h"
 #include "frrdistance.h"
+#include "tracering.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_table.h"
@@ -4520,6 +4521,7 @@ void bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 		frrtrace(6, frr_bgp, process_update, peer, pfxprint, addpath_id,
 			 afi, safi, attr);
 	}
+	tracering("bgp update rcvd", p, peer->remote_id, addpath_id, afi, safi);
 
 #ifdef ENABLE_BGP_VNC
 	int vnc_implicit_withdraw = 0;
@@ -5472,6 +5474,8 @@ void bgp_withdraw(struct peer *peer, const struct prefix *p,
 			break;
 
 	/* Logging. */
+	tracering("bgp withdraw rcvd", p, peer->remote_id, addpath_id, afi,
+		  safi);
 	if (bgp_debug_update(peer, p, NULL, 1)) {
 		bgp_debug_rdpfxpath2str(afi, safi, prd, p, label, num_labels,
 					addpath_id ? 1 : 0, addpath_id, NULL,
@@ -15,6 +15,7 @@
 
 #include "command.h"
 #include "memory.h"
+#include "mpool.h"
 #include "prefix.h"
 #include "hash.h"
 #include "frrevent.h"
@@ -36,6 +37,8 @@
 #include "bgpd/bgp_advertise.h"
 #include "bgpd/bgp_addpath.h"
 
+DEFINE_MPOOL(BGP_ADJ_OUT, sizeof(struct bgp_adj_out));
+
 
 /********************
  * PRIVATE FUNCTIONS
@@ -337,13 +337,15 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 	struct peer *peer;
 	struct bgp_filter *filter;
 
-	s = stream_dup(pkt->buffer);
 	peer = PAF_PEER(paf);
 
 	vec = &pkt->arr.entries[BGP_ATTR_VEC_NH];
 
+	/* nothing to rewrite, all peers can share the packet's data */
 	if (!CHECK_FLAG(vec->flags, BPKT_ATTRVEC_FLAGS_UPDATED))
-		return s;
+		return stream_clone(pkt->buffer);
+
+	s = stream_dup(pkt->buffer);
 
 	uint8_t nhlen;
 	afi_t nhafi;
@@ -1773,12 +1773,22 @@ static void bgp_handle_route_announcements_to_zebra(struct event *e)
 	struct bgp_table *table = NULL;
 	enum zclient_send_status status = ZCLIENT_SEND_SUCCESS;
 	bool install;
+	bool throttled = false;
 
 	while (count < ZEBRA_ANNOUNCEMENTS_LIMIT) {
-		dest = zebra_announce_pop(&bm->zebra_announce_head);
+		if (!zebra_announce_count(&bm->zebra_announce_head))
+			break;
 
-		if (!dest)
+		/*
+		 * Zebra has asked us to back off; the rest of the list is
+		 * picked up again from bgp_zebra_backpressure().
+		 */
+		if (!zclient_backpressure_consume(zclient)) {
+			throttled = true;
 			break;
+		}
+
+		dest = zebra_announce_pop(&bm->zebra_announce_head);
 
 		table = bgp_dest_table(dest);
 		install = CHECK_FLAG(dest->flags, BGP_NODE_SCHEDULE_FOR_INSTALL);
@@ -1831,13 +1841,29 @@ static void bgp_handle_route_announcements_to_zebra(struct event *e)
 		count++;
 	}
 
-	if (status != ZCLIENT_SEND_BUFFERED &&
+	if (status != ZCLIENT_SEND_BUFFERED && !throttled &&
 	    zebra_announce_count(&bm->zebra_announce_head))
 		event_add_event(bm->master,
 				bgp_handle_route_announcements_to_zebra, NULL,
 				0, &bm->t_bgp_zebra_route);
 }
 
+/*
+ * Callback function invoked when zebra engages, refreshes or releases
+ * ZAPI backpressure.  Resume pushing routes if we have been granted
+ * any room to do so.
+ */
+static void bgp_zebra_backpressure(struct zclient *zclient)
+{
+	if (zclient->bp_engaged && !zclient->bp_window)
+		return;
+
+	if (zebra_announce_count(&bm->zebra_announce_head))
+		event_add_event(bm->master,
+				bgp_handle_route_announcements_to_zebra, NULL,
+				0, &bm->t_bgp_zebra_route);
+}
+
 /*
  * Callback function invoked when zclient_flush_data() receives a BUFFER_EMPTY
  * i.e. zebra is free to receive more incoming data.
@@ -3649,6 +3675,7 @@ void bgp_zebra_init(struct event_loop *master, unsigned short instance)
 			      array_size(bgp_handlers));
 	zclient_init(zclient, ZEBRA_ROUTE_BGP, 0, &bgpd_privs);
 	zclient->zebra_buffer_write_ready = bgp_zebra_buffer_write_ready;
+	zclient->zebra_backpressure = bgp_zebra_backpressure;
 	zclient->zebra_connected = bgp_zebra_connected;
 	zclient->zebra_capabilities = bgp_zebra_capabilities;
 	zclient->nexthop_update = bgp_nexthop_update;
@@ -40,6 +40,7 @@
 #include "northbound_cli.h"
 #include "network.h"
 #include "routemap.h"
+#include "tracering.h"
 
 #include "frrscript.h"
 
@@ -498,6 +499,21 @@ static int config_write_host(struct vty *vty)
 			vty_out(vty, "service walltime-warning %lu\n",
 				walltime_threshold / 1000);
 
+		if (event_profile_enabled)
+			vty_out(vty, "service event-profile\n");
+
+		if (qmem_profile_rate() == QMEM_PROFILE_RATE_DEFAULT)
+			vty_out(vty, "service memory-profile\n");
+		else if (qmem_profile_rate())
+			vty_out(vty, "service memory-profile sample-rate %u\n",
+				qmem_profile_rate());
+
+		if (!tracering_get())
+			vty_out(vty, "no service trace-ring\n");
+		else if (tracering_get() != TRACERING_RECORDS_DEFAULT)
+			vty_out(vty, "service trace-ring records %u\n",
+				tracering_get());
+
 		if (host.advanced)
 			vty_out(vty, "service advanced-vty\n");
 
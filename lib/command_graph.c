@@ -19,6 +19,8 @@ DEFINE_MTYPE_STATIC(LIB, CMD_TEXT, "Command Token Help");
 DEFINE_MTYPE(LIB, CMD_ARG, "Command Argument");
 DEFINE_MTYPE_STATIC(LIB, CMD_VAR, "Command Argument Name");
 
+uint32_t cmd_graph_gen;
+
 struct cmd_token *cmd_token_new(enum cmd_token_type type, uint8_t attr,
 				const char *text, const char *desc)
 {
@@ -45,6 +47,8 @@ void cmd_token_del(struct cmd_token *token)
 	XFREE(MTYPE_CMD_DESC, token->desc);
 	XFREE(MTYPE_CMD_ARG, token->arg);
 	XFREE(MTYPE_CMD_VAR, token->varname);
+	cmd_follow_free(token->follow[0]);
+	cmd_follow_free(token->follow[1]);
 
 	XFREE(MTYPE_CMD_TOKENS, token);
 }
@@ -429,6 +433,7 @@ void cmd_graph_merge(struct graph *old, struct graph *new, int direction)
 	assert(vector_active(old->nodes) >= 1);
 	assert(vector_active(new->nodes) >= 1);
 
+	cmd_graph_gen++;
 	cmd_merge_nodes(old, new, vector_slot(old->nodes, 0),
 			vector_slot(new->nodes, 0), direction);
 }
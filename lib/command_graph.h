@@ -91,6 +91,9 @@ struct cmd_token {
 	char *varname;
 
 	struct graph_node *forkjoin; // paired FORK/JOIN for JOIN/FORK
+
+	/* matcher's compiled follow sets, without/with "no" prefix */
+	struct cmd_follow *follow[2];
 };
 
 /* Structure of command element. */
@@ -120,6 +123,12 @@ extern void cmd_token_varname_set(struct cmd_token *token, const char *varname);
 extern void cmd_token_varname_seqappend(struct graph_node *n);
 extern void cmd_token_varname_join(struct graph_node *n, const char *varname);
 
+/* bumped on any change to a command graph;  the matcher rebuilds its cached
+ * follow sets when this moves
+ */
+extern uint32_t cmd_graph_gen;
+extern void cmd_follow_free(struct cmd_follow *follow);
+
 extern void cmd_graph_parse(struct graph *graph, const struct cmd_element *cmd);
 extern void cmd_graph_names(struct graph *graph);
 extern void cmd_graph_merge(struct graph *old, struct graph *n,
@@ -13,6 +13,7 @@
 #include "asn.h"
 
 DEFINE_MTYPE_STATIC(LIB, CMD_MATCHSTACK, "Command Match Stack");
+DEFINE_MTYPE_STATIC(LIB, CMD_FOLLOW, "Command Follow Set");
 
 #ifdef TRACE_MATCHER
 #define TM 1
@@ -30,8 +31,10 @@ DEFINE_MTYPE_STATIC(LIB, CMD_MATCHSTACK, "Command Match Stack");
 static int add_nexthops(struct list *, struct graph_node *,
 			struct graph_node **, size_t, bool);
 
-static enum matcher_rv command_match_r(struct graph_node *, vector,
-				       unsigned int, struct graph_node **,
+struct cmd_match_ctx;
+
+static enum matcher_rv command_match_r(struct graph_node *,
+				       struct cmd_match_ctx *, unsigned int,
 				       struct list **);
 
 static int score_precedence(enum cmd_token_type);
@@ -65,6 +68,241 @@ static enum match_type match_variable(struct cmd_token *, const char *);
 
 static enum match_type match_mac(const char *, bool);
 
+/* Compiled follow set of a graph node, i.e. what add_nexthops() yields for
+ * it, split up so the matcher only looks at children that can match the
+ * next input token:
+ *  - keywords, sorted by text.  The ones the input token is a prefix of are
+ *    a contiguous range found with a binary search.
+ *  - varying tokens (ranges, addresses, ...), which are matched through the
+ *    per-line cache in struct cmd_match_ctx.
+ *  - END_TKN, which is only of interest when the input is used up.
+ * The indexes refer to the original add_nexthops() order, which candidates
+ * are tried in.  Built on first use, and rebuilt when cmd_graph_gen says a
+ * command graph changed since.
+ */
+struct cmd_follow_word {
+	const char *text;
+	unsigned int idx;
+};
+
+struct cmd_follow {
+	uint32_t gen;
+
+	unsigned int count;
+	struct graph_node **nodes;
+
+	unsigned int nwords, nvarying, nends;
+	struct cmd_follow_word *words;
+	unsigned int *varying;
+	unsigned int *ends;
+};
+
+/* per input token results for token types that don't depend on the token
+ * itself (0 = not checked yet, else match_type + 1), and the parsed value for
+ * ranges (range_state 0 = not checked yet, 1 = not a number, 2 = range_val).
+ */
+struct cmd_match_memo {
+	uint8_t types[SPECIAL_TKN];
+	uint8_t range_state;
+	long long range_val;
+};
+
+struct cmd_match_ctx {
+	vector vline;
+	bool neg;
+
+	struct graph_node *stack[CMD_ARGC_MAX];
+	/* one per input token, sized to the line */
+	struct cmd_match_memo *memo;
+};
+
+static int cmd_follow_word_cmp(const void *a, const void *b)
+{
+	const struct cmd_follow_word *wa = a, *wb = b;
+	int ret = strcmp(wa->text, wb->text);
+
+	if (ret)
+		return ret;
+	return wa->idx < wb->idx ? -1 : (wa->idx > wb->idx);
+}
+
+static int cmd_follow_idx_cmp(const void *a, const void *b)
+{
+	unsigned int ia = *(const unsigned int *)a;
+	unsigned int ib = *(const unsigned int *)b;
+
+	return ia < ib ? -1 : (ia > ib);
+}
+
+void cmd_follow_free(struct cmd_follow *follow)
+{
+	if (!follow)
+		return;
+
+	XFREE(MTYPE_CMD_FOLLOW, follow->nodes);
+	XFREE(MTYPE_CMD_FOLLOW, follow->words);
+	XFREE(MTYPE_CMD_FOLLOW, follow->varying);
+	XFREE(MTYPE_CMD_FOLLOW, follow->ends);
+	XFREE(MTYPE_CMD_FOLLOW, follow);
+}
+
+static struct cmd_follow *cmd_follow_get(struct graph_node *node, bool neg)
+{
+	struct cmd_token *token = node->data;
+	struct cmd_follow *follow = token->follow[neg];
+	struct list *next;
+	struct listnode *ln;
+	struct graph_node *gn;
+	struct cmd_token *tok;
+	unsigned int i = 0;
+
+	if (follow && follow->gen == cmd_graph_gen)
+		return follow;
+
+	cmd_follow_free(follow);
+
+	next = list_new();
+	add_nexthops(next, node, NULL, 0, neg);
+
+	follow = XCALLOC(MTYPE_CMD_FOLLOW, sizeof(*follow));
+	follow->gen = cmd_graph_gen;
+	follow->count = listcount(next);
+	follow->nodes = XCALLOC(MTYPE_CMD_FOLLOW,
+				follow->count * sizeof(follow->nodes[0]));
+	follow->words = XCALLOC(MTYPE_CMD_FOLLOW,
+				follow->count * sizeof(follow->words[0]));
+	follow->varying = XCALLOC(MTYPE_CMD_FOLLOW,
+				  follow->count * sizeof(follow->varying[0]));
+	follow->ends = XCALLOC(MTYPE_CMD_FOLLOW,
+			       follow->count * sizeof(follow->ends[0]));
+
+	for (ALL_LIST_ELEMENTS_RO(next, ln, gn)) {
+		tok = gn->data;
+		follow->nodes[i] = gn;
+
+		if (tok->type == WORD_TKN) {
+			follow->words[follow->nwords].text = tok->text;
+			follow->words[follow->nwords].idx = i;
+			follow->nwords++;
+		} else if (tok->type == END_TKN)
+			follow->ends[follow->nends++] = i;
+		else
+			follow->varying[follow->nvarying++] = i;
+		i++;
+	}
+	list_delete(&next);
+
+	qsort(follow->words, follow->nwords, sizeof(follow->words[0]),
+	      cmd_follow_word_cmp);
+
+	token->follow[neg] = follow;
+	return follow;
+}
+
+/* collects the follow set entries that may match the input token, in
+ * add_nexthops() order.  cands needs room for follow->count entries.
+ */
+static unsigned int cmd_follow_candidates(struct cmd_follow *follow,
+					  const char *input, unsigned int *cands)
+{
+	unsigned int lo = 0, hi = follow->nwords, mid;
+	unsigned int nw = 0, nv = 0, count = 0, i;
+	size_t len;
+
+	/* NULL input trivially matches everything */
+	if (!input) {
+		for (i = 0; i < follow->count; i++)
+			if (((struct cmd_token *)follow->nodes[i]->data)->type !=
+			    END_TKN)
+				cands[count++] = i;
+		return count;
+	}
+
+	/* first keyword >= input;  all keywords with input as prefix follow */
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (strcmp(follow->words[mid].text, input) < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	len = strlen(input);
+	for (i = lo; i < follow->nwords; i++) {
+		if (strncmp(follow->words[i].text, input, len))
+			break;
+		cands[nw++] = follow->words[i].idx;
+	}
+
+	if (nw > 1)
+		qsort(cands, nw, sizeof(cands[0]), cmd_follow_idx_cmp);
+
+	/* merge keywords & varying tokens back into the original order.
+	 * cands is filled from the back so the keywords aren't overwritten.
+	 */
+	if (!follow->nvarying)
+		return nw;
+
+	memmove(cands + follow->nvarying, cands, nw * sizeof(cands[0]));
+	i = follow->nvarying;
+	while (nw || nv < follow->nvarying) {
+		if (nv < follow->nvarying &&
+		    (!nw || follow->varying[nv] < cands[i]))
+			cands[count++] = follow->varying[nv++];
+		else {
+			cands[count++] = cands[i++];
+			nw--;
+		}
+	}
+	return count;
+}
+
+/* match_token() with the results for the input token kept around, since the
+ * same input usually gets checked against a lot of nodes of the same type.
+ */
+static enum match_type cmd_match_token(struct cmd_match_ctx *ctx,
+				       struct cmd_token *token, unsigned int n)
+{
+	char *input_token = vector_slot(ctx->vline, n);
+	struct cmd_match_memo *memo = &ctx->memo[n];
+	char *endptr = NULL;
+
+	if (!input_token)
+		return trivial_match;
+
+	switch (token->type) {
+	case RANGE_TKN:
+		if (!memo->range_state) {
+			memo->range_val = strtoll(input_token, &endptr, 10);
+			memo->range_state = (*endptr == '\0') ? 2 : 1;
+		}
+		if (memo->range_state == 1 || memo->range_val < token->min ||
+		    memo->range_val > token->max)
+			return no_match;
+		return exact_match;
+	case IPV4_TKN:
+	case IPV4_PREFIX_TKN:
+	case IPV6_TKN:
+	case IPV6_PREFIX_TKN:
+	case MAC_TKN:
+	case MAC_PREFIX_TKN:
+	case ASNUM_TKN:
+		if (!memo->types[token->type])
+			memo->types[token->type] =
+				match_token(token, input_token) + 1;
+		return memo->types[token->type] - 1;
+	case WORD_TKN:
+	case VARIABLE_TKN:
+	case FORK_TKN:
+	case JOIN_TKN:
+	case START_TKN:
+	case END_TKN:
+	case NEG_ONLY_TKN:
+		break;
+	}
+	return match_token(token, input_token);
+}
+
 static bool is_neg(vector vline, size_t idx)
 {
 	if (idx >= vector_active(vline) || !vector_slot(vline, idx))
@@ -75,7 +313,7 @@ static bool is_neg(vector vline, size_t idx)
 enum matcher_rv command_match(struct graph *cmdgraph, vector vline,
 			      struct list **argv, const struct cmd_element **el)
 {
-	struct graph_node *stack[CMD_ARGC_MAX];
+	struct cmd_match_ctx ctx;
 	enum matcher_rv status;
 	*argv = NULL;
 
@@ -86,8 +324,17 @@ enum matcher_rv command_match(struct graph *cmdgraph, vector vline,
 	       sizeof(void *) * vline->alloced);
 	vvline->active = vline->active + 1;
 
+	/* the matcher gives up past CMD_ARGC_MAX tokens */
+	struct cmd_match_memo memo[MIN(vector_active(vvline),
+				       (unsigned int)CMD_ARGC_MAX)];
+
+	memset(memo, 0, sizeof(memo));
+	ctx.vline = vvline;
+	ctx.neg = is_neg(vvline, 1);
+	ctx.memo = memo;
+
 	struct graph_node *start = vector_slot(cmdgraph->nodes, 0);
-	status = command_match_r(start, vvline, 0, stack, argv);
+	status = command_match_r(start, &ctx, 0, argv);
 	if (status == MATCHER_OK) { // successful match
 		struct listnode *head = listhead(*argv);
 		struct listnode *tail = listtail(*argv);
@@ -167,8 +414,12 @@ enum matcher_rv command_match(struct graph *cmdgraph, vector vline,
  * In the event that two children are found to match with the same precedence,
  * then the input is ambiguous for the passed cmd_element and NULL is returned.
  *
+ * The children are taken from the node's compiled follow set (struct
+ * cmd_follow), which narrows them down to the ones that can match the next
+ * input token, without changing the order they are tried in.
+ *
  * @param[in] start the start node.
- * @param[in] vline the vectorized input line.
+ * @param[in] ctx matching context, holding the vectorized input line.
  * @param[in] n the index of the first input token.
  * @return A linked list of n elements. The first n-1 elements are pointers to
  * struct cmd_token and represent the sequence of tokens matched by the input.
@@ -178,11 +429,14 @@ enum matcher_rv command_match(struct graph *cmdgraph, vector vline,
  *
  * If no match was found, the return value is NULL.
  */
-static enum matcher_rv command_match_r(struct graph_node *start, vector vline,
+static enum matcher_rv command_match_r(struct graph_node *start,
+				       struct cmd_match_ctx *ctx,
 				       unsigned int n,
-				       struct graph_node **stack,
 				       struct list **currbest)
 {
+	vector vline = ctx->vline;
+	struct graph_node **stack = ctx->stack;
+
 	assert(n < vector_active(vline));
 
 	enum matcher_rv status = MATCHER_NO_MATCH;
@@ -230,57 +484,65 @@ static enum matcher_rv command_match_r(struct graph_node *start, vector vline,
 #endif
 
 	// if we don't match this node, die
-	if (match_token(token, input_token) < minmatch)
+	if (cmd_match_token(ctx, token, n) < minmatch)
 		return MATCHER_NO_MATCH;
 
 	stack[n] = start;
 
-	// pointers for iterating linklist
-	struct listnode *ln;
-	struct graph_node *gn;
-
 	// get all possible nexthops
-	struct list *next = list_new();
-	add_nexthops(next, start, NULL, 0, is_neg(vline, 1));
+	struct cmd_follow *follow = cmd_follow_get(start, ctx->neg);
+	struct graph_node *gn;
+	unsigned int i;
 
-	// determine the best match
-	for (ALL_LIST_ELEMENTS_RO(next, ln, gn)) {
-		// if we've matched all input we're looking for END_TKN
-		if (n + 1 == vector_active(vline)) {
-			struct cmd_token *tok = gn->data;
-			if (tok->type == END_TKN) {
-				// if more than one END_TKN in the follow set
-				if (*currbest) {
-					status = MATCHER_AMBIGUOUS;
-					break;
-				} else {
-					status = MATCHER_OK;
-				}
-				*currbest = list_new();
-				// node should have one child node with the
-				// element
-				struct graph_node *leaf =
-					vector_slot(gn->to, 0);
-				// last node in the list will hold the
-				// cmd_element; this is important because
-				// list_delete() expects that all nodes have
-				// the same data type, so when deleting this
-				// list the last node must be manually deleted
-				struct cmd_element *el = leaf->data;
-				listnode_add(*currbest, el);
-				(*currbest)->del =
-					(void (*)(void *)) & cmd_token_del;
-				// do not break immediately; continue walking
-				// through the follow set to ensure that there
-				// is exactly one END_TKN
+	// if we've matched all input we're looking for END_TKN
+	if (n + 1 == vector_active(vline)) {
+		for (i = 0; i < follow->nends; i++) {
+			// if more than one END_TKN in the follow set
+			if (*currbest) {
+				status = MATCHER_AMBIGUOUS;
+				break;
+			} else {
+				status = MATCHER_OK;
 			}
-			continue;
+			*currbest = list_new();
+			// node should have one child node with the
+			// element
+			gn = follow->nodes[follow->ends[i]];
+			struct graph_node *leaf = vector_slot(gn->to, 0);
+			// last node in the list will hold the
+			// cmd_element; this is important because
+			// list_delete() expects that all nodes have
+			// the same data type, so when deleting this
+			// list the last node must be manually deleted
+			struct cmd_element *el = leaf->data;
+			listnode_add(*currbest, el);
+			(*currbest)->del = (void (*)(void *)) & cmd_token_del;
+			// do not break immediately; continue walking
+			// through the follow set to ensure that there
+			// is exactly one END_TKN
 		}
+		goto out;
+	}
+
+	/* children that can't match the next input token would return
+	 * MATCHER_NO_MATCH without touching currbest, so only recurse on the
+	 * candidates.
+	 */
+	unsigned int cands_buf[32], *cands = cands_buf, ncands;
 
-		// else recurse on candidate child node
+	if (follow->count > array_size(cands_buf))
+		cands = XMALLOC(MTYPE_TMP, follow->count * sizeof(cands[0]));
+	ncands = cmd_follow_candidates(follow, vector_slot(vline, n + 1),
+				       cands);
+
+	// determine the best match
+	for (i = 0; i < ncands; i++) {
+		gn = follow->nodes[cands[i]];
+
+		// recurse on candidate child node
 		struct list *result = NULL;
 		enum matcher_rv rstat =
-			command_match_r(gn, vline, n + 1, stack, &result);
+			command_match_r(gn, ctx, n + 1, &result);
 
 		// save the best match
 		if (result && *currbest) {
@@ -317,6 +579,11 @@ static enum matcher_rv command_match_r(struct graph_node *start, vector vline,
 			status = MAX(rstat, status);
 		}
 	}
+
+	if (cands != cands_buf)
+		XFREE(MTYPE_TMP, cands);
+
+out:
 	if (*currbest) {
 		// copy token, set arg and prepend to currbest
 		token = start->data;
@@ -326,9 +593,6 @@ static enum matcher_rv command_match_r(struct graph_node *start, vector vline,
 	} else if (n + 1 == vector_active(vline) && status == MATCHER_NO_MATCH)
 		status = MATCHER_INCOMPLETE;
 
-	// cleanup
-	list_delete(&next);
-
 	return status;
 }
 
@@ -394,6 +394,7 @@ cmd_graph_parse (struct graph *graph, const struct cmd_element *cmd)
   // set to 1 to enable parser traces
   yydebug = 0;
 
+  cmd_graph_gen++;
   set_lexer_string (&ctx.scanner, cmd->string);
 
   // parse command into DFA
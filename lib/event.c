@@ -9,6 +9,9 @@
 
 #include <signal.h>
 #include <sys/resource.h>
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
 
 #include "frrevent.h"
 #include "memory.h"
@@ -29,6 +32,8 @@ DEFINE_MTYPE_STATIC(LIB, THREAD, "Thread");
 DEFINE_MTYPE_STATIC(LIB, EVENT_MASTER, "Thread master");
 DEFINE_MTYPE_STATIC(LIB, EVENT_POLL, "Thread Poll Info");
 DEFINE_MTYPE_STATIC(LIB, EVENT_STATS, "Thread stats");
+DEFINE_MTYPE_STATIC(LIB, EVENT_WHEEL, "Thread timer wheel");
+DEFINE_MTYPE_STATIC(LIB, EVENT_PROFILE, "Thread profile");
 
 DECLARE_LIST(event_list, struct event, eventitem);
 
@@ -56,6 +61,34 @@ static int event_timer_cmp(const struct event *a, const struct event *b)
 }
 
 DECLARE_HEAP(event_timer_list, struct event, timeritem, event_timer_cmp);
+DECLARE_DLIST(event_wheel_list, struct event, wheelitem);
+
+/*
+ * Hierarchical timer wheel.  Level 0 has one slot per tick, every level
+ * above one slot per full turn of the level below.  Timers are cascaded
+ * down a level as the wheel turns, and are run once they reach their
+ * level 0 slot, at most one tick late.
+ */
+#define EVENT_WHEEL_TICK_USEC 10000
+#define EVENT_WHEEL_BITS 6
+#define EVENT_WHEEL_SLOTS (1U << EVENT_WHEEL_BITS)
+#define EVENT_WHEEL_MASK (EVENT_WHEEL_SLOTS - 1)
+#define EVENT_WHEEL_LEVELS 4
+#define EVENT_WHEEL_SPAN (1ULL << (EVENT_WHEEL_LEVELS * EVENT_WHEEL_BITS))
+
+/* Timers this far out or further go on the wheel, when enabled. */
+#define EVENT_WHEEL_MIN_SEC 1
+
+struct event_timer_wheel {
+	struct event_wheel_list_head
+		slots[EVENT_WHEEL_LEVELS * EVENT_WHEEL_SLOTS];
+	/* next tick to process, all before have been run */
+	uint64_t now;
+	/* tick the event loop is going to wake up at, at the latest */
+	uint64_t wait;
+	/* number of timers on the wheel */
+	size_t count;
+};
 
 #define AWAKEN(m)                                                              \
 	do {                                                                   \
@@ -72,9 +105,178 @@ static struct list *masters;
 
 static void thread_free(struct event_loop *master, struct event *thread);
 
+/* Backend used by event_master_create() */
+static enum event_io_backend default_backend = EVENT_IO_POLL;
+/* Whether new event loops use the timer wheel */
+static bool default_timer_wheel;
+
+/* epoll_state bits */
+#define EPOLL_WANT_READ  0x01
+#define EPOLL_WANT_WRITE 0x02
+#define EPOLL_WANT	 (EPOLL_WANT_READ | EPOLL_WANT_WRITE)
+#define EPOLL_REGISTERED 0x04
+
+/* Events fetched per epoll_wait() call */
+#define EPOLL_BATCH 1024
+
+static inline bool event_use_epoll(const struct event_loop *m)
+{
+	return m->handler.epoll_fd >= 0;
+}
+
 bool cputime_enabled = true;
 unsigned long cputime_threshold = CONSUMED_TIME_CHECK;
 unsigned long walltime_threshold = CONSUMED_TIME_CHECK;
+bool event_profile_enabled;
+
+/*
+ * Log-linear latency histogram, in microseconds.  Values below 8 get a
+ * bucket each, every power of two above is split into 8 buckets, which
+ * keeps the error under 12.5% all the way up to 2^32.
+ */
+#define EVENT_HIST_SUB_BITS 3
+#define EVENT_HIST_SUB (1U << EVENT_HIST_SUB_BITS)
+#define EVENT_HIST_BUCKETS ((32 - EVENT_HIST_SUB_BITS + 1) * EVENT_HIST_SUB)
+
+struct event_latency {
+	/* time spent running */
+	atomic_size_t run[EVENT_HIST_BUCKETS];
+	/* time between becoming ready and starting to run */
+	atomic_size_t queued[EVENT_HIST_BUCKETS];
+};
+
+/* Recent event history of one event loop, for export. */
+#define EVENT_PROFILE_RECORDS 65536
+
+struct event_profile_record {
+	const struct xref_eventsched *xref;
+	uint64_t start; /* monotonic, usec */
+	uint32_t run, queued;
+	uint8_t type;
+};
+
+struct event_profile {
+	/* when poll returned, the I/O tasks on the ready queue got ready */
+	struct timeval polled;
+	/* number of records ever written, next one goes to pos % size */
+	atomic_size_t pos;
+	struct event_profile_record records[EVENT_PROFILE_RECORDS];
+};
+
+static unsigned int event_hist_bucket(unsigned long usec)
+{
+	unsigned int msb;
+
+	if (usec < EVENT_HIST_SUB)
+		return usec;
+	if (usec > UINT32_MAX)
+		usec = UINT32_MAX;
+
+	msb = 31 - __builtin_clz((uint32_t)usec);
+	return (msb - EVENT_HIST_SUB_BITS + 1) * EVENT_HIST_SUB +
+	       ((usec >> (msb - EVENT_HIST_SUB_BITS)) & (EVENT_HIST_SUB - 1));
+}
+
+/* Largest value falling into a bucket. */
+static unsigned long event_hist_value(unsigned int bucket)
+{
+	unsigned int msb, sub;
+
+	if (bucket < EVENT_HIST_SUB)
+		return bucket;
+
+	msb = bucket / EVENT_HIST_SUB + EVENT_HIST_SUB_BITS - 1;
+	sub = bucket % EVENT_HIST_SUB;
+	return (1UL << msb) +
+	       ((unsigned long)(sub + 1) << (msb - EVENT_HIST_SUB_BITS)) - 1;
+}
+
+static unsigned long event_hist_percentile(const atomic_size_t *hist,
+					   size_t total, unsigned int pct)
+{
+	size_t want = (total * pct + 99) / 100, seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < EVENT_HIST_BUCKETS && total; i++) {
+		seen += atomic_load_explicit(&hist[i], memory_order_relaxed);
+		if (seen >= want)
+			return event_hist_value(i);
+	}
+	return 0;
+}
+
+/*
+ * Account a task that just ran to its histograms and to the event loop's
+ * history.  Called by the event loop's own pthread only, which is also
+ * the only one to set up or tear down the history; other pthreads read
+ * it under the loop's mutex.
+ */
+static void event_profile_account(struct event *thread,
+				  const struct timeval *ready,
+				  const struct timeval *start,
+				  unsigned long walltime)
+{
+	struct event_loop *m = thread->master;
+	struct event_profile *prof = m->profile;
+	struct event_latency *lat = thread->hist->latency;
+	struct event_profile_record *rec;
+	unsigned long queued = 0;
+	size_t pos;
+
+	if (!event_profile_enabled) {
+		frr_with_mutex (&m->mtx) {
+			XFREE(MTYPE_EVENT_PROFILE, m->profile);
+		}
+		return;
+	}
+
+	if (!prof) {
+		prof = XCALLOC(MTYPE_EVENT_PROFILE, sizeof(*prof));
+		frr_with_mutex (&m->mtx) {
+			m->profile = prof;
+		}
+	}
+
+	if (!lat) {
+		lat = XCALLOC(MTYPE_EVENT_PROFILE, sizeof(*lat));
+		thread->hist->latency = lat;
+	}
+
+	/*
+	 * Timers are ready at their deadline, I/O when poll returned and
+	 * events when they were added.
+	 */
+	switch (thread->add_type) {
+	case EVENT_TIMER:
+		ready = &thread->u.sands;
+		break;
+	case EVENT_READ:
+	case EVENT_WRITE:
+		ready = &prof->polled;
+		break;
+	case EVENT_EVENT:
+		break;
+	default:
+		ready = NULL;
+		break;
+	}
+	if (ready && timerisset(ready) && timercmp(start, ready, >))
+		queued = timeval_elapsed(*start, *ready);
+
+	atomic_fetch_add_explicit(&lat->run[event_hist_bucket(walltime)], 1,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&lat->queued[event_hist_bucket(queued)], 1,
+				  memory_order_relaxed);
+
+	pos = atomic_load_explicit(&prof->pos, memory_order_relaxed);
+	rec = &prof->records[pos % EVENT_PROFILE_RECORDS];
+	rec->xref = thread->xref;
+	rec->start = (uint64_t)start->tv_sec * 1000000 + start->tv_usec;
+	rec->run = MIN(walltime, UINT32_MAX);
+	rec->queued = MIN(queued, UINT32_MAX);
+	rec->type = thread->add_type;
+	atomic_store_explicit(&prof->pos, pos + 1, memory_order_release);
+}
 
 /* CLI start ---------------------------------------------------------------- */
 #include "lib/event_clippy.c"
@@ -113,6 +315,7 @@ static struct cpu_event_history *cpu_records_get(struct event_loop *loop,
 
 static void cpu_records_free(struct cpu_event_history **p)
 {
+	XFREE(MTYPE_EVENT_PROFILE, (*p)->latency);
 	XFREE(MTYPE_EVENT_STATS, *p);
 }
 
@@ -395,6 +598,20 @@ static void show_event_poll_helper(struct vty *vty, struct event_loop *m)
 	vty_out(vty, "----------------------%s\n", underline);
 	vty_out(vty, "Count: %u/%d\n", (uint32_t)m->handler.pfdcount,
 		m->fd_limit);
+
+	if (event_use_epoll(m)) {
+		vty_out(vty, "Backend: epoll\n");
+		for (i = 0; (int)i <= m->handler.epoll_maxfd; i++) {
+			if (!(m->handler.epoll_state[i] & EPOLL_WANT))
+				continue;
+
+			vty_out(vty, "\tfd:%6d\t\t%s %s\n", i,
+				m->read[i] ? m->read[i]->xref->funcname : "",
+				m->write[i] ? m->write[i]->xref->funcname : "");
+		}
+		return;
+	}
+
 	for (i = 0; i < m->handler.pfdcount; i++) {
 		vty_out(vty, "\t%6d fd:%6d events:%2d revents:%2d\t\t", i,
 			m->handler.pfds[i].fd, m->handler.pfds[i].events,
@@ -487,6 +704,14 @@ static void show_event_timers_helper(struct vty *vty, struct event_loop *m)
 	frr_each (event_timer_list, &m->timer, thread) {
 		vty_out(vty, "  %-50s%pTH\n", thread->hist->funcname, thread);
 	}
+
+	if (!m->wheel)
+		return;
+
+	for (unsigned int i = 0; i < array_size(m->wheel->slots); i++)
+		frr_each (event_wheel_list, &m->wheel->slots[i], thread)
+			vty_out(vty, "  %-50s%pTH\n", thread->hist->funcname,
+				thread);
 }
 
 DEFPY_NOSH (show_event_timers,
@@ -514,6 +739,265 @@ ALIAS(show_event_timers,
       "Thread information\n"
       "Show all timers and how long they have in the system\n")
 
+static const char *event_type_name(uint8_t type)
+{
+	switch (type) {
+	case EVENT_READ:
+		return "read";
+	case EVENT_WRITE:
+		return "write";
+	case EVENT_TIMER:
+		return "timer";
+	case EVENT_EVENT:
+		return "event";
+	case EVENT_EXECUTE:
+		return "execute";
+	}
+	return "other";
+}
+
+static void show_event_latency_helper(struct vty *vty, struct event_loop *m)
+{
+	const char *name = m->name ? m->name : "main";
+	char underline[strlen(name) + 1];
+	struct cpu_event_history *rec;
+	struct event_latency *lat;
+	size_t calls;
+	unsigned int i;
+
+	memset(underline, '-', sizeof(underline));
+	underline[sizeof(underline) - 1] = '\0';
+
+	vty_out(vty, "\nShowing latency for pthread %s\n", name);
+	vty_out(vty, "------------------------------%s\n", underline);
+	vty_out(vty, "%10s %29s %29s\n", "", "Running (uSecs):",
+		"Queued (uSecs):");
+	vty_out(vty, "%10s %9s %9s %9s %9s %9s %9s  Event\n", "Invoked",
+		"p50", "p99", "Max", "p50", "p99", "Max");
+
+	frr_each (cpu_records, m->cpu_records, rec) {
+		lat = rec->latency;
+		if (!lat)
+			continue;
+
+		calls = 0;
+		for (i = 0; i < EVENT_HIST_BUCKETS; i++)
+			calls += atomic_load_explicit(&lat->run[i],
+						      memory_order_relaxed);
+
+		vty_out(vty, "%10zu %9lu %9lu %9lu %9lu %9lu %9lu  %s\n",
+			calls, event_hist_percentile(lat->run, calls, 50),
+			event_hist_percentile(lat->run, calls, 99),
+			event_hist_percentile(lat->run, calls, 100),
+			event_hist_percentile(lat->queued, calls, 50),
+			event_hist_percentile(lat->queued, calls, 99),
+			event_hist_percentile(lat->queued, calls, 100),
+			rec->funcname);
+	}
+}
+
+DEFPY_NOSH (show_event_latency,
+            show_event_latency_cmd,
+            "show event latency",
+            SHOW_STR
+            "Event information\n"
+            "Event run and queueing latency percentiles\n")
+{
+	struct listnode *node;
+	struct event_loop *m;
+
+	if (!event_profile_enabled)
+		vty_out(vty,
+			"\nCollecting latency histograms is currently disabled.  Use the\n"
+			"  \"service event-profile\"  command to start collecting data.\n");
+
+	frr_with_mutex (&masters_mtx) {
+		for (ALL_LIST_ELEMENTS_RO(masters, node, m))
+			show_event_latency_helper(vty, m);
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (service_event_profile,
+       service_event_profile_cmd,
+       "[no] service event-profile",
+       NO_STR
+       "Set up miscellaneous service\n"
+       "Collect event latency histograms and recent event history\n")
+{
+	event_profile_enabled = !no;
+	return CMD_SUCCESS;
+}
+
+static int event_profile_record_cmp(const void *a, const void *b)
+{
+	const struct event_profile_record *ra = a, *rb = b;
+	int cmp = strcmp(ra->xref->funcname, rb->xref->funcname);
+
+	if (cmp)
+		return cmp;
+	return numcmp(ra->type, rb->type);
+}
+
+/*
+ * Copy the records of the last 'secs' seconds out of an event loop's
+ * history.  Records being written while this runs may come out torn,
+ * which is fine for what this is used for.
+ */
+static size_t event_profile_snapshot(struct event_loop *m, uint64_t since,
+				     struct event_profile_record **out)
+{
+	struct event_profile_record *recs = NULL, *rec;
+	size_t pos, n = 0, i, count;
+
+	frr_with_mutex (&m->mtx) {
+		if (!m->profile)
+			break;
+
+		pos = atomic_load_explicit(&m->profile->pos,
+					   memory_order_acquire);
+		count = MIN(pos, (size_t)EVENT_PROFILE_RECORDS);
+		recs = XMALLOC(MTYPE_TMP, sizeof(*recs) * MAX(count, 1U));
+
+		for (i = pos - count; i < pos; i++) {
+			rec = &m->profile->records[i % EVENT_PROFILE_RECORDS];
+			if (rec->xref && rec->start >= since)
+				recs[n++] = *rec;
+		}
+	}
+
+	*out = recs;
+	return n;
+}
+
+/* flamegraph.pl input: pthread;state;type;function <usecs> */
+static void event_profile_write_folded(FILE *fp, const char *name,
+				       struct event_profile_record *recs,
+				       size_t n)
+{
+	uint64_t run = 0, queued = 0;
+	size_t i;
+
+	qsort(recs, n, sizeof(*recs), event_profile_record_cmp);
+
+	for (i = 0; i < n; i++) {
+		run += recs[i].run;
+		queued += recs[i].queued;
+
+		if (i + 1 < n && !event_profile_record_cmp(&recs[i], &recs[i + 1]))
+			continue;
+
+		if (run)
+			fprintf(fp, "%s;running;%s;%s %" PRIu64 "\n", name,
+				event_type_name(recs[i].type),
+				recs[i].xref->funcname, run);
+		if (queued)
+			fprintf(fp, "%s;queued;%s;%s %" PRIu64 "\n", name,
+				event_type_name(recs[i].type),
+				recs[i].xref->funcname, queued);
+		run = queued = 0;
+	}
+}
+
+/* Chrome trace event format, one complete event per task run. */
+static void event_profile_write_chrome(FILE *fp, const char *name,
+				       unsigned int tid,
+				       struct event_profile_record *recs,
+				       size_t n, bool *first)
+{
+	size_t i;
+
+	fprintf(fp,
+		"%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+		*first ? "" : ",", (int)getpid(), tid, name);
+	*first = false;
+
+	for (i = 0; i < n; i++)
+		fprintf(fp,
+			",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%" PRIu64
+			",\"dur\":%u,\"pid\":%d,\"tid\":%u,\"args\":{\"queued_us\":%u,\"file\":\"%s\",\"line\":%d}}",
+			recs[i].xref->funcname, event_type_name(recs[i].type),
+			recs[i].start, recs[i].run, (int)getpid(), tid,
+			recs[i].queued, recs[i].xref->xref.file,
+			recs[i].xref->xref.line);
+}
+
+DEFPY (event_profile_export,
+       event_profile_export_cmd,
+       "event profile export <folded|chrome>$format FILENAME [last (1-3600)$secs]",
+       "Event loop\n"
+       "Event profiling\n"
+       "Write recent event history to a file\n"
+       "Folded stacks, for flamegraph.pl\n"
+       "Chrome trace event format, for chrome://tracing or Perfetto\n"
+       "File to write to, the daemon name is appended\n"
+       "Only include the most recent events\n"
+       "Seconds (default 10)\n")
+{
+	struct event_profile_record *recs;
+	struct listnode *node;
+	struct event_loop *m;
+	struct timeval now;
+	unsigned int tid = 0;
+	bool chrome = !strcmp(format, "chrome"), first = true;
+	const char *progname;
+	char path[MAXPATHLEN];
+	uint64_t since;
+	size_t n;
+	FILE *fp;
+
+	if (!event_profile_enabled) {
+		vty_out(vty, "%% Event profiling is not enabled\n");
+		return CMD_WARNING;
+	}
+
+	progname = frr_get_progname();
+	if (progname)
+		snprintf(path, sizeof(path), "%s.%s", filename, progname);
+	else
+		strlcpy(path, filename, sizeof(path));
+	fp = fopen(path, "w");
+	if (!fp) {
+		vty_out(vty, "%% Can't open %s: %s\n", path,
+			safe_strerror(errno));
+		return CMD_WARNING;
+	}
+
+	monotime(&now);
+	since = (uint64_t)now.tv_sec * 1000000 + now.tv_usec;
+	since -= MIN(since, (uint64_t)(secs_str ? secs : 10) * 1000000);
+
+	if (chrome)
+		fprintf(fp, "{\"traceEvents\":[");
+
+	frr_with_mutex (&masters_mtx) {
+		for (ALL_LIST_ELEMENTS_RO(masters, node, m)) {
+			const char *name = m->name ? m->name : "main";
+
+			n = event_profile_snapshot(m, since, &recs);
+			if (chrome)
+				event_profile_write_chrome(fp, name, ++tid,
+							   recs, n, &first);
+			else
+				event_profile_write_folded(fp, name, recs, n);
+			XFREE(MTYPE_TMP, recs);
+		}
+	}
+
+	if (chrome)
+		fprintf(fp, "\n]}\n");
+
+	if (fclose(fp)) {
+		vty_out(vty, "%% Error writing %s: %s\n", path,
+			safe_strerror(errno));
+		return CMD_WARNING;
+	}
+
+	vty_out(vty, "Event history written to %s\n", path);
+	return CMD_SUCCESS;
+}
+
 void event_cmd_init(void)
 {
 	install_element(VIEW_NODE, &show_thread_cpu_cmd);
@@ -528,6 +1012,10 @@ void event_cmd_init(void)
 
 	install_element(VIEW_NODE, &show_thread_timers_cmd);
 	install_element(VIEW_NODE, &show_event_timers_cmd);
+
+	install_element(CONFIG_NODE, &service_event_profile_cmd);
+	install_element(VIEW_NODE, &show_event_latency_cmd);
+	install_element(ENABLE_NODE, &event_profile_export_cmd);
 }
 /* CLI end ------------------------------------------------------------------ */
 
@@ -543,8 +1031,61 @@ static void initializer(void)
 	pthread_key_create(&thread_current, NULL);
 }
 
-#define STUPIDLY_LARGE_FD_SIZE 100000
+void event_set_default_backend(enum event_io_backend backend)
+{
+	default_backend = backend;
+}
+
+void event_set_default_timer_wheel(bool enable)
+{
+	default_timer_wheel = enable;
+}
+
+#ifdef HAVE_EPOLL
+static bool event_epoll_init(struct event_loop *m)
+{
+	struct epoll_event ev = {};
+
+	m->handler.epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (m->handler.epoll_fd < 0) {
+		flog_err(EC_LIB_SYSTEM_CALL,
+			 "epoll_create1() failed, falling back to poll(): %s",
+			 safe_strerror(errno));
+		return false;
+	}
+
+	/* The pipe poker stays registered and level triggered */
+	ev.events = EPOLLIN;
+	ev.data.fd = m->io_pipe[0];
+	if (epoll_ctl(m->handler.epoll_fd, EPOLL_CTL_ADD, m->io_pipe[0],
+		      &ev) < 0) {
+		flog_err(EC_LIB_SYSTEM_CALL,
+			 "epoll_ctl() failed, falling back to poll(): %s",
+			 safe_strerror(errno));
+		close(m->handler.epoll_fd);
+		m->handler.epoll_fd = -1;
+		return false;
+	}
+
+	m->handler.epoll_state = XCALLOC(MTYPE_EVENT_POLL,
+					 sizeof(uint8_t) * m->fd_limit);
+	m->handler.epoll_events = XCALLOC(MTYPE_EVENT_POLL,
+					  sizeof(struct epoll_event) *
+						  EPOLL_BATCH);
+	m->handler.epoll_maxfd = -1;
+
+	return true;
+}
+#endif
+
 struct event_loop *event_master_create(const char *name)
+{
+	return event_master_create_backend(name, default_backend);
+}
+
+#define STUPIDLY_LARGE_FD_SIZE 100000
+struct event_loop *event_master_create_backend(const char *name,
+					       enum event_io_backend backend)
 {
 	struct event_loop *rv;
 	struct rlimit limit;
@@ -609,13 +1150,28 @@ struct event_loop *event_master_create(const char *name)
 	set_nonblocking(rv->io_pipe[0]);
 	set_nonblocking(rv->io_pipe[1]);
 
-	/* Initialize data structures for poll() */
+	/* Initialize data structures for poll() or epoll */
 	rv->handler.pfdsize = rv->fd_limit;
 	rv->handler.pfdcount = 0;
-	rv->handler.pfds = XCALLOC(MTYPE_EVENT_MASTER,
-				   sizeof(struct pollfd) * rv->handler.pfdsize);
-	rv->handler.copy = XCALLOC(MTYPE_EVENT_MASTER,
-				   sizeof(struct pollfd) * rv->handler.pfdsize);
+	rv->handler.epoll_fd = -1;
+#ifdef HAVE_EPOLL
+	if (backend == EVENT_IO_EPOLL && !event_epoll_init(rv))
+		backend = EVENT_IO_POLL;
+#else
+	backend = EVENT_IO_POLL;
+#endif
+
+	if (backend == EVENT_IO_POLL) {
+		rv->handler.pfds = XCALLOC(MTYPE_EVENT_MASTER,
+					   sizeof(struct pollfd) *
+						   rv->handler.pfdsize);
+		rv->handler.copy = XCALLOC(MTYPE_EVENT_MASTER,
+					   sizeof(struct pollfd) *
+						   rv->handler.pfdsize);
+	}
+
+	if (default_timer_wheel)
+		event_master_set_timer_wheel(rv, true);
 
 	/* add to list of threadmasters */
 	frr_with_mutex (&masters_mtx) {
@@ -707,6 +1263,7 @@ void event_master_free(struct event_loop *m)
 {
 	struct cpu_event_history *record;
 	struct event *t;
+	unsigned int i;
 
 	frr_with_mutex (&masters_mtx) {
 		listnode_delete(masters, m);
@@ -718,6 +1275,12 @@ void event_master_free(struct event_loop *m)
 	thread_array_free(m, m->write);
 	while ((t = event_timer_list_pop(&m->timer)))
 		thread_free(m, t);
+	if (m->wheel) {
+		for (i = 0; i < array_size(m->wheel->slots); i++)
+			while ((t = event_wheel_list_pop(&m->wheel->slots[i])))
+				thread_free(m, t);
+		XFREE(MTYPE_EVENT_WHEEL, m->wheel);
+	}
 	thread_list_free(m, &m->event);
 	thread_list_free(m, &m->ready);
 	thread_list_free(m, &m->unuse);
@@ -732,9 +1295,14 @@ void event_master_free(struct event_loop *m)
 		cpu_records_free(&record);
 	cpu_records_fini(m->cpu_records);
 
+	XFREE(MTYPE_EVENT_PROFILE, m->profile);
 	XFREE(MTYPE_EVENT_MASTER, m->name);
 	XFREE(MTYPE_EVENT_MASTER, m->handler.pfds);
 	XFREE(MTYPE_EVENT_MASTER, m->handler.copy);
+	if (event_use_epoll(m))
+		close(m->handler.epoll_fd);
+	XFREE(MTYPE_EVENT_POLL, m->handler.epoll_state);
+	XFREE(MTYPE_EVENT_POLL, m->handler.epoll_events);
 	XFREE(MTYPE_EVENT_MASTER, m);
 }
 
@@ -856,6 +1424,129 @@ static void thread_free(struct event_loop *master, struct event *thread)
 	XFREE(MTYPE_THREAD, thread);
 }
 
+#ifdef HAVE_EPOLL
+/*
+ * epoll backend.
+ *
+ * Registrations are EPOLLONESHOT, which matches read/write tasks running
+ * once: the kernel disables an fd once it reported it, and scheduling
+ * another task re-enables it with a single epoll_ctl().  Nothing is
+ * copied or scanned per wakeup, only the ready fds are returned.
+ *
+ * An fd is removed from the epoll set when it is closed, and its number
+ * may be reused behind our back, so a failing MOD is retried as ADD and
+ * the other way round.
+ */
+static void event_epoll_move_ready(struct event_loop *m, struct event *thread)
+{
+	if (thread->type == EVENT_READ)
+		m->read[thread->u.fd] = NULL;
+	else
+		m->write[thread->u.fd] = NULL;
+	event_list_add_tail(&m->ready, thread);
+	thread->type = EVENT_READY;
+}
+
+/*
+ * Watch fd for the directions in want.  If fired is set, the kernel just
+ * reported the fd and has disabled it already.
+ */
+static void event_epoll_set(struct event_loop *m, int fd, uint8_t want,
+			    bool fired)
+{
+	struct fd_handler *h = &m->handler;
+	uint8_t state = h->epoll_state[fd];
+	struct epoll_event ev = {};
+	int op;
+
+	if ((state & EPOLL_WANT) && !want)
+		h->pfdcount--;
+	else if (!(state & EPOLL_WANT) && want)
+		h->pfdcount++;
+
+	if (!want) {
+		/* The fd may be closed already, nothing to do then */
+		if ((state & EPOLL_REGISTERED) && !fired)
+			epoll_ctl(h->epoll_fd, EPOLL_CTL_DEL, fd, &ev);
+		h->epoll_state[fd] = fired ? (state & EPOLL_REGISTERED) : 0;
+		return;
+	}
+
+	if (fd > h->epoll_maxfd)
+		h->epoll_maxfd = fd;
+
+	ev.events = EPOLLONESHOT;
+	if (want & EPOLL_WANT_READ)
+		ev.events |= EPOLLIN;
+	if (want & EPOLL_WANT_WRITE)
+		ev.events |= EPOLLOUT;
+	ev.data.fd = fd;
+
+	op = (state & EPOLL_REGISTERED) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	if (epoll_ctl(h->epoll_fd, op, fd, &ev) < 0) {
+		if (op == EPOLL_CTL_MOD && errno == ENOENT)
+			op = EPOLL_CTL_ADD;
+		else if (op == EPOLL_CTL_ADD && errno == EEXIST)
+			op = EPOLL_CTL_MOD;
+		else
+			op = -1;
+
+		if (op < 0 || epoll_ctl(h->epoll_fd, op, fd, &ev) < 0) {
+			/*
+			 * epoll refuses regular files, which poll() always
+			 * reports ready.  Do the same.
+			 */
+			if (errno != EPERM)
+				flog_err(EC_LIB_SYSTEM_CALL,
+					 "epoll_ctl() failed for fd %d: %s", fd,
+					 safe_strerror(errno));
+
+			h->pfdcount--;
+			h->epoll_state[fd] = 0;
+			if (m->read[fd])
+				event_epoll_move_ready(m, m->read[fd]);
+			if (m->write[fd])
+				event_epoll_move_ready(m, m->write[fd]);
+			return;
+		}
+	}
+
+	h->epoll_state[fd] = want | EPOLL_REGISTERED;
+}
+
+static void event_epoll_process_io(struct event_loop *m, int num)
+{
+	struct epoll_event *ev;
+	uint8_t want;
+	int i, fd;
+
+	for (i = 0; i < num; i++) {
+		ev = &m->handler.epoll_events[i];
+		fd = ev->data.fd;
+		want = m->handler.epoll_state[fd] & EPOLL_WANT;
+
+		/* Same mapping as the poll() backend */
+		if (ev->events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+			if (m->read[fd]) {
+				event_epoll_move_ready(m, m->read[fd]);
+				want &= ~EPOLL_WANT_READ;
+			} else if ((ev->events & (EPOLLHUP | EPOLLIN)) !=
+				   EPOLLHUP)
+				flog_err(EC_LIB_NO_THREAD,
+					 "Attempting to process an I/O event but for fd: %d(%d) no thread to handle this!",
+					 fd, ev->events);
+		}
+		if ((ev->events & EPOLLOUT) && m->write[fd]) {
+			event_epoll_move_ready(m, m->write[fd]);
+			want &= ~EPOLL_WANT_WRITE;
+		}
+
+		/* Re-enable the fd if the other direction is still wanted */
+		event_epoll_set(m, fd, want, true);
+	}
+}
+#endif /* HAVE_EPOLL */
+
 static int fd_poll(struct event_loop *m, const struct timeval *timer_wait,
 		   bool *eintr_p)
 {
@@ -894,11 +1585,13 @@ static int fd_poll(struct event_loop *m, const struct timeval *timer_wait,
 	rcu_read_unlock();
 	rcu_assert_read_unlocked();
 
-	/* add poll pipe poker */
-	assert(count + 1 < m->handler.pfdsize);
-	m->handler.copy[count].fd = m->io_pipe[0];
-	m->handler.copy[count].events = POLLIN;
-	m->handler.copy[count].revents = 0x00;
+	/* add poll pipe poker, epoll has it registered for good */
+	if (!event_use_epoll(m)) {
+		assert(count + 1 < m->handler.pfdsize);
+		m->handler.copy[count].fd = m->io_pipe[0];
+		m->handler.copy[count].events = POLLIN;
+		m->handler.copy[count].revents = 0x00;
+	}
 
 	/* We need to deal with a signal-handling race here: we
 	 * don't want to miss a crucial signal, such as SIGTERM or SIGINT,
@@ -923,6 +1616,15 @@ static int fd_poll(struct event_loop *m, const struct timeval *timer_wait,
 		pthread_sigmask(SIG_SETMASK, NULL, &origsigs);
 	}
 
+#ifdef HAVE_EPOLL
+	if (event_use_epoll(m)) {
+		num = epoll_pwait(m->handler.epoll_fd, m->handler.epoll_events,
+				  EPOLL_BATCH, timeout, &origsigs);
+		pthread_sigmask(SIG_SETMASK, &origsigs, NULL);
+		goto done;
+	}
+#endif
+
 #if defined(HAVE_PPOLL)
 	struct timespec ts, *tsp;
 
@@ -946,6 +1648,20 @@ done:
 	if (num < 0 && errno == EINTR)
 		*eintr_p = true;
 
+#ifdef HAVE_EPOLL
+	if (event_use_epoll(m)) {
+		struct epoll_event *events = m->handler.epoll_events;
+
+		for (int i = 0; i < num; i++) {
+			if (events[i].data.fd != m->io_pipe[0])
+				continue;
+
+			while (read(m->io_pipe[0], &trash, sizeof(trash)) > 0)
+				;
+			events[i--] = events[--num];
+		}
+	} else
+#endif
 	if (num > 0 && m->handler.copy[count].revents != 0 && num--)
 		while (read(m->io_pipe[0], &trash, sizeof(trash)) > 0)
 			;
@@ -990,6 +1706,33 @@ void _event_add_read_write(const struct xref_eventsched *xref,
 		else
 			thread_array = m->write;
 
+#ifdef HAVE_EPOLL
+		if (event_use_epoll(m)) {
+#ifdef DEV_BUILD
+			if (thread_array[fd])
+				assert(!"Thread already scheduled for file descriptor");
+#endif
+			thread = thread_get(m, dir, func, arg, xref);
+			thread->u.fd = fd;
+			thread_array[fd] = thread;
+			if (t_ptr) {
+				*t_ptr = thread;
+				thread->ref = t_ptr;
+			}
+
+			event_epoll_set(m, fd,
+					(m->handler.epoll_state[fd] &
+					 EPOLL_WANT) |
+						(dir == EVENT_READ
+							 ? EPOLL_WANT_READ
+							 : EPOLL_WANT_WRITE),
+					false);
+
+			AWAKEN(m);
+			break;
+		}
+#endif
+
 		/*
 		 * if we already have a pollfd for our file descriptor, find and
 		 * use it
@@ -1037,6 +1780,200 @@ void _event_add_read_write(const struct xref_eventsched *xref,
 	}
 }
 
+static uint64_t event_wheel_tick(const struct timeval *tv, bool round_up)
+{
+	uint64_t usec = (uint64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+
+	if (round_up)
+		usec += EVENT_WHEEL_TICK_USEC - 1;
+	return usec / EVENT_WHEEL_TICK_USEC;
+}
+
+static void event_wheel_add(struct event_timer_wheel *w, struct event *thread)
+{
+	uint64_t expires = event_wheel_tick(&thread->u.sands, true);
+	unsigned int level, slot;
+
+	if (expires < w->now)
+		expires = w->now;
+	/* beyond the top level, park it there and cascade it back up */
+	if (expires - w->now >= EVENT_WHEEL_SPAN)
+		expires = w->now + EVENT_WHEEL_SPAN - 1;
+
+	for (level = 0; level < EVENT_WHEEL_LEVELS - 1; level++)
+		if (expires - w->now < 1ULL << ((level + 1) * EVENT_WHEEL_BITS))
+			break;
+
+	slot = level * EVENT_WHEEL_SLOTS +
+	       ((expires >> (level * EVENT_WHEEL_BITS)) & EVENT_WHEEL_MASK);
+	event_wheel_list_add_tail(&w->slots[slot], thread);
+	thread->wheel_slot = slot + 1;
+	w->count++;
+}
+
+static void event_wheel_del(struct event_timer_wheel *w, struct event *thread)
+{
+	event_wheel_list_del(&w->slots[thread->wheel_slot - 1], thread);
+	thread->wheel_slot = 0;
+	w->count--;
+}
+
+/* Put a timer on the wheel, returns whether the loop needs a wakeup. */
+static bool event_wheel_schedule(struct event_timer_wheel *w,
+				 struct event *thread,
+				 const struct timeval *now)
+{
+	uint64_t expires = event_wheel_tick(&thread->u.sands, true);
+
+	/* nothing to turn, skip the idle ticks */
+	if (!w->count)
+		w->now = event_wheel_tick(now, false);
+
+	event_wheel_add(w, thread);
+
+	if (expires >= w->wait)
+		return false;
+	w->wait = expires;
+	return true;
+}
+
+/* Remove a timer from the heap or the wheel, whichever it is on. */
+static void event_timer_del(struct event_loop *m, struct event *thread)
+{
+	if (thread->wheel_slot)
+		event_wheel_del(m->wheel, thread);
+	else
+		event_timer_list_del(&m->timer, thread);
+}
+
+/* Move all timers in a slot one level down. */
+static void event_wheel_cascade(struct event_timer_wheel *w,
+				unsigned int level, unsigned int index)
+{
+	struct event_wheel_list_head *head;
+	struct event *thread;
+
+	head = &w->slots[level * EVENT_WHEEL_SLOTS + index];
+	while ((thread = event_wheel_list_pop(head))) {
+		w->count--;
+		event_wheel_add(w, thread);
+	}
+}
+
+/* Turn the wheel up to the current time, moving expired timers to ready. */
+static unsigned int event_wheel_expire(struct event_loop *m,
+				       const struct timeval *timenow)
+{
+	struct event_timer_wheel *w = m->wheel;
+	uint64_t now = event_wheel_tick(timenow, false);
+	struct event_wheel_list_head *head;
+	struct event *thread;
+	unsigned int level, ready = 0;
+
+	if (!w->count) {
+		w->now = now + 1;
+		return 0;
+	}
+
+	for (; w->now <= now; w->now++) {
+		for (level = 1; level < EVENT_WHEEL_LEVELS; level++) {
+			if ((w->now >> ((level - 1) * EVENT_WHEEL_BITS)) &
+			    EVENT_WHEEL_MASK)
+				break;
+			event_wheel_cascade(w, level,
+					    (w->now >> (level * EVENT_WHEEL_BITS)) &
+						    EVENT_WHEEL_MASK);
+		}
+
+		head = &w->slots[w->now & EVENT_WHEEL_MASK];
+		while ((thread = event_wheel_list_pop(head))) {
+			thread->wheel_slot = 0;
+			w->count--;
+			thread->type = EVENT_READY;
+			event_list_add_tail(&m->ready, thread);
+			ready++;
+		}
+	}
+
+	return ready;
+}
+
+/*
+ * Earliest tick the wheel needs to be turned at: a level 0 slot holding
+ * timers, or the cascade of a non-empty slot further up.  The current
+ * slot of a level only is still to be cascaded if the wheel is exactly
+ * at its boundary.
+ */
+static bool event_wheel_next(struct event_timer_wheel *w, uint64_t *next)
+{
+	unsigned int level, k, first, shift;
+	uint64_t pos, tick;
+	bool found = false;
+
+	if (!w->count)
+		return false;
+
+	for (level = 0; level < EVENT_WHEEL_LEVELS; level++) {
+		shift = level * EVENT_WHEEL_BITS;
+		pos = w->now >> shift;
+		first = (w->now & ((1ULL << shift) - 1)) ? 1 : 0;
+
+		for (k = first; k < first + EVENT_WHEEL_SLOTS; k++) {
+			if (!event_wheel_list_count(
+				    &w->slots[level * EVENT_WHEEL_SLOTS +
+					      ((pos + k) & EVENT_WHEEL_MASK)]))
+				continue;
+
+			tick = (pos + k) << shift;
+			if (!found || tick < *next)
+				*next = tick;
+			found = true;
+			break;
+		}
+	}
+
+	return found;
+}
+
+/*
+ * Enable or disable the timer wheel for an event loop.  With the wheel,
+ * timers of a second or more are kept on it instead of the timer heap:
+ * scheduling and cancelling them is O(1), at the cost of running them up
+ * to a tick (10ms) late.  Shorter timers stay on the heap and remain
+ * precise.
+ */
+void event_master_set_timer_wheel(struct event_loop *m, bool enable)
+{
+	struct event_timer_wheel *w;
+	struct event *thread;
+	struct timeval now;
+	unsigned int i;
+
+	frr_with_mutex (&m->mtx) {
+		if (enable && !m->wheel) {
+			w = XCALLOC(MTYPE_EVENT_WHEEL, sizeof(*w));
+			for (i = 0; i < array_size(w->slots); i++)
+				event_wheel_list_init(&w->slots[i]);
+			monotime(&now);
+			w->now = event_wheel_tick(&now, false);
+			w->wait = UINT64_MAX;
+			m->wheel = w;
+		} else if (!enable && m->wheel) {
+			w = m->wheel;
+			for (i = 0; i < array_size(w->slots); i++) {
+				while ((thread = event_wheel_list_pop(
+						&w->slots[i]))) {
+					thread->wheel_slot = 0;
+					event_timer_list_add(&m->timer, thread);
+				}
+				event_wheel_list_fini(&w->slots[i]);
+			}
+			XFREE(MTYPE_EVENT_WHEEL, m->wheel);
+		}
+		AWAKEN(m);
+	}
+}
+
 static void _event_add_timer_timeval(const struct xref_eventsched *xref,
 				     struct event_loop *m,
 				     void (*func)(struct event *), void *arg,
@@ -1044,7 +1981,8 @@ static void _event_add_timer_timeval(const struct xref_eventsched *xref,
 				     struct event **t_ptr)
 {
 	struct event *thread;
-	struct timeval t;
+	struct timeval t, now;
+	bool wakeup;
 
 	assert(m != NULL);
 
@@ -1055,8 +1993,8 @@ static void _event_add_timer_timeval(const struct xref_eventsched *xref,
 		 t_ptr, 0, 0, arg, (long)time_relative->tv_sec);
 
 	/* Compute expiration/deadline time. */
-	monotime(&t);
-	timeradd(&t, time_relative, &t);
+	monotime(&now);
+	timeradd(&now, time_relative, &t);
 
 	frr_with_mutex (&m->mtx) {
 		if (t_ptr && *t_ptr)
@@ -1067,7 +2005,15 @@ static void _event_add_timer_timeval(const struct xref_eventsched *xref,
 
 		frr_with_mutex (&thread->mtx) {
 			thread->u.sands = t;
-			event_timer_list_add(&m->timer, thread);
+			if (m->wheel &&
+			    time_relative->tv_sec >= EVENT_WHEEL_MIN_SEC) {
+				wakeup = event_wheel_schedule(m->wheel, thread,
+							      &now);
+			} else {
+				event_timer_list_add(&m->timer, thread);
+				wakeup = event_timer_list_first(&m->timer) ==
+					 thread;
+			}
 			if (t_ptr) {
 				*t_ptr = thread;
 				thread->ref = t_ptr;
@@ -1078,7 +2024,7 @@ static void _event_add_timer_timeval(const struct xref_eventsched *xref,
 		 * might change the time we'll wait for, give the pthread
 		 * a chance to re-compute.
 		 */
-		if (event_timer_list_first(&m->timer) == thread)
+		if (wakeup)
 			AWAKEN(m);
 	}
 #define ONEYEAR2SEC (60 * 60 * 24 * 365)
@@ -1149,6 +2095,12 @@ void _event_add_event(const struct xref_eventsched *xref, struct event_loop *m,
 		thread = thread_get(m, EVENT_EVENT, func, arg, xref);
 		frr_with_mutex (&thread->mtx) {
 			thread->u.val = val;
+			/*
+			 * Not stamped with profiling off, events queued before
+			 * it is enabled are accounted as not queued.
+			 */
+			if (event_profile_enabled)
+				monotime(&thread->real);
 			event_list_add_tail(&m->event, thread);
 		}
 
@@ -1185,6 +2137,19 @@ static void event_cancel_rw(struct event_loop *master, int fd, short state,
 	/* find the index of corresponding pollfd */
 	nfds_t i;
 
+#ifdef HAVE_EPOLL
+	if (event_use_epoll(master)) {
+		uint8_t want = master->handler.epoll_state[fd] & EPOLL_WANT;
+
+		if (state & POLLIN)
+			want &= ~EPOLL_WANT_READ;
+		if (state & POLLOUT)
+			want &= ~EPOLL_WANT_WRITE;
+		event_epoll_set(master, fd, want, false);
+		return;
+	}
+#endif
+
 	/* Cancel POLLHUP too just in case some bozo set it */
 	state |= POLLHUP;
 
@@ -1281,7 +2246,29 @@ static void cancel_arg_helper(struct event_loop *master,
 		return;
 
 	/* Check the io tasks */
-	for (i = 0; i < master->handler.pfdcount;) {
+	if (event_use_epoll(master)) {
+		for (fd = 0; fd <= master->handler.epoll_maxfd; fd++) {
+			t = master->read[fd];
+			if (t && t->arg == cr->eventobj) {
+				event_cancel_rw(master, fd, POLLIN, -1);
+				master->read[fd] = NULL;
+				if (t->ref)
+					*t->ref = NULL;
+				thread_add_unuse(master, t);
+			}
+
+			t = master->write[fd];
+			if (t && t->arg == cr->eventobj) {
+				event_cancel_rw(master, fd, POLLOUT, -1);
+				master->write[fd] = NULL;
+				if (t->ref)
+					*t->ref = NULL;
+				thread_add_unuse(master, t);
+			}
+		}
+	}
+
+	for (i = 0; i < master->handler.pfdcount && !event_use_epoll(master);) {
 		pfd = master->handler.pfds + i;
 
 		if (pfd->events & POLLIN)
@@ -1328,6 +2315,21 @@ static void cancel_arg_helper(struct event_loop *master,
 
 		t = t_next;
 	}
+
+	if (!master->wheel)
+		return;
+
+	for (i = 0; i < array_size(master->wheel->slots); i++) {
+		frr_each_safe (event_wheel_list, &master->wheel->slots[i], t) {
+			if (t->arg != cr->eventobj)
+				continue;
+
+			event_wheel_del(master->wheel, t);
+			if (t->ref)
+				*t->ref = NULL;
+			thread_add_unuse(master, t);
+		}
+	}
 }
 
 /**
@@ -1382,7 +2384,7 @@ static void do_event_cancel(struct event_loop *master)
 			thread_array = master->write;
 			break;
 		case EVENT_TIMER:
-			event_timer_list_del(&master->timer, thread);
+			event_timer_del(master, thread);
 			break;
 		case EVENT_EVENT:
 			list = &master->event;
@@ -1568,15 +2570,30 @@ void event_cancel_async(struct event_loop *master, struct event **thread,
 }
 /* ------------------------------------------------------------------------- */
 
-static struct timeval *thread_timer_wait(struct event_timer_list_head *timers,
+static struct timeval *thread_timer_wait(struct event_loop *m,
 					 struct timeval *timer_val)
 {
-	if (!event_timer_list_count(timers))
+	struct event *next_timer = event_timer_list_first(&m->timer);
+	struct timeval next;
+	uint64_t tick;
+
+	if (m->wheel && event_wheel_next(m->wheel, &tick)) {
+		next.tv_sec = tick * EVENT_WHEEL_TICK_USEC / 1000000;
+		next.tv_usec = tick * EVENT_WHEEL_TICK_USEC % 1000000;
+		if (next_timer && timercmp(&next_timer->u.sands, &next, <))
+			next = next_timer->u.sands;
+	} else if (next_timer) {
+		next = next_timer->u.sands;
+	} else {
+		if (m->wheel)
+			m->wheel->wait = UINT64_MAX;
 		return NULL;
+	}
 
-	struct event *next_timer = event_timer_list_first(timers);
+	if (m->wheel)
+		m->wheel->wait = event_wheel_tick(&next, true);
 
-	monotime_until(&next_timer->u.sands, timer_val);
+	monotime_until(&next, timer_val);
 	return timer_val;
 }
 
@@ -1697,7 +2714,16 @@ static void thread_process_io(struct event_loop *m, unsigned int num)
 {
 	unsigned int ready = 0;
 	struct pollfd *pfds = m->handler.copy;
-	nfds_t i, last_read = m->last_read % m->handler.copycount;
+	nfds_t i, last_read;
+
+#ifdef HAVE_EPOLL
+	if (event_use_epoll(m)) {
+		event_epoll_process_io(m, num);
+		return;
+	}
+#endif
+
+	last_read = m->last_read % m->handler.copycount;
 
 	for (i = last_read; i < m->handler.copycount && ready < num; ++i)
 		thread_process_io_inner_loop(m, num, pfds, &i, &ready);
@@ -1747,6 +2773,9 @@ static unsigned int thread_process_timers(struct event_loop *m,
 		ready++;
 	}
 
+	if (m->wheel)
+		ready += event_wheel_expire(m, timenow);
+
 	return ready;
 }
 
@@ -1827,7 +2856,7 @@ struct event *event_fetch(struct event_loop *m, struct event *fetch)
 		 * once per loop to avoid starvation by events
 		 */
 		if (!event_list_count(&m->ready))
-			tw = thread_timer_wait(&m->timer, &tv);
+			tw = thread_timer_wait(m, &tv);
 
 		if (event_list_count(&m->ready) ||
 		    (tw && !timercmp(tw, &zerotime, >)))
@@ -1843,9 +2872,11 @@ struct event *event_fetch(struct event_loop *m, struct event *fetch)
 		 * Copy pollfd array + # active pollfds in it. Not necessary to
 		 * copy the array size as this is fixed.
 		 */
-		m->handler.copycount = m->handler.pfdcount;
-		memcpy(m->handler.copy, m->handler.pfds,
-		       m->handler.copycount * sizeof(struct pollfd));
+		if (!event_use_epoll(m)) {
+			m->handler.copycount = m->handler.pfdcount;
+			memcpy(m->handler.copy, m->handler.pfds,
+			       m->handler.copycount * sizeof(struct pollfd));
+		}
 
 		pthread_mutex_unlock(&m->mtx);
 		{
@@ -1874,6 +2905,9 @@ struct event *event_fetch(struct event_loop *m, struct event *fetch)
 		monotime(&now);
 		thread_process_timers(m, &now);
 
+		if (m->profile)
+			m->profile->polled = now;
+
 		/* Post I/O to ready queue. */
 		if (num > 0)
 			thread_process_io(m, num);
@@ -1988,6 +3022,8 @@ void event_call(struct event *thread)
 {
 	RUSAGE_T before, after;
 	bool suppress_warnings = EVENT_ARG(thread);
+	/* events are stamped with the time they were added when profiling */
+	struct timeval ready = thread->real;
 
 	/* if the thread being called is the CLI, it may change cputime_enabled
 	 * ("service cputime-stats" command), which can result in nonsensical
@@ -2048,6 +3084,9 @@ void event_call(struct event *thread)
 	atomic_fetch_or_explicit(&thread->hist->types, 1 << thread->add_type,
 				 memory_order_seq_cst);
 
+	if (event_profile_enabled || thread->master->profile)
+		event_profile_account(thread, &ready, &before.real, walltime);
+
 	if (suppress_warnings)
 		return;
 
@@ -21,6 +21,17 @@ DEFINE_MTYPE_STATIC(LIB, ACCESS_LIST, "Access List");
 DEFINE_MTYPE_STATIC(LIB, ACCESS_LIST_STR, "Access List Str");
 DEFINE_MTYPE_STATIC(LIB, ACCESS_FILTER, "Access Filter");
 
+DECLARE_DLIST(access_batch, struct access_list, batch_item);
+
+/* access_list->batch_flags */
+#define ACCESS_BATCH_ADDED	(1 << 0)
+#define ACCESS_BATCH_DELETED	(1 << 1)
+
+static unsigned int access_batch_depth;
+static struct access_batch_head access_batch[1] = {
+	INIT_DLIST(access_batch[0]),
+};
+
 /* Static structure for mac access_list's master. */
 static struct access_master access_master_mac = {
 	{NULL, NULL},
@@ -165,6 +176,10 @@ void access_list_delete(struct access_list *access)
 	else
 		list->head = access->next;
 
+	/* notified below, not in access_list_batch_end() */
+	if (access->batch_flags)
+		access_batch_del(access_batch, access);
+
 	route_map_notify_dependencies(access->name, RMAP_EVENT_FILTER_DELETED);
 
 	if (master->delete_hook)
@@ -338,6 +353,20 @@ static struct filter *filter_seq_check(struct access_list *access,
 	return NULL;
 }
 
+/* Returns true if notifying route-maps and running the hook for this change
+ * is left to access_list_batch_end().
+ */
+static bool access_list_batch_defer(struct access_list *access, uint8_t flag)
+{
+	if (!access_batch_depth)
+		return false;
+
+	if (!access->batch_flags)
+		access_batch_add_tail(access_batch, access);
+	SET_FLAG(access->batch_flags, flag);
+	return true;
+}
+
 /* Delete filter from specified access_list.  If there is hook
    function execute it. */
 void access_list_filter_delete(struct access_list *access,
@@ -359,6 +388,9 @@ void access_list_filter_delete(struct access_list *access,
 
 	filter_free(filter);
 
+	if (access_list_batch_defer(access, ACCESS_BATCH_DELETED))
+		return;
+
 	route_map_notify_dependencies(access->name, RMAP_EVENT_FILTER_DELETED);
 	/* Run hook function. */
 	if (master->delete_hook)
@@ -414,12 +446,66 @@ void access_list_filter_add(struct access_list *access,
 
 void access_list_filter_update(struct access_list *access)
 {
+	if (access_list_batch_defer(access, ACCESS_BATCH_ADDED))
+		return;
+
 	/* Run hook function. */
 	if (access->master->add_hook)
 		(*access->master->add_hook)(access);
 	route_map_notify_dependencies(access->name, RMAP_EVENT_FILTER_ADDED);
 }
 
+void access_list_batch_start(void)
+{
+	access_batch_depth++;
+}
+
+/* Users re-check the whole list on any notification, so one is enough even
+ * if filters were both added and removed.
+ */
+static void access_list_batch_flush(struct access_list *access)
+{
+	uint8_t flags = access->batch_flags;
+
+	access->batch_flags = 0;
+
+	if (CHECK_FLAG(flags, ACCESS_BATCH_ADDED)) {
+		if (access->master->add_hook)
+			(*access->master->add_hook)(access);
+		route_map_notify_dependencies(access->name,
+					      RMAP_EVENT_FILTER_ADDED);
+	} else {
+		route_map_notify_dependencies(access->name,
+					      RMAP_EVENT_FILTER_DELETED);
+		if (access->master->delete_hook)
+			(*access->master->delete_hook)(access);
+	}
+}
+
+void access_list_batch_end(void)
+{
+	struct access_list *access;
+
+	assert(access_batch_depth);
+	if (--access_batch_depth)
+		return;
+
+	while ((access = access_batch_pop(access_batch)))
+		access_list_batch_flush(access);
+}
+
+static int access_list_nb_apply_start(struct nb_transaction *transaction)
+{
+	access_list_batch_start();
+	return 0;
+}
+
+static int access_list_nb_apply_end(struct nb_transaction *transaction)
+{
+	access_list_batch_end();
+	return 0;
+}
+
 /*
   deny    Specify packets to reject
   permit  Specify packets to forward
@@ -892,6 +978,9 @@ void access_list_init_new(bool in_backend)
 {
 	cmd_variable_handler_register(access_list_handlers);
 
+	hook_register(nb_transaction_apply_start, access_list_nb_apply_start);
+	hook_register(nb_transaction_apply_end, access_list_nb_apply_end);
+
 	access_list_init_ipv4();
 	access_list_init_ipv6();
 	access_list_init_mac();
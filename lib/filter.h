@@ -79,6 +79,8 @@ struct filter {
 	} u;
 };
 
+PREDECL_DLIST(access_batch);
+
 /* Access list */
 struct access_list {
 	char *name;
@@ -91,6 +93,10 @@ struct access_list {
 
 	struct filter *head;
 	struct filter *tail;
+
+	/* changes not yet notified, see access_list_batch_start() */
+	struct access_batch_item batch_item;
+	uint8_t batch_flags;
 };
 
 /* List of access_list. */
@@ -118,6 +124,14 @@ extern void access_list_init_new(bool in_backend);
 extern void access_list_reset(void);
 extern void access_list_add_hook(void (*func)(struct access_list *));
 extern void access_list_delete_hook(void (*func)(struct access_list *));
+
+/* Batched updates:  between access_list_batch_start() and _end(), adding or
+ * removing filters doesn't notify route-maps or run the add / delete hooks;
+ * _end() does that once for each changed access-list.  Calls nest;
+ * northbound commits are batched automatically.
+ */
+extern void access_list_batch_start(void);
+extern void access_list_batch_end(void);
 extern struct access_list *access_list_lookup(afi_t, const char *);
 extern enum filter_type access_list_apply(struct access_list *access,
 					  const void *object);
@@ -27,6 +27,8 @@ extern unsigned long cputime_threshold;
  * hardware TSC w/o syscalls)
  */
 extern unsigned long walltime_threshold;
+/* latency histograms and recent event history, "service event-profile" */
+extern bool event_profile_enabled;
 
 struct rusage_t {
 #ifdef HAVE_CLOCK_THREAD_CPUTIME_ID
@@ -42,6 +44,18 @@ struct rusage_t {
 
 PREDECL_LIST(event_list);
 PREDECL_HEAP(event_timer_list);
+PREDECL_DLIST(event_wheel_list);
+
+/* I/O readiness backend of an event loop */
+enum event_io_backend {
+	EVENT_IO_POLL = 0,
+	EVENT_IO_EPOLL,
+};
+
+struct epoll_event;
+struct event_timer_wheel;
+struct event_profile;
+struct event_latency;
 
 struct fd_handler {
 	/* number of pfd that fit in the allocated space of pfds. This is a
@@ -51,13 +65,24 @@ struct fd_handler {
 
 	/* file descriptors to monitor for i/o */
 	struct pollfd *pfds;
-	/* number of pollfds stored in pfds */
+	/* number of pollfds stored in pfds; with epoll, number of fds
+	 * being watched
+	 */
 	nfds_t pfdcount;
 
 	/* chunk used for temp copy of pollfds */
 	struct pollfd *copy;
 	/* number of pollfds stored in copy */
 	nfds_t copycount;
+
+	/* epoll instance, -1 if poll() is used instead */
+	int epoll_fd;
+	/* per fd: directions being watched, and kernel registration */
+	uint8_t *epoll_state;
+	/* highest fd ever watched, bounds scans of the read/write arrays */
+	int epoll_maxfd;
+	/* events returned by the last epoll_wait() */
+	struct epoll_event *epoll_events;
 };
 
 struct xref_eventsched {
@@ -77,6 +102,8 @@ struct event_loop {
 	struct event **read;
 	struct event **write;
 	struct event_timer_list_head timer;
+	/* coarse timers, NULL unless enabled */
+	struct event_timer_wheel *wheel;
 	struct event_list_head event, ready, unuse;
 	struct list *cancel_req;
 	bool canceled;
@@ -96,6 +123,9 @@ struct event_loop {
 
 	bool ready_run_loop;
 	RUSAGE_T last_getrusage;
+
+	/* recent event history, only with event_profile_enabled */
+	struct event_profile *profile;
 };
 
 /* Event types. */
@@ -115,6 +145,7 @@ struct event {
 	enum event_types add_type; /* event type */
 	struct event_list_item eventitem;
 	struct event_timer_list_item timeritem;
+	struct event_wheel_list_item wheelitem;
 	struct event **ref;	      /* external reference (if given) */
 	struct event_loop *master;    /* pointer to the struct event_loop */
 	void (*func)(struct event *e); /* event function */
@@ -130,6 +161,7 @@ struct event {
 	const struct xref_eventsched *xref; /* origin location */
 	pthread_mutex_t mtx;		    /* mutex for thread.c functions */
 	bool ignore_timer_late;
+	uint16_t wheel_slot; /* timer wheel slot + 1, 0 if on the heap */
 };
 
 #ifdef _FRR_ATTRIBUTE_PRINTFRR
@@ -151,6 +183,8 @@ struct cpu_event_history {
 	struct time_stats cpu;
 	atomic_uint_fast32_t types;
 	const char *funcname;
+	/* run/queue latency histograms, only with event_profile_enabled */
+	struct event_latency *latency;
 };
 
 /* Struct timeval's tv_usec one second value.  */
@@ -225,6 +259,11 @@ static inline unsigned long timeval_elapsed(struct timeval a, struct timeval b)
 
 /* Prototypes. */
 extern struct event_loop *event_master_create(const char *name);
+extern struct event_loop *
+event_master_create_backend(const char *name, enum event_io_backend backend);
+extern void event_set_default_backend(enum event_io_backend backend);
+extern void event_master_set_timer_wheel(struct event_loop *m, bool enable);
+extern void event_set_default_timer_wheel(bool enable);
 void event_master_set_name(struct event_loop *master, const char *name);
 extern void event_master_free(struct event_loop *m);
 extern void event_master_free_unused(struct event_loop *m);
@@ -19,21 +19,37 @@
 DEFINE_MTYPE_STATIC(LIB, HASH, "Hash");
 DEFINE_MTYPE_STATIC(LIB, HASH_BUCKET, "Hash Bucket");
 DEFINE_MTYPE_STATIC(LIB, HASH_INDEX, "Hash Index");
+DEFINE_MTYPE_STATIC(LIB, HASH_SLOTS, "Hash Slots");
+
+/* Open addressing: released slot marker and expansion threshold */
+#define HASH_SLOT_RELEASED -1
+#define HASH_OPEN_THRESHOLD(used, size) ((used) * 4 > (size) * 3)
 
 static pthread_mutex_t _hashes_mtx = PTHREAD_MUTEX_INITIALIZER;
 static struct list *_hashes;
 
-struct hash *hash_create_size(unsigned int size,
-			      unsigned int (*hash_key)(const void *),
-			      bool (*hash_cmp)(const void *, const void *),
-			      const char *name)
+static inline bool hash_is_open(const struct hash *hash)
+{
+	return CHECK_FLAG(hash->flags, HASH_OPEN_ADDRESSING);
+}
+
+static struct hash *hash_create_flags(unsigned int size,
+				      unsigned int (*hash_key)(const void *),
+				      bool (*hash_cmp)(const void *,
+						       const void *),
+				      const char *name, uint8_t flags)
 {
 	struct hash *hash;
 
 	assert((size & (size - 1)) == 0);
 	hash = XCALLOC(MTYPE_HASH, sizeof(struct hash));
-	hash->index =
-		XCALLOC(MTYPE_HASH_INDEX, sizeof(struct hash_bucket *) * size);
+	hash->flags = flags;
+	if (hash_is_open(hash))
+		hash->slots = XCALLOC(MTYPE_HASH_SLOTS,
+				      sizeof(struct hash_bucket) * size);
+	else
+		hash->index = XCALLOC(MTYPE_HASH_INDEX,
+				      sizeof(struct hash_bucket *) * size);
 	hash->size = size;
 	hash->hash_key = hash_key;
 	hash->hash_cmp = hash_cmp;
@@ -51,6 +67,23 @@ struct hash *hash_create_size(unsigned int size,
 	return hash;
 }
 
+struct hash *hash_create_size(unsigned int size,
+			      unsigned int (*hash_key)(const void *),
+			      bool (*hash_cmp)(const void *, const void *),
+			      const char *name)
+{
+	return hash_create_flags(size, hash_key, hash_cmp, name, 0);
+}
+
+struct hash *hash_create_open(unsigned int size,
+			      unsigned int (*hash_key)(const void *),
+			      bool (*hash_cmp)(const void *, const void *),
+			      const char *name)
+{
+	return hash_create_flags(size, hash_key, hash_cmp, name,
+				 HASH_OPEN_ADDRESSING);
+}
+
 struct hash *hash_create(unsigned int (*hash_key)(const void *),
 			 bool (*hash_cmp)(const void *, const void *),
 			 const char *name)
@@ -78,17 +111,12 @@ void *hash_alloc_intern(void *arg)
 						  memory_order_relaxed);       \
 	} while (0)
 
-/* Expand hash if the chain length exceeds the threshold. */
-static void hash_expand(struct hash *hash)
+/* Rehash a chained table into new_size buckets */
+static void hash_resize(struct hash *hash, unsigned int new_size)
 {
-	unsigned int i, new_size;
+	unsigned int i;
 	struct hash_bucket *hb, *hbnext, **new_index;
 
-	new_size = hash->size * 2;
-
-	if (hash->max_size && new_size > hash->max_size)
-		return;
-
 	new_index = XCALLOC(MTYPE_HASH_INDEX,
 			    sizeof(struct hash_bucket *) * new_size);
 
@@ -122,6 +150,156 @@ static void hash_expand(struct hash *hash)
 	hash->index = new_index;
 }
 
+/* Expand hash if the chain length exceeds the threshold. */
+static void hash_expand(struct hash *hash)
+{
+	unsigned int new_size = hash->size * 2;
+
+	if (hash->max_size && new_size > hash->max_size)
+		return;
+
+	hash_resize(hash, new_size);
+}
+
+/*
+ * Open addressing. Slots are probed linearly from key & (size - 1); a
+ * lookup stops at the first slot that never held an element. Released
+ * slots are skipped by lookups and reused by inserts, and are dropped
+ * when the table is resized.
+ */
+static struct hash_bucket *hash_open_find(struct hash *hash, unsigned int key,
+					  const void *data)
+{
+	unsigned int mask = hash->size - 1;
+	unsigned int i = key & mask;
+	struct hash_bucket *hb;
+
+	for (;; i = (i + 1) & mask) {
+		hb = &hash->slots[i];
+
+		if (!hb->data) {
+			if (hb->len != HASH_SLOT_RELEASED)
+				return NULL;
+			continue;
+		}
+
+		if (hb->key == key && (*hash->hash_cmp)(hb->data, data))
+			return hb;
+	}
+}
+
+/* Take the first free slot for key; the caller fills in the data. */
+static struct hash_bucket *hash_open_place(struct hash *hash, unsigned int key)
+{
+	unsigned int mask = hash->size - 1;
+	unsigned int i = key & mask;
+	struct hash_bucket *hb;
+
+	while (hash->slots[i].data)
+		i = (i + 1) & mask;
+
+	hb = &hash->slots[i];
+	if (hb->len == HASH_SLOT_RELEASED)
+		hash->deleted--;
+	hb->len = 1;
+	hb->key = key;
+
+	return hb;
+}
+
+static void hash_open_resize(struct hash *hash, unsigned int new_size)
+{
+	struct hash_bucket *old_slots = hash->slots;
+	unsigned int i, old_size = hash->size;
+	struct hash_bucket *hb;
+
+	hash->slots =
+		XCALLOC(MTYPE_HASH_SLOTS, sizeof(struct hash_bucket) * new_size);
+	hash->size = new_size;
+	hash->deleted = 0;
+	hash->stats.empty = new_size - hash->count;
+
+	for (i = 0; i < old_size; i++) {
+		if (!old_slots[i].data)
+			continue;
+
+		hb = hash_open_place(hash, old_slots[i].key);
+		hb->data = old_slots[i].data;
+	}
+
+	XFREE(MTYPE_HASH_SLOTS, old_slots);
+}
+
+static void *hash_open_insert(struct hash *hash, unsigned int key,
+			      void *newdata)
+{
+	struct hash_bucket *bucket;
+
+	if (HASH_OPEN_THRESHOLD(hash->count + hash->deleted + 1, hash->size)) {
+		/* Only flush released slots if the table is mostly free */
+		if ((hash->count + 1) * 2 > hash->size)
+			hash_open_resize(hash, hash->size * 2);
+		else
+			hash_open_resize(hash, hash->size);
+	}
+
+	bucket = hash_open_place(hash, key);
+	bucket->data = newdata;
+	hash->count++;
+	hash->stats.empty--;
+	hash_update_ssq(hash, 0, 1);
+
+	return newdata;
+}
+
+static void *hash_open_release(struct hash *hash, unsigned int key,
+			       void *data)
+{
+	struct hash_bucket *bucket, *next;
+	void *ret;
+
+	bucket = hash_open_find(hash, key, data);
+	if (!bucket)
+		return NULL;
+
+	ret = bucket->data;
+	bucket->data = NULL;
+
+	/* No lookup goes past an unused successor, no marker needed then */
+	next = &hash->slots[(bucket - hash->slots + 1) & (hash->size - 1)];
+	if (!next->data && next->len != HASH_SLOT_RELEASED) {
+		bucket->len = 0;
+	} else {
+		bucket->len = HASH_SLOT_RELEASED;
+		hash->deleted++;
+	}
+
+	hash->count--;
+	hash->stats.empty++;
+	hash_update_ssq(hash, 1, 0);
+
+	return ret;
+}
+
+void hash_reserve(struct hash *hash, unsigned long count)
+{
+	unsigned int new_size = hash->size;
+
+	if (hash_is_open(hash)) {
+		while (HASH_OPEN_THRESHOLD(count, new_size))
+			new_size *= 2;
+		if (new_size > hash->size)
+			hash_open_resize(hash, new_size);
+		return;
+	}
+
+	while (HASH_THRESHOLD(count, new_size) &&
+	       (!hash->max_size || new_size * 2 <= hash->max_size))
+		new_size *= 2;
+	if (new_size > hash->size)
+		hash_resize(hash, new_size);
+}
+
 void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
 {
 	frrtrace(2, frr_libfrr, hash_get, hash, data);
@@ -135,6 +313,24 @@ void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
 		return NULL;
 
 	key = (*hash->hash_key)(data);
+
+	if (hash_is_open(hash)) {
+		bucket = hash_open_find(hash, key, data);
+		if (bucket)
+			return bucket->data;
+
+		if (!alloc_func)
+			return NULL;
+
+		newdata = (*alloc_func)(data);
+		if (newdata == NULL)
+			return NULL;
+
+		frrtrace(3, frr_libfrr, hash_insert, hash, data, key);
+
+		return hash_open_insert(hash, key, newdata);
+	}
+
 	index = key & (hash->size - 1);
 
 	for (bucket = hash->index[index]; bucket != NULL;
@@ -203,6 +399,13 @@ void *hash_release(struct hash *hash, void *data)
 	struct hash_bucket *pp;
 
 	key = (*hash->hash_key)(data);
+
+	if (hash_is_open(hash)) {
+		ret = hash_open_release(hash, key, data);
+		frrtrace(3, frr_libfrr, hash_release, hash, data, ret);
+		return ret;
+	}
+
 	index = key & (hash->size - 1);
 
 	for (bucket = pp = hash->index[index]; bucket; bucket = bucket->next) {
@@ -243,6 +446,13 @@ void hash_iterate(struct hash *hash, void (*func)(struct hash_bucket *, void *),
 	struct hash_bucket *hb;
 	struct hash_bucket *hbnext;
 
+	if (hash_is_open(hash)) {
+		for (i = 0; i < hash->size; i++)
+			if (hash->slots[i].data)
+				(*func)(&hash->slots[i], arg);
+		return;
+	}
+
 	for (i = 0; i < hash->size; i++)
 		for (hb = hash->index[i]; hb; hb = hbnext) {
 			/* get pointer to next hash bucket here, in case (*func)
@@ -261,6 +471,17 @@ void hash_walk(struct hash *hash, int (*func)(struct hash_bucket *, void *),
 	struct hash_bucket *hbnext;
 	int ret = HASHWALK_CONTINUE;
 
+	if (hash_is_open(hash)) {
+		for (i = 0; i < hash->size; i++) {
+			if (!hash->slots[i].data)
+				continue;
+			ret = (*func)(&hash->slots[i], arg);
+			if (ret == HASHWALK_ABORT)
+				return;
+		}
+		return;
+	}
+
 	for (i = 0; i < hash->size; i++) {
 		for (hb = hash->index[i]; hb; hb = hbnext) {
 			/* get pointer to next hash bucket here, in case (*func)
@@ -280,6 +501,20 @@ void hash_clean(struct hash *hash, void (*free_func)(void *))
 	struct hash_bucket *hb;
 	struct hash_bucket *next;
 
+	if (hash_is_open(hash)) {
+		for (i = 0; i < hash->size; i++) {
+			hb = &hash->slots[i];
+			if (hb->data && free_func)
+				(*free_func)(hb->data);
+		}
+		memset(hash->slots, 0, sizeof(struct hash_bucket) * hash->size);
+		hash->count = 0;
+		hash->deleted = 0;
+		hash->stats.ssq = 0;
+		hash->stats.empty = hash->size;
+		return;
+	}
+
 	for (i = 0; i < hash->size; i++) {
 		for (hb = hash->index[i]; hb; hb = next) {
 			next = hb->next;
@@ -336,6 +571,7 @@ void hash_free(struct hash *hash)
 	XFREE(MTYPE_HASH, hash->name);
 
 	XFREE(MTYPE_HASH_INDEX, hash->index);
+	XFREE(MTYPE_HASH_SLOTS, hash->slots);
 	XFREE(MTYPE_HASH, hash);
 }
 
@@ -21,10 +21,15 @@ extern "C" {
 #define HASHWALK_CONTINUE 0
 #define HASHWALK_ABORT -1
 
+/* Hash table flags */
+#define HASH_OPEN_ADDRESSING (1 << 0)
+
 struct hash_bucket {
 	/*
 	 * if this bucket is the head of the linked listed, len denotes the
 	 * number of elements in the list
+	 *
+	 * In an open addressed table, -1 marks a released slot.
 	 */
 	int len;
 
@@ -49,6 +54,17 @@ struct hash {
 	/* Hash bucket. */
 	struct hash_bucket **index;
 
+	/*
+	 * Buckets of an open addressed table, stored inline; index is
+	 * unused for these.
+	 */
+	struct hash_bucket *slots;
+
+	/* Released slots of an open addressed table */
+	unsigned long deleted;
+
+	uint8_t flags;
+
 	/* Hash table size. Must be power of 2 */
 	unsigned int size;
 
@@ -139,6 +155,46 @@ hash_create_size(unsigned int size, unsigned int (*hash_key)(const void *),
 		 bool (*hash_cmp)(const void *, const void *),
 		 const char *name);
 
+/*
+ * Create an open addressed hash table.
+ *
+ * Same API as a table from hash_create_size(), but the buckets are kept in
+ * a single array and probed linearly: there is no allocation per entry and
+ * lookups touch contiguous memory. Released entries leave a marker behind
+ * until the table is next resized. max_size is not honoured, and the index
+ * member must not be accessed directly.
+ *
+ * The bucket passed to hash_iterate() and hash_walk() callbacks is only
+ * valid for the duration of the callback.
+ *
+ * size
+ *    initial number of slots to allocate; must be a power of 2 or the
+ *    program will assert. The table grows once it is 3/4 full.
+ *
+ * hash_key, hash_cmp, name
+ *    see hash_create_size
+ *
+ * Returns:
+ *    a new hash table
+ */
+extern struct hash *
+hash_create_open(unsigned int size, unsigned int (*hash_key)(const void *),
+		 bool (*hash_cmp)(const void *, const void *),
+		 const char *name);
+
+/*
+ * Grow a hash table so that it holds count elements without expanding.
+ *
+ * Useful before bulk inserts of a known number of elements.
+ *
+ * hash
+ *    hash table to operate on
+ *
+ * count
+ *    number of elements the table is expected to hold
+ */
+extern void hash_reserve(struct hash *hash, unsigned long count);
+
 /*
  * Retrieve or insert data from / into a hash table.
  *
@@ -8,6 +8,8 @@
 
 #include "linklist.h"
 #include "vector.h"
+#include "hash.h"
+#include "jhash.h"
 #include "lib_errors.h"
 #include "vty.h"
 #include "command.h"
@@ -143,6 +145,84 @@ static int if_cmp_index_func(const struct interface *ifp1,
 		return -1;
 }
 
+/*
+ * All interfaces are also kept in global hash tables keyed by name and
+ * ifindex, across VRFs.  The per-VRF trees stay around for ordered walks,
+ * lookups go through the hashes so that they don't depend on the number
+ * of interfaces or VRFs.
+ *
+ * The VRF is part of the key; a lookup key without VRF matches the
+ * interface in any VRF.
+ */
+static int if_name_hash_cmp(const struct interface *ifp1,
+			    const struct interface *ifp2)
+{
+	int ret;
+
+	ret = strcmp(ifp1->name, ifp2->name);
+	if (ret || !ifp1->vrf || !ifp2->vrf)
+		return ret;
+
+	return numcmp((uintptr_t)ifp1->vrf, (uintptr_t)ifp2->vrf);
+}
+
+static uint32_t if_name_hash_key(const struct interface *ifp)
+{
+	return string_hash_make(ifp->name);
+}
+
+DECLARE_HASH(if_name_hash, struct interface, name_hash_entry,
+	     if_name_hash_cmp, if_name_hash_key);
+
+static int if_index_hash_cmp(const struct interface *ifp1,
+			     const struct interface *ifp2)
+{
+	if (ifp1->ifindex != ifp2->ifindex)
+		return numcmp(ifp1->ifindex, ifp2->ifindex);
+	if (!ifp1->vrf || !ifp2->vrf)
+		return 0;
+
+	return numcmp((uintptr_t)ifp1->vrf, (uintptr_t)ifp2->vrf);
+}
+
+static uint32_t if_index_hash_key(const struct interface *ifp)
+{
+	return jhash_1word(ifp->ifindex, 0);
+}
+
+DECLARE_HASH(if_index_hash, struct interface, index_hash_entry,
+	     if_index_hash_cmp, if_index_hash_key);
+
+static struct if_name_hash_head ifaces_name_hash;
+static struct if_index_hash_head ifaces_index_hash;
+
+static void if_name_link(struct vrf *vrf, struct interface *ifp)
+{
+	if (!IFNAME_RB_INSERT(vrf, ifp))
+		if_name_hash_add(&ifaces_name_hash, ifp);
+}
+
+static void if_name_unlink(struct vrf *vrf, struct interface *ifp)
+{
+	IFNAME_RB_REMOVE(vrf, ifp);
+	if_name_hash_del(&ifaces_name_hash, ifp);
+}
+
+static bool if_index_link(struct vrf *vrf, struct interface *ifp)
+{
+	if (IFINDEX_RB_INSERT(vrf, ifp))
+		return false;
+
+	if_index_hash_add(&ifaces_index_hash, ifp);
+	return true;
+}
+
+static void if_index_unlink(struct vrf *vrf, struct interface *ifp)
+{
+	IFINDEX_RB_REMOVE(vrf, ifp);
+	if_index_hash_del(&ifaces_index_hash, ifp);
+}
+
 static void ifp_connected_free(void *arg)
 {
 	struct connected *c = arg;
@@ -223,19 +303,19 @@ void if_update_to_new_vrf(struct interface *ifp, vrf_id_t vrf_id)
 	old_vrf = ifp->vrf;
 
 	if (ifp->name[0] != '\0')
-		IFNAME_RB_REMOVE(old_vrf, ifp);
+		if_name_unlink(old_vrf, ifp);
 
 	if (ifp->ifindex != IFINDEX_INTERNAL)
-		IFINDEX_RB_REMOVE(old_vrf, ifp);
+		if_index_unlink(old_vrf, ifp);
 
 	vrf = vrf_get(vrf_id, NULL);
 	ifp->vrf = vrf;
 
 	if (ifp->name[0] != '\0')
-		IFNAME_RB_INSERT(vrf, ifp);
+		if_name_link(vrf, ifp);
 
 	if (ifp->ifindex != IFINDEX_INTERNAL)
-		IFINDEX_RB_INSERT(vrf, ifp);
+		if_index_link(vrf, ifp);
 }
 
 
@@ -261,9 +341,9 @@ void if_delete(struct interface **ifp)
 	struct interface *ptr = *ifp;
 	struct vrf *vrf = ptr->vrf;
 
-	IFNAME_RB_REMOVE(vrf, ptr);
+	if_name_unlink(vrf, ptr);
 	if (ptr->ifindex != IFINDEX_INTERNAL)
-		IFINDEX_RB_REMOVE(vrf, ptr);
+		if_index_unlink(vrf, ptr);
 
 	if_delete_retain(ptr);
 
@@ -290,7 +370,8 @@ static struct interface *if_lookup_by_ifindex(ifindex_t ifindex,
 		return NULL;
 
 	if_tmp.ifindex = ifindex;
-	return RB_FIND(if_index_head, &vrf->ifaces_by_index, &if_tmp);
+	if_tmp.vrf = vrf;
+	return if_index_hash_find(&ifaces_index_hash, &if_tmp);
 }
 
 /* Interface existence check by index. */
@@ -368,7 +449,8 @@ struct interface *if_lookup_by_name(const char *name, vrf_id_t vrf_id)
 		return NULL;
 
 	strlcpy(if_tmp.name, name, sizeof(if_tmp.name));
-	return RB_FIND(if_name_head, &vrf->ifaces_by_name, &if_tmp);
+	if_tmp.vrf = vrf;
+	return if_name_hash_find(&ifaces_name_hash, &if_tmp);
 }
 
 struct interface *if_lookup_by_name_vrf(const char *name, struct vrf *vrf)
@@ -379,41 +461,32 @@ struct interface *if_lookup_by_name_vrf(const char *name, struct vrf *vrf)
 		return NULL;
 
 	strlcpy(if_tmp.name, name, sizeof(if_tmp.name));
-	return RB_FIND(if_name_head, &vrf->ifaces_by_name, &if_tmp);
+	if_tmp.vrf = vrf;
+	return if_name_hash_find(&ifaces_name_hash, &if_tmp);
 }
 
-static struct interface *if_lookup_by_name_all_vrf(const char *name)
+struct interface *if_lookup_by_name_all_vrf(const char *name)
 {
-	struct vrf *vrf;
-	struct interface *ifp;
+	struct interface if_tmp;
 
 	if (!name || strnlen(name, IFNAMSIZ) == IFNAMSIZ)
 		return NULL;
 
-	RB_FOREACH (vrf, vrf_name_head, &vrfs_by_name) {
-		ifp = if_lookup_by_name_vrf(name, vrf);
-		if (ifp)
-			return ifp;
-	}
-
-	return NULL;
+	strlcpy(if_tmp.name, name, sizeof(if_tmp.name));
+	if_tmp.vrf = NULL;
+	return if_name_hash_find(&ifaces_name_hash, &if_tmp);
 }
 
 static struct interface *if_lookup_by_index_all_vrf(ifindex_t ifindex)
 {
-	struct vrf *vrf;
-	struct interface *ifp;
+	struct interface if_tmp;
 
 	if (ifindex == IFINDEX_INTERNAL)
 		return NULL;
 
-	RB_FOREACH (vrf, vrf_id_head, &vrfs_by_id) {
-		ifp = if_lookup_by_ifindex(ifindex, vrf->vrf_id);
-		if (ifp)
-			return ifp;
-	}
-
-	return NULL;
+	if_tmp.ifindex = ifindex;
+	if_tmp.vrf = NULL;
+	return if_index_hash_find(&ifaces_index_hash, &if_tmp);
 }
 
 /* Lookup interface by IP address.
@@ -620,7 +693,7 @@ int if_set_index(struct interface *ifp, ifindex_t ifindex)
 		return -1;
 
 	if (ifp->ifindex != IFINDEX_INTERNAL)
-		IFINDEX_RB_REMOVE(ifp->vrf, ifp);
+		if_index_unlink(ifp->vrf, ifp);
 
 	ifp->ifindex = ifindex;
 
@@ -630,7 +703,7 @@ int if_set_index(struct interface *ifp, ifindex_t ifindex)
 		 * already an interface with the desired ifindex at the top of
 		 * the function. Nevertheless.
 		 */
-		if (IFINDEX_RB_INSERT(ifp->vrf, ifp))
+		if (!if_index_link(ifp->vrf, ifp))
 			return -1;
 	}
 
@@ -643,12 +716,12 @@ static void if_set_name(struct interface *ifp, const char *name)
 		return;
 
 	if (ifp->name[0] != '\0')
-		IFNAME_RB_REMOVE(ifp->vrf, ifp);
+		if_name_unlink(ifp->vrf, ifp);
 
 	strlcpy(ifp->name, name, sizeof(ifp->name));
 
 	if (ifp->name[0] != '\0')
-		IFNAME_RB_INSERT(ifp->vrf, ifp);
+		if_name_link(ifp->vrf, ifp);
 }
 
 /* Does interface up ? */
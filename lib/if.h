@@ -205,11 +205,17 @@ struct if_link_params {
 #define HAS_LINK_PARAMS(ifp)  ((ifp)->link_params != NULL)
 
 PREDECL_DLIST(if_connected);
+PREDECL_HASH(if_name_hash);
+PREDECL_HASH(if_index_hash);
 
 /* Interface structure */
 struct interface {
 	RB_ENTRY(interface) name_entry, index_entry;
 
+	/* Global name and ifindex lookup tables, across all VRFs */
+	struct if_name_hash_item name_hash_entry;
+	struct if_index_hash_item index_hash_entry;
+
 	/* Interface name.  This should probably never be changed after the
 	   interface is created, because the configuration info for this
 	   interface
@@ -552,6 +558,8 @@ static inline bool if_address_is_local(const void *matchaddr, int family,
 
 struct vrf;
 extern struct interface *if_lookup_by_name_vrf(const char *name, struct vrf *vrf);
+/* Lookup by name in any VRF, for backends with system wide names */
+extern struct interface *if_lookup_by_name_all_vrf(const char *name);
 extern struct interface *if_lookup_by_name(const char *ifname, vrf_id_t vrf_id);
 extern struct interface *if_get_vrf_loopback(vrf_id_t vrf_id);
 extern struct interface *if_get_by_name(const char *ifname, vrf_id_t vrf_id,
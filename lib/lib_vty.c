@@ -15,15 +15,19 @@
 #include <malloc/malloc.h>
 #endif
 #include <dlfcn.h>
+#include <fcntl.h>
 #ifdef HAVE_LINK_H
 #include <link.h>
 #endif
 
 #include "log.h"
 #include "memory.h"
+#include "mpool.h"
 #include "module.h"
+#include "tracering.h"
 #include "defaults.h"
 #include "lib_vty.h"
+#include "libfrr.h"
 #include "northbound_cli.h"
 
 /* Looking up memory status from vty interface. */
@@ -68,6 +72,8 @@ static int show_memory_mallinfo(struct vty *vty)
 static int qmem_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 {
 	struct vty *vty = arg;
+	struct mtype_stats stats;
+
 	if (!mt) {
 		vty_out(vty, "--- qmem %s ---\n", mg->name);
 		vty_out(vty, "%-30s: %8s %-8s%s %8s %9s\n",
@@ -85,13 +91,14 @@ static int qmem_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 #endif
 			);
 	} else {
-		if (mt->n_max != 0) {
+		mtype_stats(mt, &stats);
+		if (stats.n_max != 0) {
 			char size[32];
-			snprintf(size, sizeof(size), "%6zu", mt->size);
+			snprintf(size, sizeof(size), "%6zu", stats.size);
 #ifdef HAVE_MALLOC_USABLE_SIZE
 #define TSTR " %9zu"
-#define TARG , mt->total
-#define TARG2 , mt->max_size
+#define TARG , stats.total
+#define TARG2 , stats.max_size
 #else
 #define TSTR ""
 #define TARG
@@ -99,19 +106,52 @@ static int qmem_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 #endif
 			vty_out(vty, "%-30s: %8zu %-8s"TSTR" %8zu"TSTR"\n",
 				mt->name,
-				mt->n_alloc,
-				mt->size == 0 ? ""
-					      : mt->size == SIZE_VAR
-							? "variable"
-							: size
+				stats.n_alloc,
+				stats.size == 0 ? ""
+						: stats.size == SIZE_VAR
+							  ? "variable"
+							  : size
 				TARG,
-				mt->n_max
+				stats.n_max
 				TARG2);
 		}
 	}
 	return 0;
 }
 
+static int mpool_walker(void *arg, struct mpool *mp,
+			const struct mpool_stats *stats)
+{
+	struct vty *vty = arg;
+
+	vty_out(vty, "%-30s: %8zu %8zu %10zu %8zu\n", mp->mt->name,
+		stats->size, stats->n_slabs, stats->reserved, stats->n_free);
+	return 0;
+}
+
+static int qmem_site_walker(void *arg, const struct qmem_site *site)
+{
+	struct vty *vty = arg;
+	Dl_info dlinfo = {};
+	const char *base = "?";
+	const char *fname;
+	uintptr_t offset = (uintptr_t)site->site;
+
+	if (dladdr(site->site, &dlinfo)) {
+		if (dlinfo.dli_sname) {
+			base = dlinfo.dli_sname;
+			offset -= (uintptr_t)dlinfo.dli_saddr;
+		} else if (dlinfo.dli_fname) {
+			fname = strrchr(dlinfo.dli_fname, '/');
+			base = fname ? fname + 1 : dlinfo.dli_fname;
+			offset -= (uintptr_t)dlinfo.dli_fbase;
+		}
+	}
+
+	vty_out(vty, "%-30s: %8zu %10zu  %s+%#jx\n", site->mt->name,
+		site->count, site->bytes, base, (uintmax_t)offset);
+	return 0;
+}
 
 DEFUN_NOSH (show_memory,
 	    show_memory_cmd,
@@ -124,6 +164,132 @@ DEFUN_NOSH (show_memory,
 #endif /* HAVE_MALLINFO */
 
 	qmem_walk(qmem_walker, vty);
+
+	vty_out(vty, "--- qmem pools ---\n");
+	vty_out(vty, "%-30s: %8s %8s %10s %8s\n", "Type", "ObjSize", "Slabs",
+		"Reserved", "Free#");
+	mpool_walk(mpool_walker, vty);
+
+	if (qmem_profile_rate()) {
+		vty_out(vty, "--- live allocations by site, sampled 1 in %u ---\n",
+			qmem_profile_rate());
+		vty_out(vty, "%-30s: %8s %10s  %s\n", "Type", "Current#",
+			"Bytes", "Site");
+		qmem_profile_walk(qmem_site_walker, vty);
+	}
+	return CMD_SUCCESS;
+}
+
+DEFUN (service_memory_profile,
+       service_memory_profile_cmd,
+       "service memory-profile [sample-rate (1-1000000)]",
+       "Set up miscellaneous service\n"
+       "Track live memory by allocation site\n"
+       "Sample one in this many allocations\n"
+       "Sample rate (default 1000)\n")
+{
+	unsigned int rate = QMEM_PROFILE_RATE_DEFAULT;
+
+	if (argc == 4)
+		rate = strtoul(argv[3]->arg, NULL, 10);
+
+	qmem_profile_set(rate);
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_service_memory_profile,
+       no_service_memory_profile_cmd,
+       "no service memory-profile [sample-rate (1-1000000)]",
+       NO_STR
+       "Set up miscellaneous service\n"
+       "Track live memory by allocation site\n"
+       "Sample one in this many allocations\n"
+       "Sample rate (default 1000)\n")
+{
+	qmem_profile_set(0);
+	return CMD_SUCCESS;
+}
+
+DEFUN (service_trace_ring,
+       service_trace_ring_cmd,
+       "service trace-ring [records (64-1048576)]",
+       "Set up miscellaneous service\n"
+       "Record binary trace records in memory\n"
+       "Ring size for each pthread\n"
+       "Number of records (default 1024)\n")
+{
+	unsigned int records = TRACERING_RECORDS_DEFAULT;
+
+	if (argc == 4)
+		records = strtoul(argv[3]->arg, NULL, 10);
+
+	tracering_set(records);
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_service_trace_ring,
+       no_service_trace_ring_cmd,
+       "no service trace-ring [records (64-1048576)]",
+       NO_STR
+       "Set up miscellaneous service\n"
+       "Record binary trace records in memory\n"
+       "Ring size for each pthread\n"
+       "Number of records (default 1024)\n")
+{
+	tracering_set(0);
+	return CMD_SUCCESS;
+}
+
+DEFUN (show_trace_ring,
+       show_trace_ring_cmd,
+       "show trace-ring",
+       SHOW_STR
+       "Binary trace records kept in memory\n")
+{
+	struct tracering_stats stats;
+
+	tracering_get_stats(&stats);
+
+	if (tracering_get())
+		vty_out(vty, "Trace ring: %u records per pthread\n",
+			tracering_get());
+	else
+		vty_out(vty, "Trace ring: disabled\n");
+	vty_out(vty, "  Tracepoints:      %zu\n", stats.tracepoints);
+	vty_out(vty, "  Rings:            %zu (%zu bytes)\n", stats.rings,
+		stats.bytes);
+	vty_out(vty, "  Records written:  %" PRIu64 "\n", stats.recorded);
+	return CMD_SUCCESS;
+}
+
+DEFUN (dump_trace_ring,
+       dump_trace_ring_cmd,
+       "dump trace-ring FILENAME",
+       "Write diagnostic data to a file\n"
+       "Binary trace records kept in memory\n"
+       "File name, the daemon name is appended\n")
+{
+	char path[MAXPATHLEN];
+	int fd, ret;
+
+	snprintf(path, sizeof(path), "%s.%s", argv[2]->arg,
+		 frr_get_progname());
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd < 0) {
+		vty_out(vty, "%% Can't open %s: %s\n", path,
+			safe_strerror(errno));
+		return CMD_WARNING;
+	}
+
+	ret = tracering_dump(fd);
+	if (ret)
+		vty_out(vty, "%% Writing %s failed: %s\n", path,
+			safe_strerror(errno));
+	close(fd);
+
+	if (ret)
+		return CMD_WARNING;
+	vty_out(vty, "Trace ring written to %s\n", path);
 	return CMD_SUCCESS;
 }
 
@@ -290,6 +456,12 @@ void lib_cmd_init(void)
 
 	install_element(VIEW_NODE, &show_memory_cmd);
 	install_element(VIEW_NODE, &show_modules_cmd);
+	install_element(CONFIG_NODE, &service_memory_profile_cmd);
+	install_element(CONFIG_NODE, &no_service_memory_profile_cmd);
+	install_element(CONFIG_NODE, &service_trace_ring_cmd);
+	install_element(CONFIG_NODE, &no_service_trace_ring_cmd);
+	install_element(VIEW_NODE, &show_trace_ring_cmd);
+	install_element(ENABLE_NODE, &dump_trace_ring_cmd);
 
 	install_element(CONFIG_NODE, &start_config_cmd);
 	install_element(CONFIG_NODE, &end_config_cmd);
@@ -36,6 +36,7 @@
 #include "defaults.h"
 #include "frrscript.h"
 #include "systemd.h"
+#include "tracering.h"
 
 #include "lib/config_paths.h"
 
@@ -100,6 +101,8 @@ static void opt_extend(const struct optspec *os)
 #define OPTION_LOGGING   1007
 #define OPTION_LIMIT_FDS 1008
 #define OPTION_SCRIPTDIR 1009
+#define OPTION_EVENT_BACKEND 1010
+#define OPTION_TIMER_WHEEL 1011
 
 static const struct option lo_always[] = {
 	{"help", no_argument, NULL, 'h'},
@@ -116,6 +119,8 @@ static const struct option lo_always[] = {
 	{"log-level", required_argument, NULL, OPTION_LOGLEVEL},
 	{"command-log-always", no_argument, NULL, OPTION_LOGGING},
 	{"limit-fds", required_argument, NULL, OPTION_LIMIT_FDS},
+	{"event-backend", required_argument, NULL, OPTION_EVENT_BACKEND},
+	{"timer-wheel", no_argument, NULL, OPTION_TIMER_WHEEL},
 	{NULL}};
 static const struct optspec os_always = {
 	"hvdM:F:N:o:",
@@ -131,7 +136,9 @@ static const struct optspec os_always = {
 	"      --scriptdir    Override scripts directory\n"
 	"      --log          Set Logging to stdout, syslog, or file:<name>\n"
 	"      --log-level    Set Logging Level to use, debug, info, warn, etc\n"
-	"      --limit-fds    Limit number of fds supported\n",
+	"      --limit-fds    Limit number of fds supported\n"
+	"      --event-backend  Wait for I/O with poll (default) or epoll\n"
+	"      --timer-wheel  Keep timers of a second or more on a timer wheel\n",
 	lo_always};
 
 static bool logging_to_stdout = false; /* set when --log stdout specified */
@@ -624,6 +631,19 @@ static int frr_opt(int opt)
 	case OPTION_LIMIT_FDS:
 		di->limit_fds = strtoul(optarg, &err, 0);
 		break;
+	case OPTION_EVENT_BACKEND:
+		if (!strcmp(optarg, "epoll"))
+			event_set_default_backend(EVENT_IO_EPOLL);
+		else if (!strcmp(optarg, "poll"))
+			event_set_default_backend(EVENT_IO_POLL);
+		else {
+			fprintf(stderr, "invalid event backend: %s\n", optarg);
+			errors++;
+		}
+		break;
+	case OPTION_TIMER_WHEEL:
+		event_set_default_timer_wheel(true);
+		break;
 	default:
 		return 1;
 	}
@@ -1249,6 +1269,7 @@ void frr_fini(void)
 	master = NULL;
 	zlog_tls_buffer_fini();
 	zlog_fini();
+	tracering_fini();
 	/* frrmod_init -> nothing needed / hooks */
 	rcu_shutdown();
 
@@ -461,7 +461,9 @@ static const struct zebra_desc_table command_types[] = {
 	DESC_ENTRY(ZEBRA_TC_CLASS_DELETE),
 	DESC_ENTRY(ZEBRA_TC_FILTER_ADD),
 	DESC_ENTRY(ZEBRA_TC_FILTER_DELETE),
-	DESC_ENTRY(ZEBRA_OPAQUE_NOTIFY)
+	DESC_ENTRY(ZEBRA_OPAQUE_NOTIFY),
+	DESC_ENTRY(ZEBRA_CLIENT_BACKPRESSURE),
+	DESC_ENTRY(ZEBRA_REDISTRIBUTE_ROUTE_BATCH)
 };
 #undef DESC_ENTRY
 
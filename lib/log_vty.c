@@ -176,6 +176,7 @@ DEFUN_NOSH (show_logging,
 	    "Show current logging configuration\n")
 {
 	int stdout_prio;
+	size_t bufsize;
 
 	log_show_syslog(vty);
 
@@ -222,6 +223,18 @@ DEFUN_NOSH (show_logging,
 		(zt_file.record_priority ? "enabled" : "disabled"));
 	vty_out(vty, "Timestamp precision: %d\n", zt_file.ts_subsec);
 
+	if (zlog_get_async(&bufsize)) {
+		struct zlog_async_stats stats;
+
+		zlog_async_get_stats(&stats);
+		vty_out(vty,
+			"Asynchronous output: %zu kB buffer per thread, %zu threads, %zu bytes pending\n",
+			bufsize / 1024, stats.n_rings, stats.pending);
+		vty_out(vty, "  %zu messages written, %zu dropped\n",
+			stats.written, stats.dropped);
+	} else
+		vty_out(vty, "Asynchronous output: disabled\n");
+
 	hook_call(zlog_cli_show, vty);
 	return CMD_SUCCESS;
 }
@@ -823,9 +836,29 @@ DEFPY (log_immediate_mode,
 	return CMD_SUCCESS;
 }
 
+/* Enable/disable asynchronous output from a separate pthread */
+DEFPY (log_async,
+       log_async_cmd,
+       "[no] log asynchronous [buffer-size (4-1024)$kbytes]",
+       NO_STR
+       "Logging control\n"
+       "Write log messages from a separate thread\n"
+       "Size of each thread's message buffer\n"
+       "Size in kilobytes\n")
+{
+	size_t bufsize = ZLOG_ASYNC_BUFSIZE_DEFAULT;
+
+	if (kbytes_str)
+		bufsize = kbytes * 1024;
+
+	zlog_set_async(!no, bufsize);
+	return CMD_SUCCESS;
+}
+
 void log_config_write(struct vty *vty)
 {
 	bool show_cmdline_hint = false;
+	size_t bufsize;
 
 	if (zt_file.prio_min != ZLOG_DISABLED && zt_file.filename) {
 		vty_out(vty, "log file %s", zt_file.filename);
@@ -904,6 +937,12 @@ void log_config_write(struct vty *vty)
 		vty_out(vty, "no log unique-id\n");
 	if (zlog_get_immediate_mode())
 		vty_out(vty, "log immediate-mode\n");
+	if (zlog_get_async(&bufsize)) {
+		vty_out(vty, "log asynchronous");
+		if (bufsize != ZLOG_ASYNC_BUFSIZE_DEFAULT)
+			vty_out(vty, " buffer-size %zu", bufsize / 1024);
+		vty_out(vty, "\n");
+	}
 
 	if (logmsgs_with_persist_bt) {
 		struct xrefdata *xrd;
@@ -991,6 +1030,7 @@ void log_cmd_init(void)
 	install_element(CONFIG_NODE, &config_log_filterfile_cmd);
 	install_element(CONFIG_NODE, &no_config_log_filterfile_cmd);
 	install_element(CONFIG_NODE, &log_immediate_mode_cmd);
+	install_element(CONFIG_NODE, &log_async_cmd);
 
 	install_element(ENABLE_NODE, &debug_uid_backtrace_cmd);
 	install_element(CONFIG_NODE, &debug_uid_backtrace_cmd);
@@ -17,6 +17,8 @@
 #endif
 
 #include "memory.h"
+#include "mpool.h"
+#include "pthread_local.h"
 #include "log.h"
 #include "libfrr_trace.h"
 
@@ -27,21 +29,548 @@ DEFINE_MGROUP(LIB, "libfrr");
 DEFINE_MTYPE(LIB, TMP, "Temporary memory");
 DEFINE_MTYPE(LIB, BITFIELD, "Bitfield memory");
 
-static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
+unsigned int mt_index_next;
+
+/* Allocation counters are kept per pthread and only added into the memtype
+ * once they have drifted by MT_FLUSH allocations (or frees, or bytes), so
+ * allocating doesn't bounce the memtype's cachelines between CPUs.  A pthread
+ * only ever writes its own counters, readers add up the memtype and all
+ * pthreads' pending counts in mt_count_sum().  Memory can be freed on another
+ * pthread than it was allocated on, so allocations and frees are counted
+ * separately and only ever go up.  The byte total is a difference and wraps
+ * around "below zero" for that.
+ */
+#define MT_FLUSH       64
+#define MT_FLUSH_BYTES 65536
+
+struct mt_count {
+	atomic_size_t n_alloc;
+	atomic_size_t n_free;
+	atomic_size_t total;
+};
+
+struct mt_thread {
+	struct mt_thread *next, **ref;
+
+	/* indexed by memtype->index, swapped under mt_threads_mtx */
+	struct mt_count *counts;
+	size_t cap;
+};
+
+static pthread_mutex_t mt_threads_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct mt_thread *mt_threads;
+
+#ifndef __OpenBSD__
+static void mt_thread_free(struct mt_thread *mtt);
+DEFINE_PTHREAD_LOCAL(mt_thread_tls, struct mt_thread, mt_thread_free);
+
+static void mt_count_flush(struct memtype *mt, size_t n_alloc, size_t n_free,
+			   size_t bytes);
+
+static int mt_thread_fold(void *arg, struct memgroup *mg, struct memtype *mt)
 {
-	size_t current;
-	size_t oldsize;
+	struct mt_thread *mtt = arg;
+	struct mt_count *cnt;
 
-	current = 1 + atomic_fetch_add_explicit(&mt->n_alloc, 1,
-						memory_order_relaxed);
+	if (!mt || mt->index >= mtt->cap)
+		return 0;
+
+	cnt = &mtt->counts[mt->index];
+	if (cnt->n_alloc || cnt->n_free || cnt->total)
+		mt_count_flush(mt, cnt->n_alloc, cnt->n_free, cnt->total);
+	return 0;
+}
+
+/* anything freed from other TLS destructors after this goes straight to the
+ * memtype, rather than resurrecting it
+ */
+static void mt_thread_free(struct mt_thread *mtt)
+{
+	pthread_mutex_lock(&mt_threads_mtx);
+	if (mtt->next)
+		mtt->next->ref = mtt->ref;
+	*mtt->ref = mtt->next;
+	qmem_walk(mt_thread_fold, mtt);
+	pthread_mutex_unlock(&mt_threads_mtx);
+
+	free(mtt->counts);
+	free(mtt);
+}
+
+static struct mt_count *mt_count_grow(struct memtype *mt)
+{
+	struct mt_thread *mtt = mt_thread_tls_get();
+	struct mt_count *counts, *old;
+	size_t cap;
+
+	if (!mt->index || mt_thread_tls_exited())
+		return NULL;
+
+	if (!mtt) {
+		/* plain libc allocations, can't recurse into ourselves */
+		mtt = calloc(1, sizeof(*mtt));
+		if (!mtt)
+			return NULL;
+
+		pthread_mutex_lock(&mt_threads_mtx);
+		mtt->ref = &mt_threads;
+		mtt->next = mt_threads;
+		if (mtt->next)
+			mtt->next->ref = &mtt->next;
+		mt_threads = mtt;
+		pthread_mutex_unlock(&mt_threads_mtx);
+
+		mt_thread_tls_set(mtt);
+	}
+
+	/* make room for all memtypes known so far, modules may add more */
+	cap = MAX(mt->index, mt_index_next) + 1;
+	cap = (cap + 63) & ~(size_t)63;
+
+	counts = calloc(cap, sizeof(*counts));
+	if (!counts)
+		return NULL;
+
+	pthread_mutex_lock(&mt_threads_mtx);
+	old = mtt->counts;
+	if (old)
+		memcpy(counts, old, mtt->cap * sizeof(*counts));
+	mtt->counts = counts;
+	mtt->cap = cap;
+	pthread_mutex_unlock(&mt_threads_mtx);
+
+	free(old);
+	return &counts[mt->index];
+}
+
+static inline struct mt_count *mt_count_get(struct memtype *mt)
+{
+	struct mt_thread *mtt = mt_thread_tls_get();
 
-	oldsize = atomic_load_explicit(&mt->n_max, memory_order_relaxed);
-	if (current > oldsize)
+	if (likely(mtt && mt->index && mt->index < mtt->cap))
+		return &mtt->counts[mt->index];
+	return mt_count_grow(mt);
+}
+#else /* __OpenBSD__ */
+/* no cheap TLS, count on the memtype directly */
+static inline struct mt_count *mt_count_get(struct memtype *mt)
+{
+	return NULL;
+}
+#endif
+
+static inline void mt_count_max(atomic_size_t *max, size_t current)
+{
+	size_t oldval;
+
+	/* still "negative" from frees on other pthreads */
+	if ((ssize_t)current < 0)
+		return;
+
+	oldval = atomic_load_explicit(max, memory_order_relaxed);
+	if (current > oldval)
 		/* note that this may fail, but approximation is sufficient */
-		atomic_compare_exchange_weak_explicit(&mt->n_max, &oldsize,
-						      current,
+		atomic_compare_exchange_weak_explicit(max, &oldval, current,
 						      memory_order_relaxed,
 						      memory_order_relaxed);
+}
+
+/*
+ * Pending frees are zeroed before they are added to the memtype, pending
+ * allocations only after.  Reading frees from the memtype first and
+ * allocations from it last, like mt_count_sum() does, can thus count an
+ * allocation twice or miss a free, but never the other way around.
+ */
+static void mt_count_flush(struct memtype *mt, size_t n_alloc, size_t n_free,
+			   size_t bytes)
+{
+	size_t current;
+
+	if (n_free)
+		atomic_fetch_add_explicit(&mt->n_free, n_free,
+					  memory_order_release);
+	if (n_alloc) {
+		current = n_alloc +
+			  atomic_fetch_add_explicit(&mt->n_alloc, n_alloc,
+						    memory_order_release);
+		current -= atomic_load_explicit(&mt->n_free,
+						memory_order_relaxed);
+		mt_count_max(&mt->n_max, current);
+	}
+
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	current = bytes + atomic_fetch_add_explicit(&mt->total, bytes,
+						    memory_order_relaxed);
+	mt_count_max(&mt->max_size, current);
+#endif
+}
+
+/* bytes are negated for frees */
+static inline void mt_count_add(struct memtype *mt, struct mt_count *cnt,
+				size_t n_alloc, size_t n_free, size_t bytes)
+{
+	size_t pend_alloc, pend_free, pend_bytes;
+
+	if (!cnt) {
+		mt_count_flush(mt, n_alloc, n_free, bytes);
+		return;
+	}
+
+	/* only this pthread writes to cnt, no RMW needed */
+	pend_alloc = n_alloc + atomic_load_explicit(&cnt->n_alloc,
+						    memory_order_relaxed);
+	pend_free = n_free + atomic_load_explicit(&cnt->n_free,
+						  memory_order_relaxed);
+	pend_bytes = bytes + atomic_load_explicit(&cnt->total,
+						  memory_order_relaxed);
+
+	if (pend_alloc < MT_FLUSH && pend_free < MT_FLUSH &&
+	    pend_bytes + MT_FLUSH_BYTES <= 2 * MT_FLUSH_BYTES) {
+		atomic_store_explicit(&cnt->n_alloc, pend_alloc,
+				      memory_order_release);
+		atomic_store_explicit(&cnt->n_free, pend_free,
+				      memory_order_release);
+		atomic_store_explicit(&cnt->total, pend_bytes,
+				      memory_order_relaxed);
+		return;
+	}
+
+	atomic_store_explicit(&cnt->n_free, 0, memory_order_release);
+	atomic_store_explicit(&cnt->total, 0, memory_order_relaxed);
+	mt_count_flush(mt, pend_alloc, pend_free, pend_bytes);
+	atomic_store_explicit(&cnt->n_alloc, 0, memory_order_release);
+}
+
+/*
+ * Everything that was allocated and freed before the call is in n_alloc and
+ * n_free, n_alloc may have some allocations twice and n_free may miss some
+ * frees that happen while adding up.  Any free counted has its allocation
+ * counted as well.
+ */
+static void mt_count_sum(struct memtype *mt, size_t *n_alloc, size_t *n_free,
+			 size_t *total)
+{
+	struct mt_thread *mtt;
+	size_t idx = mt->index;
+
+	*n_free = atomic_load_explicit(&mt->n_free, memory_order_acquire);
+	*n_alloc = 0;
+	*total = 0;
+
+	if (idx) {
+		pthread_mutex_lock(&mt_threads_mtx);
+		for (mtt = mt_threads; mtt; mtt = mtt->next)
+			if (idx < mtt->cap)
+				*n_free += atomic_load_explicit(
+					&mtt->counts[idx].n_free,
+					memory_order_acquire);
+		for (mtt = mt_threads; mtt; mtt = mtt->next) {
+			if (idx >= mtt->cap)
+				continue;
+			*n_alloc += atomic_load_explicit(
+				&mtt->counts[idx].n_alloc,
+				memory_order_acquire);
+			*total += atomic_load_explicit(&mtt->counts[idx].total,
+						       memory_order_relaxed);
+		}
+		pthread_mutex_unlock(&mt_threads_mtx);
+	}
+
+	*n_alloc += atomic_load_explicit(&mt->n_alloc, memory_order_acquire);
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	*total += atomic_load_explicit(&mt->total, memory_order_relaxed);
+#endif
+}
+
+/*
+ * Catch frees without a matching allocation.  The memtype and this pthread's
+ * own pending counts are enough unless other pthreads have allocations
+ * pending, only if that doesn't add up all of them are summed.  The memory
+ * being freed is counted as allocated there, so less than 1 left means more
+ * was freed than allocated.
+ */
+static inline void mt_count_check(struct memtype *mt, struct mt_count *cnt)
+{
+	size_t n_alloc, n_free, total;
+
+	n_alloc = atomic_load_explicit(&mt->n_alloc, memory_order_relaxed);
+	n_free = atomic_load_explicit(&mt->n_free, memory_order_relaxed);
+	if (cnt) {
+		n_alloc += atomic_load_explicit(&cnt->n_alloc,
+						memory_order_relaxed);
+		n_free += atomic_load_explicit(&cnt->n_free,
+					       memory_order_relaxed);
+	}
+	if (likely((ssize_t)(n_alloc - n_free) > 0))
+		return;
+
+	mt_count_sum(mt, &n_alloc, &n_free, &total);
+	assert((ssize_t)(n_alloc - n_free) > 0);
+}
+
+void mtype_stats(struct memtype *mt, struct mtype_stats *stats)
+{
+	size_t n_alloc, n_free, total;
+
+	mt_count_sum(mt, &n_alloc, &n_free, &total);
+	n_alloc -= n_free;
+
+	/* a pthread can be caught between zeroing its byte count and adding
+	 * it to the memtype
+	 */
+	if ((ssize_t)total < 0)
+		total = 0;
+
+	mt_count_max(&mt->n_max, n_alloc);
+	stats->n_alloc = n_alloc;
+	stats->n_max = atomic_load_explicit(&mt->n_max, memory_order_relaxed);
+	stats->size = atomic_load_explicit(&mt->size, memory_order_relaxed);
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	mt_count_max(&mt->max_size, total);
+	stats->total = total;
+	stats->max_size = atomic_load_explicit(&mt->max_size,
+					       memory_order_relaxed);
+#else
+	stats->total = 0;
+	stats->max_size = 0;
+#endif
+}
+
+size_t mtype_stats_alloc(struct memtype *mt)
+{
+	struct mtype_stats stats;
+
+	mtype_stats(mt, &stats);
+	return stats.n_alloc;
+}
+
+/* Sampled allocation site profiler:  roughly one in qmem_sample_rate
+ * allocations records its caller and size, and freeing the memory drops the
+ * record again.  What's left are the live allocations, scaled up by the rate.
+ * qmem_sample_filter counts records per pointer hash so frees of pointers
+ * that were never sampled don't need the lock.
+ */
+#define QMEM_SAMPLE_BITS 12
+#define QMEM_FILTER_BITS 14
+
+struct qmem_sample {
+	struct qmem_sample *next;
+
+	void *ptr;
+	const void *site;
+	struct memtype *mt;
+	size_t size;
+};
+
+static atomic_uint_fast32_t qmem_sample_rate;
+/* set once profiling has been enabled, never cleared */
+static atomic_bool qmem_sample_used;
+static atomic_uint_fast32_t qmem_sample_filter[1 << QMEM_FILTER_BITS];
+
+static pthread_mutex_t qmem_sample_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct qmem_sample *qmem_samples[1 << QMEM_SAMPLE_BITS];
+static size_t qmem_sample_count;
+
+#ifndef __OpenBSD__
+static thread_local uint32_t qmem_sample_countdown;
+static thread_local uint32_t qmem_sample_rand;
+#else
+/* no TLS; racy, but this only decides when to take a sample */
+static uint32_t qmem_sample_countdown;
+static uint32_t qmem_sample_rand;
+#endif
+
+static inline uint32_t qmem_sample_hash(const void *ptr, unsigned int bits)
+{
+	return ((uintptr_t)ptr * 0x9e3779b97f4a7c15ULL) >> (64 - bits);
+}
+
+static bool qmem_sample_tick(uint32_t rate, void *ptr)
+{
+	uint32_t x;
+
+	if (likely(qmem_sample_countdown > 1)) {
+		qmem_sample_countdown--;
+		return false;
+	}
+
+	/* xorshift32; randomize the interval so periodic allocation
+	 * patterns don't alias with the sampling
+	 */
+	x = qmem_sample_rand ?: (uint32_t)(uintptr_t)ptr | 1;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	qmem_sample_rand = x;
+	qmem_sample_countdown = 1 + x % (2 * rate - 1);
+	return true;
+}
+
+static void qmem_sample_add(struct memtype *mt, void *ptr, size_t size,
+			    const void *site)
+{
+	struct qmem_sample *smp;
+	uint32_t hash;
+
+	smp = malloc(sizeof(*smp));
+	if (!smp)
+		return;
+
+	smp->ptr = ptr;
+	smp->site = site;
+	smp->mt = mt;
+	smp->size = size;
+
+	hash = qmem_sample_hash(ptr, QMEM_SAMPLE_BITS);
+	pthread_mutex_lock(&qmem_sample_mtx);
+	smp->next = qmem_samples[hash];
+	qmem_samples[hash] = smp;
+	qmem_sample_count++;
+	atomic_fetch_add_explicit(
+		&qmem_sample_filter[qmem_sample_hash(ptr, QMEM_FILTER_BITS)], 1,
+		memory_order_relaxed);
+	pthread_mutex_unlock(&qmem_sample_mtx);
+}
+
+static void qmem_sample_del(void *ptr)
+{
+	struct qmem_sample *smp = NULL, **prev;
+	uint32_t fhash = qmem_sample_hash(ptr, QMEM_FILTER_BITS);
+
+	if (!atomic_load_explicit(&qmem_sample_filter[fhash],
+				  memory_order_relaxed))
+		return;
+
+	pthread_mutex_lock(&qmem_sample_mtx);
+	prev = &qmem_samples[qmem_sample_hash(ptr, QMEM_SAMPLE_BITS)];
+	for (; *prev; prev = &(*prev)->next) {
+		if ((*prev)->ptr != ptr)
+			continue;
+
+		smp = *prev;
+		*prev = smp->next;
+		qmem_sample_count--;
+		atomic_fetch_sub_explicit(&qmem_sample_filter[fhash], 1,
+					  memory_order_relaxed);
+		break;
+	}
+	pthread_mutex_unlock(&qmem_sample_mtx);
+
+	free(smp);
+}
+
+static void qmem_sample_clear(void)
+{
+	struct qmem_sample *smp;
+	size_t i;
+
+	pthread_mutex_lock(&qmem_sample_mtx);
+	for (i = 0; i < array_size(qmem_samples); i++)
+		while ((smp = qmem_samples[i])) {
+			qmem_samples[i] = smp->next;
+			free(smp);
+		}
+	for (i = 0; i < array_size(qmem_sample_filter); i++)
+		atomic_store_explicit(&qmem_sample_filter[i], 0,
+				      memory_order_relaxed);
+	qmem_sample_count = 0;
+	pthread_mutex_unlock(&qmem_sample_mtx);
+}
+
+void qmem_profile_set(unsigned int rate)
+{
+	if (rate == atomic_load_explicit(&qmem_sample_rate,
+					 memory_order_relaxed))
+		return;
+
+	if (rate)
+		atomic_store_explicit(&qmem_sample_used, true,
+				      memory_order_relaxed);
+	atomic_store_explicit(&qmem_sample_rate, rate, memory_order_relaxed);
+
+	/* samples taken at another rate would be scaled wrong */
+	qmem_sample_clear();
+}
+
+unsigned int qmem_profile_rate(void)
+{
+	return atomic_load_explicit(&qmem_sample_rate, memory_order_relaxed);
+}
+
+static int qmem_site_cmp(const void *a, const void *b)
+{
+	const struct qmem_site *sa = a, *sb = b;
+
+	if (sa->site != sb->site)
+		return sa->site < sb->site ? -1 : 1;
+	if (sa->mt != sb->mt)
+		return sa->mt < sb->mt ? -1 : 1;
+	return 0;
+}
+
+static int qmem_site_bytes_cmp(const void *a, const void *b)
+{
+	const struct qmem_site *sa = a, *sb = b;
+
+	if (sa->bytes != sb->bytes)
+		return sa->bytes > sb->bytes ? -1 : 1;
+	return qmem_site_cmp(a, b);
+}
+
+int qmem_profile_walk(qmem_profile_fn *func, void *arg)
+{
+	struct qmem_site *sites;
+	struct qmem_sample *smp;
+	size_t i, n = 0, nsites = 0;
+	unsigned int rate;
+	int rv = 0;
+
+	pthread_mutex_lock(&qmem_sample_mtx);
+	rate = atomic_load_explicit(&qmem_sample_rate, memory_order_relaxed);
+	sites = calloc(qmem_sample_count + 1, sizeof(*sites));
+	if (!sites) {
+		pthread_mutex_unlock(&qmem_sample_mtx);
+		return -1;
+	}
+	for (i = 0; i < array_size(qmem_samples); i++)
+		for (smp = qmem_samples[i]; smp; smp = smp->next) {
+			sites[n].site = smp->site;
+			sites[n].mt = smp->mt;
+			sites[n].count = 1;
+			sites[n].bytes = smp->size;
+			n++;
+		}
+	pthread_mutex_unlock(&qmem_sample_mtx);
+
+	qsort(sites, n, sizeof(*sites), qmem_site_cmp);
+	for (i = 0; i < n; i++) {
+		if (nsites && !qmem_site_cmp(&sites[nsites - 1], &sites[i])) {
+			sites[nsites - 1].count++;
+			sites[nsites - 1].bytes += sites[i].bytes;
+			continue;
+		}
+		sites[nsites++] = sites[i];
+	}
+	for (i = 0; i < nsites; i++) {
+		sites[i].count *= rate;
+		sites[i].bytes *= rate;
+	}
+	qsort(sites, nsites, sizeof(*sites), qmem_site_bytes_cmp);
+
+	for (i = 0; i < nsites; i++)
+		if ((rv = func(arg, &sites[i])))
+			break;
+
+	free(sites);
+	return rv;
+}
+
+static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr,
+				  const void *site)
+{
+	size_t oldsize;
+	size_t mallocsz = 0;
+	uint32_t rate;
 
 	oldsize = atomic_load_explicit(&mt->size, memory_order_relaxed);
 	if (oldsize == 0)
@@ -51,36 +580,42 @@ static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
 		atomic_store_explicit(&mt->size, SIZE_VAR,
 				      memory_order_relaxed);
 
+	if (mt->pool)
+		mallocsz = mt->pool->size;
 #ifdef HAVE_MALLOC_USABLE_SIZE
-	size_t mallocsz = malloc_usable_size(ptr);
-
-	current = mallocsz + atomic_fetch_add_explicit(&mt->total, mallocsz,
-						       memory_order_relaxed);
-	oldsize = atomic_load_explicit(&mt->max_size, memory_order_relaxed);
-	if (current > oldsize)
-		/* note that this may fail, but approximation is sufficient */
-		atomic_compare_exchange_weak_explicit(&mt->max_size, &oldsize,
-						      current,
-						      memory_order_relaxed,
-						      memory_order_relaxed);
+	else
+		mallocsz = malloc_usable_size(ptr);
 #endif
+	mt_count_add(mt, mt_count_get(mt), 1, 0, mallocsz);
+
+	rate = atomic_load_explicit(&qmem_sample_rate, memory_order_relaxed);
+	if (unlikely(rate) && qmem_sample_tick(rate, ptr))
+		qmem_sample_add(mt, ptr, size, site);
 }
 
 static inline void mt_count_free(struct memtype *mt, void *ptr)
 {
-	frrtrace(2, frr_libfrr, memfree, mt, ptr);
+	struct mt_count *cnt = mt_count_get(mt);
+	size_t mallocsz = 0;
 
-	assert(mt->n_alloc);
-	atomic_fetch_sub_explicit(&mt->n_alloc, 1, memory_order_relaxed);
+	frrtrace(2, frr_libfrr, memfree, mt, ptr);
 
+	if (mt->pool)
+		mallocsz = mt->pool->size;
 #ifdef HAVE_MALLOC_USABLE_SIZE
-	size_t mallocsz = malloc_usable_size(ptr);
-
-	atomic_fetch_sub_explicit(&mt->total, mallocsz, memory_order_relaxed);
+	else
+		mallocsz = malloc_usable_size(ptr);
 #endif
+	mt_count_check(mt, cnt);
+	mt_count_add(mt, cnt, 0, 1, -mallocsz);
+
+	if (unlikely(atomic_load_explicit(&qmem_sample_used,
+					  memory_order_relaxed)))
+		qmem_sample_del(ptr);
 }
 
-static inline void *mt_checkalloc(struct memtype *mt, void *ptr, size_t size)
+static inline void *mt_checkalloc(struct memtype *mt, void *ptr, size_t size,
+				  const void *site)
 {
 	frrtrace(3, frr_libfrr, memalloc, mt, ptr, size);
 
@@ -91,43 +626,75 @@ static inline void *mt_checkalloc(struct memtype *mt, void *ptr, size_t size)
 		}
 		return NULL;
 	}
-	mt_count_alloc(mt, size, ptr);
+	mt_count_alloc(mt, size, ptr, site);
 	return ptr;
 }
 
+static inline void *mt_poolalloc(struct memtype *mt, size_t size,
+				  const void *site)
+{
+	/* pooled memtypes only hold objects up to the pool's size */
+	assert(size <= mt->pool->size);
+
+	return mt_checkalloc(mt, mpool_alloc(mt->pool), size, site);
+}
+
 void *qmalloc(struct memtype *mt, size_t size)
 {
-	return mt_checkalloc(mt, malloc(size), size);
+	if (mt->pool)
+		return mt_poolalloc(mt, size, __builtin_return_address(0));
+	return mt_checkalloc(mt, malloc(size), size,
+			     __builtin_return_address(0));
 }
 
 void *qcalloc(struct memtype *mt, size_t size)
 {
-	return mt_checkalloc(mt, calloc(size, 1), size);
+	if (mt->pool)
+		return memset(mt_poolalloc(mt, size,
+					   __builtin_return_address(0)),
+			      0, size);
+	return mt_checkalloc(mt, calloc(size, 1), size,
+			     __builtin_return_address(0));
 }
 
 void *qrealloc(struct memtype *mt, void *ptr, size_t size)
 {
+	assert(!mt->pool);
+
 	if (ptr)
 		mt_count_free(mt, ptr);
-	return mt_checkalloc(mt, ptr ? realloc(ptr, size) : malloc(size), size);
+	return mt_checkalloc(mt, ptr ? realloc(ptr, size) : malloc(size), size,
+			     __builtin_return_address(0));
 }
 
 void *qstrdup(struct memtype *mt, const char *str)
 {
-	return str ? mt_checkalloc(mt, strdup(str), strlen(str) + 1) : NULL;
+	assert(!mt->pool);
+
+	return str ? mt_checkalloc(mt, strdup(str), strlen(str) + 1,
+				  __builtin_return_address(0))
+		   : NULL;
 }
 
 void qcountfree(struct memtype *mt, void *ptr)
 {
+	/* pool objects can't be handed to free() */
+	assert(!mt->pool);
+
 	if (ptr)
 		mt_count_free(mt, ptr);
 }
 
 void qfree(struct memtype *mt, void *ptr)
 {
-	if (ptr)
-		mt_count_free(mt, ptr);
-	free(ptr);
+	if (!ptr)
+		return;
+
+	mt_count_free(mt, ptr);
+	if (mt->pool)
+		mpool_free(mt->pool, ptr);
+	else
+		free(ptr);
 }
 
 int qmem_walk(qmem_walk_fn *func, void *arg)
@@ -155,20 +722,25 @@ struct exit_dump_args {
 static int qmem_exit_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 {
 	struct exit_dump_args *eda = arg;
+	struct mtype_stats stats;
 
 	if (!mt) {
 		fprintf(eda->fp,
 			"%s: showing active allocations in memory group %s\n",
 			eda->prefix, mg->name);
 
-	} else if (mt->n_alloc) {
+		return 0;
+	}
+
+	mtype_stats(mt, &stats);
+	if (stats.n_alloc) {
 		char size[32];
 		if (!mg->active_at_exit)
 			eda->error++;
-		snprintf(size, sizeof(size), "%10zu", mt->size);
+		snprintf(size, sizeof(size), "%10zu", stats.size);
 		fprintf(eda->fp, "%s: memstats:  %-30s: %6zu * %s\n",
-			eda->prefix, mt->name, mt->n_alloc,
-			mt->size == SIZE_VAR ? "(variably sized)" : size);
+			eda->prefix, mt->name, stats.n_alloc,
+			stats.size == SIZE_VAR ? "(variably sized)" : size);
 	}
 	return 0;
 }
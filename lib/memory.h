@@ -22,10 +22,21 @@ extern "C" {
 #endif
 
 #define SIZE_VAR ~0UL
+struct mpool;
+
 struct memtype {
 	struct memtype *next, **ref;
 	const char *name;
+	/* slot in the per-pthread counters, 0 if not assigned (yet) */
+	unsigned int index;
+	/* fixed size object pool backing this memtype, see mpool.h */
+	struct mpool *pool;
+	/* allocations and frees so far, these and total lag behind by what's
+	 * still pending in the per-pthread counters, use mtype_stats() to
+	 * read them
+	 */
 	atomic_size_t n_alloc;
+	atomic_size_t n_free;
 	atomic_size_t n_max;
 	atomic_size_t size;
 #ifdef HAVE_MALLOC_USABLE_SIZE
@@ -116,8 +127,10 @@ struct memgroup {
 	static void _mtinit_##mname(void) __attribute__((_CONSTRUCTOR(1001))); \
 	static void _mtinit_##mname(void)                                      \
 	{                                                                      \
+		extern unsigned int mt_index_next;                             \
 		if (_mg_##group.insert == NULL)                                \
 			_mg_##group.insert = &_mg_##group.types;               \
+		MTYPE_##mname->index = ++mt_index_next;                        \
 		MTYPE_##mname->ref = _mg_##group.insert;                       \
 		*_mg_##group.insert = MTYPE_##mname;                           \
 		_mg_##group.insert = &MTYPE_##mname->next;                      \
@@ -166,10 +179,39 @@ extern void qfree(struct memtype *mt, void *ptr) __attribute__((nonnull(1)));
 		ptr = NULL;                                                    \
 	} while (0)
 
-static inline size_t mtype_stats_alloc(struct memtype *mt)
-{
-	return mt->n_alloc;
-}
+/* counters of a memtype, including what other pthreads haven't flushed yet.
+ * Maxima are approximate.
+ */
+struct mtype_stats {
+	size_t n_alloc;
+	size_t n_max;
+	size_t size;
+	size_t total;
+	size_t max_size;
+};
+
+extern void mtype_stats(struct memtype *mt, struct mtype_stats *stats);
+extern size_t mtype_stats_alloc(struct memtype *mt);
+
+/* sampled allocation site profiling, "service memory-profile".  One in
+ * rate allocations records its caller, until the memory is freed again.
+ */
+#define QMEM_PROFILE_RATE_DEFAULT 1000
+
+struct qmem_site {
+	const void *site;
+	struct memtype *mt;
+	/* live allocations & bytes, extrapolated from the samples */
+	size_t count;
+	size_t bytes;
+};
+
+extern void qmem_profile_set(unsigned int rate);
+extern unsigned int qmem_profile_rate(void);
+
+/* calls are ordered by bytes, largest first */
+typedef int qmem_profile_fn(void *arg, const struct qmem_site *site);
+extern int qmem_profile_walk(qmem_profile_fn *func, void *arg);
 
 /* NB: calls are ordered by memgroup; and there is a call with mt == NULL for
  * each memgroup (so that a header can be printed, and empty memgroups show)
@@ -0,0 +1,323 @@
+// SPDX-License-Identifier: ISC
+/*
+ * Fixed size object pools for hot memtypes
+ */
+
+#include <zebra.h>
+
+#include <string.h>
+
+#include "mpool.h"
+#include "pthread_local.h"
+
+/* free objects are linked through their first bytes; the first object of a
+ * batch also links to the next batch
+ */
+struct mpool_obj {
+	struct mpool_obj *next;
+	struct mpool_obj *next_batch;
+};
+
+struct mpool_slab {
+	struct mpool_slab *next;
+	size_t size;
+};
+
+/* slabs are this big, or hold at least one batch */
+#define MPOOL_SLAB_SIZE 16384
+#define MPOOL_ALIGN	16
+#define MPOOL_SLAB_HDR                                                         \
+	((sizeof(struct mpool_slab) + MPOOL_ALIGN - 1) & ~(MPOOL_ALIGN - 1))
+
+static pthread_mutex_t mpools_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct mpool *mpools;
+static unsigned int mpool_index_next;
+
+void mpool_register(struct mpool *mp)
+{
+	mp->size = MAX(mp->size, sizeof(struct mpool_obj));
+	mp->size = (mp->size + MPOOL_ALIGN - 1) & ~(size_t)(MPOOL_ALIGN - 1);
+
+	pthread_mutex_lock(&mpools_mtx);
+	mp->index = ++mpool_index_next;
+	mp->ref = &mpools;
+	mp->next = mpools;
+	if (mp->next)
+		mp->next->ref = &mp->next;
+	mpools = mp;
+	pthread_mutex_unlock(&mpools_mtx);
+}
+
+void mpool_unregister(struct mpool *mp)
+{
+	pthread_mutex_lock(&mpools_mtx);
+	if (mp->next)
+		mp->next->ref = mp->ref;
+	*mp->ref = mp->next;
+	pthread_mutex_unlock(&mpools_mtx);
+}
+
+/* mp->mtx held */
+static void mpool_put_loose(struct mpool *mp, struct mpool_obj *head,
+			    struct mpool_obj *tail, size_t count)
+{
+	tail->next = mp->loose;
+	mp->loose = head;
+	mp->n_loose += count;
+}
+
+/* mp->mtx held; carve up a new slab into batches, handing out the first */
+static struct mpool_obj *mpool_grow(struct mpool *mp, size_t *count)
+{
+	struct mpool_slab *slab;
+	struct mpool_obj *objs[MPOOL_BATCH];
+	char *base;
+	size_t size, n, i, j, len;
+
+	n = (MPOOL_SLAB_SIZE - MPOOL_SLAB_HDR) / mp->size;
+	n = MAX(n, (size_t)MPOOL_BATCH);
+	size = MPOOL_SLAB_HDR + n * mp->size;
+
+	/* plain libc, the pool's memory is counted per object */
+	slab = malloc(size);
+	if (!slab)
+		memory_oom(size, mp->mt->name);
+
+	slab->size = size;
+	slab->next = mp->slabs;
+	mp->slabs = slab;
+	mp->n_slabs++;
+
+	/* back to front, so the first batch is the one handed out */
+	base = (char *)slab + MPOOL_SLAB_HDR;
+	for (i = (n - 1) / MPOOL_BATCH * MPOOL_BATCH;; i -= MPOOL_BATCH) {
+		len = MIN(n - i, (size_t)MPOOL_BATCH);
+		for (j = 0; j < len; j++)
+			objs[j] = (struct mpool_obj *)(base + (i + j) * mp->size);
+		for (j = 0; j < len; j++)
+			objs[j]->next = j + 1 < len ? objs[j + 1] : NULL;
+
+		if (i == 0)
+			break;
+
+		if (len < MPOOL_BATCH) {
+			mpool_put_loose(mp, objs[0], objs[len - 1], len);
+			continue;
+		}
+		objs[0]->next_batch = mp->batches;
+		mp->batches = objs[0];
+		mp->n_batches++;
+	}
+
+	*count = MPOOL_BATCH;
+	return objs[0];
+}
+
+/* mp->mtx held; returns a NULL terminated list of count objects */
+static struct mpool_obj *mpool_take(struct mpool *mp, size_t *count)
+{
+	struct mpool_obj *head, *obj;
+	size_t n;
+
+	if (mp->batches) {
+		head = mp->batches;
+		mp->batches = head->next_batch;
+		mp->n_batches--;
+		*count = MPOOL_BATCH;
+		return head;
+	}
+
+	if (!mp->loose)
+		return mpool_grow(mp, count);
+
+	head = obj = mp->loose;
+	for (n = 1; n < MPOOL_BATCH && obj->next; n++)
+		obj = obj->next;
+	mp->loose = obj->next;
+	mp->n_loose -= n;
+	obj->next = NULL;
+
+	*count = n;
+	return head;
+}
+
+#ifndef __OpenBSD__
+struct mpool_cache {
+	struct mpool_obj *head;
+	size_t count;
+};
+
+struct mpool_thread {
+	/* indexed by mpool->index */
+	struct mpool_cache *caches;
+	size_t cap;
+};
+
+static void mpool_thread_free(struct mpool_thread *mpt);
+DEFINE_PTHREAD_LOCAL(mpool_thread_tls, struct mpool_thread, mpool_thread_free);
+
+/* frees from other TLS destructors after this go straight to the pools */
+static void mpool_thread_free(struct mpool_thread *mpt)
+{
+	struct mpool_cache *cache;
+	struct mpool_obj *tail;
+	struct mpool *mp;
+
+	pthread_mutex_lock(&mpools_mtx);
+	for (mp = mpools; mp; mp = mp->next) {
+		if (mp->index >= mpt->cap)
+			continue;
+		cache = &mpt->caches[mp->index];
+		if (!cache->head)
+			continue;
+
+		for (tail = cache->head; tail->next; tail = tail->next)
+			;
+		pthread_mutex_lock(&mp->mtx);
+		mpool_put_loose(mp, cache->head, tail, cache->count);
+		pthread_mutex_unlock(&mp->mtx);
+	}
+	pthread_mutex_unlock(&mpools_mtx);
+
+	free(mpt->caches);
+	free(mpt);
+}
+
+static struct mpool_cache *mpool_cache_grow(struct mpool *mp)
+{
+	struct mpool_thread *mpt = mpool_thread_tls_get();
+	struct mpool_cache *caches;
+	size_t cap;
+
+	if (mpool_thread_tls_exited())
+		return NULL;
+
+	if (!mpt) {
+		mpt = calloc(1, sizeof(*mpt));
+		if (!mpt)
+			return NULL;
+		mpool_thread_tls_set(mpt);
+	}
+
+	/* only this pthread looks at its caches until it exits */
+	cap = MAX(mp->index, mpool_index_next) + 1;
+	cap = (cap + 15) & ~(size_t)15;
+	caches = realloc(mpt->caches, cap * sizeof(*caches));
+	if (!caches)
+		return NULL;
+	memset(caches + mpt->cap, 0, (cap - mpt->cap) * sizeof(*caches));
+	mpt->caches = caches;
+	mpt->cap = cap;
+	return &caches[mp->index];
+}
+
+static inline struct mpool_cache *mpool_cache_get(struct mpool *mp)
+{
+	struct mpool_thread *mpt = mpool_thread_tls_get();
+
+	if (likely(mpt && mp->index < mpt->cap))
+		return &mpt->caches[mp->index];
+	return mpool_cache_grow(mp);
+}
+#else /* __OpenBSD__ */
+/* no cheap TLS, always go to the pool */
+struct mpool_cache {
+	struct mpool_obj *head;
+	size_t count;
+};
+
+static inline struct mpool_cache *mpool_cache_get(struct mpool *mp)
+{
+	return NULL;
+}
+#endif
+
+void *mpool_alloc(struct mpool *mp)
+{
+	struct mpool_cache *cache = mpool_cache_get(mp);
+	struct mpool_obj *obj, *tail;
+	size_t count;
+
+	if (unlikely(!cache)) {
+		pthread_mutex_lock(&mp->mtx);
+		obj = mpool_take(mp, &count);
+		if (obj->next) {
+			for (tail = obj->next; tail->next; tail = tail->next)
+				;
+			mpool_put_loose(mp, obj->next, tail, count - 1);
+		}
+		pthread_mutex_unlock(&mp->mtx);
+		return obj;
+	}
+
+	if (unlikely(!cache->head)) {
+		pthread_mutex_lock(&mp->mtx);
+		cache->head = mpool_take(mp, &cache->count);
+		pthread_mutex_unlock(&mp->mtx);
+	}
+
+	obj = cache->head;
+	cache->head = obj->next;
+	cache->count--;
+	return obj;
+}
+
+void mpool_free(struct mpool *mp, void *ptr)
+{
+	struct mpool_cache *cache = mpool_cache_get(mp);
+	struct mpool_obj *obj = ptr, *tail;
+	size_t i;
+
+	if (unlikely(!cache)) {
+		pthread_mutex_lock(&mp->mtx);
+		mpool_put_loose(mp, obj, obj, 1);
+		pthread_mutex_unlock(&mp->mtx);
+		return;
+	}
+
+	obj->next = cache->head;
+	cache->head = obj;
+	if (likely(++cache->count < 2 * MPOOL_BATCH))
+		return;
+
+	/* hand a batch back to the pool in one go, keeping the most
+	 * recently freed objects since they're likely still in cache
+	 */
+	for (tail = cache->head, i = 1; i < MPOOL_BATCH; i++)
+		tail = tail->next;
+	obj = tail->next;
+	tail->next = NULL;
+	cache->count -= MPOOL_BATCH;
+
+	pthread_mutex_lock(&mp->mtx);
+	obj->next_batch = mp->batches;
+	mp->batches = obj;
+	mp->n_batches++;
+	pthread_mutex_unlock(&mp->mtx);
+}
+
+int mpool_walk(mpool_walk_fn *func, void *arg)
+{
+	struct mpool_stats stats;
+	struct mpool_slab *slab;
+	struct mpool *mp;
+	int rv = 0;
+
+	pthread_mutex_lock(&mpools_mtx);
+	for (mp = mpools; mp; mp = mp->next) {
+		memset(&stats, 0, sizeof(stats));
+
+		pthread_mutex_lock(&mp->mtx);
+		stats.size = mp->size;
+		stats.n_slabs = mp->n_slabs;
+		for (slab = mp->slabs; slab; slab = slab->next)
+			stats.reserved += slab->size;
+		stats.n_free = mp->n_batches * MPOOL_BATCH + mp->n_loose;
+		pthread_mutex_unlock(&mp->mtx);
+
+		if ((rv = func(arg, mp, &stats)))
+			break;
+	}
+	pthread_mutex_unlock(&mpools_mtx);
+	return rv;
+}
@@ -0,0 +1,117 @@
+// SPDX-License-Identifier: ISC
+/*
+ * Fixed size object pools for hot memtypes
+ */
+
+#ifndef _FRR_MPOOL_H
+#define _FRR_MPOOL_H
+
+#include <pthread.h>
+
+#include "memory.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A memtype can be backed by a pool of fixed size objects, carved from
+ * larger slabs.  Each pthread keeps a small cache of free objects per pool,
+ * which is refilled from and spilled to the pool in batches, so most
+ * allocations and frees touch neither malloc nor a lock.  Slabs are not
+ * returned to the system until the pool goes away.
+ *
+ * macro usage:
+ *
+ *   DEFINE_MTYPE_STATIC(MYDAEMON, MYDAEMON_ITEM, "my item");
+ *   DEFINE_MPOOL(MYDAEMON_ITEM, sizeof(struct my_item));
+ *
+ *   item = XCALLOC(MTYPE_MYDAEMON_ITEM, sizeof(*item));
+ *   XFREE(MTYPE_MYDAEMON_ITEM, item);
+ *
+ * All allocations of a pooled memtype must fit in the object size given
+ * here, and must be freed with XFREE.  XREALLOC, XSTRDUP and XCOUNTFREE
+ * can't be used on them.  Builds with AddressSanitizer leave the pool
+ * disabled, so memory errors are still caught.
+ */
+
+struct mpool_slab;
+struct mpool_obj;
+
+struct mpool {
+	struct mpool *next, **ref;
+	struct memtype *mt;
+	/* object size, rounded up for alignment */
+	size_t size;
+	/* slot in the per-pthread caches */
+	unsigned int index;
+
+	pthread_mutex_t mtx;
+	/* free objects not cached by any pthread, in batches of
+	 * MPOOL_BATCH objects, plus what didn't fill a batch
+	 */
+	struct mpool_obj *batches, *loose;
+	size_t n_batches, n_loose;
+	struct mpool_slab *slabs;
+	size_t n_slabs;
+};
+
+#define MPOOL_BATCH 32
+
+#if defined(__SANITIZE_ADDRESS__)
+#define MPOOL_DISABLED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define MPOOL_DISABLED 1
+#endif
+#endif
+
+#ifdef MPOOL_DISABLED
+#define MPOOL_ATTACH(mname) do { } while (0)
+#else
+#define MPOOL_ATTACH(mname) MTYPE_##mname->pool = &_mp_##mname
+#endif
+
+#define DEFINE_MPOOL(mname, objsize)                                           \
+	static struct mpool _mp_##mname = {                                    \
+		.mt = MTYPE_##mname,                                           \
+		.size = (objsize),                                             \
+		.mtx = PTHREAD_MUTEX_INITIALIZER,                              \
+	};                                                                     \
+	static void _mpinit_##mname(void) __attribute__((_CONSTRUCTOR(1002))); \
+	static void _mpinit_##mname(void)                                      \
+	{                                                                      \
+		mpool_register(&_mp_##mname);                                  \
+		MPOOL_ATTACH(mname);                                           \
+	}                                                                      \
+	static void _mpfini_##mname(void) __attribute__((_DESTRUCTOR(1002)));  \
+	static void _mpfini_##mname(void)                                      \
+	{                                                                      \
+		mpool_unregister(&_mp_##mname);                                \
+	}                                                                      \
+	MACRO_REQUIRE_SEMICOLON() /* end */
+
+extern void mpool_register(struct mpool *mp);
+extern void mpool_unregister(struct mpool *mp);
+
+/* only for use by qmalloc() & co., these don't count the allocation */
+extern void *mpool_alloc(struct mpool *mp);
+extern void mpool_free(struct mpool *mp, void *ptr);
+
+struct mpool_stats {
+	size_t size;
+	size_t n_slabs;
+	/* bytes taken from malloc */
+	size_t reserved;
+	/* free objects held by the pool, not counting pthread caches */
+	size_t n_free;
+};
+
+typedef int mpool_walk_fn(void *arg, struct mpool *mp,
+			  const struct mpool_stats *stats);
+extern int mpool_walk(mpool_walk_fn *func, void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_MPOOL_H */
@@ -7,6 +7,7 @@
 #include "prefix.h"
 #include "table.h"
 #include "memory.h"
+#include "mpool.h"
 #include "command.h"
 #include "log.h"
 #include "sockunion.h"
@@ -23,6 +24,8 @@ DEFINE_MTYPE_STATIC(LIB, NEXTHOP, "Nexthop");
 DEFINE_MTYPE_STATIC(LIB, NH_LABEL, "Nexthop label");
 DEFINE_MTYPE_STATIC(LIB, NH_SRV6, "Nexthop srv6");
 
+DEFINE_MPOOL(NEXTHOP, sizeof(struct nexthop));
+
 static int _nexthop_labels_cmp(const struct nexthop *nh1,
 			       const struct nexthop *nh2)
 {
@@ -459,6 +459,32 @@ uint32_t nexthop_group_hash(const struct nexthop_group *nhg)
 	return key;
 }
 
+uint64_t nexthop_group_fingerprint(const struct nexthop_group *nhg)
+{
+	struct nexthop *nh;
+	uint32_t lo = 0x2e0b9a1f, hi = 0x61c88647;
+	uint32_t key, active;
+
+	/*
+	 * Two independently seeded chains, so that a collision of the low
+	 * half (which is what ends up as the hash key) rarely collides in the
+	 * high half as well.
+	 */
+	for (ALL_NEXTHOPS_PTR(nhg, nh)) {
+		key = nexthop_hash(nh);
+		active = !nh->rparent &&
+			 CHECK_FLAG(nh->flags, NEXTHOP_FLAG_ACTIVE);
+
+		lo = jhash_2words(key, active, lo);
+		hi = jhash_3words(key, nh->ifindex, nh->type | active << 8, hi);
+	}
+
+	lo = jhash_3words(nhg->nhgr.buckets, nhg->nhgr.idle_timer,
+			  nhg->nhgr.unbalanced_timer, lo);
+
+	return ((uint64_t)hi << 32) | lo;
+}
+
 void nexthop_group_mark_duplicates(struct nexthop_group *nhg)
 {
 	struct nexthop *nexthop, *prev;
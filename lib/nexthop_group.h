@@ -53,6 +53,14 @@ void copy_nexthops(struct nexthop **tnh, const struct nexthop *nh,
 
 uint32_t nexthop_group_hash_no_recurse(const struct nexthop_group *nhg);
 uint32_t nexthop_group_hash(const struct nexthop_group *nhg);
+
+/*
+ * 64-bit fingerprint over everything nexthop_group_hash() covers, plus the
+ * ACTIVE flag of the top level nexthops and the resilience parameters.
+ * Groups that compare equal always have the same fingerprint, so users may
+ * cache it and compare fingerprints before walking the nexthop lists.
+ */
+uint64_t nexthop_group_fingerprint(const struct nexthop_group *nhg);
 void nexthop_group_mark_duplicates(struct nexthop_group *nhg);
 
 /* Add a nexthop to a list, enforcing the canonical sort order. */
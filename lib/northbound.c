@@ -1124,13 +1124,20 @@ void nb_candidate_commit_abort(struct nb_transaction *transaction, char *errmsg,
 	nb_transaction_free(transaction);
 }
 
+DEFINE_HOOK(nb_transaction_apply_start, (struct nb_transaction *transaction),
+	    (transaction));
+DEFINE_KOOH(nb_transaction_apply_end, (struct nb_transaction *transaction),
+	    (transaction));
+
 void nb_candidate_commit_apply(struct nb_transaction *transaction,
 			       bool save_transaction, uint32_t *transaction_id,
 			       char *errmsg, size_t errmsg_len)
 {
+	hook_call(nb_transaction_apply_start, transaction);
 	(void)nb_transaction_process(NB_EV_APPLY, transaction, errmsg,
 				     errmsg_len);
 	nb_transaction_apply_finish(transaction, errmsg, errmsg_len);
+	hook_call(nb_transaction_apply_end, transaction);
 
 	/* Replace running by candidate. */
 	transaction->config->version++;
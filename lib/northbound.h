@@ -802,6 +802,16 @@ DECLARE_HOOK(nb_notification_tree_send,
 DECLARE_HOOK(nb_client_debug_config_write, (struct vty *vty), (vty));
 DECLARE_HOOK(nb_client_debug_set_all, (uint32_t flags, bool set), (flags, set));
 
+/*
+ * Called around the 'apply' phase of a transaction, including the
+ * 'apply_finish' callbacks, so work triggered by the individual changes can
+ * be done once for the whole transaction.
+ */
+DECLARE_HOOK(nb_transaction_apply_start, (struct nb_transaction *transaction),
+	     (transaction));
+DECLARE_KOOH(nb_transaction_apply_end, (struct nb_transaction *transaction),
+	     (transaction));
+
 /* Northbound debugging records */
 extern struct debug nb_dbg_cbs_config;
 extern struct debug nb_dbg_cbs_state;
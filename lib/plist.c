@@ -65,6 +65,15 @@ static int prefix_list_compare_func(const struct prefix_list *a,
 DECLARE_RBTREE_UNIQ(plist, struct prefix_list, plist_item,
 		    prefix_list_compare_func);
 
+DECLARE_DLIST(plist_batch, struct prefix_list, batch_item);
+
+/* prefix_list->batch_flags */
+#define PLIST_BATCH_ADDED	(1 << 0)
+#define PLIST_BATCH_DELETED	(1 << 1)
+
+static unsigned int plist_batch_depth;
+static struct plist_batch_head plist_batch[1] = {INIT_DLIST(plist_batch[0])};
+
 /* Static structure of IPv4 prefix_list's master. */
 static struct prefix_master prefix_master_ipv4 = {
 	NULL, NULL, NULL, PLC_MAXLEVELV4,
@@ -207,6 +216,13 @@ struct prefix_list *prefix_list_get(afi_t afi, int orf, const char *name)
 
 static void prefix_list_trie_del(struct prefix_list *plist,
 				 struct prefix_list_entry *pentry);
+static void prefix_list_trie_build(struct prefix_list *plist);
+
+static inline void prefix_list_trie_sync(struct prefix_list *plist)
+{
+	if (unlikely(plist->trie_stale))
+		prefix_list_trie_build(plist);
+}
 
 /* Delete prefix-list from prefix_list_master and free it. */
 void prefix_list_delete(struct prefix_list *plist)
@@ -229,6 +245,10 @@ void prefix_list_delete(struct prefix_list *plist)
 
 	plist_del(&master->str, plist);
 
+	/* notified below, not in prefix_list_batch_end() */
+	if (plist->batch_flags)
+		plist_batch_del(plist_batch, plist);
+
 	XFREE(MTYPE_TMP, plist->desc);
 
 	/* Make sure master's recent changed prefix-list information is
@@ -382,6 +402,10 @@ static void prefix_list_trie_del(struct prefix_list *plist,
 	size_t validbits = pentry->prefix.prefixlen;
 	struct pltrie_table *table, **tables[PLC_MAXLEVEL];
 
+	/* nothing was put in the trie yet */
+	if (plist->trie_stale)
+		return;
+
 	table = plist->trie;
 	for (depth = 0; validbits > PLC_BITS && depth < maxdepth - 1; depth++) {
 		uint8_t byte = bytes[depth];
@@ -412,9 +436,12 @@ static bool prefix_list_entry_is_duplicated(struct prefix_list *list,
 	size_t depth, maxdepth = list->master->trie_depth;
 	uint8_t byte, *bytes = entry->prefix.u.val;
 	size_t validbits = entry->prefix.prefixlen;
-	struct pltrie_table *table = list->trie;
+	struct pltrie_table *table;
 	struct prefix_list_entry *pentry;
 
+	prefix_list_trie_sync(list);
+
+	table = list->trie;
 	for (depth = 0; validbits > PLC_BITS && depth < maxdepth - 1; depth++) {
 		byte = bytes[depth];
 		if (!table->entries[byte].next_table)
@@ -440,6 +467,20 @@ static bool prefix_list_entry_is_duplicated(struct prefix_list *list,
 	return false;
 }
 
+/* Returns true if notifying route-maps and running the hook for this change
+ * is left to prefix_list_batch_end().
+ */
+static bool prefix_list_batch_defer(struct prefix_list *plist, uint8_t flag)
+{
+	if (!plist_batch_depth)
+		return false;
+
+	if (!plist->batch_flags)
+		plist_batch_add_tail(plist_batch, plist);
+	SET_FLAG(plist->batch_flags, flag);
+	return true;
+}
+
 void prefix_list_entry_delete(struct prefix_list *plist,
 			      struct prefix_list_entry *pentry,
 			      int update_list)
@@ -471,10 +512,12 @@ void prefix_list_entry_delete(struct prefix_list *plist,
 	plist->count--;
 
 	if (update_list) {
-		route_map_notify_dependencies(plist->name,
-					      RMAP_EVENT_PLIST_DELETED);
-		if (plist->master->delete_hook)
-			(*plist->master->delete_hook)(plist);
+		if (!prefix_list_batch_defer(plist, PLIST_BATCH_DELETED)) {
+			route_map_notify_dependencies(plist->name,
+						      RMAP_EVENT_PLIST_DELETED);
+			if (plist->master->delete_hook)
+				(*plist->master->delete_hook)(plist);
+		}
 
 		if (plist->head == NULL && plist->tail == NULL
 		    && plist->desc == NULL)
@@ -514,6 +557,14 @@ static void prefix_list_trie_add(struct prefix_list *plist,
 	size_t validbits = pentry->prefix.prefixlen;
 	struct pltrie_table *table;
 
+	/* a list filled from empty in a batch gets its trie built in one go
+	 * when it's needed, see prefix_list_trie_build()
+	 */
+	if (plist_batch_depth && !plist->count)
+		plist->trie_stale = true;
+	if (plist->trie_stale)
+		return;
+
 	table = plist->trie;
 	while (validbits > PLC_BITS && depth > 1) {
 		if (!table->entries[*bytes].next_table)
@@ -529,6 +580,34 @@ static void prefix_list_trie_add(struct prefix_list *plist,
 	trie_walk_affected(validbits, table, *bytes, pentry, trie_install_fn);
 }
 
+/* Going by ascending prefix length and descending sequence number puts each
+ * entry at the head of the chains it goes on, so trie_install_fn() doesn't
+ * need to walk them.  next_best is unused until then and serves as the link
+ * for sorting.
+ */
+static void prefix_list_trie_build(struct prefix_list *plist)
+{
+	struct prefix_list_entry *bylen[IPV6_MAX_BITLEN + 1] = {};
+	struct prefix_list_entry *pentry;
+	size_t len;
+
+	plist->trie_stale = false;
+
+	for (pentry = plist->head; pentry; pentry = pentry->next) {
+		len = pentry->prefix.prefixlen;
+		pentry->next_best = bylen[len];
+		bylen[len] = pentry;
+	}
+
+	for (len = 0; len < array_size(bylen); len++) {
+		while ((pentry = bylen[len])) {
+			bylen[len] = pentry->next_best;
+			pentry->next_best = NULL;
+			prefix_list_trie_add(plist, pentry);
+		}
+	}
+}
+
 static void prefix_list_entry_add(struct prefix_list *plist,
 				  struct prefix_list_entry *pentry)
 {
@@ -579,14 +658,17 @@ static void prefix_list_entry_add(struct prefix_list *plist,
 	/* Increment count. */
 	plist->count++;
 
-	route_map_notify_pentry_dependencies(plist->name, pentry,
-					     RMAP_EVENT_PLIST_ADDED);
+	if (!prefix_list_batch_defer(plist, PLIST_BATCH_ADDED)) {
+		route_map_notify_pentry_dependencies(plist->name, pentry,
+						     RMAP_EVENT_PLIST_ADDED);
 
-	/* Run hook function. */
-	if (plist->master->add_hook)
-		(*plist->master->add_hook)(plist);
+		/* Run hook function. */
+		if (plist->master->add_hook)
+			(*plist->master->add_hook)(plist);
 
-	route_map_notify_dependencies(plist->name, RMAP_EVENT_PLIST_ADDED);
+		route_map_notify_dependencies(plist->name,
+					      RMAP_EVENT_PLIST_ADDED);
+	}
 	plist->master->recent = plist;
 }
 
@@ -625,9 +707,12 @@ void prefix_list_entry_update_start(struct prefix_list_entry *ple)
 						     RMAP_EVENT_PLIST_DELETED);
 	pl->count--;
 
-	route_map_notify_dependencies(pl->name, RMAP_EVENT_PLIST_DELETED);
-	if (pl->master->delete_hook)
-		(*pl->master->delete_hook)(pl);
+	if (!prefix_list_batch_defer(pl, PLIST_BATCH_DELETED)) {
+		route_map_notify_dependencies(pl->name,
+					      RMAP_EVENT_PLIST_DELETED);
+		if (pl->master->delete_hook)
+			(*pl->master->delete_hook)(pl);
+	}
 
 	if (pl->head || pl->tail || pl->desc)
 		pl->master->recent = pl;
@@ -694,14 +779,17 @@ void prefix_list_entry_update_finish(struct prefix_list_entry *ple)
 	prefix_list_trie_add(pl, ple);
 	pl->count++;
 
-	route_map_notify_pentry_dependencies(pl->name, ple,
-					     RMAP_EVENT_PLIST_ADDED);
+	if (!prefix_list_batch_defer(pl, PLIST_BATCH_ADDED)) {
+		route_map_notify_pentry_dependencies(pl->name, ple,
+						     RMAP_EVENT_PLIST_ADDED);
 
-	/* Run hook function. */
-	if (pl->master->add_hook)
-		(*pl->master->add_hook)(pl);
+		/* Run hook function. */
+		if (pl->master->add_hook)
+			(*pl->master->add_hook)(pl);
 
-	route_map_notify_dependencies(pl->name, RMAP_EVENT_PLIST_ADDED);
+		route_map_notify_dependencies(pl->name,
+					      RMAP_EVENT_PLIST_ADDED);
+	}
 	pl->master->recent = pl;
 
 	ple->installed = true;
@@ -722,6 +810,53 @@ void prefix_list_entry_delete2(struct prefix_list_entry *ple)
 	prefix_list_entry_free(ple);
 }
 
+void prefix_list_batch_start(void)
+{
+	plist_batch_depth++;
+}
+
+/* Users re-check the whole list on any notification, so one is enough even
+ * if entries were both added and removed.
+ */
+static void prefix_list_batch_flush(struct prefix_list *plist)
+{
+	struct prefix_master *master = plist->master;
+	uint8_t flags = plist->batch_flags;
+
+	plist->batch_flags = 0;
+	prefix_list_trie_sync(plist);
+
+	if (CHECK_FLAG(flags, PLIST_BATCH_ADDED)) {
+		if (plist->count)
+			route_map_notify_plist_dependencies(
+				plist->name, prefix_list_afi(plist));
+
+		if (master->add_hook)
+			(*master->add_hook)(plist);
+
+		route_map_notify_dependencies(plist->name,
+					      RMAP_EVENT_PLIST_ADDED);
+	} else {
+		route_map_notify_dependencies(plist->name,
+					      RMAP_EVENT_PLIST_DELETED);
+
+		if (master->delete_hook)
+			(*master->delete_hook)(plist);
+	}
+}
+
+void prefix_list_batch_end(void)
+{
+	struct prefix_list *plist;
+
+	assert(plist_batch_depth);
+	if (--plist_batch_depth)
+		return;
+
+	while ((plist = plist_batch_pop(plist_batch)))
+		prefix_list_batch_flush(plist);
+}
+
 /* Return string of prefix_list_type. */
 static const char *prefix_list_type_str(struct prefix_list_entry *pentry)
 {
@@ -792,6 +927,8 @@ enum prefix_list_type prefix_list_apply_ext(
 		return PREFIX_PERMIT;
 	}
 
+	prefix_list_trie_sync(plist);
+
 	depth = plist->master->trie_depth;
 	table = plist->trie;
 	while (1) {
@@ -884,6 +1021,8 @@ prefix_entry_dup_check(struct prefix_list *plist, struct prefix_list_entry *new)
 	else
 		seq = new->seq;
 
+	prefix_list_trie_sync(plist);
+
 	table = plist->trie;
 	for (depth = 0; validbits > PLC_BITS && depth < maxdepth - 1; depth++) {
 		byte = bytes[depth];
@@ -1687,6 +1826,18 @@ static void prefix_list_init_ipv6(void)
 	install_element(ENABLE_NODE, &clear_ipv6_prefix_list_cmd);
 }
 
+static int prefix_list_nb_apply_start(struct nb_transaction *transaction)
+{
+	prefix_list_batch_start();
+	return 0;
+}
+
+static int prefix_list_nb_apply_end(struct nb_transaction *transaction)
+{
+	prefix_list_batch_end();
+	return 0;
+}
+
 void prefix_list_init(void)
 {
 	plist_init(&prefix_master_ipv4.str);
@@ -1696,6 +1847,9 @@ void prefix_list_init(void)
 
 	cmd_variable_handler_register(plist_var_handlers);
 
+	hook_register(nb_transaction_apply_start, prefix_list_nb_apply_start);
+	hook_register(nb_transaction_apply_end, prefix_list_nb_apply_end);
+
 	prefix_list_init_ipv4();
 	prefix_list_init_ipv6();
 }
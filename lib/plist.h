@@ -37,6 +37,16 @@ extern void prefix_list_reset(void);
 extern void prefix_list_add_hook(void (*func)(struct prefix_list *));
 extern void prefix_list_delete_hook(void (*func)(struct prefix_list *));
 
+/* Batched updates:  between prefix_list_batch_start() and _end(), adding or
+ * removing prefix-list entries doesn't notify route-maps or run the add /
+ * delete hooks;  _end() does that once for each changed prefix-list.  The
+ * lookup trie of a list filled from empty is built in one go, either on its
+ * first use or in _end().  Calls nest;  northbound commits (and thus config
+ * file loading) are batched automatically.
+ */
+extern void prefix_list_batch_start(void);
+extern void prefix_list_batch_end(void);
+
 extern const char *prefix_list_name(struct prefix_list *);
 extern afi_t prefix_list_afi(struct prefix_list *);
 extern struct prefix_list *prefix_list_lookup(afi_t, const char *);
@@ -14,6 +14,7 @@ extern "C" {
 struct pltrie_table;
 
 PREDECL_RBTREE_UNIQ(plist);
+PREDECL_DLIST(plist_batch);
 
 struct prefix_list {
 	char *name;
@@ -30,6 +31,12 @@ struct prefix_list {
 	struct prefix_list_entry *tail;
 
 	struct pltrie_table *trie;
+
+	/* changes not yet notified, see prefix_list_batch_start() */
+	struct plist_batch_item batch_item;
+	uint8_t batch_flags;
+	/* entries haven't been added to the trie yet */
+	bool trie_stale;
 };
 
 /* Each prefix-list's entry. */
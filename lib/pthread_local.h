@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: ISC
+/*
+ * Per-pthread pointers with a destructor
+ */
+
+#ifndef _FRR_PTHREAD_LOCAL_H
+#define _FRR_PTHREAD_LOCAL_H
+
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "compiler.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A pointer kept per pthread, handed to a destructor when the pthread exits.
+ * Proper ELF TLS is a good bit faster than pthread_getspecific(), so it is
+ * used where available, with a pthread key only for the destructor.
+ *
+ * macro usage:
+ *
+ *   static void my_state_free(struct my_state *st);
+ *   DEFINE_PTHREAD_LOCAL(my_state_tls, struct my_state, my_state_free);
+ *
+ *   st = my_state_tls_get();
+ *   if (!st && !my_state_tls_exited()) {
+ *       st = calloc(1, sizeof(*st));
+ *       my_state_tls_set(st);
+ *   }
+ *
+ * The pointer is cleared before the destructor runs.  Anything running after
+ * that on the exiting pthread (e.g. other TLS destructors) should check
+ * _exited() rather than set up new state, since nothing would free it.
+ * OpenBSD has no cheap TLS, the key is used directly there and _exited() is
+ * always false.
+ */
+
+#ifndef __OpenBSD__
+# ifndef thread_local
+#  define thread_local __thread
+# endif
+
+#define DEFINE_PTHREAD_LOCAL(name, type, dtor)                                 \
+	static pthread_key_t name##_key;                                       \
+	static thread_local type *name##_var                                   \
+		__attribute__((tls_model("initial-exec")));                    \
+	static thread_local bool name##_gone                                   \
+		__attribute__((tls_model("initial-exec")));                    \
+	static void name##_key_free(void *arg)                                 \
+	{                                                                      \
+		name##_var = NULL;                                             \
+		name##_gone = true;                                            \
+		dtor((type *)arg);                                             \
+	}                                                                      \
+	static inline type *name##_get(void)                                   \
+	{                                                                      \
+		return name##_var;                                             \
+	}                                                                      \
+	static inline bool name##_exited(void)                                 \
+	{                                                                      \
+		return name##_gone;                                            \
+	}                                                                      \
+	static inline void name##_set(type *val)                               \
+	{                                                                      \
+		pthread_setspecific(name##_key, val);                          \
+		name##_var = val;                                              \
+	}                                                                      \
+	_DEFINE_PTHREAD_LOCAL_KEY(name) /* end */
+#else
+#define DEFINE_PTHREAD_LOCAL(name, type, dtor)                                 \
+	static pthread_key_t name##_key;                                       \
+	static void name##_key_free(void *arg)                                 \
+	{                                                                      \
+		dtor((type *)arg);                                             \
+	}                                                                      \
+	static inline type *name##_get(void)                                   \
+	{                                                                      \
+		return pthread_getspecific(name##_key);                        \
+	}                                                                      \
+	static inline bool name##_exited(void)                                 \
+	{                                                                      \
+		return false;                                                  \
+	}                                                                      \
+	static inline void name##_set(type *val)                               \
+	{                                                                      \
+		pthread_setspecific(name##_key, val);                          \
+	}                                                                      \
+	_DEFINE_PTHREAD_LOCAL_KEY(name) /* end */
+#endif
+
+#define _DEFINE_PTHREAD_LOCAL_KEY(name)                                        \
+	static void name##_key_init(void) __attribute__((_CONSTRUCTOR(500)));  \
+	static void name##_key_init(void)                                      \
+	{                                                                      \
+		pthread_key_create(&name##_key, name##_key_free);              \
+	}                                                                      \
+	static void name##_key_fini(void) __attribute__((_DESTRUCTOR(500)));   \
+	static void name##_key_fini(void)                                      \
+	{                                                                      \
+		pthread_key_delete(name##_key);                                \
+	}                                                                      \
+	MACRO_REQUIRE_SEMICOLON() /* end */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_PTHREAD_LOCAL_H */
@@ -65,8 +65,10 @@ static struct rmap_cmd_name_head rmap_set_cmds[1] = {
 	(strncmp(S, IPv6_PREFIX_LIST, strlen(IPv6_PREFIX_LIST)) == 0)
 
 struct route_map_pentry_dep {
+	/* NULL for all entries of the prefix-list */
 	struct prefix_list_entry *pentry;
 	const char *plist_name;
+	afi_t afi;
 	route_map_event_t event;
 };
 
@@ -2363,22 +2365,14 @@ static void route_map_pfx_tbl_update(route_map_event_t event,
  * a prefix-list or, an existing prefix-entry is removed from the prefix-list.
  * It updates the prefix-table of the route-map accordingly.
  */
-static void route_map_pentry_update(route_map_event_t event,
+static void route_map_pentry_update(route_map_event_t event, afi_t afi,
 				    const char *plist_name,
 				    struct route_map_index *index,
 				    struct prefix_list_entry *pentry)
 {
 	struct prefix_list *plist = NULL;
-	afi_t afi;
-	unsigned char family = pentry->prefix.family;
 
-	if (family == AF_INET) {
-		afi = AFI_IP;
-		plist = prefix_list_lookup(AFI_IP, plist_name);
-	} else {
-		afi = AFI_IP6;
-		plist = prefix_list_lookup(AFI_IP6, plist_name);
-	}
+	plist = prefix_list_lookup(afi, plist_name);
 
 	if (event == RMAP_EVENT_PLIST_ADDED) {
 		if (afi == AFI_IP) {
@@ -2420,7 +2414,7 @@ static void route_map_pentry_process_dependency(struct hash_bucket *bucket,
 	struct route_map_dep_data *dep_data = NULL;
 	struct route_map_pentry_dep *pentry_dep =
 		(struct route_map_pentry_dep *)data;
-	unsigned char family = pentry_dep->pentry->prefix.family;
+	afi_t afi = pentry_dep->afi;
 
 	dep_data = (struct route_map_dep_data *)bucket->data;
 	if (!dep_data)
@@ -2441,16 +2435,16 @@ static void route_map_pentry_process_dependency(struct hash_bucket *bucket,
 			if (strcmp(match->rule_str, pentry_dep->plist_name)
 			    == 0) {
 				if (IS_RULE_IPv4_PREFIX_LIST(match->cmd->str)
-				    && family == AF_INET) {
+				    && afi == AFI_IP) {
 					route_map_pentry_update(
-						pentry_dep->event,
+						pentry_dep->event, afi,
 						pentry_dep->plist_name, index,
 						pentry_dep->pentry);
 				} else if (IS_RULE_IPv6_PREFIX_LIST(
 						   match->cmd->str)
-					   && family == AF_INET6) {
+					   && afi == AFI_IP6) {
 					route_map_pentry_update(
-						pentry_dep->event,
+						pentry_dep->event, afi,
 						pentry_dep->plist_name, index,
 						pentry_dep->pentry);
 				}
@@ -2459,17 +2453,14 @@ static void route_map_pentry_process_dependency(struct hash_bucket *bucket,
 	}
 }
 
-void route_map_notify_pentry_dependencies(const char *affected_name,
-					  struct prefix_list_entry *pentry,
-					  route_map_event_t event)
+static void route_map_notify_plist_dep(const char *affected_name, afi_t afi,
+				       struct prefix_list_entry *pentry,
+				       route_map_event_t event)
 {
 	struct route_map_dep *dep = NULL;
 	struct hash *upd8_hash = NULL;
 	struct route_map_pentry_dep pentry_dep;
 
-	if (!affected_name || !pentry)
-		return;
-
 	upd8_hash = route_map_get_dep_hash(event);
 	if (!upd8_hash)
 		return;
@@ -2483,6 +2474,7 @@ void route_map_notify_pentry_dependencies(const char *affected_name,
 		memset(&pentry_dep, 0, sizeof(pentry_dep));
 		pentry_dep.pentry = pentry;
 		pentry_dep.plist_name = affected_name;
+		pentry_dep.afi = afi;
 		pentry_dep.event = event;
 
 		hash_iterate(dep->dep_rmap_hash,
@@ -2491,6 +2483,27 @@ void route_map_notify_pentry_dependencies(const char *affected_name,
 	}
 }
 
+void route_map_notify_pentry_dependencies(const char *affected_name,
+					  struct prefix_list_entry *pentry,
+					  route_map_event_t event)
+{
+	if (!affected_name || !pentry)
+		return;
+
+	route_map_notify_plist_dep(affected_name,
+				   family2afi(pentry->prefix.family), pentry,
+				   event);
+}
+
+void route_map_notify_plist_dependencies(const char *affected_name, afi_t afi)
+{
+	if (!affected_name)
+		return;
+
+	route_map_notify_plist_dep(affected_name, afi, NULL,
+				   RMAP_EVENT_PLIST_ADDED);
+}
+
 /* Apply route map's each index to the object.
 
    The matrix for a route-map looks like this:
@@ -513,6 +513,12 @@ extern void
 route_map_notify_pentry_dependencies(const char *affected_name,
 				     struct prefix_list_entry *pentry,
 				     route_map_event_t event);
+/* Updates the route-maps' prefix tables for all entries of a prefix-list that
+ * got entries added, instead of one route_map_notify_pentry_dependencies()
+ * call per entry.
+ */
+extern void route_map_notify_plist_dependencies(const char *affected_name,
+						afi_t afi);
 extern int generic_match_add(struct route_map_index *index,
 			     const char *command, const char *arg,
 			     route_map_event_t type,
@@ -10,6 +10,7 @@
 #include <log.h>
 #include <memory.h>
 #include <lib_errors.h>
+#include <tracering.h>
 
 #ifdef HAVE_UCONTEXT_H
 #ifdef GNU_LINUX
@@ -252,6 +253,9 @@ core_handler(int signo, siginfo_t *siginfo, void *context)
 	 */
 	zlog_tls_buffer_flush();
 
+	/* binary trace records, goes into the same tmpdir as the crashlog */
+	tracering_crashdump();
+
 	/* give the kernel a chance to generate a coredump */
 	sigaddset(&sigset, signo);
 	sigprocmask(SIG_UNBLOCK, &sigset, NULL);
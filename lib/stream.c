@@ -10,6 +10,7 @@
 
 #include "stream.h"
 #include "memory.h"
+#include "mpool.h"
 #include "network.h"
 #include "prefix.h"
 #include "log.h"
@@ -17,8 +18,21 @@
 #include "lib_errors.h"
 
 DEFINE_MTYPE_STATIC(LIB, STREAM, "Stream");
+DEFINE_MTYPE_STATIC(LIB, STREAM_SMALL, "Stream (small)");
+DEFINE_MTYPE_STATIC(LIB, STREAM_LARGE, "Stream (packet)");
+DEFINE_MTYPE_STATIC(LIB, STREAM_CLONE, "Stream clone");
 DEFINE_MTYPE_STATIC(LIB, STREAM_FIFO, "Stream FIFO");
 
+/* Streams up to these sizes come from object pools.  Most messages are
+ * small; BGP packets without extended message support fit the larger size.
+ */
+#define STREAM_POOL_SMALL 512
+#define STREAM_POOL_LARGE 4096
+
+DEFINE_MPOOL(STREAM_SMALL, sizeof(struct stream) + STREAM_POOL_SMALL);
+DEFINE_MPOOL(STREAM_LARGE, sizeof(struct stream) + STREAM_POOL_LARGE);
+DEFINE_MPOOL(STREAM_CLONE, sizeof(struct stream));
+
 /* Tests whether a position is valid */
 #define GETP_VALID(S, G) ((G) <= (S)->endp)
 #define PUT_AT_VALID(S,G) GETP_VALID(S,G)
@@ -72,6 +86,18 @@ DEFINE_MTYPE_STATIC(LIB, STREAM_FIFO, "Stream FIFO");
 		STREAM_WARN_OFFSETS(S);                                        \
 	} while (0)
 
+/* data shared with clones must not change under them */
+#define STREAM_VERIFY_EXCLUSIVE(S)                                             \
+	do {                                                                   \
+		if (stream_is_shared(S)) {                                     \
+			flog_warn(EC_LIB_STREAM,                               \
+				  "%s: Attempt to modify shared stream",       \
+				  __func__);                                   \
+			STREAM_WARN_OFFSETS(S);                                \
+			assert(0);                                             \
+		}                                                              \
+	} while (0)
+
 /* XXX: Deprecated macro: do not use */
 #define CHECK_SIZE(S, Z)                                                       \
 	do {                                                                   \
@@ -85,6 +111,28 @@ DEFINE_MTYPE_STATIC(LIB, STREAM_FIFO, "Stream FIFO");
 		}                                                              \
 	} while (0);
 
+static inline bool stream_is_shared(const struct stream *s)
+{
+	return s->owner
+	       || atomic_load_explicit(&s->refcount, memory_order_relaxed) > 1;
+}
+
+static struct memtype *stream_size_mtype(size_t size)
+{
+	if (size <= STREAM_POOL_SMALL)
+		return MTYPE_STREAM_SMALL;
+	if (size <= STREAM_POOL_LARGE)
+		return MTYPE_STREAM_LARGE;
+	return MTYPE_STREAM;
+}
+
+static struct memtype *stream_mtype(const struct stream *s)
+{
+	if (s->owner)
+		return MTYPE_STREAM_CLONE;
+	return stream_size_mtype(s->size);
+}
+
 /* Make stream buffer. */
 struct stream *stream_new(size_t size)
 {
@@ -92,21 +140,34 @@ struct stream *stream_new(size_t size)
 
 	assert(size > 0);
 
-	s = XMALLOC(MTYPE_STREAM, sizeof(struct stream) + size);
+	s = XMALLOC(stream_size_mtype(size), sizeof(struct stream) + size);
 
 	s->getp = s->endp = 0;
 	s->next = NULL;
 	s->size = size;
+	s->data = s->buf;
+	s->owner = NULL;
+	atomic_store_explicit(&s->refcount, 1, memory_order_relaxed);
 	return s;
 }
 
-/* Free it now. */
+/* Free it now.  The data of a cloned stream stays around until the last
+ * clone is freed, possibly on another pthread.
+ */
 void stream_free(struct stream *s)
 {
+	struct stream *owner;
+
 	if (!s)
 		return;
 
-	XFREE(MTYPE_STREAM, s);
+	owner = s->owner ? s->owner : s;
+	if (s->owner)
+		XFREE(MTYPE_STREAM_CLONE, s);
+
+	if (atomic_fetch_sub_explicit(&owner->refcount, 1,
+				      memory_order_acq_rel) == 1)
+		XFREE(stream_mtype(owner), owner);
 }
 
 struct stream *stream_copy(struct stream *dest, const struct stream *src)
@@ -115,6 +176,7 @@ struct stream *stream_copy(struct stream *dest, const struct stream *src)
 
 	assert(dest != NULL);
 	assert(STREAM_SIZE(dest) >= src->endp);
+	STREAM_VERIFY_EXCLUSIVE(dest);
 
 	dest->endp = src->endp;
 	dest->getp = src->getp;
@@ -135,6 +197,30 @@ struct stream *stream_dup(const struct stream *s)
 	return (stream_copy(snew, s));
 }
 
+/* Like stream_dup(), but the new stream shares the data instead of copying
+ * it.  The clone has no room to write, and the original can only be appended
+ * to until all its clones are freed.
+ */
+struct stream *stream_clone(struct stream *s)
+{
+	struct stream *owner = s->owner ? s->owner : s;
+	struct stream *clone;
+
+	STREAM_VERIFY_SANE(s);
+
+	clone = XMALLOC(MTYPE_STREAM_CLONE, sizeof(struct stream));
+
+	clone->next = NULL;
+	clone->getp = s->getp;
+	clone->endp = clone->size = s->endp;
+	clone->data = s->data;
+	clone->owner = owner;
+	atomic_store_explicit(&clone->refcount, 0, memory_order_relaxed);
+
+	atomic_fetch_add_explicit(&owner->refcount, 1, memory_order_relaxed);
+	return clone;
+}
+
 struct stream *stream_dupcat(const struct stream *s1, const struct stream *s2,
 			     size_t offset)
 {
@@ -156,11 +242,29 @@ struct stream *stream_dupcat(const struct stream *s1, const struct stream *s2,
 
 size_t stream_resize_inplace(struct stream **sptr, size_t newsize)
 {
-	struct stream *orig = *sptr;
+	struct stream *orig = *sptr, *new;
+	struct memtype *mt = stream_size_mtype(newsize);
 
 	STREAM_VERIFY_SANE(orig);
-
-	orig = XREALLOC(MTYPE_STREAM, orig, sizeof(struct stream) + newsize);
+	STREAM_VERIFY_EXCLUSIVE(orig);
+
+	if (mt == stream_mtype(orig) && !mt->pool) {
+		/* not pooled, or pools disabled (e.g. for ASan) and the
+		 * allocation is only as big as the stream
+		 */
+		orig = XREALLOC(mt, orig, sizeof(struct stream) + newsize);
+		orig->data = orig->buf;
+	} else if (mt != stream_mtype(orig)) {
+		/* pooled streams can't be realloc'd, move to a new one */
+		new = stream_new(newsize);
+		new->next = orig->next;
+		new->getp = orig->getp;
+		new->endp = MIN(orig->endp, newsize);
+		memcpy(new->data, orig->data, new->endp);
+		stream_free(orig);
+		orig = new;
+	}
+	/* else still fits the same pool object */
 
 	orig->size = newsize;
 
@@ -215,6 +319,10 @@ void stream_set_endp(struct stream *s, size_t pos)
 		return;
 	}
 
+	/* appending past a lowered endp would overwrite shared data */
+	if (pos < s->endp)
+		STREAM_VERIFY_EXCLUSIVE(s);
+
 	/*
 	 * Make sure the current read pointer is not beyond the new endp.
 	 */
@@ -813,6 +921,7 @@ int stream_putd(struct stream *s, double d)
 int stream_putc_at(struct stream *s, size_t putp, uint8_t c)
 {
 	STREAM_VERIFY_SANE(s);
+	STREAM_VERIFY_EXCLUSIVE(s);
 
 	if (!PUT_AT_VALID(s, putp + sizeof(uint8_t))) {
 		STREAM_BOUND_WARN(s, "put");
@@ -827,6 +936,7 @@ int stream_putc_at(struct stream *s, size_t putp, uint8_t c)
 int stream_putw_at(struct stream *s, size_t putp, uint16_t w)
 {
 	STREAM_VERIFY_SANE(s);
+	STREAM_VERIFY_EXCLUSIVE(s);
 
 	if (!PUT_AT_VALID(s, putp + sizeof(uint16_t))) {
 		STREAM_BOUND_WARN(s, "put");
@@ -842,6 +952,7 @@ int stream_putw_at(struct stream *s, size_t putp, uint16_t w)
 int stream_put3_at(struct stream *s, size_t putp, uint32_t l)
 {
 	STREAM_VERIFY_SANE(s);
+	STREAM_VERIFY_EXCLUSIVE(s);
 
 	if (!PUT_AT_VALID(s, putp + 3)) {
 		STREAM_BOUND_WARN(s, "put");
@@ -857,6 +968,7 @@ int stream_put3_at(struct stream *s, size_t putp, uint32_t l)
 int stream_putl_at(struct stream *s, size_t putp, uint32_t l)
 {
 	STREAM_VERIFY_SANE(s);
+	STREAM_VERIFY_EXCLUSIVE(s);
 
 	if (!PUT_AT_VALID(s, putp + sizeof(uint32_t))) {
 		STREAM_BOUND_WARN(s, "put");
@@ -873,6 +985,7 @@ int stream_putl_at(struct stream *s, size_t putp, uint32_t l)
 int stream_putq_at(struct stream *s, size_t putp, uint64_t q)
 {
 	STREAM_VERIFY_SANE(s);
+	STREAM_VERIFY_EXCLUSIVE(s);
 
 	if (!PUT_AT_VALID(s, putp + sizeof(uint64_t))) {
 		STREAM_BOUND_WARN(s, "put");
@@ -947,6 +1060,7 @@ int stream_put_in_addr_at(struct stream *s, size_t putp,
 			  const struct in_addr *addr)
 {
 	STREAM_VERIFY_SANE(s);
+	STREAM_VERIFY_EXCLUSIVE(s);
 
 	if (!PUT_AT_VALID(s, putp + 4)) {
 		STREAM_BOUND_WARN(s, "put");
@@ -962,6 +1076,7 @@ int stream_put_in6_addr_at(struct stream *s, size_t putp,
 			   const struct in6_addr *addr)
 {
 	STREAM_VERIFY_SANE(s);
+	STREAM_VERIFY_EXCLUSIVE(s);
 
 	if (!PUT_AT_VALID(s, putp + 16)) {
 		STREAM_BOUND_WARN(s, "put");
@@ -1200,6 +1315,7 @@ int stream_empty(struct stream *s)
 void stream_reset(struct stream *s)
 {
 	STREAM_VERIFY_SANE(s);
+	STREAM_VERIFY_EXCLUSIVE(s);
 
 	s->getp = s->endp = 0;
 }
@@ -1357,6 +1473,138 @@ void stream_fifo_free(struct stream_fifo *fifo)
 	XFREE(MTYPE_STREAM_FIFO, fifo);
 }
 
+void stream_chain_init(struct stream_chain *sc, size_t seg_size)
+{
+	assert(seg_size > 0);
+
+	sc->head = sc->tail = NULL;
+	sc->seg_size = seg_size;
+}
+
+void stream_chain_fini(struct stream_chain *sc)
+{
+	struct stream *s, *next;
+
+	for (s = sc->head; s; s = next) {
+		next = s->next;
+		stream_free(s);
+	}
+	sc->head = sc->tail = NULL;
+}
+
+void stream_chain_append(struct stream_chain *sc, struct stream *s)
+{
+	STREAM_VERIFY_SANE(s);
+
+	s->next = NULL;
+	if (sc->tail)
+		sc->tail->next = s;
+	else
+		sc->head = s;
+	sc->tail = s;
+}
+
+struct stream *stream_chain_reserve(struct stream_chain *sc, size_t size)
+{
+	struct stream *s = sc->tail;
+
+	if (s && STREAM_WRITEABLE(s) >= size)
+		return s;
+
+	s = stream_new(MAX(size, sc->seg_size));
+	stream_chain_append(sc, s);
+	return s;
+}
+
+void stream_chain_put(struct stream_chain *sc, const void *src, size_t size)
+{
+	const uint8_t *pos = src;
+	struct stream *s;
+	size_t len;
+
+	while (size) {
+		s = stream_chain_reserve(sc, 1);
+		len = MIN(size, STREAM_WRITEABLE(s));
+		stream_put(s, pos, len);
+		if (pos)
+			pos += len;
+		size -= len;
+	}
+}
+
+size_t stream_chain_len(const struct stream_chain *sc)
+{
+	const struct stream *s;
+	size_t len = 0;
+
+	for (s = sc->head; s; s = s->next)
+		len += STREAM_READABLE(s);
+	return len;
+}
+
+int stream_chain_iov(const struct stream_chain *sc, struct iovec *iov,
+		     int iovcnt)
+{
+	const struct stream *s;
+	int n = 0;
+
+	for (s = sc->head; s && n < iovcnt; s = s->next) {
+		if (!STREAM_READABLE(s))
+			continue;
+		iov[n].iov_base = s->data + s->getp;
+		iov[n].iov_len = STREAM_READABLE(s);
+		n++;
+	}
+	return n;
+}
+
+/* streams written per writev() call */
+#define STREAM_CHAIN_IOV 64
+
+ssize_t stream_chain_write(struct stream_chain *sc, int fd)
+{
+	struct iovec iov[STREAM_CHAIN_IOV];
+	struct stream *s;
+	ssize_t nbytes;
+	size_t left, len;
+	int iovcnt;
+
+	iovcnt = stream_chain_iov(sc, iov, array_size(iov));
+	if (!iovcnt)
+		return 0;
+
+	nbytes = writev(fd, iov, iovcnt);
+	if (nbytes <= 0)
+		return nbytes;
+
+	left = nbytes;
+	while ((s = sc->head)) {
+		len = MIN(left, STREAM_READABLE(s));
+		s->getp += len;
+		left -= len;
+		if (STREAM_READABLE(s))
+			break;
+
+		sc->head = s->next;
+		if (!sc->head)
+			sc->tail = NULL;
+		stream_free(s);
+	}
+	return nbytes;
+}
+
+struct stream *stream_chain_flatten(struct stream_chain *sc)
+{
+	struct stream *new, *s;
+
+	new = stream_new(MAX(stream_chain_len(sc), (size_t)1));
+	for (s = sc->head; s; s = s->next)
+		stream_put(new, s->data + s->getp, STREAM_READABLE(s));
+
+	stream_chain_fini(sc);
+	return new;
+}
+
 void stream_pulldown(struct stream *s)
 {
 	size_t rlen = STREAM_READABLE(s);
@@ -1367,6 +1615,8 @@ void stream_pulldown(struct stream *s)
 		return;
 	}
 
+	STREAM_VERIFY_EXCLUSIVE(s);
+
 	/* Move the available data to the beginning. */
 	memmove(s->data, &s->data[s->getp], rlen);
 	s->getp = 0;
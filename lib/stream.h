@@ -8,6 +8,7 @@
 #define _ZEBRA_STREAM_H
 
 #include <pthread.h>
+#include <sys/uio.h>
 
 #include "frratomic.h"
 #include "mpls.h"
@@ -81,6 +82,10 @@ extern "C" {
  *
  * Best practice is to use stream_put (<stream *>, NULL, <size>) to zero out
  * any part of a stream which isn't otherwise written to.
+ *
+ * Several streams can share one buffer, see stream_clone().  Shared data is
+ * read-only: clones have no room to write, and the original may only be
+ * appended to until all clones are freed.
  */
 
 /* Stream buffer. */
@@ -95,7 +100,14 @@ struct stream {
 	size_t getp;	       /* next get position */
 	size_t endp;	       /* last valid data position */
 	size_t size;	       /* size of data segment */
-	unsigned char data[];  /* data pointer */
+	unsigned char *data;   /* data pointer */
+
+	/* stream whose data this is, for clones made by stream_clone() */
+	struct stream *owner;
+	/* clones of this stream, plus one for the stream itself */
+	atomic_size_t refcount;
+
+	unsigned char buf[];
 };
 
 /* First in first out queue structure. */
@@ -137,6 +149,8 @@ extern void stream_free(struct stream *);
 extern struct stream *stream_copy(struct stream *dest,
 				  const struct stream *src);
 extern struct stream *stream_dup(const struct stream *s);
+/* zero-copy stream_dup(); the clone shares the data and is read-only */
+extern struct stream *stream_clone(struct stream *s);
 
 extern size_t stream_resize_inplace(struct stream **sptr, size_t newsize);
 
@@ -359,6 +373,46 @@ extern size_t stream_fifo_count_safe(struct stream_fifo *fifo);
  */
 extern void stream_fifo_free(struct stream_fifo *fifo);
 
+/*
+ * A chain of streams, for messages that are too big for one stream or whose
+ * size isn't known up front.  Encoders ask for room in the last stream with
+ * stream_chain_reserve() and fill it with the usual stream_put functions; a
+ * new stream is started when the last one is full, so nothing is ever
+ * reallocated or copied.  Other streams can be added as a whole, or shared
+ * with stream_chain_append(sc, stream_clone(s)).
+ *
+ * The streams are linked through their next pointer, so they can't be on a
+ * stream_fifo at the same time.
+ */
+struct stream_chain {
+	struct stream *head, *tail;
+
+	/* size of the streams started by stream_chain_reserve() */
+	size_t seg_size;
+};
+
+extern void stream_chain_init(struct stream_chain *sc, size_t seg_size);
+/* frees all streams on the chain */
+extern void stream_chain_fini(struct stream_chain *sc);
+
+/* returns the last stream on the chain, with at least size bytes writeable */
+extern struct stream *stream_chain_reserve(struct stream_chain *sc,
+					   size_t size);
+extern void stream_chain_put(struct stream_chain *sc, const void *src,
+			     size_t size);
+/* the chain takes ownership of s */
+extern void stream_chain_append(struct stream_chain *sc, struct stream *s);
+
+/* readable bytes on the chain */
+extern size_t stream_chain_len(const struct stream_chain *sc);
+/* fills iov with up to iovcnt readable parts, returns how many */
+extern int stream_chain_iov(const struct stream_chain *sc, struct iovec *iov,
+			    int iovcnt);
+/* writev() as much as possible, freeing the streams that were written out */
+extern ssize_t stream_chain_write(struct stream_chain *sc, int fd);
+/* copy all readable data into one new stream and empty the chain */
+extern struct stream *stream_chain_flatten(struct stream_chain *sc);
+
 /* This is here because "<< 24" is particularly problematic in C.
  * This is because the left operand of << is integer-promoted, which means
  * an uint8_t gets converted into a *signed* int.  Shifting into the sign
@@ -16,8 +16,10 @@
 
 DEFINE_MTYPE_STATIC(LIB, ROUTE_TABLE, "Route table");
 DEFINE_MTYPE(LIB, ROUTE_NODE, "Route node");
+DEFINE_MTYPE_STATIC(LIB, ROUTE_TABLE_LPM, "Route table LPM index");
 
 static void route_table_free(struct route_table *);
+static void route_table_lpm_free(struct route_table *table);
 
 static int route_table_hash_cmp(const struct route_node *a,
 				const struct route_node *b)
@@ -122,6 +124,7 @@ static void route_table_free(struct route_table *rt)
 
 	assert(rt->count == 0);
 
+	route_table_lpm_free(rt);
 	rn_hash_node_fini(&rt->hash);
 	XFREE(MTYPE_ROUTE_TABLE, rt);
 	return;
@@ -177,6 +180,380 @@ static void set_link(struct route_node *node, struct route_node *new)
 	new->parent = node;
 }
 
+/*
+ * Longest prefix match index.
+ *
+ * Poptrie layout: the first LPM_DIRECT bits of an address index a flat
+ * array, after that every node consumes LPM_STRIDE bits and has 64 slots.
+ * A slot either descends to a child node or ends in a leaf, the deepest
+ * radix tree node covering the slot.  Children of a node and its distinct
+ * leaves are stored contiguously, so a node only keeps a bitmap of the
+ * slots with children, a bitmap of the slots starting a new run of
+ * leaves, and the base index of both arrays.
+ */
+#define LPM_DIRECT 16
+#define LPM_STRIDE 6
+
+/* Direct array entry referring to a leaf rather than a node */
+#define LPM_DIRECT_LEAF (1U << 31)
+
+/*
+ * Rebuild a stale index after LPM_REBUILD_RATIO lookups per unit of rebuild
+ * work, which is the tree plus the whole direct array.  Small tables that
+ * keep changing are left to the tree walk.
+ */
+#define LPM_REBUILD_RATIO 16
+#define LPM_REBUILD_LOOKUPS(count)                                             \
+	(((count) + (1UL << LPM_DIRECT)) / LPM_REBUILD_RATIO)
+
+struct lpm_node {
+	uint64_t vector;
+	uint64_t leafvec;
+	uint32_t base0;
+	uint32_t base1;
+};
+
+struct route_table_lpm {
+	/* Address family indexed, 0 if not built */
+	int family;
+	bool stale;
+	unsigned long stale_lookups;
+
+	uint32_t *direct;
+
+	struct lpm_node *nodes;
+	uint32_t nodes_count, nodes_size;
+
+	struct route_node **leaves;
+	uint32_t leaves_count, leaves_size;
+};
+
+static inline void route_table_lpm_stale(struct route_table *table)
+{
+	if (table->lpm) {
+		table->lpm->stale = true;
+		table->lpm->stale_lookups = 0;
+	}
+}
+
+/* Left aligned address bits, zero padded past the address length. */
+static void lpm_words(const struct prefix *p, uint64_t w[2])
+{
+	const uint8_t *b = p->u.val;
+	unsigned int i;
+
+	w[0] = w[1] = 0;
+	if (p->family == AF_INET) {
+		w[0] = (uint64_t)ntohl(p->u.prefix4.s_addr) << 32;
+		return;
+	}
+
+	for (i = 0; i < 8; i++) {
+		w[0] = (w[0] << 8) | b[i];
+		w[1] = (w[1] << 8) | b[i + 8];
+	}
+}
+
+static inline unsigned int lpm_bits(const uint64_t w[2], unsigned int depth,
+				    unsigned int width)
+{
+	uint64_t v;
+
+	if (depth == 0)
+		v = w[0];
+	else if (depth < 64)
+		v = (w[0] << depth) | (w[1] >> (64 - depth));
+	else
+		v = w[1] << (depth - 64);
+
+	return v >> (64 - width);
+}
+
+static uint32_t lpm_alloc(void **array, uint32_t *count, uint32_t *size,
+			  size_t elemsize, uint32_t n)
+{
+	uint32_t base = *count;
+
+	if (*count + n > *size) {
+		while (*count + n > *size)
+			*size = *size ? *size * 2 : 64;
+		*array = XREALLOC(MTYPE_ROUTE_TABLE_LPM, *array,
+				  *size * elemsize);
+	}
+	*count += n;
+
+	return base;
+}
+
+static uint32_t lpm_add_leaf(struct route_table_lpm *lpm,
+			     struct route_node *leaf)
+{
+	uint32_t i;
+
+	i = lpm_alloc((void **)&lpm->leaves, &lpm->leaves_count,
+		      &lpm->leaves_size, sizeof(*lpm->leaves), 1);
+	lpm->leaves[i] = leaf;
+
+	return i;
+}
+
+/*
+ * Fill in the 2^width slots for the address bits at depth from the radix
+ * subtree at node, which lies within the range being filled.  Tree nodes
+ * are visited parent first, so deeper prefixes overwrite the leaves they
+ * cover.
+ */
+static bool lpm_collect(struct route_node *node, int family,
+			unsigned int depth, unsigned int width,
+			struct route_node *leaf[], struct route_node *child[])
+{
+	unsigned int len = node->p.prefixlen, span, v, i;
+	uint64_t w[2];
+
+	if (node->p.family != family)
+		return false;
+
+	lpm_words(&node->p, w);
+	if (len > depth + width) {
+		child[lpm_bits(w, depth, width)] = node;
+		return true;
+	}
+
+	if (len > depth) {
+		span = 1U << (depth + width - len);
+		v = lpm_bits(w, depth, width) & ~(span - 1);
+		for (i = v; i < v + span; i++)
+			leaf[i] = node;
+
+		if (len == depth + width) {
+			if (node->l_left || node->l_right)
+				child[v] = node;
+			return true;
+		}
+	}
+
+	for (i = 0; i < 2; i++)
+		if (node->link[i] && !lpm_collect(node->link[i], family, depth,
+						  width, leaf, child))
+			return false;
+
+	return true;
+}
+
+static bool lpm_build_node(struct route_table_lpm *lpm, uint32_t idx,
+			   unsigned int depth, struct route_node *root,
+			   struct route_node *best)
+{
+	struct route_node *leaf[64], *child[64], *prev = NULL;
+	uint64_t vector = 0, leafvec = 0;
+	uint32_t base0, base1, nchild = 0, i;
+	unsigned int v;
+
+	for (v = 0; v < 64; v++) {
+		leaf[v] = best;
+		child[v] = NULL;
+	}
+
+	if (!lpm_collect(root, lpm->family, depth, LPM_STRIDE, leaf, child))
+		return false;
+
+	base0 = lpm->leaves_count;
+	for (v = 0; v < 64; v++) {
+		if (child[v]) {
+			vector |= 1ULL << v;
+			nchild++;
+			continue;
+		}
+
+		if (!leafvec || leaf[v] != prev) {
+			leafvec |= 1ULL << v;
+			lpm_add_leaf(lpm, leaf[v]);
+			prev = leaf[v];
+		}
+	}
+
+	base1 = lpm_alloc((void **)&lpm->nodes, &lpm->nodes_count,
+			  &lpm->nodes_size, sizeof(*lpm->nodes), nchild);
+
+	lpm->nodes[idx].vector = vector;
+	lpm->nodes[idx].leafvec = leafvec;
+	lpm->nodes[idx].base0 = base0;
+	lpm->nodes[idx].base1 = base1;
+
+	for (v = 0, i = base1; v < 64; v++) {
+		if (!child[v])
+			continue;
+		if (!lpm_build_node(lpm, i++, depth + LPM_STRIDE, child[v],
+				    leaf[v]))
+			return false;
+	}
+
+	return true;
+}
+
+static bool lpm_build_direct(struct route_table *table)
+{
+	struct route_table_lpm *lpm = table->lpm;
+	struct route_node **leaf, **child, *prev = NULL;
+	uint32_t i, prev_idx = 0;
+	bool ret = false;
+
+	leaf = XCALLOC(MTYPE_TMP, sizeof(*leaf) << LPM_DIRECT);
+	child = XCALLOC(MTYPE_TMP, sizeof(*child) << LPM_DIRECT);
+
+	if (table->top && !lpm_collect(table->top, lpm->family, 0, LPM_DIRECT,
+				       leaf, child))
+		goto out;
+
+	for (i = 0; i < (1U << LPM_DIRECT); i++) {
+		if (child[i]) {
+			lpm->direct[i] = lpm_alloc((void **)&lpm->nodes,
+						   &lpm->nodes_count,
+						   &lpm->nodes_size,
+						   sizeof(*lpm->nodes), 1);
+			if (!lpm_build_node(lpm, lpm->direct[i], LPM_DIRECT,
+					    child[i], leaf[i]))
+				goto out;
+			continue;
+		}
+
+		if (i == 0 || leaf[i] != prev) {
+			prev_idx = lpm_add_leaf(lpm, leaf[i]);
+			prev = leaf[i];
+		}
+		lpm->direct[i] = prev_idx | LPM_DIRECT_LEAF;
+	}
+	ret = true;
+out:
+	XFREE(MTYPE_TMP, leaf);
+	XFREE(MTYPE_TMP, child);
+	return ret;
+}
+
+bool route_table_lpm_build(struct route_table *table, int family)
+{
+	struct route_table_lpm *lpm = table->lpm;
+
+	if (!lpm || (family != AF_INET && family != AF_INET6))
+		return false;
+
+	lpm->family = family;
+	lpm->stale = false;
+	lpm->stale_lookups = 0;
+	lpm->nodes_count = lpm->leaves_count = 0;
+	if (!lpm->direct)
+		lpm->direct = XCALLOC(MTYPE_ROUTE_TABLE_LPM,
+				      sizeof(*lpm->direct) << LPM_DIRECT);
+
+	if (!lpm_build_direct(table)) {
+		/* Mixed address families, the tree walk has to do */
+		lpm->family = 0;
+		lpm->stale = true;
+		return false;
+	}
+
+	/* The index is read-only until the next build, trim it */
+	if (lpm->nodes_size > lpm->nodes_count && lpm->nodes_count) {
+		lpm->nodes_size = lpm->nodes_count;
+		lpm->nodes = XREALLOC(MTYPE_ROUTE_TABLE_LPM, lpm->nodes,
+				      lpm->nodes_size * sizeof(*lpm->nodes));
+	}
+	if (lpm->leaves_size > lpm->leaves_count) {
+		lpm->leaves_size = lpm->leaves_count;
+		lpm->leaves = XREALLOC(MTYPE_ROUTE_TABLE_LPM, lpm->leaves,
+				       lpm->leaves_size * sizeof(*lpm->leaves));
+	}
+
+	return true;
+}
+
+static void route_table_lpm_free(struct route_table *table)
+{
+	if (!table->lpm)
+		return;
+
+	XFREE(MTYPE_ROUTE_TABLE_LPM, table->lpm->direct);
+	XFREE(MTYPE_ROUTE_TABLE_LPM, table->lpm->nodes);
+	XFREE(MTYPE_ROUTE_TABLE_LPM, table->lpm->leaves);
+	XFREE(MTYPE_ROUTE_TABLE_LPM, table->lpm);
+}
+
+void route_table_set_lpm(struct route_table *table, bool enable)
+{
+	if (!enable) {
+		route_table_lpm_free(table);
+		return;
+	}
+
+	if (!table->lpm) {
+		table->lpm = XCALLOC(MTYPE_ROUTE_TABLE_LPM,
+				     sizeof(struct route_table_lpm));
+		table->lpm->stale = true;
+	}
+}
+
+size_t route_table_lpm_memory(const struct route_table *table)
+{
+	const struct route_table_lpm *lpm = table->lpm;
+
+	if (!lpm)
+		return 0;
+
+	return sizeof(*lpm) + (lpm->direct ? sizeof(*lpm->direct) << LPM_DIRECT
+					   : 0) +
+	       lpm->nodes_size * sizeof(*lpm->nodes) +
+	       lpm->leaves_size * sizeof(*lpm->leaves);
+}
+
+/*
+ * Find the deepest tree node covering a full length address.  Returns
+ * false if the index can't answer and the tree has to be walked.
+ */
+static bool route_table_lpm_lookup(struct route_table *table,
+				   const struct prefix *p,
+				   struct route_node **result)
+{
+	struct route_table_lpm *lpm = table->lpm;
+	const struct lpm_node *n;
+	unsigned int depth = LPM_DIRECT, v;
+	uint64_t w[2];
+	uint32_t e;
+
+	if (lpm->stale) {
+		if (++lpm->stale_lookups < LPM_REBUILD_LOOKUPS(table->count))
+			return false;
+		if (!route_table_lpm_build(table, p->family))
+			return false;
+	}
+
+	if (p->family != lpm->family)
+		return false;
+
+	lpm_words(p, w);
+	e = lpm->direct[lpm_bits(w, 0, LPM_DIRECT)];
+	if (e & LPM_DIRECT_LEAF) {
+		*result = lpm->leaves[e & ~LPM_DIRECT_LEAF];
+		return true;
+	}
+
+	n = &lpm->nodes[e];
+	for (;;) {
+		v = lpm_bits(w, depth, LPM_STRIDE);
+		if (!(n->vector & (1ULL << v)))
+			break;
+		n = &lpm->nodes[n->base1 +
+				__builtin_popcountll(n->vector &
+						     ((1ULL << v) - 1))];
+		depth += LPM_STRIDE;
+	}
+
+	*result = lpm->leaves[n->base0 +
+			      __builtin_popcountll(n->leafvec &
+						   ((2ULL << v) - 1)) -
+			      1];
+	return true;
+}
+
 /* Find matched prefix. */
 struct route_node *route_node_match(struct route_table *table,
 				    union prefixconstptr pu)
@@ -186,6 +563,15 @@ struct route_node *route_node_match(struct route_table *table,
 	struct route_node *matched;
 
 	matched = NULL;
+
+	if (table->lpm && p->prefixlen == prefix_blen(p) * 8 &&
+	    route_table_lpm_lookup(table, p, &node)) {
+		/* Covering prefixes are all on the way up to the root */
+		while (node && !node->info)
+			node = node->parent;
+		return node ? route_lock_node(node) : NULL;
+	}
+
 	node = table->top;
 
 	/* Walk down tree.  If there is matched route then store it to
@@ -295,6 +681,8 @@ struct route_node *route_node_get(struct route_table *table,
 		node = node->link[prefix_bit(prefix, node->p.prefixlen)];
 	}
 
+	route_table_lpm_stale(table);
+
 	if (node == NULL) {
 		new = route_node_set(table, p);
 		if (match)
@@ -338,6 +726,8 @@ void route_node_delete(struct route_node *node)
 	if (node->l_left && node->l_right)
 		return;
 
+	route_table_lpm_stale(node->table);
+
 	if (node->l_left)
 		child = node->l_left;
 	else
@@ -46,11 +46,16 @@ struct route_table_delegate_t_ {
 
 PREDECL_HASH(rn_hash_node);
 
+struct route_table_lpm;
+
 /* Routing table top structure. */
 struct route_table {
 	struct route_node *top;
 	struct rn_hash_node_head hash;
 
+	/* Optional longest prefix match index, see route_table_set_lpm() */
+	struct route_table_lpm *lpm;
+
 	/*
 	 * Delegate that performs certain functions for this table.
 	 */
@@ -202,6 +207,30 @@ extern struct route_node *route_node_match_ipv6(struct route_table *table,
 
 extern unsigned long route_table_count(struct route_table *table);
 
+/*
+ * Longest prefix match index.
+ *
+ * When enabled, route_node_match() for a full length address (and thus
+ * route_node_match_ipv4/ipv6()) is answered from a compact multibit trie
+ * (a poptrie, 64 way nodes with popcount compressed children and leaves)
+ * instead of walking the radix tree.  The index only records the tree
+ * structure; route_node_match() still walks up to the nearest node with
+ * info set, so changing node->info does not affect it.
+ *
+ * Adding or removing tree nodes marks the index stale.  Until it is
+ * rebuilt, lookups walk the tree; the rebuild happens on its own once
+ * enough lookups went by to amortize it, or explicitly through
+ * route_table_lpm_build() e.g. after a bulk load.  The index covers one
+ * address family, that of the first lookup after it is enabled.
+ *
+ * Since route_node_match() may rebuild the index, lookups in a table with
+ * one enabled modify it; concurrent readers need to hold a lock just like
+ * writers do, or build the index beforehand and not change the table.
+ */
+extern void route_table_set_lpm(struct route_table *table, bool enable);
+extern bool route_table_lpm_build(struct route_table *table, int family);
+extern size_t route_table_lpm_memory(const struct route_table *table);
+
 extern struct route_node *route_node_create(route_table_delegate_t *delegate,
 					    struct route_table *table);
 extern void route_node_delete(struct route_node *node);
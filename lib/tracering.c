@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: ISC
+/*
+ * Always-on binary trace ring
+ */
+
+#include "zebra.h"
+
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "tracering.h"
+#include "frratomic.h"
+#include "frr_pthread.h"
+#include "memory.h"
+#include "prefix.h"
+#include "pthread_local.h"
+#include "zlog.h"
+
+DEFINE_MTYPE_STATIC(LIB, TRACERING, "Trace ring");
+
+struct tracering {
+	struct tracering *next;
+
+	intmax_t tid;
+	unsigned int records;
+
+	/* only written by the owning pthread */
+	atomic_uint_fast64_t pos;
+
+	struct tracering_rec recs[];
+};
+
+static pthread_mutex_t tracering_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+/* protected by tracering_mtx;  the crash dump walks this without the lock */
+static struct tracering *tracering_rings;
+static uint64_t tracering_recorded_dead;
+
+static atomic_uint tracering_records = TRACERING_RECORDS_DEFAULT;
+
+static void tracering_free(struct tracering *ring);
+DEFINE_PTHREAD_LOCAL(tracering_tls, struct tracering, tracering_free);
+
+static void tracering_unlink(struct tracering *ring)
+{
+	struct tracering **prev;
+
+	for (prev = &tracering_rings; *prev; prev = &(*prev)->next)
+		if (*prev == ring) {
+			*prev = ring->next;
+			break;
+		}
+	tracering_recorded_dead +=
+		atomic_load_explicit(&ring->pos, memory_order_relaxed);
+}
+
+static void tracering_free(struct tracering *ring)
+{
+	frr_with_mutex (&tracering_mtx) {
+		tracering_unlink(ring);
+	}
+	XFREE(MTYPE_TRACERING, ring);
+}
+
+/* (re)allocates this pthread's ring after the size was changed */
+static struct tracering *tracering_realloc(struct tracering *old,
+					   unsigned int records)
+{
+	struct tracering *ring = NULL;
+
+	if (records)
+		ring = XCALLOC(MTYPE_TRACERING,
+			       sizeof(*ring) + records * sizeof(ring->recs[0]));
+
+	frr_with_mutex (&tracering_mtx) {
+		if (old)
+			tracering_unlink(old);
+		if (ring) {
+			ring->tid = zlog_gettid();
+			ring->records = records;
+			ring->next = tracering_rings;
+			tracering_rings = ring;
+		}
+	}
+
+	XFREE(MTYPE_TRACERING, old);
+	tracering_tls_set(ring);
+	return ring;
+}
+
+struct tracering_rec *tracering_slot(const struct xref_tracering *xref)
+{
+	struct tracering *ring = tracering_tls_get();
+	struct tracering_rec *rec;
+	struct timespec ts;
+	unsigned int records;
+	uint64_t pos;
+
+	records = atomic_load_explicit(&tracering_records,
+				       memory_order_relaxed);
+	if (unlikely(!ring || ring->records != records)) {
+		/* nothing would free a ring set up in a later TLS destructor */
+		if (!ring && (!records || tracering_tls_exited()))
+			return NULL;
+		ring = tracering_realloc(ring, records);
+		if (!ring)
+			return NULL;
+	}
+
+	pos = atomic_load_explicit(&ring->pos, memory_order_relaxed);
+	atomic_store_explicit(&ring->pos, pos + 1, memory_order_relaxed);
+	rec = &ring->recs[pos & (ring->records - 1)];
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	rec->ts = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	rec->xref = (uintptr_t)xref;
+	return rec;
+}
+
+uint8_t *tracering_put_prefix(uint8_t *pos, const void *arg)
+{
+	const struct prefix *p = arg;
+
+	pos[0] = p->family;
+	pos[1] = p->prefixlen;
+	/* struct prefix_ipv4 is shorter than the others */
+	if (p->family == AF_INET) {
+		memcpy(pos + 2, &p->u.prefix4, 4);
+		memset(pos + 6, 0, 12);
+	} else
+		memcpy(pos + 2, &p->u.prefix, 16);
+	return pos + TRACERING_PREFIX_SIZE;
+}
+
+void tracering_set(unsigned int records)
+{
+	unsigned int size = 1;
+
+	if (records) {
+		records = MIN(records, TRACERING_RECORDS_MAX);
+		while (size < records)
+			size <<= 1;
+		records = size;
+	}
+	atomic_store_explicit(&tracering_records, records,
+			      memory_order_relaxed);
+}
+
+unsigned int tracering_get(void)
+{
+	return atomic_load_explicit(&tracering_records, memory_order_relaxed);
+}
+
+static size_t tracering_count_xrefs(void)
+{
+	const struct xref_block *block;
+	const struct xref * const *xrefp;
+	size_t count = 0;
+
+	for (block = xref_blocks; block; block = block->next)
+		for (xrefp = block->start; xrefp < block->stop; xrefp++)
+			if (*xrefp && (*xrefp)->type == XREFT_TRACERING)
+				count++;
+	return count;
+}
+
+void tracering_get_stats(struct tracering_stats *stats)
+{
+	struct tracering *ring;
+
+	memset(stats, 0, sizeof(*stats));
+
+	frr_with_mutex (&tracering_mtx) {
+		stats->recorded = tracering_recorded_dead;
+		for (ring = tracering_rings; ring; ring = ring->next) {
+			stats->rings++;
+			stats->recorded += atomic_load_explicit(
+				&ring->pos, memory_order_relaxed);
+			stats->bytes += ring->records * sizeof(ring->recs[0]);
+		}
+	}
+	stats->tracepoints = tracering_count_xrefs();
+}
+
+void tracering_fini(void)
+{
+	struct tracering *ring;
+
+	tracering_set(0);
+	tracering_tls_set(NULL);
+
+	frr_with_mutex (&tracering_mtx) {
+		while ((ring = tracering_rings)) {
+			tracering_rings = ring->next;
+			XFREE(MTYPE_TRACERING, ring);
+		}
+	}
+}
+
+/* everything below here is used from the crash handler, so only
+ * async-signal-safe calls and no allocations.
+ */
+static int tracering_write(int fd, const void *buf, size_t len)
+{
+	const uint8_t *pos = buf;
+	ssize_t nwr;
+
+	while (len) {
+		nwr = write(fd, pos, len);
+		if (nwr < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		pos += nwr;
+		len -= nwr;
+	}
+	return 0;
+}
+
+static int tracering_write_sec(int fd, uint32_t type, const void *buf,
+			       size_t len)
+{
+	struct tracering_section sec = {
+		.type = type,
+		.len = len,
+	};
+
+	if (tracering_write(fd, &sec, sizeof(sec)))
+		return -1;
+	return tracering_write(fd, buf, len);
+}
+
+static size_t tracering_add_str(uint8_t *buf, size_t pos, size_t size,
+				const char *str)
+{
+	size_t len = str ? strlen(str) : 0;
+
+	len = MIN(len, size - pos - 1);
+	if (len)
+		memcpy(buf + pos, str, len);
+	buf[pos + len] = '\0';
+	return pos + len + 1;
+}
+
+static int tracering_write_xref(int fd, const struct xref_tracering *xref)
+{
+	struct tracering_file_xref *fx;
+	uint8_t buf[1024];
+	size_t len;
+
+	/* strings get truncated to fit, 4x 240 is plenty */
+	memset(buf, 0, sizeof(*fx));
+	fx = (struct tracering_file_xref *)buf;
+	fx->xref = (uintptr_t)xref;
+	fx->line = xref->xref.line;
+	if (xref->xref.xrefdata)
+		memcpy(fx->uid, xref->xref.xrefdata->uid, sizeof(fx->uid));
+	memcpy(fx->types, xref->types, sizeof(xref->types));
+
+	len = sizeof(*fx);
+	len = tracering_add_str(buf, len, len + 240, xref->name);
+	len = tracering_add_str(buf, len, len + 240, xref->xref.file);
+	len = tracering_add_str(buf, len, len + 240, xref->xref.func);
+	len = tracering_add_str(buf, len, len + 240, xref->args);
+
+	return tracering_write_sec(fd, TRACERING_SEC_XREF, buf, len);
+}
+
+static int tracering_write_ring(int fd, struct tracering *ring)
+{
+	struct tracering_file_ring fr = {
+		.tid = ring->tid,
+		.pos = atomic_load_explicit(&ring->pos, memory_order_relaxed),
+		.records = ring->records,
+	};
+	struct tracering_section sec = {
+		.type = TRACERING_SEC_RING,
+		.len = sizeof(fr) + ring->records * sizeof(ring->recs[0]),
+	};
+
+	if (tracering_write(fd, &sec, sizeof(sec)) ||
+	    tracering_write(fd, &fr, sizeof(fr)))
+		return -1;
+	return tracering_write(fd, ring->recs,
+			       ring->records * sizeof(ring->recs[0]));
+}
+
+static int tracering_dump_locked(int fd)
+{
+	struct tracering_file_hdr hdr = {
+		.magic = TRACERING_MAGIC,
+		.byteorder = 0x01020304,
+		.version = TRACERING_VERSION,
+		.rec_size = sizeof(struct tracering_rec),
+		.data_size = TRACERING_DATA,
+		.pid = getpid(),
+	};
+	const struct xref_block *block;
+	const struct xref * const *xrefp;
+	struct tracering *ring;
+
+	if (zlog_progname)
+		strlcpy(hdr.progname, zlog_progname, sizeof(hdr.progname));
+
+	if (tracering_write(fd, &hdr, sizeof(hdr)))
+		return -1;
+
+	for (block = xref_blocks; block; block = block->next)
+		for (xrefp = block->start; xrefp < block->stop; xrefp++) {
+			if (!*xrefp || (*xrefp)->type != XREFT_TRACERING)
+				continue;
+			if (tracering_write_xref(fd,
+						 container_of(*xrefp,
+							      struct xref_tracering,
+							      xref)))
+				return -1;
+		}
+
+	for (ring = tracering_rings; ring; ring = ring->next)
+		if (tracering_write_ring(fd, ring))
+			return -1;
+
+	return tracering_write_sec(fd, TRACERING_SEC_END, NULL, 0);
+}
+
+int tracering_dump(int fd)
+{
+	int ret = -1;
+
+	frr_with_mutex (&tracering_mtx) {
+		ret = tracering_dump_locked(fd);
+	}
+	return ret;
+}
+
+void tracering_crashdump(void)
+{
+	int fd;
+
+	if (zlog_tmpdirfd < 0 || !tracering_rings)
+		return;
+
+	fd = openat(zlog_tmpdirfd, "tracering",
+		    O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+	if (fd < 0)
+		return;
+
+	/* the lock may be held by the crashing pthread itself */
+	tracering_dump_locked(fd);
+	close(fd);
+}
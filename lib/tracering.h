@@ -0,0 +1,330 @@
+// SPDX-License-Identifier: ISC
+/*
+ * Always-on binary trace ring
+ */
+
+#ifndef _FRR_TRACERING_H
+#define _FRR_TRACERING_H
+
+#include <stdint.h>
+#include <string.h>
+#include <netinet/in.h>
+
+#include "compiler.h"
+#include "xref.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Each pthread records fixed size binary records into its own ring, which
+ * overwrites the oldest records when full.  A record holds a timestamp, a
+ * reference to the tracepoint's xref and a few integer / address / prefix
+ * arguments;  nothing is formatted at runtime.  The rings are written to a
+ * file on request ("dump trace-ring FILENAME") and when the daemon crashes
+ * (into its zlog tmpdir), and can be turned into text offline with
+ * tools/frr-tracering-decode.py.
+ *
+ * macro usage:
+ *
+ *   tracering("bgp update rcvd", p, peer->remote_id, addpath_id);
+ *
+ * The first argument must be a string literal naming the tracepoint, the
+ * rest (up to 8) may be:
+ *   - integers up to 64 bit (including enums and bool)
+ *   - struct in_addr, or pointers to struct in_addr / struct in6_addr
+ *   - pointers to struct prefix, prefix_ipv4 or prefix_ipv6
+ *   - void pointers, which are recorded as their value
+ * Anything else is a compile error.  The arguments must fit into
+ * TRACERING_DATA bytes, which is checked at compile time.
+ *
+ * Recording costs a clock_gettime() and a few stores, so tracepoints can sit
+ * next to existing "if (debug) zlog_debug(...)" sites without the debug
+ * check.  Records being written while a dump is taken may come out garbled.
+ */
+
+#define TRACERING_DATA		48
+#define TRACERING_MAXARGS	8
+
+#define TRACERING_RECORDS_DEFAULT 1024
+#define TRACERING_RECORDS_MAX	(1U << 20)
+
+struct prefix;
+struct prefix_ipv4;
+struct prefix_ipv6;
+
+struct xref_tracering {
+	struct xref xref;
+
+	const char *name;
+	const char *args;
+	/* one TRACERING_T_* per argument, NUL terminated */
+	char types[TRACERING_MAXARGS + 1];
+};
+
+/* argument type codes, as stored in the dump file */
+#define TRACERING_T_INT32	'i'
+#define TRACERING_T_UINT32	'u'
+#define TRACERING_T_INT64	'I'
+#define TRACERING_T_UINT64	'U'
+#define TRACERING_T_PTR		'x'
+#define TRACERING_T_IPV4	'4'
+#define TRACERING_T_IPV6	'6'
+#define TRACERING_T_PREFIX	'p'
+
+/* family, prefixlen, 16 bytes of address */
+#define TRACERING_PREFIX_SIZE	18
+
+struct tracering_rec {
+	/* CLOCK_REALTIME, in nanoseconds */
+	uint64_t ts;
+	/* address of the struct xref_tracering, 0 for unused slots */
+	uint64_t xref;
+	uint8_t data[TRACERING_DATA];
+};
+
+/* dump file layout, all in host byte order (byteorder tells which):
+ *
+ *   struct tracering_file_hdr
+ *   repeated:
+ *     struct tracering_section
+ *     section payload
+ *   struct tracering_section with type TRACERING_SEC_END
+ *
+ * tools/frr-tracering-decode.py needs to be kept in sync with this.
+ */
+#define TRACERING_MAGIC		"FRRTRING"
+#define TRACERING_VERSION	1
+
+struct tracering_file_hdr {
+	char magic[8];
+	uint32_t byteorder;
+	uint32_t version;
+	uint32_t rec_size;
+	uint32_t data_size;
+	int64_t pid;
+	char progname[32];
+};
+
+enum tracering_sec_type {
+	TRACERING_SEC_END = 0,
+	/* struct tracering_file_xref + name, file, func, args (NUL
+	 * terminated each)
+	 */
+	TRACERING_SEC_XREF = 1,
+	/* struct tracering_file_ring + records */
+	TRACERING_SEC_RING = 2,
+};
+
+struct tracering_section {
+	uint32_t type;
+	uint32_t len;
+};
+
+struct tracering_file_xref {
+	uint64_t xref;
+	uint32_t line;
+	char uid[16];
+	char types[TRACERING_MAXARGS + 4];
+};
+
+struct tracering_file_ring {
+	int64_t tid;
+	uint64_t pos;
+	uint32_t records;
+	uint32_t _pad;
+};
+
+/* returns the slot for a new record in this pthread's ring, with ts and
+ * xref filled in, or NULL if the trace ring is disabled.
+ */
+extern struct tracering_rec *tracering_slot(const struct xref_tracering *xref);
+
+extern uint8_t *tracering_put_prefix(uint8_t *pos, const void *p);
+
+static inline uint8_t *tracering_put_i32(uint8_t *pos, int32_t val)
+{
+	memcpy(pos, &val, sizeof(val));
+	return pos + sizeof(val);
+}
+
+static inline uint8_t *tracering_put_u32(uint8_t *pos, uint32_t val)
+{
+	memcpy(pos, &val, sizeof(val));
+	return pos + sizeof(val);
+}
+
+static inline uint8_t *tracering_put_i64(uint8_t *pos, int64_t val)
+{
+	memcpy(pos, &val, sizeof(val));
+	return pos + sizeof(val);
+}
+
+static inline uint8_t *tracering_put_u64(uint8_t *pos, uint64_t val)
+{
+	memcpy(pos, &val, sizeof(val));
+	return pos + sizeof(val);
+}
+
+static inline uint8_t *tracering_put_ptr(uint8_t *pos, const void *val)
+{
+	return tracering_put_u64(pos, (uintptr_t)val);
+}
+
+static inline uint8_t *tracering_put_in4(uint8_t *pos, struct in_addr val)
+{
+	memcpy(pos, &val, sizeof(val));
+	return pos + sizeof(val);
+}
+
+static inline uint8_t *tracering_put_in4p(uint8_t *pos,
+					  const struct in_addr *val)
+{
+	return tracering_put_in4(pos, *val);
+}
+
+static inline uint8_t *tracering_put_in6p(uint8_t *pos,
+					  const struct in6_addr *val)
+{
+	memcpy(pos, val, sizeof(*val));
+	return pos + sizeof(*val);
+}
+
+/* clang-format off */
+#define _TRACERING_TYPE(x)                                                     \
+	_Generic((x),                                                          \
+		_Bool: TRACERING_T_UINT32,                                     \
+		char: TRACERING_T_INT32,                                       \
+		signed char: TRACERING_T_INT32,                                \
+		short: TRACERING_T_INT32,                                      \
+		int: TRACERING_T_INT32,                                        \
+		unsigned char: TRACERING_T_UINT32,                             \
+		unsigned short: TRACERING_T_UINT32,                            \
+		unsigned int: TRACERING_T_UINT32,                              \
+		long: TRACERING_T_INT64,                                       \
+		long long: TRACERING_T_INT64,                                  \
+		unsigned long: TRACERING_T_UINT64,                             \
+		unsigned long long: TRACERING_T_UINT64,                        \
+		void *: TRACERING_T_PTR,                                       \
+		const void *: TRACERING_T_PTR,                                 \
+		struct in_addr: TRACERING_T_IPV4,                              \
+		struct in_addr *: TRACERING_T_IPV4,                            \
+		const struct in_addr *: TRACERING_T_IPV4,                      \
+		struct in6_addr *: TRACERING_T_IPV6,                           \
+		const struct in6_addr *: TRACERING_T_IPV6,                     \
+		struct prefix *: TRACERING_T_PREFIX,                           \
+		const struct prefix *: TRACERING_T_PREFIX,                     \
+		struct prefix_ipv4 *: TRACERING_T_PREFIX,                      \
+		const struct prefix_ipv4 *: TRACERING_T_PREFIX,                \
+		struct prefix_ipv6 *: TRACERING_T_PREFIX,                      \
+		const struct prefix_ipv6 *: TRACERING_T_PREFIX),               \
+	/* end */
+
+#define _TRACERING_SIZE(x)                                                     \
+	+ _Generic((x),                                                        \
+		long: 8,                                                       \
+		long long: 8,                                                  \
+		unsigned long: 8,                                              \
+		unsigned long long: 8,                                         \
+		void *: 8,                                                     \
+		const void *: 8,                                               \
+		struct in6_addr *: 16,                                         \
+		const struct in6_addr *: 16,                                   \
+		struct prefix *: TRACERING_PREFIX_SIZE,                        \
+		const struct prefix *: TRACERING_PREFIX_SIZE,                  \
+		struct prefix_ipv4 *: TRACERING_PREFIX_SIZE,                   \
+		const struct prefix_ipv4 *: TRACERING_PREFIX_SIZE,             \
+		struct prefix_ipv6 *: TRACERING_PREFIX_SIZE,                   \
+		const struct prefix_ipv6 *: TRACERING_PREFIX_SIZE,             \
+		default: 4)                                                    \
+	/* end */
+
+#define _TRACERING_PUT(x)                                                      \
+	_pos = _Generic((x),                                                   \
+		_Bool: tracering_put_u32,                                      \
+		char: tracering_put_i32,                                       \
+		signed char: tracering_put_i32,                                \
+		short: tracering_put_i32,                                      \
+		int: tracering_put_i32,                                        \
+		unsigned char: tracering_put_u32,                              \
+		unsigned short: tracering_put_u32,                             \
+		unsigned int: tracering_put_u32,                               \
+		long: tracering_put_i64,                                       \
+		long long: tracering_put_i64,                                  \
+		unsigned long: tracering_put_u64,                              \
+		unsigned long long: tracering_put_u64,                         \
+		void *: tracering_put_ptr,                                     \
+		const void *: tracering_put_ptr,                               \
+		struct in_addr: tracering_put_in4,                             \
+		struct in_addr *: tracering_put_in4p,                          \
+		const struct in_addr *: tracering_put_in4p,                    \
+		struct in6_addr *: tracering_put_in6p,                         \
+		const struct in6_addr *: tracering_put_in6p,                   \
+		struct prefix *: tracering_put_prefix,                         \
+		const struct prefix *: tracering_put_prefix,                   \
+		struct prefix_ipv4 *: tracering_put_prefix,                    \
+		const struct prefix_ipv4 *: tracering_put_prefix,              \
+		struct prefix_ipv6 *: tracering_put_prefix,                    \
+		const struct prefix_ipv6 *: tracering_put_prefix)(_pos, (x));  \
+	/* end */
+/* clang-format on */
+
+#define tracering(name_, ...)                                                  \
+	do {                                                                   \
+		static struct xrefdata _xrefdata = {                           \
+			.xref = NULL,                                          \
+			.uid = {},                                             \
+			.hashstr = (name_),                                    \
+			.hashu32 = {0, 0},                                     \
+		};                                                             \
+		static const struct xref_tracering _xref __attribute__(        \
+			(used)) = {                                            \
+			.xref = XREF_INIT(XREFT_TRACERING, &_xrefdata,         \
+					  __func__),                           \
+			.name = (name_),                                       \
+			.args = (#__VA_ARGS__),                                \
+			.types = {MACRO_REPEAT(_TRACERING_TYPE,                \
+					       ##__VA_ARGS__) 0},              \
+		};                                                             \
+		_Static_assert(0 MACRO_REPEAT(_TRACERING_SIZE, ##__VA_ARGS__) \
+				      <= TRACERING_DATA,                       \
+			      "too many tracering() arguments");               \
+		XREF_LINK(_xref.xref);                                         \
+		struct tracering_rec *_rec = tracering_slot(&_xref);           \
+		if (_rec) {                                                    \
+			uint8_t *_pos = _rec->data;                            \
+			MACRO_REPEAT(_TRACERING_PUT, ##__VA_ARGS__)            \
+			(void)_pos;                                            \
+		}                                                              \
+	} while (0)
+
+/* number of records per pthread, rounded up to a power of 2;  0 disables
+ * recording.  Rings of running pthreads are resized on their next record.
+ */
+extern void tracering_set(unsigned int records);
+extern unsigned int tracering_get(void);
+
+struct tracering_stats {
+	size_t rings;
+	size_t tracepoints;
+	uint64_t recorded;
+	size_t bytes;
+};
+extern void tracering_get_stats(struct tracering_stats *stats);
+
+/* frees all rings and stops recording, for shutdown */
+extern void tracering_fini(void);
+
+/* writes all rings to fd, returns 0 or -1 with errno set */
+extern int tracering_dump(int fd);
+
+/* async-signal-safe, for the crash handler;  writes "tracering" into the
+ * zlog tmpdir.
+ */
+extern void tracering_crashdump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_TRACERING_H */
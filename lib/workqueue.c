@@ -267,6 +267,9 @@ void work_queue_run(struct event *thread)
 	if (wq->cycles.granularity == 0)
 		wq->cycles.granularity = WORK_QUEUE_MIN_GRANULARITY;
 
+	if (wq->spec.run_begin)
+		wq->spec.run_begin(wq);
+
 	STAILQ_FOREACH_SAFE (item, &wq->items, wq, titem) {
 		assert(item->data);
 
@@ -327,6 +330,8 @@ void work_queue_run(struct event *thread)
 	}
 
 stats:
+	if (wq->spec.run_end)
+		wq->spec.run_end(wq);
 
 #define WQ_HYSTERESIS_FACTOR 4
 
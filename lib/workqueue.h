@@ -69,6 +69,13 @@ struct work_queue {
 		 */
 		void (*completion_func)(struct work_queue *);
 
+		/* called before and after each run of the queue, optional.
+		 * Lets the user bracket a run of items, e.g. to batch work
+		 * generated by them.
+		 */
+		void (*run_begin)(struct work_queue *);
+		void (*run_end)(struct work_queue *);
+
 		/* max number of retries to make for item that errors */
 		unsigned int max_retries;
 
@@ -24,6 +24,7 @@ enum xref_type {
 
 	XREFT_LOGMSG = 0x200,
 	XREFT_ASSERT = 0x280,
+	XREFT_TRACERING = 0x290,
 
 	XREFT_DEFUN = 0x300,
 	XREFT_INSTALL_ELEMENT = 0x301,
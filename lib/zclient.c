@@ -83,6 +83,7 @@ struct zclient *zclient_new(struct event_loop *master,
 
 	zclient->synchronous = opt->synchronous;
 	zclient->auxiliary = opt->auxiliary;
+	zclient->redist_batch = true;
 
 	return zclient;
 }
@@ -96,6 +97,8 @@ void zclient_free(struct zclient *zclient)
 {
 	if (zclient->ibuf)
 		stream_free(zclient->ibuf);
+	if (zclient->ibuf_batch)
+		stream_free(zclient->ibuf_batch);
 	if (zclient->obuf)
 		stream_free(zclient->obuf);
 	if (zclient->wb)
@@ -190,6 +193,10 @@ void zclient_stop(struct zclient *zclient)
 	}
 	zclient->fail = 0;
 
+	/* A fresh session starts without backpressure */
+	zclient->bp_engaged = false;
+	zclient->bp_window = 0;
+
 	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
 		for (i = 0; i < ZEBRA_ROUTE_MAX; i++) {
 			vrf_bitmap_free(&zclient->redist[afi][i]);
@@ -409,6 +416,7 @@ enum zclient_send_status zclient_send_hello(struct zclient *zclient)
 			stream_putc(s, 1);
 		else
 			stream_putc(s, 0);
+		stream_putc(s, zclient->redist_batch);
 
 		stream_putw_at(s, 0, stream_get_endp(s));
 		return zclient_send_message(zclient);
@@ -4299,10 +4307,79 @@ static int zclient_nexthop_update(ZAPI_CALLBACK_ARGS)
 	return 0;
 }
 
+int zapi_backpressure_encode(struct stream *s,
+			     const struct zapi_backpressure *bp)
+{
+	stream_reset(s);
+	zclient_create_header(s, ZEBRA_CLIENT_BACKPRESSURE, VRF_DEFAULT);
+
+	stream_putc(s, bp->engaged);
+	stream_putl(s, bp->window);
+	stream_putl(s, bp->depth);
+
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	return 0;
+}
+
+int zapi_backpressure_decode(struct stream *s, struct zapi_backpressure *bp)
+{
+	uint8_t engaged;
+
+	memset(bp, 0, sizeof(*bp));
+
+	STREAM_GETC(s, engaged);
+	STREAM_GETL(s, bp->window);
+	STREAM_GETL(s, bp->depth);
+
+	bp->engaged = !!engaged;
+
+	return 0;
+
+stream_failure:
+	return -1;
+}
+
+bool zclient_backpressure_consume(struct zclient *zclient)
+{
+	if (!zclient->bp_engaged)
+		return true;
+
+	if (zclient->bp_window == 0)
+		return false;
+
+	zclient->bp_window--;
+	return true;
+}
+
+static int zclient_backpressure(ZAPI_CALLBACK_ARGS)
+{
+	struct zapi_backpressure bp;
+
+	if (zapi_backpressure_decode(zclient->ibuf, &bp) < 0) {
+		zlog_err("failed to decode backpressure update");
+		return -1;
+	}
+
+	if (zclient_debug && bp.engaged != zclient->bp_engaged)
+		zlog_debug("zclient %p backpressure %s, window %u depth %u",
+			   zclient, bp.engaged ? "engaged" : "released",
+			   bp.window, bp.depth);
+
+	zclient->bp_engaged = bp.engaged;
+	zclient->bp_window = bp.window;
+
+	if (zclient->zebra_backpressure)
+		zclient->zebra_backpressure(zclient);
+
+	return 0;
+}
+
 static zclient_handler *const lib_handlers[] = {
 	/* fundamentals */
 	[ZEBRA_CAPABILITIES] = zclient_capability_decode,
 	[ZEBRA_ERROR] = zclient_handle_error,
+	[ZEBRA_CLIENT_BACKPRESSURE] = zclient_backpressure,
 
 	/* VRF & interface code is shared in lib */
 	[ZEBRA_VRF_ADD] = zclient_vrf_add,
@@ -4320,6 +4397,72 @@ static zclient_handler *const lib_handlers[] = {
 	[ZEBRA_INTERFACE_BFD_DEST_UPDATE] = zclient_bfd_session_update,
 };
 
+/*
+ * ZEBRA_REDISTRIBUTE_ROUTE_BATCH carries a count followed by complete
+ * ZEBRA_REDISTRIBUTE_ROUTE_ADD/DEL messages, header included.  Each one is
+ * handed to the daemon's handler as if it had been read on its own.
+ */
+static void zclient_redistribute_batch(struct zclient *zclient)
+{
+	struct stream *batch = zclient->ibuf;
+	struct stream *s;
+	uint16_t count, length, command;
+	uint8_t marker, version;
+	vrf_id_t vrf_id;
+	size_t start;
+
+	if (!zclient->ibuf_batch)
+		zclient->ibuf_batch = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	s = zclient->ibuf_batch;
+
+	STREAM_GETW(batch, count);
+	while (count--) {
+		start = stream_get_getp(batch);
+		STREAM_GETW(batch, length);
+		STREAM_GETC(batch, marker);
+		STREAM_GETC(batch, version);
+		STREAM_GETL(batch, vrf_id);
+		STREAM_GETW(batch, command);
+
+		if (marker != ZEBRA_HEADER_MARKER || version != ZSERV_VERSION ||
+		    length < ZEBRA_HEADER_SIZE || length > STREAM_SIZE(s) ||
+		    start + length > stream_get_endp(batch))
+			goto stream_failure;
+
+		stream_reset(s);
+		stream_put(s, STREAM_DATA(batch) + start, length);
+		stream_set_getp(s, ZEBRA_HEADER_SIZE);
+		stream_set_getp(batch, start + length);
+
+		if (zclient_debug)
+			zlog_debug("zclient %p batched command %s VRF %u",
+				   zclient, zserv_command_string(command),
+				   vrf_id);
+
+		if (command < zclient->n_handlers &&
+		    zclient->handlers[command]) {
+			zclient->ibuf = s;
+			zclient->handlers[command](command, zclient,
+						   length - ZEBRA_HEADER_SIZE,
+						   vrf_id);
+			zclient->ibuf = batch;
+		}
+
+		/* zclient_stop() in the handler reset s, not the real ibuf */
+		if (zclient->sock < 0) {
+			stream_reset(batch);
+			return;
+		}
+	}
+
+	return;
+
+stream_failure:
+	flog_err(EC_LIB_ZAPI_MISSMATCH,
+		 "%s: socket %d malformed redistribution batch", __func__,
+		 zclient->sock);
+}
+
 /* Zebra client message read function. */
 static void zclient_read(struct event *thread)
 {
@@ -4423,6 +4566,8 @@ static void zclient_read(struct event *thread)
 		zlog_debug("zclient %p command %s VRF %u", zclient,
 			   zserv_command_string(command), vrf_id);
 
+	if (command == ZEBRA_REDISTRIBUTE_ROUTE_BATCH)
+		zclient_redistribute_batch(zclient);
 	if (!zclient->auxiliary && command < array_size(lib_handlers) &&
 	    lib_handlers[command])
 		lib_handlers[command](command, zclient, length, vrf_id);
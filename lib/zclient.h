@@ -235,6 +235,8 @@ typedef enum {
 	ZEBRA_TC_FILTER_ADD,
 	ZEBRA_TC_FILTER_DELETE,
 	ZEBRA_OPAQUE_NOTIFY,
+	ZEBRA_CLIENT_BACKPRESSURE,
+	ZEBRA_REDISTRIBUTE_ROUTE_BATCH,
 } zebra_message_types_t;
 /* Zebra message types. Please update the corresponding
  * command_types array with any changes!
@@ -307,6 +309,9 @@ struct zclient {
 	/* Is this a synchronous client? */
 	bool synchronous;
 
+	/* Accept ZEBRA_REDISTRIBUTE_ROUTE_BATCH messages (announced in HELLO) */
+	bool redist_batch;
+
 	/* Auxiliary clients don't execute standard library handlers
 	 * (which otherwise would duplicate VRF/interface add/delete/etc.
 	 */
@@ -327,6 +332,9 @@ struct zclient {
 	/* Input buffer for zebra message. */
 	struct stream *ibuf;
 
+	/* Single message of a ZEBRA_REDISTRIBUTE_ROUTE_BATCH being handled. */
+	struct stream *ibuf_batch;
+
 	/* Output buffer for zebra message. */
 	struct stream *obuf;
 
@@ -380,6 +388,18 @@ struct zclient {
 	 */
 	void (*zebra_buffer_write_ready)(void);
 
+	/*
+	 * ZAPI backpressure signalled by zebra when its rib meta-queue
+	 * and dataplane queues grow too deep.  While engaged, the client
+	 * may send at most bp_window more route updates; zebra refreshes
+	 * the window periodically and eventually releases the throttle.
+	 * The callback is invoked on every update so that daemons can
+	 * resume any route pushes they deferred.
+	 */
+	bool bp_engaged;
+	uint32_t bp_window;
+	void (*zebra_backpressure)(struct zclient *zclient);
+
 	zclient_handler *const *handlers;
 	size_t n_handlers;
 };
@@ -1348,6 +1368,29 @@ extern int zapi_client_close_notify_decode(struct stream *s,
 
 extern int zclient_send_zebra_gre_request(struct zclient *client,
 					  struct interface *ifp);
+
+/* ZAPI backpressure state carried by ZEBRA_CLIENT_BACKPRESSURE */
+struct zapi_backpressure {
+	bool engaged;
+	/* Route updates the client may still send while engaged */
+	uint32_t window;
+	/* Combined zebra meta-queue and dataplane depth, informational */
+	uint32_t depth;
+};
+
+extern int zapi_backpressure_encode(struct stream *s,
+				    const struct zapi_backpressure *bp);
+extern int zapi_backpressure_decode(struct stream *s,
+				    struct zapi_backpressure *bp);
+
+/*
+ * Account for one route update about to be sent to zebra.  Returns false
+ * if zebra has engaged backpressure and the client's window is used up;
+ * the caller should then defer the update until the zebra_backpressure
+ * callback fires.
+ */
+extern bool zclient_backpressure_consume(struct zclient *zclient);
+
 #ifdef __cplusplus
 }
 #endif
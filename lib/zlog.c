@@ -49,6 +49,7 @@
 #include "atomlist.h"
 #include "printfrr.h"
 #include "frrcu.h"
+#include "pthread_local.h"
 #include "zlog.h"
 #include "zlog_live.h"
 #include "libfrr_trace.h"
@@ -56,6 +57,7 @@
 
 DEFINE_MTYPE_STATIC(LIB, LOG_MESSAGE,  "log message");
 DEFINE_MTYPE_STATIC(LIB, LOG_TLSBUF,   "log thread-local buffer");
+DEFINE_MTYPE_STATIC(LIB, LOG_ASYNC,    "log asynchronous ring buffer");
 
 DEFINE_HOOK(zlog_init, (const char *progname, const char *protoname,
 			unsigned short instance, uid_t uid, gid_t gid),
@@ -223,8 +225,7 @@ static inline void zlog_tls_set(struct zlog_tls *val)
 }
 #endif
 
-#ifdef CAN_DO_TLS
-static intmax_t zlog_gettid(void)
+intmax_t zlog_gettid(void)
 {
 #ifndef __OpenBSD__
 	/* accessing a TLS variable is much faster than a syscall */
@@ -259,6 +260,8 @@ static intmax_t zlog_gettid(void)
 	return rv;
 }
 
+#ifdef CAN_DO_TLS
+
 void zlog_tls_buffer_init(void)
 {
 	struct zlog_tls *zlog_tls;
@@ -452,26 +455,32 @@ static void vzlog_notls(const struct xref_logmsg *xref, int prio,
 		XFREE(MTYPE_LOG_MESSAGE, msg->text);
 }
 
-static void vzlog_tls(struct zlog_tls *zlog_tls, const struct xref_logmsg *xref,
-		      int prio, const char *fmt, va_list ap)
+static bool zlog_prio_wanted(int prio)
 {
 	struct zlog_target *zt;
-	struct zlog_msg *msg;
-	char *buf;
-	bool ignoremsg = true;
-	bool immediate = zlog_default_immediate;
+	bool wanted = false;
 
-	/* avoid further processing cost if no target wants this message */
 	rcu_read_lock();
 	frr_each (zlog_targets, &zlog_targets, zt) {
 		if (prio > zt->prio_min)
 			continue;
-		ignoremsg = false;
+		wanted = true;
 		break;
 	}
 	rcu_read_unlock();
 
-	if (ignoremsg)
+	return wanted;
+}
+
+static void vzlog_tls(struct zlog_tls *zlog_tls, const struct xref_logmsg *xref,
+		      int prio, const char *fmt, va_list ap)
+{
+	struct zlog_msg *msg;
+	char *buf;
+	bool immediate = zlog_default_immediate;
+
+	/* avoid further processing cost if no target wants this message */
+	if (!zlog_prio_wanted(prio))
 		return;
 
 	msg = &zlog_tls->msgs[zlog_tls->nmsgs];
@@ -521,6 +530,455 @@ static void vzlog_tls(struct zlog_tls *zlog_tls, const struct xref_logmsg *xref,
 		XFREE(MTYPE_LOG_MESSAGE, msg->text);
 }
 
+/* asynchronous output
+ *
+ * This is optional and enabled with zlog_set_async().  Each pthread copies
+ * its formatted messages into a ring buffer of its own, and a dedicated
+ * logging pthread hands them to the log targets in batches, which write
+ * them out with writev() or sendmmsg().  Nothing on the producer side takes
+ * a lock, unless the logging pthread is asleep and needs a wakeup.  If a
+ * ring is full, the message is dropped and counted; the logging pthread
+ * then reports the number of dropped messages in the log itself.
+ *
+ * Messages from different pthreads may be written slightly out of order,
+ * but carry the time of the zlog call.  Unlike the per-thread buffers above,
+ * the rings aren't backed by a file, so messages still in a ring are lost if
+ * the daemon crashes.
+ */
+
+#define ZLOG_ASYNC_BATCH	TLS_LOG_MAXMSG
+#define ZLOG_ASYNC_ALIGN	8
+
+struct zlog_async_rec {
+	/* whole record including alignment */
+	uint32_t len;
+	/* -1 for filler up to the end of the ring */
+	int32_t prio;
+
+	struct timespec ts;
+	const struct xref_logmsg *xref;
+	const char *fmt;
+	intmax_t tid;
+	uint32_t textlen, hdrlen;
+	uint32_t n_argpos;
+
+	/* followed by the text, with trailing \n\0 */
+	struct fmt_outpos argpos[];
+};
+
+struct zlog_async_ring {
+	struct zlog_async_ring *next;
+
+	/* free-running positions, head is written only by the pthread owning
+	 * the ring and tail only by the logging pthread
+	 */
+	atomic_size_t head, tail;
+	atomic_size_t dropped;
+	size_t dropped_seen;
+	/* pthread has exited, free once empty */
+	bool dead;
+
+	size_t size;
+	char *buf;
+};
+
+static pthread_mutex_t zlog_async_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t zlog_async_cond = PTHREAD_COND_INITIALIZER;
+static pthread_t zlog_async_pthread;
+
+/* below are protected by zlog_async_mtx */
+static struct zlog_async_ring *zlog_async_rings;
+static bool zlog_async_run;
+static size_t zlog_async_written, zlog_async_dropped_dead;
+
+static atomic_bool zlog_async_active, zlog_async_sleeping;
+static atomic_size_t zlog_async_bufsize = ZLOG_ASYNC_BUFSIZE_DEFAULT;
+
+static void zlog_async_ring_free(struct zlog_async_ring *ring);
+static size_t zlog_async_drain(void);
+DEFINE_PTHREAD_LOCAL(zlog_async_tls, struct zlog_async_ring,
+		     zlog_async_ring_free);
+
+/* (re)allocates this pthread's ring after the size was changed */
+static struct zlog_async_ring *zlog_async_ring_get(void)
+{
+	struct zlog_async_ring *ring, *old = zlog_async_tls_get();
+	size_t size = atomic_load_explicit(&zlog_async_bufsize,
+					   memory_order_relaxed);
+
+	if (likely(old && old->size == size))
+		return old;
+
+	ring = XCALLOC(MTYPE_LOG_ASYNC, sizeof(*ring));
+	ring->size = size;
+	ring->buf = XMALLOC(MTYPE_LOG_ASYNC, ring->size);
+
+	pthread_mutex_lock(&zlog_async_mtx);
+	if (old) {
+		/* rings are drained in list order, putting the new one right
+		 * behind the old one keeps this pthread's messages in order
+		 */
+		ring->next = old->next;
+		old->next = ring;
+		old->dead = true;
+		if (!zlog_async_run)
+			zlog_async_drain();
+	} else {
+		ring->next = zlog_async_rings;
+		zlog_async_rings = ring;
+	}
+	pthread_mutex_unlock(&zlog_async_mtx);
+
+	zlog_async_tls_set(ring);
+	return ring;
+}
+
+static void vzlog_async(const struct xref_logmsg *xref, int prio,
+			const char *fmt, va_list ap)
+{
+	struct zlog_async_ring *ring = zlog_async_ring_get();
+	struct zlog_async_rec *rec;
+	struct zlog_msg stackmsg = {
+		.prio = prio & LOG_PRIMASK,
+		.fmt = fmt,
+		.xref = xref,
+	}, *msg = &stackmsg;
+	char stackbuf[512], *text;
+	size_t head, tail, off, need, argsz, textlen, pad = 0;
+
+	head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+	off = head & (ring->size - 1);
+
+	/* don't bother formatting the message if it can't fit anyway */
+	if (ring->size - (head - tail) < sizeof(*rec) + 64) {
+		atomic_fetch_add_explicit(&ring->dropped, 1,
+					  memory_order_relaxed);
+		return;
+	}
+
+	clock_gettime(CLOCK_REALTIME, &msg->ts);
+	va_copy(msg->args, ap);
+	msg->stackbuf = stackbuf;
+	msg->stackbufsz = sizeof(stackbuf);
+
+	zlog_msg_text(msg, &textlen);
+
+	argsz = msg->n_argpos * sizeof(msg->argpos[0]);
+	need = sizeof(*rec) + argsz + textlen + 2;
+	need = (need + ZLOG_ASYNC_ALIGN - 1) & ~(size_t)(ZLOG_ASYNC_ALIGN - 1);
+
+	/* records don't wrap around, skip the rest of the ring instead */
+	if (need > ring->size - off)
+		pad = ring->size - off;
+
+	if (need > ring->size / 4 || head + pad + need - tail > ring->size) {
+		atomic_fetch_add_explicit(&ring->dropped, 1,
+					  memory_order_relaxed);
+		goto out;
+	}
+
+	if (pad) {
+		rec = (struct zlog_async_rec *)(ring->buf + off);
+		rec->len = pad;
+		rec->prio = -1;
+		head += pad;
+		off = 0;
+	}
+
+	rec = (struct zlog_async_rec *)(ring->buf + off);
+	rec->len = need;
+	rec->prio = msg->prio;
+	rec->ts = msg->ts;
+	rec->xref = xref;
+	rec->fmt = fmt;
+	zlog_msg_pid(msg, &(intmax_t){ 0 }, &rec->tid);
+	rec->textlen = textlen;
+	rec->hdrlen = msg->hdrlen;
+	rec->n_argpos = msg->n_argpos;
+	memcpy(rec->argpos, msg->argpos, argsz);
+
+	text = (char *)rec->argpos + argsz;
+	memcpy(text, msg->text, textlen + 1);
+	text[textlen + 1] = '\0';
+
+	/* pairs with zlog_async_sleeping in zlog_async_thread() */
+	atomic_store_explicit(&ring->head, head + need, memory_order_seq_cst);
+
+	if (atomic_load_explicit(&zlog_async_sleeping, memory_order_seq_cst)) {
+		pthread_mutex_lock(&zlog_async_mtx);
+		pthread_cond_signal(&zlog_async_cond);
+		pthread_mutex_unlock(&zlog_async_mtx);
+	}
+
+out:
+	va_end(msg->args);
+	if (msg->text && msg->text != stackbuf)
+		XFREE(MTYPE_LOG_MESSAGE, msg->text);
+}
+
+/* zlog_async_mtx held */
+static void zlog_async_output(struct zlog_msg **msgp, size_t nmsgs)
+{
+	struct zlog_target *zt;
+
+	rcu_read_lock();
+	frr_each_safe (zlog_targets, &zlog_targets, zt) {
+		if (!zt->logfn)
+			continue;
+
+		zt->logfn(zt, msgp, nmsgs);
+	}
+	rcu_read_unlock();
+
+	zlog_async_written += nmsgs;
+}
+
+/* zlog_async_mtx held; returns number of messages written */
+static size_t zlog_async_drain_ring(struct zlog_async_ring *ring)
+{
+	/* only used under zlog_async_mtx, and too big for the stack */
+	static struct zlog_msg msgs[ZLOG_ASYNC_BATCH];
+	static struct zlog_msg *msgp[ZLOG_ASYNC_BATCH];
+	struct zlog_async_rec *rec;
+	struct zlog_msg *msg;
+	size_t head, pos, dropped, n = 0, total = 0;
+	intmax_t pid;
+	char dropbuf[96];
+
+	pos = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+	head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+	while (pos != head) {
+		rec = (struct zlog_async_rec *)(ring->buf
+						+ (pos & (ring->size - 1)));
+		pos += rec->len;
+		if (rec->prio < 0)
+			continue;
+
+		msg = msgp[n] = &msgs[n];
+		memset(msg, 0, sizeof(*msg));
+		msg->ts = rec->ts;
+		msg->prio = rec->prio;
+		msg->fmt = rec->fmt;
+		msg->xref = rec->xref;
+		msg->text = (char *)rec->argpos
+			    + rec->n_argpos * sizeof(rec->argpos[0]);
+		msg->textlen = rec->textlen;
+		msg->hdrlen = rec->hdrlen;
+		zlog_msg_pid(msg, &msg->pid, &pid);
+		msg->tid = rec->tid;
+		msg->n_argpos = rec->n_argpos;
+		memcpy(msg->argpos, rec->argpos,
+		       rec->n_argpos * sizeof(rec->argpos[0]));
+
+		if (++n < ZLOG_ASYNC_BATCH)
+			continue;
+
+		zlog_async_output(msgp, n);
+		atomic_store_explicit(&ring->tail, pos, memory_order_release);
+		total += n;
+		n = 0;
+	}
+
+	if (n) {
+		zlog_async_output(msgp, n);
+		total += n;
+	}
+	atomic_store_explicit(&ring->tail, pos, memory_order_release);
+
+	dropped = atomic_load_explicit(&ring->dropped, memory_order_relaxed);
+	if (dropped != ring->dropped_seen) {
+		msg = msgp[0] = &msgs[0];
+		memset(msg, 0, sizeof(*msg));
+		clock_gettime(CLOCK_REALTIME, &msg->ts);
+		msg->prio = LOG_WARNING;
+		msg->text = dropbuf;
+		msg->textlen = snprintfrr(dropbuf, sizeof(dropbuf) - 1,
+					  "%zu log messages dropped, asynchronous log buffer full",
+					  dropped - ring->dropped_seen);
+		strlcat(dropbuf, "\n", sizeof(dropbuf));
+		msg->fmt = msg->text;
+
+		zlog_async_output(msgp, 1);
+		ring->dropped_seen = dropped;
+	}
+	return total;
+}
+
+/* zlog_async_mtx held */
+static size_t zlog_async_drain(void)
+{
+	struct zlog_async_ring *ring, **prevp = &zlog_async_rings;
+	size_t total = 0;
+
+	while ((ring = *prevp)) {
+		total += zlog_async_drain_ring(ring);
+
+		if (!ring->dead) {
+			prevp = &ring->next;
+			continue;
+		}
+
+		*prevp = ring->next;
+		zlog_async_dropped_dead += atomic_load_explicit(
+			&ring->dropped, memory_order_relaxed);
+		XFREE(MTYPE_LOG_ASYNC, ring->buf);
+		XFREE(MTYPE_LOG_ASYNC, ring);
+	}
+	return total;
+}
+
+/* zlog_async_mtx held */
+static bool zlog_async_pending(void)
+{
+	struct zlog_async_ring *ring;
+
+	for (ring = zlog_async_rings; ring; ring = ring->next)
+		if (atomic_load_explicit(&ring->head, memory_order_seq_cst) !=
+		    atomic_load_explicit(&ring->tail, memory_order_relaxed))
+			return true;
+	return false;
+}
+
+static void zlog_async_ring_free(struct zlog_async_ring *ring)
+{
+	pthread_mutex_lock(&zlog_async_mtx);
+	/* the logging pthread, or the one below, frees the ring once empty */
+	ring->dead = true;
+	if (!zlog_async_run)
+		zlog_async_drain();
+	pthread_mutex_unlock(&zlog_async_mtx);
+}
+
+static void *zlog_async_thread(void *arg)
+{
+	struct rcu_thread *rcu_thread = arg;
+	struct timespec ts;
+
+	rcu_thread_start(rcu_thread);
+	rcu_read_unlock();
+
+	pthread_mutex_lock(&zlog_async_mtx);
+	while (zlog_async_run) {
+		if (zlog_async_drain())
+			continue;
+
+		atomic_store_explicit(&zlog_async_sleeping, true,
+				      memory_order_seq_cst);
+		if (!zlog_async_pending()) {
+			/* wakeups can't get lost, but be safe anyway */
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_sec++;
+			pthread_cond_timedwait(&zlog_async_cond,
+					       &zlog_async_mtx, &ts);
+		}
+		atomic_store_explicit(&zlog_async_sleeping, false,
+				      memory_order_seq_cst);
+	}
+	zlog_async_drain();
+	pthread_mutex_unlock(&zlog_async_mtx);
+	return NULL;
+}
+
+static void zlog_async_start(void)
+{
+	struct rcu_thread *rcu_thread;
+	sigset_t blocksigs, oldsigs;
+	int ret;
+
+	zlog_async_run = true;
+
+	/* signals are handled on the main pthread */
+	sigfillset(&blocksigs);
+	pthread_sigmask(SIG_BLOCK, &blocksigs, &oldsigs);
+
+	rcu_thread = rcu_thread_prepare();
+	ret = pthread_create(&zlog_async_pthread, NULL, zlog_async_thread,
+			     rcu_thread);
+
+	pthread_sigmask(SIG_SETMASK, &oldsigs, NULL);
+
+	if (ret) {
+		rcu_thread_unprepare(rcu_thread);
+		zlog_async_run = false;
+		zlog_err("failed to start asynchronous logging: %s",
+			 strerror(ret));
+		return;
+	}
+
+	atomic_store_explicit(&zlog_async_active, true, memory_order_release);
+}
+
+static void zlog_async_stop(void)
+{
+	struct zlog_async_ring *ring;
+
+	atomic_store_explicit(&zlog_async_active, false, memory_order_release);
+
+	pthread_mutex_lock(&zlog_async_mtx);
+	zlog_async_run = false;
+	pthread_cond_signal(&zlog_async_cond);
+	pthread_mutex_unlock(&zlog_async_mtx);
+
+	pthread_join(zlog_async_pthread, NULL);
+
+	/* other pthreads' rings stay until they exit, as they might be
+	 * in the middle of using them
+	 */
+	ring = zlog_async_tls_get();
+	if (ring) {
+		zlog_async_tls_set(NULL);
+		zlog_async_ring_free(ring);
+	}
+}
+
+void zlog_set_async(bool enable, size_t bufsize)
+{
+	size_t size = 4096;
+
+	while (size < bufsize && size < ZLOG_ASYNC_BUFSIZE_MAX)
+		size <<= 1;
+	atomic_store_explicit(&zlog_async_bufsize, size, memory_order_relaxed);
+
+	if (enable == atomic_load_explicit(&zlog_async_active,
+					   memory_order_relaxed))
+		return;
+
+	if (enable)
+		zlog_async_start();
+	else
+		zlog_async_stop();
+}
+
+bool zlog_get_async(size_t *bufsize)
+{
+	if (bufsize)
+		*bufsize = atomic_load_explicit(&zlog_async_bufsize,
+						memory_order_relaxed);
+	return atomic_load_explicit(&zlog_async_active, memory_order_relaxed);
+}
+
+void zlog_async_get_stats(struct zlog_async_stats *stats)
+{
+	struct zlog_async_ring *ring;
+
+	memset(stats, 0, sizeof(*stats));
+
+	pthread_mutex_lock(&zlog_async_mtx);
+	stats->written = zlog_async_written;
+	stats->dropped = zlog_async_dropped_dead;
+	for (ring = zlog_async_rings; ring; ring = ring->next) {
+		stats->n_rings++;
+		stats->pending +=
+			atomic_load_explicit(&ring->head, memory_order_relaxed) -
+			atomic_load_explicit(&ring->tail, memory_order_relaxed);
+		stats->dropped += atomic_load_explicit(&ring->dropped,
+						       memory_order_relaxed);
+	}
+	pthread_mutex_unlock(&zlog_async_mtx);
+}
+
 /* reinject log message received by zlog_recirculate_recv().  As of writing,
  * only used in the ldpd parent process to proxy messages from lde/ldpe
  * subprocesses.
@@ -718,7 +1176,13 @@ void vzlogx(const struct xref_logmsg *xref, int prio,
 	XFREE(MTYPE_LOG_MESSAGE, msg);
 #endif
 
-	if (zlog_tls)
+	if (atomic_load_explicit(&zlog_async_active, memory_order_acquire)
+	    && !zlog_default_immediate
+	    && !pthread_equal(pthread_self(), zlog_async_pthread)
+	    && !zlog_async_tls_exited()) {
+		if (zlog_prio_wanted(prio))
+			vzlog_async(xref, prio, fmt, ap);
+	} else if (zlog_tls)
 		vzlog_tls(zlog_tls, xref, prio, fmt, ap);
 	else
 		vzlog_notls(xref, prio, fmt, ap);
@@ -1150,6 +1614,8 @@ out_warn:
 
 void zlog_fini(void)
 {
+	zlog_set_async(false, 0);
+
 	hook_call(zlog_fini);
 
 	if (zlog_tmpdirfd >= 0) {
@@ -189,6 +189,7 @@ extern size_t zlog_msg_ts_3164(struct zlog_msg *msg, struct fbuf *out,
  * thread's messages
  */
 extern void zlog_msg_pid(struct zlog_msg *msg, intmax_t *pid, intmax_t *tid);
+extern intmax_t zlog_gettid(void);
 
 /* This list & struct implements the actual logging targets.  It is accessed
  * lock-free from all threads, and thus MUST only be changed atomically, i.e.
@@ -281,6 +282,29 @@ extern void zlog_tls_buffer_fini(void);
 extern void zlog_set_immediate(bool set_p);
 bool zlog_get_immediate_mode(void);
 
+/* Asynchronous output: each pthread queues its messages in a ring buffer
+ * of bufsize bytes (rounded up to a power of 2), which a dedicated pthread
+ * writes out.  Messages are dropped, and counted, when a ring is full.
+ * Takes precedence over per-thread buffering, but not immediate mode.
+ * A new bufsize applies to each pthread's ring from its next message on.
+ */
+#define ZLOG_ASYNC_BUFSIZE_DEFAULT	65536
+#define ZLOG_ASYNC_BUFSIZE_MAX		(1 << 20)
+
+extern void zlog_set_async(bool enable, size_t bufsize);
+extern bool zlog_get_async(size_t *bufsize);
+
+struct zlog_async_stats {
+	/* pthreads with a ring buffer */
+	size_t n_rings;
+	/* bytes queued */
+	size_t pending;
+	size_t written;
+	size_t dropped;
+};
+
+extern void zlog_async_get_stats(struct zlog_async_stats *stats);
+
 extern const char *zlog_priority_str(int priority);
 
 #ifdef __cplusplus
@@ -39,6 +39,16 @@ struct sharp_routes {
 	char opaque[ZAPI_MESSAGE_OPAQUE_LENGTH];
 };
 
+/* Redistributed routes received, for measuring redistribution rates */
+struct sharp_redist_data {
+	uint32_t adds;
+	uint32_t dels;
+
+	/* First and last redistribution message received */
+	struct timeval t_start;
+	struct timeval t_end;
+};
+
 struct sharp_srv6_locator {
 	/* name of locator */
 	char name[SRV6_LOCNAME_SIZE];
@@ -51,6 +61,9 @@ struct sharp_global {
 	/* Global data about route install/deletions */
 	struct sharp_routes r;
 
+	/* Data about redistributed routes */
+	struct sharp_redist_data redist;
+
 	/* The list of nexthops that we are watching and data about them */
 	struct list *nhs;
 
@@ -76,6 +76,8 @@ DEFPY(watch_redistribute, watch_redistribute_cmd,
 	}
 
 	source = proto_redistnum(AFI_IP, argv[argc-1]->text);
+	if (!no)
+		memset(&sg.redist, 0, sizeof(sg.redist));
 	sharp_redistribute_vrf(vrf, source, !no);
 
 	return CMD_SUCCESS;
@@ -199,6 +201,28 @@ DEFPY (install_routes_data_dump,
 	return CMD_SUCCESS;
 }
 
+DEFPY (redistribute_data_dump,
+       redistribute_data_dump_cmd,
+       "sharp data redistribute",
+       "Sharp routing Protocol\n"
+       "Data about what is going on\n"
+       "Redistributed route information\n")
+{
+	struct timeval r;
+	uint64_t usecs, total = sg.redist.adds + sg.redist.dels;
+
+	timersub(&sg.redist.t_end, &sg.redist.t_start, &r);
+	usecs = r.tv_sec * 1000000ULL + r.tv_usec;
+	vty_out(vty, "Added: %u Deleted: %u Time: %jd.%06ld", sg.redist.adds,
+		sg.redist.dels, (intmax_t)r.tv_sec, (long)r.tv_usec);
+	if (usecs)
+		vty_out(vty, " Rate: %" PRIu64 " routes/sec",
+			total * 1000000 / usecs);
+	vty_out(vty, "\n");
+
+	return CMD_SUCCESS;
+}
+
 DEFPY (install_routes,
        install_routes_cmd,
        "sharp install routes [vrf NAME$vrf_name]\
@@ -1440,6 +1464,7 @@ DEFPY (tc_filter_rate,
 void sharp_vty_init(void)
 {
 	install_element(ENABLE_NODE, &install_routes_data_dump_cmd);
+	install_element(ENABLE_NODE, &redistribute_data_dump_cmd);
 	install_element(ENABLE_NODE, &install_routes_cmd);
 	install_element(ENABLE_NODE, &install_seg6_routes_cmd);
 	install_element(ENABLE_NODE, &install_seg6local_routes_cmd);
@@ -696,6 +696,14 @@ static int sharp_redistribute_route(ZAPI_CALLBACK_ARGS)
 		zlog_warn("%s: Decode of redistribute failed: %d", __func__,
 			  ZEBRA_REDISTRIBUTE_ROUTE_ADD);
 
+	if (!sg.redist.adds && !sg.redist.dels)
+		monotime(&sg.redist.t_start);
+	monotime(&sg.redist.t_end);
+	if (cmd == ZEBRA_REDISTRIBUTE_ROUTE_ADD)
+		sg.redist.adds++;
+	else
+		sg.redist.dels++;
+
 	zlog_debug("%s: %pFX (%s)", zserv_command_string(cmd), &api.prefix,
 		   zebra_route_string(api.type));
 
@@ -29,6 +29,10 @@ DUMMY_DEFUN(cmd14,
 	    "pat g {  foo A.B.C.D$foo|foo|bar   X:X::X:X$bar| baz } [final]");
 DUMMY_DEFUN(cmd15, "no pat g ![ WORD ]");
 DUMMY_DEFUN(cmd16, "[no] pat h {foo ![A.B.C.D$foo]|bar X:X::X:X$bar} final");
+DUMMY_DEFUN(cmd17, "amb one");
+DUMMY_DEFUN(cmd18, "amb onetwo");
+DUMMY_DEFUN(cmd19, "amb (1-10)");
+DUMMY_DEFUN(cmd20, "amb (5-20)");
 
 #include "tests/lib/cli/test_cli_clippy.c"
 
@@ -72,5 +76,9 @@ void test_init(int argc, char **argv)
 	install_element(ENABLE_NODE, &cmd14_cmd);
 	install_element(ENABLE_NODE, &cmd15_cmd);
 	install_element(ENABLE_NODE, &cmd16_cmd);
+	install_element(ENABLE_NODE, &cmd17_cmd);
+	install_element(ENABLE_NODE, &cmd18_cmd);
+	install_element(ENABLE_NODE, &cmd19_cmd);
+	install_element(ENABLE_NODE, &cmd20_cmd);
 	install_element(ENABLE_NODE, &magic_test_cmd);
 }
@@ -0,0 +1,380 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures how many lines per second a config file is
+ * loaded at, through config_from_file() like "vtysh -b" and "-f" do.
+ *
+ * The commands use the syntax of the real ones making up the bulk of big
+ * configs (prefix-lists, access-lists, route-maps, static routes, BGP
+ * neighbors), along with some of their siblings.  Their handlers do
+ * nothing, so this is mostly the cost of tokenizing and matching.
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "memory.h"
+#include "monotime.h"
+#include "vty.h"
+#include "prng.h"
+
+struct event_loop *master; /* dummy for libfrr*/
+
+static unsigned long executed;
+
+static int bench_cmd(const struct cmd_element *self, struct vty *vty, int argc,
+		     struct cmd_token *argv[])
+{
+	executed++;
+	return CMD_SUCCESS;
+}
+
+static int bench_rmap(const struct cmd_element *self, struct vty *vty,
+		      int argc, struct cmd_token *argv[])
+{
+	executed++;
+	vty->node = RMAP_NODE;
+	return CMD_SUCCESS;
+}
+
+static int bench_bgp(const struct cmd_element *self, struct vty *vty, int argc,
+		     struct cmd_token *argv[])
+{
+	executed++;
+	vty->node = BGP_NODE;
+	return CMD_SUCCESS;
+}
+
+static int bench_bgp_af(const struct cmd_element *self, struct vty *vty,
+			int argc, struct cmd_token *argv[])
+{
+	executed++;
+	vty->node = BGP_IPV4_NODE;
+	return CMD_SUCCESS;
+}
+
+static int bench_interface(const struct cmd_element *self, struct vty *vty,
+			   int argc, struct cmd_token *argv[])
+{
+	executed++;
+	vty->node = INTERFACE_NODE;
+	return CMD_SUCCESS;
+}
+
+static struct cmd_node rmap_node = {
+	.name = "routemap",
+	.node = RMAP_NODE,
+	.parent_node = CONFIG_NODE,
+	.prompt = "%s(config-route-map)# ",
+};
+
+static struct cmd_node bgp_node = {
+	.name = "bgp",
+	.node = BGP_NODE,
+	.parent_node = CONFIG_NODE,
+	.prompt = "%s(config-router)# ",
+};
+
+static struct cmd_node bgp_ipv4_node = {
+	.name = "bgp ipv4 unicast",
+	.node = BGP_IPV4_NODE,
+	.parent_node = BGP_NODE,
+	.prompt = "%s(config-router-af)# ",
+};
+
+static struct cmd_node interface_node = {
+	.name = "interface",
+	.node = INTERFACE_NODE,
+	.parent_node = CONFIG_NODE,
+	.prompt = "%s(config-if)# ",
+};
+
+#define NEIGHBOR "neighbor <A.B.C.D|X:X::X:X|WORD> "
+
+static const struct {
+	enum node_type node;
+	const char *string;
+	int (*func)(const struct cmd_element *, struct vty *, int,
+		    struct cmd_token *[]);
+} bench_cmds[] = {
+	/* clang-format off */
+	{ CONFIG_NODE, "ip prefix-list PREFIXLIST4_NAME$name [seq (1-4294967295)$seq] <deny|permit>$action <any|A.B.C.D/M$prefix [{ge (0-32)$ge|le (0-32)$le}]>", bench_cmd },
+	{ CONFIG_NODE, "ip prefix-list PREFIXLIST4_NAME$name description LINE...", bench_cmd },
+	{ CONFIG_NODE, "ip prefix-list sequence-number", bench_cmd },
+	{ CONFIG_NODE, "ipv6 prefix-list PREFIXLIST6_NAME$name [seq (1-4294967295)] <deny|permit>$action <any|X:X::X:X/M$prefix [{ge (0-128)$ge|le (0-128)$le}]>", bench_cmd },
+	{ CONFIG_NODE, "ipv6 prefix-list PREFIXLIST6_NAME$name description LINE...", bench_cmd },
+	{ CONFIG_NODE, "access-list ACCESSLIST4_NAME$name [seq (1-4294967295)$seq] <deny|permit>$action <A.B.C.D/M$prefix [exact-match$exact]|any>", bench_cmd },
+	{ CONFIG_NODE, "access-list ACCESSLIST4_NAME$name [seq (1-4294967295)$seq] <deny|permit>$action ip <A.B.C.D$src A.B.C.D$src_mask|host A.B.C.D$src|any> <A.B.C.D$dst A.B.C.D$dst_mask|host A.B.C.D$dst|any>", bench_cmd },
+	{ CONFIG_NODE, "access-list ACCESSLIST4_NAME$name remark LINE...", bench_cmd },
+	{ CONFIG_NODE, "ipv6 access-list ACCESSLIST6_NAME$name [seq (1-4294967295)$seq] <deny|permit>$action <X:X::X:X/M$prefix [exact-match$exact]|any>", bench_cmd },
+	{ CONFIG_NODE, "ip route A.B.C.D/M$prefix <A.B.C.D$gate|<INTERFACE|Null0>$ifname> [{tag (1-4294967295)|(1-255)$distance|vrf NAME|label WORD|table (1-4294967295)}]", bench_cmd },
+	{ CONFIG_NODE, "ipv6 route X:X::X:X/M$prefix [from X:X::X:X/M] <X:X::X:X$gate|<INTERFACE|Null0>$ifname> [{tag (1-4294967295)|(1-255)$distance|vrf NAME|label WORD|table (1-4294967295)}]", bench_cmd },
+	{ CONFIG_NODE, "ip protocol <any|kernel|connected|static|rip|ospf|isis|bgp>$proto route-map RMAP_NAME", bench_cmd },
+	{ CONFIG_NODE, "ip forwarding", bench_cmd },
+	{ CONFIG_NODE, "ipv6 forwarding", bench_cmd },
+	{ CONFIG_NODE, "ip nht resolve-via-default", bench_cmd },
+	{ CONFIG_NODE, "ip import-table (1-252) [distance (1-255)] [route-map RMAP_NAME]", bench_cmd },
+	{ CONFIG_NODE, "bgp as-path access-list AS_PATH_FILTER_NAME [seq (0-4294967295)] <deny|permit> LINE...", bench_cmd },
+	{ CONFIG_NODE, "bgp community-list <(1-99)|standard COMMUNITY_LIST_NAME> [seq (0-4294967295)] <deny|permit> AA:NN...", bench_cmd },
+	{ CONFIG_NODE, "bgp large-community-list standard LCOMMUNITY_LIST_NAME [seq (0-4294967295)] <deny|permit> AA:BB:CC...", bench_cmd },
+	{ CONFIG_NODE, "bgp extcommunity-list <(1-99)|standard EXTCOMMUNITY_LIST_NAME> [seq (0-4294967295)] <deny|permit> AA:NN...", bench_cmd },
+	{ CONFIG_NODE, "bgp route-map delay-timer (0-600)", bench_cmd },
+	{ CONFIG_NODE, "bgp send-extra-data zebra", bench_cmd },
+	{ CONFIG_NODE, "route-map RMAP_NAME <deny|permit> (1-65535)", bench_rmap },
+	{ CONFIG_NODE, "router bgp [ASNUM$instasn [<view|vrf> VIEWVRFNAME] [as-notation <dot|dot+|plain>]]", bench_bgp },
+	{ CONFIG_NODE, "interface IFNAME [vrf NAME$vrf_name]", bench_interface },
+	{ CONFIG_NODE, "vrf NAME", bench_cmd },
+	{ CONFIG_NODE, "router-id A.B.C.D [vrf NAME]", bench_cmd },
+	{ CONFIG_NODE, "mpls label bind <A.B.C.D/M|X:X::X:X/M> <(16-1048575)|implicit-null>", bench_cmd },
+	{ CONFIG_NODE, "mpls lsp (16-1048575) <A.B.C.D|X:X::X:X> <(16-1048575)|explicit-null|implicit-null>", bench_cmd },
+
+	{ RMAP_NODE, "match ip address <(1-199)|(1300-2699)|ACCESSLIST4_NAME>", bench_cmd },
+	{ RMAP_NODE, "match ip address prefix-list PREFIXLIST4_NAME$name", bench_cmd },
+	{ RMAP_NODE, "match ip address prefix-len (0-32)$length", bench_cmd },
+	{ RMAP_NODE, "match ip next-hop address A.B.C.D", bench_cmd },
+	{ RMAP_NODE, "match ip next-hop prefix-list PREFIXLIST4_NAME$name", bench_cmd },
+	{ RMAP_NODE, "match ipv6 address ACCESSLIST6_NAME$name", bench_cmd },
+	{ RMAP_NODE, "match ipv6 address prefix-list PREFIXLIST6_NAME$name", bench_cmd },
+	{ RMAP_NODE, "match as-path AS_PATH_FILTER_NAME", bench_cmd },
+	{ RMAP_NODE, "match community <(1-99)|(100-500)|COMMUNITY_LIST_NAME> [<exact-match$exact|any$any>]", bench_cmd },
+	{ RMAP_NODE, "match large-community <(1-99)|(100-500)|LCOMMUNITY_LIST_NAME> [exact-match]", bench_cmd },
+	{ RMAP_NODE, "match metric (0-4294967295)$metric", bench_cmd },
+	{ RMAP_NODE, "match tag <(1-4294967295)$tagged|default$default>", bench_cmd },
+	{ RMAP_NODE, "match interface INTERFACE", bench_cmd },
+	{ RMAP_NODE, "match source-protocol <bgp|ospf|ospf6|rip|ripng|isis|static|connected|kernel>", bench_cmd },
+	{ RMAP_NODE, "match peer <A.B.C.D$addrv4|X:X::X:X$addrv6|WORD$intf>", bench_cmd },
+	{ RMAP_NODE, "match origin <egp|igp|incomplete>", bench_cmd },
+	{ RMAP_NODE, "set local-preference WORD", bench_cmd },
+	{ RMAP_NODE, "set metric <(-4294967295-4294967295)$metric|rtt$rtt|+rtt$artt|-rtt$srtt>", bench_cmd },
+	{ RMAP_NODE, "set weight (0-4294967295)", bench_cmd },
+	{ RMAP_NODE, "set tag <untagged|(1-4294967295)>", bench_cmd },
+	{ RMAP_NODE, "set as-path prepend ASNUM...", bench_cmd },
+	{ RMAP_NODE, "set as-path prepend last-as (1-10)", bench_cmd },
+	{ RMAP_NODE, "set as-path exclude ASNUM...", bench_cmd },
+	{ RMAP_NODE, "set community AA:NN...", bench_cmd },
+	{ RMAP_NODE, "set large-community AA:BB:CC...", bench_cmd },
+	{ RMAP_NODE, "set ip next-hop A.B.C.D", bench_cmd },
+	{ RMAP_NODE, "set ipv6 next-hop global X:X::X:X", bench_cmd },
+	{ RMAP_NODE, "set origin <egp|igp|incomplete>", bench_cmd },
+	{ RMAP_NODE, "set src <A.B.C.D|X:X::X:X>", bench_cmd },
+	{ RMAP_NODE, "on-match <next|goto (1-65535)>", bench_cmd },
+	{ RMAP_NODE, "call WORD$name", bench_cmd },
+	{ RMAP_NODE, "description LINE...", bench_cmd },
+
+	{ BGP_NODE, "bgp router-id A.B.C.D", bench_cmd },
+	{ BGP_NODE, "bgp log-neighbor-changes", bench_cmd },
+	{ BGP_NODE, "bgp bestpath as-path multipath-relax [<as-set|no-as-set>]", bench_cmd },
+	{ BGP_NODE, "bgp bestpath compare-routerid", bench_cmd },
+	{ BGP_NODE, "bgp deterministic-med", bench_cmd },
+	{ BGP_NODE, "bgp graceful-restart", bench_cmd },
+	{ BGP_NODE, "bgp graceful-restart restart-time (0-4095)", bench_cmd },
+	{ BGP_NODE, "bgp ebgp-requires-policy", bench_cmd },
+	{ BGP_NODE, "bgp default local-preference (0-4294967295)", bench_cmd },
+	{ BGP_NODE, "bgp cluster-id <A.B.C.D|(1-4294967295)>", bench_cmd },
+	{ BGP_NODE, "timers bgp (0-65535) (0-65535)", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "remote-as <ASNUM|internal|external>", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "peer-group PGNAME", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "description LINE...", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "update-source <A.B.C.D|X:X::X:X|WORD>", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "ebgp-multihop [(1-255)]", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "password LINE", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "timers (0-65535) (0-65535)", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "bfd", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "shutdown", bench_cmd },
+	{ BGP_NODE, NEIGHBOR "capability extended-nexthop", bench_cmd },
+	{ BGP_NODE, "address-family ipv4 [<unicast|multicast|vpn|labeled-unicast|flowspec>]", bench_bgp_af },
+
+	{ BGP_IPV4_NODE, "network A.B.C.D/M [{route-map RMAP_NAME|label-index (0-1048560)}]", bench_cmd },
+	{ BGP_IPV4_NODE, "aggregate-address A.B.C.D/M [{as-set|summary-only|route-map RMAP_NAME}]", bench_cmd },
+	{ BGP_IPV4_NODE, "redistribute <kernel|connected|static|rip|ospf|isis|table> [{metric (0-4294967295)|route-map RMAP_NAME}]", bench_cmd },
+	{ BGP_IPV4_NODE, "maximum-paths (1-64)", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "activate", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "route-map RMAP_NAME <in|out>", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "prefix-list PREFIXLIST_NAME <in|out>", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "filter-list AS_PATH_FILTER_NAME <in|out>", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "maximum-prefix (1-4294967295) [(1-100)] [warning-only]", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "soft-reconfiguration inbound", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "next-hop-self [force]", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "route-reflector-client", bench_cmd },
+	{ BGP_IPV4_NODE, NEIGHBOR "send-community [<both|all|extended|standard|large>]", bench_cmd },
+	{ BGP_IPV4_NODE, "exit-address-family", bench_bgp },
+
+	{ INTERFACE_NODE, "description LINE...", bench_cmd },
+	{ INTERFACE_NODE, "ip address A.B.C.D/M [label LINE]", bench_cmd },
+	{ INTERFACE_NODE, "ipv6 address X:X::X:X/M", bench_cmd },
+	{ INTERFACE_NODE, "mtu (68-65535)", bench_cmd },
+	{ INTERFACE_NODE, "shutdown", bench_cmd },
+	{ INTERFACE_NODE, "link-detect", bench_cmd },
+	{ INTERFACE_NODE, "bandwidth (1-1000000)", bench_cmd },
+	/* clang-format on */
+};
+
+static struct cmd_element bench_elements[array_size(bench_cmds)];
+
+static void bench_init(void)
+{
+	size_t i;
+
+	install_node(&rmap_node);
+	install_node(&bgp_node);
+	install_node(&bgp_ipv4_node);
+	install_node(&interface_node);
+
+	install_default(RMAP_NODE);
+	install_default(BGP_NODE);
+	install_default(BGP_IPV4_NODE);
+	install_default(INTERFACE_NODE);
+
+	for (i = 0; i < array_size(bench_cmds); i++) {
+		bench_elements[i].string = bench_cmds[i].string;
+		bench_elements[i].func = bench_cmds[i].func;
+		bench_elements[i].name = bench_cmds[i].string;
+		_install_element(bench_cmds[i].node, &bench_elements[i]);
+	}
+}
+
+/* roughly what a config with a lot of policy looks like;  returns the
+ * number of lines written.
+ */
+static unsigned int write_config(FILE *fp, struct prng *prng,
+				 unsigned int lines)
+{
+	unsigned int n = 0, i, r, a, b;
+
+	while (n < lines) {
+		r = prng_rand(prng) % 100;
+		a = prng_rand(prng) & 0xff;
+		b = prng_rand(prng) & 0xff;
+
+		if (r < 40) {
+			fprintf(fp, "ip prefix-list PL-%u seq %u permit 10.%u.%u.0/24 le 32\n",
+				a % 50, n + 5, a, b);
+			n++;
+		} else if (r < 50) {
+			fprintf(fp, "ipv6 prefix-list PL6-%u seq %u permit 2001:db8:%x:%x::/64 ge 64 le 128\n",
+				a % 50, n + 5, a, b);
+			n++;
+		} else if (r < 60) {
+			fprintf(fp, "access-list ACL-%u seq %u permit 10.%u.%u.0/24\n",
+				a % 50, n + 5, a, b);
+			n++;
+		} else if (r < 75) {
+			fprintf(fp, "ip route 198.%u.%u.0/24 192.0.2.%u tag %u\n",
+				18 + (a & 1), b, a, n);
+			n++;
+		} else if (r < 88) {
+			fprintf(fp, "route-map RM-%u permit %u\n", a % 50,
+				n % 65535 + 1);
+			fprintf(fp, " match ip address prefix-list PL-%u\n", b % 50);
+			fprintf(fp, " match community %u\n", a % 99 + 1);
+			fprintf(fp, " set local-preference %u\n", 100 + b);
+			fprintf(fp, " set community 65000:%u 65000:%u\n", a, b);
+			fprintf(fp, " set as-path prepend 65000 65000\n");
+			fprintf(fp, " on-match next\n");
+			fprintf(fp, "exit\n");
+			n += 8;
+		} else if (r < 96) {
+			fprintf(fp, "router bgp 65000\n");
+			for (i = 0; i < 4; i++) {
+				fprintf(fp, " neighbor 192.0.2.%u remote-as %u\n",
+					(a + i) & 0xff, 64512 + b);
+				fprintf(fp, " neighbor 192.0.2.%u description peer %u-%u\n",
+					(a + i) & 0xff, a, i);
+				fprintf(fp, " neighbor 192.0.2.%u timers 10 30\n",
+					(a + i) & 0xff);
+			}
+			fprintf(fp, " address-family ipv4 unicast\n");
+			for (i = 0; i < 4; i++) {
+				fprintf(fp, "  network 203.0.%u.0/24\n",
+					(b + i) & 0xff);
+				fprintf(fp, "  neighbor 192.0.2.%u route-map RM-%u in\n",
+					(a + i) & 0xff, b % 50);
+				fprintf(fp, "  neighbor 192.0.2.%u soft-reconfiguration inbound\n",
+					(a + i) & 0xff);
+			}
+			fprintf(fp, " exit-address-family\n");
+			fprintf(fp, "exit\n");
+			n += 28;
+		} else {
+			fprintf(fp, "interface eth%u\n", a);
+			fprintf(fp, " description uplink %u\n", b);
+			fprintf(fp, " ip address 10.%u.%u.1/24\n", a, b);
+			fprintf(fp, " ipv6 address 2001:db8:%x:%x::1/64\n", a, b);
+			fprintf(fp, " mtu 9000\n");
+			fprintf(fp, "exit\n");
+			n += 6;
+		}
+	}
+	return n;
+}
+
+static unsigned long elapsed_us(struct timeval *start)
+{
+	struct timeval stop;
+
+	monotime(&stop);
+	return 1000000 * (stop.tv_sec - start->tv_sec) +
+	       (stop.tv_usec - start->tv_usec);
+}
+
+static void run(struct vty *vty, struct prng *prng, unsigned int lines)
+{
+	char path[] = "/tmp/test_cli_performance.XXXXXX";
+	struct timeval tv_start;
+	unsigned long t_load;
+	unsigned int written, line_num;
+	FILE *fp;
+	int fd, ret;
+
+	fd = mkstemp(path);
+	assert(fd >= 0);
+	unlink(path);
+	fp = fdopen(fd, "w+");
+	assert(fp);
+
+	written = write_config(fp, prng, lines);
+	rewind(fp);
+
+	executed = 0;
+	vty->node = CONFIG_NODE;
+
+	monotime(&tv_start);
+	ret = config_from_file(vty, fp, &line_num);
+	t_load = elapsed_us(&tv_start);
+
+	assert(ret == CMD_SUCCESS);
+	assert(!vty->error);
+	assert(line_num == written);
+
+	printf("%u lines took %lu.%03lu seconds, %lu lines/s, %lu ns each (%lu commands executed)\n",
+	       written, t_load / 1000000, (t_load % 1000000) / 1000,
+	       written * 1000000UL / MAX(t_load, 1UL),
+	       t_load * 1000 / written, executed);
+	fflush(stdout);
+
+	fclose(fp);
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int sizes[] = { 10000, 100000, 500000 };
+	struct prng *prng;
+	struct vty *vty;
+	size_t i;
+
+	zlog_aux_init("NONE: ", ZLOG_DISABLED);
+
+	cmd_init(1);
+	bench_init();
+
+	prng = prng_new(0);
+	vty = vty_new();
+	vty->type = VTY_TERM;
+
+	for (i = 0; i < array_size(sizes); i++)
+		run(vty, prng, sizes[i]);
+
+	vty_close(vty);
+	prng_free(prng);
+	cmd_terminate();
+	return 0;
+}
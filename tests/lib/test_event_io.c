@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * I/O task tests, run on both the poll() and the epoll backend: switching
+ * between read and write interest on one fd, fd numbers reused after a
+ * close, and regular files.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "frrevent.h"
+
+static struct event_loop *master;
+
+static struct event *t_read, *t_write;
+static unsigned int reads, writes;
+static bool stopped;
+
+static void read_func(struct event *thread)
+{
+	unsigned char buf[64];
+
+	assert(read(EVENT_FD(thread), buf, sizeof(buf)) >= 0);
+	reads++;
+}
+
+static void write_func(struct event *thread)
+{
+	writes++;
+}
+
+static void stop_func(struct event *thread)
+{
+	stopped = true;
+}
+
+/*
+ * Run the loop for a while.  I/O that is ready already is handled before
+ * the stop timer expires.
+ */
+static void run_for(long msec)
+{
+	struct event *t_stop = NULL;
+	struct event fetched;
+
+	stopped = false;
+	event_add_timer_msec(master, stop_func, NULL, msec, &t_stop);
+	while (!stopped && event_fetch(master, &fetched))
+		event_call(&fetched);
+}
+
+static void poke(int fd)
+{
+	assert(write(fd, "x", 1) == 1);
+}
+
+/* epoll only counts fds with tasks on them, poll() keeps idle ones around */
+static void check_idle(void)
+{
+	if (master->handler.epoll_fd >= 0)
+		assert(master->handler.pfdcount == 0);
+}
+
+static void test_switch(void)
+{
+	int sp[2];
+
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sp) == 0);
+	reads = writes = 0;
+
+	/* Only the direction that is ready runs */
+	event_add_read(master, read_func, NULL, sp[0], &t_read);
+	event_add_write(master, write_func, NULL, sp[0], &t_write);
+	run_for(20);
+	assert(writes == 1 && reads == 0);
+	assert(t_read && !t_write);
+
+	/* and the other one is still watched */
+	poke(sp[1]);
+	run_for(20);
+	assert(writes == 1 && reads == 1);
+	assert(!t_read);
+
+	/* Cancelling one direction leaves the other one alone */
+	event_add_read(master, read_func, NULL, sp[0], &t_read);
+	event_add_write(master, write_func, NULL, sp[0], &t_write);
+	event_cancel(&t_write);
+	run_for(20);
+	assert(writes == 1 && reads == 1);
+	poke(sp[1]);
+	run_for(20);
+	assert(writes == 1 && reads == 2);
+
+	/* Write interest added to an fd that only had read interest */
+	event_add_read(master, read_func, NULL, sp[0], &t_read);
+	run_for(20);
+	assert(reads == 2);
+	event_add_write(master, write_func, NULL, sp[0], &t_write);
+	run_for(20);
+	assert(writes == 2 && reads == 2);
+	event_cancel(&t_read);
+
+	check_idle();
+	close(sp[0]);
+	close(sp[1]);
+}
+
+/*
+ * An fd that ran a task is still known to the backend.  Once it is closed,
+ * its number can come back as a different file.
+ */
+static void test_reuse(void)
+{
+	int sp[2], np[2], fd;
+
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sp) == 0);
+	fd = sp[0];
+	reads = writes = 0;
+
+	event_add_read(master, read_func, NULL, fd, &t_read);
+	poke(sp[1]);
+	run_for(20);
+	assert(reads == 1);
+
+	/* Same number, new socket: dup2() closes the old one */
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, np) == 0);
+	assert(dup2(np[0], fd) == fd);
+	close(np[0]);
+	close(sp[1]);
+
+	event_add_read(master, read_func, NULL, fd, &t_read);
+	run_for(20);
+	assert(reads == 1);
+	poke(np[1]);
+	run_for(20);
+	assert(reads == 2);
+
+	/* Same again, with the task cancelled before the close */
+	event_add_read(master, read_func, NULL, fd, &t_read);
+	event_cancel(&t_read);
+	close(np[1]);
+
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, np) == 0);
+	assert(dup2(np[0], fd) == fd);
+	close(np[0]);
+
+	event_add_write(master, write_func, NULL, fd, &t_write);
+	event_add_read(master, read_func, NULL, fd, &t_read);
+	run_for(20);
+	assert(writes == 1 && reads == 2);
+	poke(np[1]);
+	run_for(20);
+	assert(reads == 3);
+
+	/*
+	 * The old file staying open under another number keeps its
+	 * registration in the kernel, that must not get in the way.
+	 */
+	np[0] = dup(fd);
+	event_add_read(master, read_func, NULL, fd, &t_read);
+	poke(np[1]);
+	run_for(20);
+	assert(reads == 4);
+
+	assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sp) == 0);
+	assert(dup2(sp[0], fd) == fd);
+	close(sp[0]);
+
+	event_add_read(master, read_func, NULL, fd, &t_read);
+	poke(np[1]);
+	run_for(20);
+	assert(reads == 4);
+	poke(sp[1]);
+	run_for(20);
+	assert(reads == 5);
+
+	check_idle();
+	close(fd);
+	close(np[0]);
+	close(np[1]);
+	close(sp[1]);
+}
+
+/* Regular files are always ready, epoll refuses them */
+static void test_file(void)
+{
+	FILE *f = tmpfile();
+	int fd;
+
+	assert(f);
+	fd = fileno(f);
+	reads = writes = 0;
+
+	event_add_read(master, read_func, NULL, fd, &t_read);
+	event_add_write(master, write_func, NULL, fd, &t_write);
+	run_for(20);
+	assert(reads == 1 && writes == 1);
+
+	event_add_read(master, read_func, NULL, fd, &t_read);
+	run_for(20);
+	assert(reads == 2);
+
+	check_idle();
+	fclose(f);
+}
+
+static void run(const char *name, enum event_io_backend backend)
+{
+	master = event_master_create_backend(name, backend);
+
+	test_switch();
+	test_reuse();
+	test_file();
+
+	event_master_free(master);
+	master = NULL;
+}
+
+int main(int argc, char **argv)
+{
+	run("poll", EVENT_IO_POLL);
+	run("epoll", EVENT_IO_EPOLL);
+
+	return 0;
+}
@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestEventIO(frrtest.TestMultiOut):
+    program = "./test_event_io"
+
+
+TestEventIO.exit_cleanly()
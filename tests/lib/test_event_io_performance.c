@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures the cost of an I/O wakeup in the event loop
+ * depending on the number of file descriptors being watched, for the
+ * poll() and epoll backends.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "frrevent.h"
+#include "prng.h"
+
+#define WAKEUPS 20000
+
+struct event_loop *master;
+
+static struct event **reads;
+static unsigned long wakeups;
+
+static void read_func(struct event *thread)
+{
+	int fd = EVENT_FD(thread);
+	unsigned char buf[16];
+
+	if (read(fd, buf, sizeof(buf)) > 0)
+		wakeups++;
+
+	event_add_read(master, read_func, EVENT_ARG(thread), fd,
+		       &reads[(uintptr_t)EVENT_ARG(thread)]);
+}
+
+static void run(const char *name, enum event_io_backend backend,
+		unsigned int pairs)
+{
+	struct prng *prng = prng_new(0);
+	struct timeval tv_start, tv_stop;
+	unsigned long t_wakeup;
+	struct event fetched;
+	int (*sp)[2];
+	unsigned int i;
+
+	master = event_master_create_backend(name, backend);
+	sp = calloc(pairs, sizeof(*sp));
+	reads = calloc(pairs, sizeof(*reads));
+
+	for (i = 0; i < pairs; i++) {
+		assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sp[i]) == 0);
+		set_nonblocking(sp[i][0]);
+		event_add_read(master, read_func, (void *)(uintptr_t)i,
+			       sp[i][0], &reads[i]);
+	}
+
+	/* One fd becomes readable at a time, all others stay idle. */
+	wakeups = 0;
+	monotime(&tv_start);
+	for (i = 0; i < WAKEUPS; i++) {
+		assert(write(sp[prng_rand(prng) % pairs][1], "x", 1) == 1);
+		while (event_fetch(master, &fetched)) {
+			event_call(&fetched);
+			if (wakeups == i + 1)
+				break;
+		}
+	}
+	monotime(&tv_stop);
+	t_wakeup = 1000000 * (tv_stop.tv_sec - tv_start.tv_sec) +
+		   (tv_stop.tv_usec - tv_start.tv_usec);
+	assert(wakeups == WAKEUPS);
+
+	printf("%-6s %5u fds: %u wakeups took %lu.%03lu seconds, %lu ns each.\n",
+	       name, pairs, WAKEUPS, t_wakeup / 1000000,
+	       (t_wakeup % 1000000) / 1000, t_wakeup * 1000 / WAKEUPS);
+	fflush(stdout);
+
+	for (i = 0; i < pairs; i++) {
+		event_cancel(&reads[i]);
+		close(sp[i][0]);
+		close(sp[i][1]);
+	}
+	event_master_free(master);
+	free(reads);
+	free(sp);
+	prng_free(prng);
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int counts[] = { 16, 128, 1024, 4096 };
+	struct rlimit limit;
+	unsigned int i, max_pairs;
+
+	/* Two fds per pair, leave some room for everything else. */
+	getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+	getrlimit(RLIMIT_NOFILE, &limit);
+	max_pairs = (limit.rlim_cur - 64) / 2;
+
+	for (i = 0; i < array_size(counts); i++) {
+		if (counts[i] > max_pairs)
+			break;
+		run("poll", EVENT_IO_POLL, counts[i]);
+		run("epoll", EVENT_IO_EPOLL, counts[i]);
+	}
+
+	return 0;
+}
@@ -0,0 +1,203 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Event profiling tests: the latency histograms shown by "show event
+ * latency" and the history written by "event profile export".
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "buffer.h"
+#include "command.h"
+#include "frrevent.h"
+#include "log.h"
+#include "memory.h"
+#include "vty.h"
+
+#define SLOW_RUNS 10
+#define SLOW_USEC 2000
+#define QUEUED_USEC 20000
+
+static struct event_loop *master;
+static struct vty *vty;
+
+static void slow_func(struct event *thread)
+{
+	usleep(SLOW_USEC);
+}
+
+static void early_func(struct event *thread)
+{
+}
+
+static void run_all(void)
+{
+	struct event fetched;
+
+	while (event_fetch(master, &fetched))
+		event_call(&fetched);
+}
+
+/* Run a command, its output is left in vty->obuf */
+static void execute(enum node_type node, const char *cmd, int expect)
+{
+	vty->node = node;
+	buffer_reset(vty->obuf);
+	assert(cmd_execute(vty, cmd, NULL, 0) == expect);
+}
+
+/* Invoked, then p50/p99/max running and p50/p99/max queued */
+static void latency_row(char *out, const char *funcname, unsigned long *vals)
+{
+	char *line, *save, *name;
+	size_t calls;
+
+	for (line = strtok_r(out, "\r\n", &save); line;
+	     line = strtok_r(NULL, "\r\n", &save)) {
+		name = strrchr(line, ' ');
+		if (!name || strcmp(name + 1, funcname))
+			continue;
+
+		assert(sscanf(line, "%zu %lu %lu %lu %lu %lu %lu", &calls,
+			      &vals[1], &vals[2], &vals[3], &vals[4], &vals[5],
+			      &vals[6]) == 7);
+		vals[0] = calls;
+		return;
+	}
+	assert(!"function missing from show event latency");
+}
+
+static char *read_file(const char *path)
+{
+	FILE *fp = fopen(path, "r");
+	char *buf;
+	long len;
+
+	assert(fp);
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	rewind(fp);
+	buf = XCALLOC(MTYPE_TMP, len + 1);
+	assert(fread(buf, 1, len, fp) == (size_t)len);
+	fclose(fp);
+	unlink(path);
+	return buf;
+}
+
+/* Weight of one folded stack */
+static unsigned long folded_value(const char *out, const char *stack)
+{
+	size_t len = strlen(stack);
+	const char *line = out;
+
+	while (line) {
+		if (!strncmp(line, stack, len) && line[len] == ' ')
+			return strtoul(line + len + 1, NULL, 10);
+		line = strchr(line, '\n');
+		if (line)
+			line++;
+	}
+	return 0;
+}
+
+static void test_profile(void)
+{
+	char path[] = "/tmp/test_event_profile.XXXXXX";
+	char cmd[128];
+	unsigned long vals[7];
+	char *out;
+	const char *p;
+	unsigned int i, n;
+	int fd;
+
+	fd = mkstemp(path);
+	assert(fd >= 0);
+	close(fd);
+
+	/* Queued before profiling starts, and thus not stamped */
+	event_add_event(master, early_func, NULL, 0, NULL);
+	usleep(QUEUED_USEC);
+
+	execute(CONFIG_NODE, "service event-profile", CMD_SUCCESS);
+	for (i = 0; i < SLOW_RUNS; i++)
+		event_add_event(master, slow_func, NULL, 0, NULL);
+	run_all();
+
+	execute(ENABLE_NODE, "show event latency", CMD_SUCCESS);
+	out = buffer_getstr(vty->obuf);
+	latency_row(out, "slow_func", vals);
+	assert(vals[0] == SLOW_RUNS);
+	/* percentiles are bucket upper bounds, never below the value */
+	assert(vals[1] >= SLOW_USEC);
+	assert(vals[1] <= vals[2] && vals[2] <= vals[3]);
+	/* the last one waited for all others */
+	assert(vals[6] >= (SLOW_RUNS - 1) * SLOW_USEC);
+	XFREE(MTYPE_TMP, out);
+
+	execute(ENABLE_NODE, "show event latency", CMD_SUCCESS);
+	out = buffer_getstr(vty->obuf);
+	latency_row(out, "early_func", vals);
+	assert(vals[0] == 1);
+	assert(vals[6] < QUEUED_USEC);
+	XFREE(MTYPE_TMP, out);
+
+	/* Queued with profiling on */
+	event_add_event(master, early_func, NULL, 0, NULL);
+	usleep(QUEUED_USEC);
+	run_all();
+
+	execute(ENABLE_NODE, "show event latency", CMD_SUCCESS);
+	out = buffer_getstr(vty->obuf);
+	latency_row(out, "early_func", vals);
+	assert(vals[0] == 2);
+	assert(vals[6] >= QUEUED_USEC);
+	XFREE(MTYPE_TMP, out);
+
+	snprintf(cmd, sizeof(cmd), "event profile export folded %s", path);
+	execute(ENABLE_NODE, cmd, CMD_SUCCESS);
+	out = read_file(path);
+	assert(folded_value(out, "test;running;event;slow_func") >=
+	       SLOW_RUNS * SLOW_USEC);
+	assert(folded_value(out, "test;queued;event;early_func") >=
+	       QUEUED_USEC);
+	XFREE(MTYPE_TMP, out);
+
+	snprintf(cmd, sizeof(cmd), "event profile export chrome %s last 60",
+		 path);
+	execute(ENABLE_NODE, cmd, CMD_SUCCESS);
+	out = read_file(path);
+	assert(!strncmp(out, "{\"traceEvents\":[", 16));
+	assert(!strcmp(out + strlen(out) - 4, "\n]}\n"));
+	for (n = 0, p = out; (p = strstr(p, "{\"name\":\"slow_func\",")); p++)
+		n++;
+	assert(n == SLOW_RUNS);
+	XFREE(MTYPE_TMP, out);
+
+	/* Turning it off drops the history at the next task */
+	execute(CONFIG_NODE, "no service event-profile", CMD_SUCCESS);
+	event_add_event(master, early_func, NULL, 0, NULL);
+	run_all();
+	assert(!master->profile);
+	execute(ENABLE_NODE, cmd, CMD_WARNING);
+	assert(access(path, F_OK) < 0);
+}
+
+int main(int argc, char **argv)
+{
+	zlog_aux_init("NONE: ", ZLOG_DISABLED);
+
+	master = event_master_create("test");
+	cmd_init(1);
+
+	vty = vty_new();
+	vty->type = VTY_TERM;
+
+	test_profile();
+
+	vty_close(vty);
+	cmd_terminate();
+	event_master_free(master);
+	return 0;
+}
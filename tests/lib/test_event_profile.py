@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestEventProfile(frrtest.TestMultiOut):
+    program = "./test_event_profile"
+
+
+TestEventProfile.exit_cleanly()
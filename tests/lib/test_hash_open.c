@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Open addressed hash table tests: random inserts, releases and lookups
+ * checked against a reference, plus reuse of released slots and their
+ * removal when the table is resized.
+ */
+
+#include <zebra.h>
+
+#include "hash.h"
+
+#define ITEMS 4096
+#define OPS 200000
+
+struct item {
+	uint32_t val;
+};
+
+static struct item items[ITEMS];
+static bool present[ITEMS];
+static unsigned int present_count;
+
+/* All keys equal: every element sits in one probe sequence */
+static bool same_key;
+
+static unsigned int item_key(const void *arg)
+{
+	const struct item *it = arg;
+
+	if (same_key)
+		return 0;
+
+	/* clustered on purpose, so probe sequences run into each other */
+	return it->val / 4;
+}
+
+static bool item_cmp(const void *a, const void *b)
+{
+	const struct item *ia = a, *ib = b;
+
+	return ia->val == ib->val;
+}
+
+static void count_iter(struct hash_bucket *hb, void *arg)
+{
+	unsigned int *count = arg;
+	struct item *it = hb->data;
+
+	assert(present[it - items]);
+	(*count)++;
+}
+
+static void check(struct hash *hash)
+{
+	unsigned int count = 0;
+
+	assert(hashcount(hash) == present_count);
+	assert(hash->count + hash->deleted <= hash->size * 3 / 4);
+
+	hash_iterate(hash, count_iter, &count);
+	assert(count == present_count);
+}
+
+static void reset(void)
+{
+	memset(present, 0, sizeof(present));
+	present_count = 0;
+}
+
+/* Random mix of operations, compared against present[] */
+static void test_random(void)
+{
+	struct hash *hash;
+	struct item *it;
+	unsigned int i, n;
+
+	reset();
+	hash = hash_create_open(16, item_key, item_cmp, "open random");
+
+	for (i = 0; i < OPS; i++) {
+		n = random() % ITEMS;
+		it = &items[n];
+
+		switch (random() % 3) {
+		case 0:
+			assert(hash_get(hash, it, hash_alloc_intern) == it);
+			if (!present[n]) {
+				present[n] = true;
+				present_count++;
+			}
+			break;
+		case 1:
+			if (present[n]) {
+				assert(hash_release(hash, it) == it);
+				present[n] = false;
+				present_count--;
+			} else
+				assert(hash_release(hash, it) == NULL);
+			break;
+		case 2:
+			assert(hash_lookup(hash, it) == (present[n] ? it : NULL));
+			break;
+		}
+
+		if (i % 1024 == 0)
+			check(hash);
+	}
+
+	for (n = 0; n < ITEMS; n++)
+		assert(hash_lookup(hash, &items[n]) ==
+		       (present[n] ? &items[n] : NULL));
+	check(hash);
+
+	hash_clean(hash, NULL);
+	reset();
+	check(hash);
+	assert(hash->deleted == 0);
+	hash_free(hash);
+}
+
+/* Released slots are reused by inserts before the table grows */
+static void test_reuse(void)
+{
+	struct hash *hash;
+	unsigned int i, size;
+
+	reset();
+	same_key = true;
+	hash = hash_create_open(64, item_key, item_cmp, "open reuse");
+
+	for (i = 0; i < 32; i++)
+		assert(hash_get(hash, &items[i], hash_alloc_intern));
+	size = hash->size;
+	assert(hash->deleted == 0);
+
+	/* Releasing inside the probe sequence leaves markers... */
+	for (i = 0; i < 16; i += 2)
+		assert(hash_release(hash, &items[i]) == &items[i]);
+	assert(hash->deleted == 8);
+	assert(hashcount(hash) == 24);
+
+	/* ...that don't cut off the elements behind them */
+	for (i = 0; i < 32; i++)
+		assert(hash_lookup(hash, &items[i]) ==
+		       (i < 16 && i % 2 == 0 ? NULL : &items[i]));
+
+	/* ...and are taken by the next inserts */
+	for (i = 100; i < 108; i++)
+		assert(hash_get(hash, &items[i], hash_alloc_intern));
+	assert(hash->deleted == 0);
+	assert(hash->size == size);
+	assert(hashcount(hash) == 32);
+
+	/* Releasing the end of the sequence needs no marker */
+	assert(hash_release(hash, &items[31]) == &items[31]);
+	assert(hash->deleted == 0);
+
+	same_key = false;
+	hash_clean(hash, NULL);
+	hash_free(hash);
+}
+
+/*
+ * Inserts reuse released slots, so markers only pile up when releases
+ * outnumber inserts.  Once they would fill the table it is resized, which
+ * drops all of them: at the same size if few elements are left, otherwise
+ * while doubling.
+ */
+static void test_compact(void)
+{
+	struct hash *hash;
+	unsigned int i;
+
+	reset();
+	same_key = true;
+	hash = hash_create_open(64, item_key, item_cmp, "open compact");
+
+	/* 3/4 of the table in use, then most of it released */
+	for (i = 0; i < 48; i++)
+		assert(hash_get(hash, &items[i], hash_alloc_intern));
+	for (i = 0; i < 40; i++)
+		assert(hash_release(hash, &items[i]) == &items[i]);
+	assert(hash->deleted == 40);
+	assert(hashcount(hash) == 8);
+
+	assert(hash_get(hash, &items[100], hash_alloc_intern));
+	assert(hash->size == 64);
+	assert(hash->deleted == 0);
+	for (i = 40; i < 48; i++)
+		assert(hash_lookup(hash, &items[i]) == &items[i]);
+	assert(hash_lookup(hash, &items[100]) == &items[100]);
+
+	hash_clean(hash, NULL);
+	assert(hash->deleted == 0);
+
+	/* Same, but with half of the table still in use */
+	for (i = 0; i < 48; i++)
+		assert(hash_get(hash, &items[i], hash_alloc_intern));
+	for (i = 0; i < 16; i++)
+		assert(hash_release(hash, &items[i]) == &items[i]);
+	assert(hash->deleted == 16);
+
+	assert(hash_get(hash, &items[100], hash_alloc_intern));
+	assert(hash->size == 128);
+	assert(hash->deleted == 0);
+	for (i = 0; i < 48; i++)
+		assert(hash_lookup(hash, &items[i]) ==
+		       (i < 16 ? NULL : &items[i]));
+	assert(hash_lookup(hash, &items[100]) == &items[100]);
+
+	/* hash_reserve() resizes as well */
+	assert(hash_release(hash, &items[20]) == &items[20]);
+	assert(hash->deleted == 1);
+	hash_reserve(hash, hash->size);
+	assert(hash->deleted == 0);
+	assert(hash_lookup(hash, &items[21]) == &items[21]);
+
+	same_key = false;
+	hash_clean(hash, NULL);
+	hash_free(hash);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int i;
+
+	for (i = 0; i < ITEMS; i++)
+		items[i].val = i;
+
+	srandom(1);
+
+	test_random();
+	test_reuse();
+	test_compact();
+
+	return 0;
+}
@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestHashOpen(frrtest.TestMultiOut):
+    program = "./test_hash_open"
+
+
+TestHashOpen.exit_cleanly()
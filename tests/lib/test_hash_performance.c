@@ -0,0 +1,160 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures chained hash tables against open addressed
+ * ones: insert, hit and miss lookups, iteration and release times, plus
+ * the memory taken by the table itself.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+
+#include "hash.h"
+#include "jhash.h"
+#include "monotime.h"
+
+#define ENTRIES 500000
+#define ROUNDS 5
+
+struct entry {
+	uint32_t id;
+};
+
+static unsigned int entry_key(const void *arg)
+{
+	const struct entry *e = arg;
+
+	return jhash_1word(e->id, 0);
+}
+
+static bool entry_equal(const void *arg1, const void *arg2)
+{
+	const struct entry *e1 = arg1, *e2 = arg2;
+
+	return e1->id == e2->id;
+}
+
+static unsigned long iterated;
+
+static void entry_count(struct hash_bucket *hb, void *arg)
+{
+	iterated++;
+}
+
+static unsigned long elapsed_msec(struct timeval *start, struct timeval *stop)
+{
+	return 1000 * (stop->tv_sec - start->tv_sec) +
+	       (stop->tv_usec - start->tv_usec) / 1000;
+}
+
+static void print_time(const char *what, unsigned long count,
+		       unsigned long msec)
+{
+	printf("  %lu %s took %lu.%03lu seconds.\n", count, what, msec / 1000,
+	       msec % 1000);
+}
+
+static void run(const char *name, struct entry *entries, struct entry *misses,
+		bool open, bool reserve)
+{
+	struct hash *hash;
+	struct timeval tv_start, tv_stop;
+	unsigned long t_insert, t_lookup, t_miss, t_iterate, t_release;
+	unsigned long found = 0, missed = 0, released = 0, table;
+	unsigned int i, r;
+
+	if (open)
+		hash = hash_create_open(HASH_INITIAL_SIZE, entry_key,
+					entry_equal, name);
+	else
+		hash = hash_create_size(HASH_INITIAL_SIZE, entry_key,
+					entry_equal, name);
+
+	monotime(&tv_start);
+	if (reserve)
+		hash_reserve(hash, ENTRIES);
+	for (i = 0; i < ENTRIES; i++)
+		(void)hash_get(hash, &entries[i], hash_alloc_intern);
+	monotime(&tv_stop);
+	t_insert = elapsed_msec(&tv_start, &tv_stop);
+	assert(hashcount(hash) == ENTRIES);
+
+	/* Index plus one bucket per entry, or the slot array alone. */
+	if (open)
+		table = hash->size * sizeof(struct hash_bucket);
+	else
+		table = hash->size * sizeof(struct hash_bucket *) +
+			hashcount(hash) * sizeof(struct hash_bucket);
+
+	monotime(&tv_start);
+	for (r = 0; r < ROUNDS; r++)
+		for (i = 0; i < ENTRIES; i++)
+			if (hash_lookup(hash, &entries[i]))
+				found++;
+	monotime(&tv_stop);
+	t_lookup = elapsed_msec(&tv_start, &tv_stop);
+
+	monotime(&tv_start);
+	for (r = 0; r < ROUNDS; r++)
+		for (i = 0; i < ENTRIES; i++)
+			if (!hash_lookup(hash, &misses[i]))
+				missed++;
+	monotime(&tv_stop);
+	t_miss = elapsed_msec(&tv_start, &tv_stop);
+
+	assert(found == (unsigned long)ENTRIES * ROUNDS);
+	assert(missed == (unsigned long)ENTRIES * ROUNDS);
+
+	iterated = 0;
+	monotime(&tv_start);
+	for (r = 0; r < ROUNDS; r++)
+		hash_iterate(hash, entry_count, NULL);
+	monotime(&tv_stop);
+	t_iterate = elapsed_msec(&tv_start, &tv_stop);
+	assert(iterated == (unsigned long)ENTRIES * ROUNDS);
+
+	monotime(&tv_start);
+	for (i = 0; i < ENTRIES; i++)
+		if (hash_release(hash, &entries[i]) == &entries[i])
+			released++;
+	monotime(&tv_stop);
+	t_release = elapsed_msec(&tv_start, &tv_stop);
+	assert(released == ENTRIES);
+
+	printf("%s:\n", name);
+	print_time("inserts", ENTRIES, t_insert);
+	print_time("hit lookups", (unsigned long)ENTRIES * ROUNDS, t_lookup);
+	print_time("miss lookups", (unsigned long)ENTRIES * ROUNDS, t_miss);
+	print_time("iterated entries", (unsigned long)ENTRIES * ROUNDS,
+		   t_iterate);
+	print_time("releases", ENTRIES, t_release);
+	printf("  table size %u, %lu bytes (%lu per entry).\n", hash->size,
+	       table, table / ENTRIES);
+	fflush(stdout);
+
+	hash_free(hash);
+}
+
+int main(int argc, char **argv)
+{
+	struct entry *entries, *misses;
+	unsigned int i;
+
+	entries = calloc(ENTRIES, sizeof(*entries));
+	misses = calloc(ENTRIES, sizeof(*misses));
+
+	for (i = 0; i < ENTRIES; i++) {
+		entries[i].id = i;
+		misses[i].id = ENTRIES + i;
+	}
+
+	run("Chained", entries, misses, false, false);
+	run("Chained, reserved", entries, misses, false, true);
+	run("Open addressing", entries, misses, true, false);
+	run("Open addressing, reserved", entries, misses, true, true);
+
+	free(entries);
+	free(misses);
+
+	return 0;
+}
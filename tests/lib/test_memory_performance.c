@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures the cost of XMALLOC/XFREE when several
+ * pthreads allocate from the same memtype, with and without allocation
+ * site profiling.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+#include <pthread.h>
+
+#include "memory.h"
+#include "monotime.h"
+
+DEFINE_MGROUP(TEST_MEMORY, "memory performance test");
+DEFINE_MTYPE_STATIC(TEST_MEMORY, TEST, "shared test mtype");
+
+#define ROUNDS 1000
+#define BATCH  1000
+
+static void *alloc_func(void *arg)
+{
+	void *ptrs[BATCH];
+	unsigned int i, j;
+
+	for (i = 0; i < ROUNDS; i++) {
+		for (j = 0; j < BATCH; j++)
+			ptrs[j] = XMALLOC(MTYPE_TEST, 64);
+		for (j = 0; j < BATCH; j++)
+			XFREE(MTYPE_TEST, ptrs[j]);
+	}
+	return NULL;
+}
+
+static void run(unsigned int nthreads, unsigned int rate)
+{
+	pthread_t threads[nthreads];
+	struct timeval tv_start, tv_stop;
+	unsigned long t_run, ops;
+	unsigned int i;
+
+	qmem_profile_set(rate);
+
+	monotime(&tv_start);
+	for (i = 0; i < nthreads; i++)
+		assert(!pthread_create(&threads[i], NULL, alloc_func, NULL));
+	for (i = 0; i < nthreads; i++)
+		pthread_join(threads[i], NULL);
+	monotime(&tv_stop);
+
+	t_run = 1000000 * (tv_stop.tv_sec - tv_start.tv_sec) +
+		(tv_stop.tv_usec - tv_start.tv_usec);
+	ops = (unsigned long)nthreads * ROUNDS * BATCH;
+
+	printf("%u threads, profile %-7s: %lu alloc+free took %lu.%03lu seconds, %lu ns each.\n",
+	       nthreads, rate ? "sampled" : "off", ops, t_run / 1000000,
+	       (t_run % 1000000) / 1000, t_run * 1000 / ops);
+	fflush(stdout);
+
+	assert(mtype_stats_alloc(MTYPE_TEST) == 0);
+	qmem_profile_set(0);
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int counts[] = { 1, 2, 4, 8 };
+	unsigned int i;
+
+	for (i = 0; i < array_size(counts); i++) {
+		run(counts[i], 0);
+		run(counts[i], QMEM_PROFILE_RATE_DEFAULT);
+	}
+
+	return 0;
+}
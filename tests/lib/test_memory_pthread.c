@@ -0,0 +1,280 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Allocation counting across pthreads: per-pthread counts adding up to the
+ * same numbers as before, memory freed on other pthreads than it was
+ * allocated on, frees without an allocation, and sampled allocation sites.
+ */
+
+#include <zebra.h>
+
+#include <pthread.h>
+#include <sys/wait.h>
+
+#include "memory.h"
+
+DEFINE_MGROUP(TEST_MEMORY, "memory test");
+DEFINE_MTYPE_STATIC(TEST_MEMORY, TEST_COUNT, "counted");
+DEFINE_MTYPE_STATIC(TEST_MEMORY, TEST_SAMPLE, "sampled");
+DEFINE_MTYPE_STATIC(TEST_MEMORY, TEST_UNDERFLOW, "underflow");
+
+#define THREADS 4
+/* not a multiple of the flush interval, some counts stay pending */
+#define ALLOCS 1000
+#define SIZE 48
+
+static void *ptrs[THREADS][ALLOCS];
+static pthread_barrier_t barrier;
+
+struct job {
+	unsigned int idx;
+	bool alloc;
+	bool wait;
+};
+
+static void *worker(void *arg)
+{
+	struct job *job = arg;
+	unsigned int i;
+
+	for (i = 0; i < ALLOCS; i++) {
+		if (job->alloc)
+			ptrs[job->idx][i] = XMALLOC(MTYPE_TEST_COUNT, SIZE);
+		else
+			XFREE(MTYPE_TEST_COUNT, ptrs[job->idx][i]);
+	}
+
+	/* keep the pthread, and its pending counts, around for a check */
+	if (job->wait) {
+		pthread_barrier_wait(&barrier);
+		pthread_barrier_wait(&barrier);
+	}
+	return NULL;
+}
+
+static void run_workers(bool alloc, bool wait, unsigned int shift)
+{
+	pthread_t threads[THREADS];
+	struct job jobs[THREADS];
+	unsigned int i;
+
+	for (i = 0; i < THREADS; i++) {
+		jobs[i].idx = (i + shift) % THREADS;
+		jobs[i].alloc = alloc;
+		jobs[i].wait = wait;
+		pthread_create(&threads[i], NULL, worker, &jobs[i]);
+	}
+	if (wait) {
+		pthread_barrier_wait(&barrier);
+		assert(mtype_stats_alloc(MTYPE_TEST_COUNT) ==
+		       (alloc ? THREADS * ALLOCS : 0));
+		pthread_barrier_wait(&barrier);
+	}
+	for (i = 0; i < THREADS; i++)
+		pthread_join(threads[i], NULL);
+}
+
+static void test_aggregate(void)
+{
+	struct mtype_stats stats;
+
+	pthread_barrier_init(&barrier, NULL, THREADS + 1);
+
+	/* pending counts of live pthreads are included... */
+	run_workers(true, true, 0);
+	/* ...and those of exited ones are kept */
+	mtype_stats(MTYPE_TEST_COUNT, &stats);
+	assert(stats.n_alloc == THREADS * ALLOCS);
+	assert(stats.n_max >= THREADS * ALLOCS);
+	assert(stats.size == SIZE);
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	assert(stats.total >= THREADS * ALLOCS * SIZE);
+#endif
+
+	/* freed on another pthread than allocated on */
+	run_workers(false, true, 1);
+	mtype_stats(MTYPE_TEST_COUNT, &stats);
+	assert(stats.n_alloc == 0);
+	assert(stats.n_max >= THREADS * ALLOCS);
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	assert(stats.total == 0);
+#endif
+
+	pthread_barrier_destroy(&barrier);
+}
+
+/* Freed while the allocations are still pending on a live pthread */
+static void test_pending(void)
+{
+	struct job job = { .idx = 0, .alloc = true, .wait = true };
+	pthread_t thread;
+	unsigned int i;
+
+	pthread_barrier_init(&barrier, NULL, 2);
+	pthread_create(&thread, NULL, worker, &job);
+	pthread_barrier_wait(&barrier);
+
+	for (i = 0; i < ALLOCS; i++)
+		XFREE(MTYPE_TEST_COUNT, ptrs[0][i]);
+	assert(mtype_stats_alloc(MTYPE_TEST_COUNT) == 0);
+
+	pthread_barrier_wait(&barrier);
+	pthread_join(thread, NULL);
+	assert(mtype_stats_alloc(MTYPE_TEST_COUNT) == 0);
+	pthread_barrier_destroy(&barrier);
+}
+
+/* Freeing more than was allocated trips an assert, in a child process */
+static void expect_abort(void (*func)(void))
+{
+	int status;
+	pid_t child;
+
+	child = fork();
+	assert(child >= 0);
+	if (child == 0) {
+		func();
+		_exit(0);
+	}
+
+	assert(waitpid(child, &status, 0) == child);
+	assert(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT);
+}
+
+static void underflow_empty(void)
+{
+	qcountfree(MTYPE_TEST_UNDERFLOW, malloc(SIZE));
+}
+
+static void *alloc_one(void *arg)
+{
+	void **ptr = arg;
+
+	*ptr = XMALLOC(MTYPE_TEST_UNDERFLOW, SIZE);
+	pthread_barrier_wait(&barrier);
+	pthread_barrier_wait(&barrier);
+	return NULL;
+}
+
+/* the allocation is still pending on another pthread */
+static void underflow_pending(void)
+{
+	pthread_t thread;
+	void *ptr;
+
+	pthread_barrier_init(&barrier, NULL, 2);
+	pthread_create(&thread, NULL, alloc_one, &ptr);
+	pthread_barrier_wait(&barrier);
+
+	XFREE(MTYPE_TEST_UNDERFLOW, ptr);
+	qcountfree(MTYPE_TEST_UNDERFLOW, malloc(SIZE));
+}
+
+static void test_underflow(void)
+{
+	expect_abort(underflow_empty);
+	expect_abort(underflow_pending);
+}
+
+/* Sampled allocations, by call site.  count and bytes are the largest. */
+struct site_count {
+	size_t count, bytes, last;
+	unsigned int sites;
+};
+
+static int site_func(void *arg, const struct qmem_site *site)
+{
+	struct site_count *sc = arg;
+
+	if (site->mt != MTYPE_TEST_SAMPLE)
+		return 0;
+
+	if (!sc->sites) {
+		sc->count = site->count;
+		sc->bytes = site->bytes;
+	} else
+		assert(site->bytes <= sc->last);
+	sc->last = site->bytes;
+	sc->sites++;
+	return 0;
+}
+
+static struct site_count sites(void)
+{
+	struct site_count sc = {};
+
+	assert(qmem_profile_walk(site_func, &sc) == 0);
+	return sc;
+}
+
+static void *free_half(void *arg)
+{
+	void **sampled = arg;
+	unsigned int i;
+
+	for (i = 0; i < ALLOCS; i += 2)
+		XFREE(MTYPE_TEST_SAMPLE, sampled[i]);
+	return NULL;
+}
+
+static void test_profile(void)
+{
+	static void *sampled[ALLOCS];
+	struct site_count sc;
+	pthread_t thread;
+	unsigned int i;
+
+	assert(qmem_profile_rate() == 0);
+	sampled[0] = XMALLOC(MTYPE_TEST_SAMPLE, SIZE);
+	assert(sites().sites == 0);
+	XFREE(MTYPE_TEST_SAMPLE, sampled[0]);
+
+	/* every allocation */
+	qmem_profile_set(1);
+	assert(qmem_profile_rate() == 1);
+	for (i = 0; i < ALLOCS; i++)
+		sampled[i] = XMALLOC(MTYPE_TEST_SAMPLE, SIZE);
+	sampled[0] = XREALLOC(MTYPE_TEST_SAMPLE, sampled[0], 4 * SIZE);
+
+	/* the realloc is a separate site */
+	sc = sites();
+	assert(sc.sites == 2);
+	assert(sc.count == ALLOCS - 1 && sc.bytes == (ALLOCS - 1) * SIZE);
+	assert(sc.last == 4 * SIZE);
+
+	/* samples go away with frees on any pthread */
+	pthread_create(&thread, NULL, free_half, sampled);
+	pthread_join(thread, NULL);
+	sc = sites();
+	assert(sc.sites == 1);
+	assert(sc.count == ALLOCS / 2 && sc.bytes == ALLOCS / 2 * SIZE);
+
+	for (i = 1; i < ALLOCS; i += 2)
+		XFREE(MTYPE_TEST_SAMPLE, sampled[i]);
+	assert(sites().sites == 0);
+
+	/* one in ten, scaled back up */
+	qmem_profile_set(10);
+	for (i = 0; i < ALLOCS; i++)
+		sampled[i] = XMALLOC(MTYPE_TEST_SAMPLE, SIZE);
+	sc = sites();
+	assert(sc.sites == 1);
+	assert(sc.count % 10 == 0);
+	assert(sc.count >= ALLOCS / 2 && sc.count <= ALLOCS * 2);
+	assert(sc.bytes == sc.count * SIZE);
+
+	/* switching it off drops the samples */
+	qmem_profile_set(0);
+	assert(sites().sites == 0);
+	for (i = 0; i < ALLOCS; i++)
+		XFREE(MTYPE_TEST_SAMPLE, sampled[i]);
+	assert(mtype_stats_alloc(MTYPE_TEST_SAMPLE) == 0);
+}
+
+int main(int argc, char **argv)
+{
+	test_aggregate();
+	test_pending();
+	test_underflow();
+	test_profile();
+	return 0;
+}
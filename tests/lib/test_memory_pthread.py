@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestMemoryPthread(frrtest.TestMultiOut):
+    program = "./test_memory_pthread"
+
+
+TestMemoryPthread.exit_cleanly()
@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Object pool tests: zeroing of recycled objects, the per-pthread caches
+ * spilling to and refilling from the pool, frees on other pthreads, caches
+ * handed back when a pthread exits, and the numbers in "show memory".
+ */
+
+#include <zebra.h>
+
+#include <pthread.h>
+
+#include "buffer.h"
+#include "command.h"
+#include "lib_vty.h"
+#include "memory.h"
+#include "mpool.h"
+#include "vty.h"
+
+DEFINE_MGROUP(TEST_MPOOL, "mpool test");
+DEFINE_MTYPE_STATIC(TEST_MPOOL, TEST_POOLED, "pooled test");
+DEFINE_MPOOL(TEST_POOLED, 40);
+
+#define SIZE 40
+#define OBJS 100
+
+static struct vty *vty;
+
+static int stats_walker(void *arg, struct mpool *mp,
+			const struct mpool_stats *stats)
+{
+	struct mpool_stats *out = arg;
+
+	if (mp->mt != MTYPE_TEST_POOLED)
+		return 0;
+	*out = *stats;
+	return 1;
+}
+
+static struct mpool_stats pool_stats(void)
+{
+	struct mpool_stats stats;
+
+	assert(mpool_walk(stats_walker, &stats) == 1);
+	return stats;
+}
+
+/* Recycled objects come back zeroed from XCALLOC */
+static void test_calloc(void)
+{
+	unsigned char *objs[OBJS], *freed[OBJS];
+	unsigned int i, j;
+
+	for (i = 0; i < OBJS; i++) {
+		objs[i] = freed[i] = XMALLOC(MTYPE_TEST_POOLED, SIZE);
+		memset(objs[i], 0xff, SIZE);
+	}
+	for (i = 0; i < OBJS; i++)
+		XFREE(MTYPE_TEST_POOLED, objs[i]);
+
+	/* most recently freed first */
+	for (i = OBJS; i-- > 0;) {
+		objs[i] = XCALLOC(MTYPE_TEST_POOLED, SIZE);
+		assert(objs[i] == freed[i]);
+		for (j = 0; j < SIZE; j++)
+			assert(objs[i][j] == 0);
+	}
+	for (i = 0; i < OBJS; i++)
+		XFREE(MTYPE_TEST_POOLED, objs[i]);
+	assert(mtype_stats_alloc(MTYPE_TEST_POOLED) == 0);
+}
+
+/*
+ * Caches are refilled a batch at a time, and hand a batch back once they
+ * hold two.  This pthread's cache holds one batch after test_calloc().
+ */
+static void test_cache(void)
+{
+	void *objs[3 * MPOOL_BATCH];
+	struct mpool_stats stats;
+	size_t n_free;
+	unsigned int i;
+
+	stats = pool_stats();
+	assert(stats.size == 48);
+	assert(stats.n_slabs == 1);
+	n_free = stats.n_free;
+
+	/* the cache runs empty without touching the pool... */
+	for (i = 0; i < MPOOL_BATCH; i++)
+		objs[i] = XMALLOC(MTYPE_TEST_POOLED, SIZE);
+	assert(pool_stats().n_free == n_free);
+
+	/* ...and then takes a batch */
+	objs[i++] = XMALLOC(MTYPE_TEST_POOLED, SIZE);
+	assert(pool_stats().n_free == n_free - MPOOL_BATCH);
+	for (; i < 3 * MPOOL_BATCH; i++)
+		objs[i] = XMALLOC(MTYPE_TEST_POOLED, SIZE);
+	assert(pool_stats().n_free == n_free - 2 * MPOOL_BATCH);
+
+	/* freeing spills every batch beyond the second */
+	for (i = 0; i < 2 * MPOOL_BATCH - 1; i++)
+		XFREE(MTYPE_TEST_POOLED, objs[i]);
+	assert(pool_stats().n_free == n_free - 2 * MPOOL_BATCH);
+	XFREE(MTYPE_TEST_POOLED, objs[i]);
+	assert(pool_stats().n_free == n_free - MPOOL_BATCH);
+	for (i++; i < 3 * MPOOL_BATCH; i++)
+		XFREE(MTYPE_TEST_POOLED, objs[i]);
+	assert(pool_stats().n_free == n_free);
+
+	assert(pool_stats().n_slabs == 1);
+	assert(mtype_stats_alloc(MTYPE_TEST_POOLED) == 0);
+}
+
+static void *alloc_func(void *arg)
+{
+	void **objs = arg;
+	unsigned int i;
+
+	for (i = 0; i < OBJS; i++)
+		objs[i] = XMALLOC(MTYPE_TEST_POOLED, SIZE);
+	return NULL;
+}
+
+static void *alloc_free_func(void *arg)
+{
+	void *objs[OBJS];
+	unsigned int i;
+
+	alloc_func(objs);
+	for (i = 0; i < OBJS; i++)
+		XFREE(MTYPE_TEST_POOLED, objs[i]);
+	return NULL;
+}
+
+static void test_pthreads(void)
+{
+	void *objs[OBJS], *last;
+	pthread_t thread;
+	size_t n_free;
+	unsigned int i;
+
+	n_free = pool_stats().n_free;
+
+	/* A pthread that exits hands its cache back to the pool */
+	pthread_create(&thread, NULL, alloc_free_func, NULL);
+	pthread_join(thread, NULL);
+	assert(pool_stats().n_free == n_free);
+
+	/* Objects freed on another pthread end up in that one's cache */
+	pthread_create(&thread, NULL, alloc_func, objs);
+	pthread_join(thread, NULL);
+	assert(mtype_stats_alloc(MTYPE_TEST_POOLED) == OBJS);
+	last = objs[OBJS - 1];
+	for (i = 0; i < OBJS; i++)
+		XFREE(MTYPE_TEST_POOLED, objs[i]);
+	assert(mtype_stats_alloc(MTYPE_TEST_POOLED) == 0);
+	objs[0] = XMALLOC(MTYPE_TEST_POOLED, SIZE);
+	assert(objs[0] == last);
+	XFREE(MTYPE_TEST_POOLED, objs[0]);
+
+	/* only what didn't make up a full batch stays in the cache */
+	assert(pool_stats().n_free == n_free - OBJS % MPOOL_BATCH);
+}
+
+/* "show memory" lists the pool with what mpool_walk() returns */
+static void test_show(void)
+{
+	struct mpool_stats stats, shown;
+	char *out, *line;
+
+	vty->node = ENABLE_NODE;
+	buffer_reset(vty->obuf);
+	assert(cmd_execute(vty, "show memory", NULL, 0) == CMD_SUCCESS);
+	out = buffer_getstr(vty->obuf);
+	stats = pool_stats();
+
+	line = strstr(out, "--- qmem pools ---");
+	assert(line);
+	line = strstr(line, "pooled test");
+	assert(line);
+	line = strchr(line, ':');
+	assert(sscanf(line + 1, "%zu %zu %zu %zu", &shown.size, &shown.n_slabs,
+		      &shown.reserved, &shown.n_free) == 4);
+	assert(shown.size == stats.size);
+	assert(shown.n_slabs == stats.n_slabs);
+	assert(shown.reserved == stats.reserved);
+	assert(shown.reserved >= stats.n_slabs * MPOOL_BATCH * stats.size);
+	assert(shown.n_free == stats.n_free);
+
+	XFREE(MTYPE_TMP, out);
+}
+
+int main(int argc, char **argv)
+{
+	/* AddressSanitizer builds leave the pools disabled */
+	if (!MTYPE_TEST_POOLED->pool)
+		return 0;
+
+	cmd_init(1);
+	lib_cmd_init();
+	vty = vty_new();
+	vty->type = VTY_TERM;
+
+	test_calloc();
+	test_cache();
+	test_pthreads();
+	test_show();
+
+	vty_close(vty);
+	cmd_terminate();
+	return 0;
+}
@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestMpool(frrtest.TestMultiOut):
+    program = "./test_mpool"
+
+
+TestMpool.exit_cleanly()
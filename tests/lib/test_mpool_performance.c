@@ -0,0 +1,96 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures XCALLOC/XFREE throughput for memtypes backed
+ * by an object pool versus plain malloc, for typical FRR object sizes.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+
+#include "memory.h"
+#include "mpool.h"
+#include "monotime.h"
+#include "prng.h"
+
+DEFINE_MGROUP(TEST_MPOOL, "mpool performance test");
+DEFINE_MTYPE_STATIC(TEST_MPOOL, MALLOC_48, "malloc 48");
+DEFINE_MTYPE_STATIC(TEST_MPOOL, MALLOC_112, "malloc 112");
+DEFINE_MTYPE_STATIC(TEST_MPOOL, MALLOC_240, "malloc 240");
+DEFINE_MTYPE_STATIC(TEST_MPOOL, POOL_48, "pool 48");
+DEFINE_MTYPE_STATIC(TEST_MPOOL, POOL_112, "pool 112");
+DEFINE_MTYPE_STATIC(TEST_MPOOL, POOL_240, "pool 240");
+
+DEFINE_MPOOL(POOL_48, 48);
+DEFINE_MPOOL(POOL_112, 112);
+DEFINE_MPOOL(POOL_240, 240);
+
+#define OBJECTS 100000
+#define ROUNDS	20
+
+static void *objs[OBJECTS];
+
+/* allocate a table's worth of objects and free them again; either in the
+ * order they were allocated, or in random order as route churn would
+ */
+static void run(struct memtype *mt, size_t size, struct prng *prng,
+		bool shuffle)
+{
+	struct timeval tv_start, tv_stop;
+	unsigned long t_run, ops;
+	unsigned int i, j, r;
+	void *tmp;
+
+	monotime(&tv_start);
+	for (r = 0; r < ROUNDS; r++) {
+		for (i = 0; i < OBJECTS; i++)
+			objs[i] = XCALLOC(mt, size);
+
+		if (shuffle)
+			for (i = OBJECTS - 1; i > 0; i--) {
+				j = prng_rand(prng) % (i + 1);
+				tmp = objs[i];
+				objs[i] = objs[j];
+				objs[j] = tmp;
+			}
+
+		for (i = 0; i < OBJECTS; i++)
+			XFREE(mt, objs[i]);
+	}
+	monotime(&tv_stop);
+
+	t_run = 1000000 * (tv_stop.tv_sec - tv_start.tv_sec) +
+		(tv_stop.tv_usec - tv_start.tv_usec);
+	ops = (unsigned long)OBJECTS * ROUNDS;
+
+	printf("%-10s %-8s: %lu alloc+free took %lu.%03lu seconds, %lu ns each.\n",
+	       mt->name, shuffle ? "random" : "in order", ops, t_run / 1000000,
+	       (t_run % 1000000) / 1000, t_run * 1000 / ops);
+	fflush(stdout);
+
+	assert(mtype_stats_alloc(mt) == 0);
+}
+
+int main(int argc, char **argv)
+{
+	static const struct {
+		struct memtype *malloc_mt, *pool_mt;
+		size_t size;
+	} sizes[] = {
+		{ MTYPE_MALLOC_48, MTYPE_POOL_48, 48 },
+		{ MTYPE_MALLOC_112, MTYPE_POOL_112, 112 },
+		{ MTYPE_MALLOC_240, MTYPE_POOL_240, 240 },
+	};
+	struct prng *prng = prng_new(0);
+	unsigned int i;
+
+	for (i = 0; i < array_size(sizes); i++) {
+		run(sizes[i].malloc_mt, sizes[i].size, prng, false);
+		run(sizes[i].pool_mt, sizes[i].size, prng, false);
+		run(sizes[i].malloc_mt, sizes[i].size, prng, true);
+		run(sizes[i].pool_mt, sizes[i].size, prng, true);
+	}
+
+	prng_free(prng);
+	return 0;
+}
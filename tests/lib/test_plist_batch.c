@@ -0,0 +1,403 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Prefix and access list batch tests: lists filled in a batch need to give
+ * the same results, and the same route-map prefix tables, as lists filled
+ * entry by entry, with one hook call per list and batch.
+ */
+
+#include <zebra.h>
+
+#include "lib/command.h"
+#include "lib/filter.h"
+#include "lib/prefix.h"
+#include "lib/plist.h"
+#include "lib/plist_int.h"
+#include "lib/routemap.h"
+#include "lib/table.h"
+
+#define ENTRIES 2000
+#define LOOKUPS 20000
+#define FILTERS 100
+
+static unsigned int add_calls, del_calls;
+
+static void add_hook(struct prefix_list *plist)
+{
+	add_calls++;
+}
+
+static void del_hook(struct prefix_list *plist)
+{
+	del_calls++;
+}
+
+static void random_prefix(afi_t afi, struct prefix *p, int maxlen)
+{
+	int i;
+
+	memset(p, 0, sizeof(*p));
+	p->family = afi2family(afi);
+	for (i = 0; i < 16; i++)
+		p->u.val[i] = random();
+	/* keep some overlap so the trie chains get longer than 1 */
+	p->u.val[0] &= 0x0f;
+	p->prefixlen = random() % (maxlen + 1);
+	apply_mask(p);
+}
+
+static struct prefix_list_entry *entries_make(afi_t afi)
+{
+	struct prefix_list_entry *specs;
+	int maxlen = afi == AFI_IP ? IPV4_MAX_BITLEN : IPV6_MAX_BITLEN;
+	int i;
+
+	specs = calloc(ENTRIES, sizeof(*specs));
+	for (i = 0; i < ENTRIES; i++) {
+		specs[i].seq = (i + 1) * 5;
+		specs[i].type = (random() & 1) ? PREFIX_PERMIT : PREFIX_DENY;
+		random_prefix(afi, &specs[i].prefix, maxlen);
+		if (random() & 1) {
+			specs[i].le = maxlen;
+			specs[i].ge = specs[i].prefix.prefixlen;
+		}
+	}
+	return specs;
+}
+
+static void entry_add(struct prefix_list *plist,
+		      const struct prefix_list_entry *spec)
+{
+	struct prefix_list_entry *ple = prefix_list_entry_new();
+
+	ple->seq = spec->seq;
+	ple->type = spec->type;
+	ple->prefix = spec->prefix;
+	ple->le = spec->le;
+	ple->ge = spec->ge;
+	ple->pl = plist;
+	prefix_list_entry_update_finish(ple);
+}
+
+static void entry_del(struct prefix_list *plist, int64_t seq)
+{
+	struct prefix_list_entry *ple;
+
+	for (ple = plist->head; ple; ple = ple->next)
+		if (ple->seq == seq)
+			break;
+	assert(ple);
+	prefix_list_entry_delete2(ple);
+}
+
+static void compare(afi_t afi, struct prefix_list *a, struct prefix_list *b)
+{
+	const struct prefix_list_entry *wa, *wb;
+	int maxlen = afi == AFI_IP ? IPV4_MAX_BITLEN : IPV6_MAX_BITLEN;
+	struct prefix p;
+	int i;
+
+	assert(a->count == b->count);
+
+	for (i = 0; i < LOOKUPS; i++) {
+		random_prefix(afi, &p, maxlen);
+		assert(prefix_list_apply_ext(a, &wa, &p, false) ==
+		       prefix_list_apply_ext(b, &wb, &p, false));
+		assert(!wa == !wb);
+		assert(!wa || wa->seq == wb->seq);
+	}
+}
+
+/*
+ * Route-maps matching on the prefix lists.  Only the match statement's name
+ * matters for the prefix tables, the rule itself is never applied.
+ */
+static enum route_map_cmd_result_t rmap_match(void *rule,
+					      const struct prefix *prefix,
+					      void *object)
+{
+	return RMAP_NOMATCH;
+}
+
+static const struct route_map_rule_cmd rmap_match_ip_cmd = {
+	"ip address prefix-list", rmap_match, NULL, NULL
+};
+
+static const struct route_map_rule_cmd rmap_match_ipv6_cmd = {
+	"ipv6 address prefix-list", rmap_match, NULL, NULL
+};
+
+static struct route_map *rmap_make(afi_t afi, const char *plist_name)
+{
+	struct route_map *map;
+	struct route_map_index *index;
+	char name[64];
+
+	snprintf(name, sizeof(name), "rm-%s-%s", plist_name, afi2str(afi));
+	map = route_map_get(name);
+	index = route_map_index_get(map, RMAP_PERMIT, 10);
+	assert(route_map_add_match(index,
+				   afi == AFI_IP ? rmap_match_ip_cmd.str
+						 : rmap_match_ipv6_cmd.str,
+				   plist_name, RMAP_EVENT_PLIST_ADDED) ==
+	       RMAP_COMPILE_SUCCESS);
+	return map;
+}
+
+static struct route_node *rmap_node_next(struct route_node *rn)
+{
+	while (rn && !rn->info)
+		rn = route_next(rn);
+	return rn;
+}
+
+/* Same prefixes in the tables, each with one route-map index */
+static void rmap_compare(afi_t afi, struct route_map *a, struct route_map *b)
+{
+	struct route_table *ta, *tb;
+	struct route_node *ra, *rb;
+	unsigned int n = 0;
+
+	ta = afi == AFI_IP ? a->ipv4_prefix_table : a->ipv6_prefix_table;
+	tb = afi == AFI_IP ? b->ipv4_prefix_table : b->ipv6_prefix_table;
+
+	ra = rmap_node_next(route_top(ta));
+	rb = rmap_node_next(route_top(tb));
+	while (ra || rb) {
+		assert(ra && rb);
+		assert(prefix_same(&ra->p, &rb->p));
+		assert(listcount((struct list *)ra->info) == 1);
+		assert(listcount((struct list *)rb->info) == 1);
+		n++;
+
+		ra = rmap_node_next(route_next(ra));
+		rb = rmap_node_next(route_next(rb));
+	}
+	/* the default route's node is gone once the list has entries */
+	assert(n > 1);
+}
+
+static void test_afi(afi_t afi)
+{
+	struct prefix_list_entry *specs = entries_make(afi);
+	struct prefix_list *a, *b, *c;
+	struct route_map *rm_a, *rm_b;
+	int i;
+
+	/* the route-maps come first, the lists get filled in afterwards */
+	rm_a = rmap_make(afi, "single");
+	rm_b = rmap_make(afi, "batch");
+
+	/* one add hook call per entry without a batch */
+	add_calls = del_calls = 0;
+	a = prefix_list_get(afi, 0, "single");
+	for (i = 0; i < ENTRIES; i++)
+		entry_add(a, &specs[i]);
+	assert(add_calls == ENTRIES);
+
+	/* and one per list with one, in any order */
+	add_calls = 0;
+	prefix_list_batch_start();
+	b = prefix_list_get(afi, 0, "batch");
+	for (i = ENTRIES - 1; i >= 0; i--)
+		entry_add(b, &specs[i]);
+	assert(add_calls == 0);
+	prefix_list_batch_end();
+	assert(add_calls == 1);
+	compare(afi, a, b);
+	/* one route_map_notify_plist_dependencies() for the whole list */
+	rmap_compare(afi, rm_a, rm_b);
+
+	/* lookups in the middle of a batch see the entries added so far,
+	 * deletions get one delete hook call per list in the end
+	 */
+	add_calls = 0;
+	prefix_list_batch_start();
+	c = prefix_list_get(afi, 0, "lookup");
+	for (i = 0; i < ENTRIES / 2; i++)
+		entry_add(c, &specs[i]);
+	for (i = ENTRIES / 2; i < ENTRIES; i++)
+		entry_del(a, specs[i].seq);
+	compare(afi, a, c);
+
+	for (i = 0; i < ENTRIES; i += 2)
+		entry_del(b, specs[i].seq);
+	for (i = 0; i < ENTRIES / 2; i += 2)
+		entry_del(c, specs[i].seq);
+	assert(add_calls == 0 && del_calls == 0);
+	prefix_list_batch_end();
+	/* a and b had entries removed, c had both */
+	assert(add_calls == 1);
+	assert(del_calls == 2);
+
+	for (i = 0; i < ENTRIES / 2; i += 2)
+		entry_del(a, specs[i].seq);
+	for (i = ENTRIES / 2 + 1; i < ENTRIES; i += 2)
+		entry_del(b, specs[i].seq);
+	compare(afi, a, b);
+	compare(afi, a, c);
+
+	/* nested batches are flushed by the outermost end */
+	add_calls = 0;
+	prefix_list_batch_start();
+	prefix_list_batch_start();
+	for (i = ENTRIES / 2; i < ENTRIES; i += 2)
+		entry_add(c, &specs[i]);
+	prefix_list_batch_end();
+	assert(add_calls == 0);
+	prefix_list_batch_end();
+	assert(add_calls == 1);
+
+	for (i = ENTRIES / 2; i < ENTRIES; i += 2)
+		entry_add(a, &specs[i]);
+	compare(afi, a, c);
+
+	prefix_list_delete(a);
+	prefix_list_delete(b);
+	prefix_list_delete(c);
+	free(specs);
+}
+
+/* access-lists under test, and hook calls for each */
+static struct access_list *acl[2];
+static unsigned int acl_add[2], acl_del[2];
+
+static void acl_add_hook(struct access_list *access)
+{
+	for (unsigned int i = 0; i < array_size(acl); i++)
+		if (access == acl[i])
+			acl_add[i]++;
+}
+
+static void acl_del_hook(struct access_list *access)
+{
+	for (unsigned int i = 0; i < array_size(acl); i++)
+		if (access == acl[i])
+			acl_del[i]++;
+}
+
+static void acl_reset(void)
+{
+	memset(acl_add, 0, sizeof(acl_add));
+	memset(acl_del, 0, sizeof(acl_del));
+}
+
+static bool acl_called(void)
+{
+	return acl_add[0] || acl_add[1] || acl_del[0] || acl_del[1];
+}
+
+static void filter_add(afi_t afi, struct access_list *access, int64_t seq)
+{
+	int maxlen = afi == AFI_IP ? IPV4_MAX_BITLEN : IPV6_MAX_BITLEN;
+	struct filter *filter = filter_new();
+
+	filter->acl = access;
+	filter->seq = seq;
+	filter->type = (random() & 1) ? FILTER_PERMIT : FILTER_DENY;
+	random_prefix(afi, &filter->u.zfilter.prefix, maxlen);
+	access_list_filter_add(access, filter);
+	access_list_filter_update(access);
+}
+
+static void filter_del(struct access_list *access, int64_t seq)
+{
+	struct filter *filter;
+
+	for (filter = access->head; filter; filter = filter->next)
+		if (filter->seq == seq)
+			break;
+	assert(filter);
+	access_list_filter_delete(access, filter);
+}
+
+static void test_access_list(afi_t afi)
+{
+	int i;
+
+	acl[0] = access_list_get(afi, "acl-a");
+	acl[1] = access_list_get(afi, "acl-b");
+
+	/* one add hook call per filter without a batch */
+	acl_reset();
+	for (i = 1; i <= FILTERS; i++)
+		filter_add(afi, acl[0], i * 5);
+	assert(acl_add[0] == FILTERS && !acl_add[1]);
+
+	/* and one per access-list with one */
+	acl_reset();
+	access_list_batch_start();
+	for (i = 1; i <= FILTERS; i++) {
+		filter_add(afi, acl[1], i * 5);
+		filter_add(afi, acl[0], i * 5 + 1);
+	}
+	assert(!acl_called());
+	access_list_batch_end();
+	assert(acl_add[0] == 1 && acl_add[1] == 1);
+	assert(!acl_del[0] && !acl_del[1]);
+
+	/* deletions get one delete hook call, a list with both only the add
+	 * hook call
+	 */
+	acl_reset();
+	access_list_batch_start();
+	for (i = 1; i <= FILTERS; i++)
+		filter_del(acl[0], i * 5 + 1);
+	for (i = 1; i <= FILTERS; i += 2)
+		filter_del(acl[1], i * 5);
+	filter_add(afi, acl[1], 1);
+	assert(!acl_called());
+	access_list_batch_end();
+	assert(!acl_add[0] && acl_del[0] == 1);
+	assert(acl_add[1] == 1 && !acl_del[1]);
+
+	/* nested batches are flushed by the outermost end, replacing a filter
+	 * with the same seq doesn't add a delete hook call
+	 */
+	acl_reset();
+	access_list_batch_start();
+	access_list_batch_start();
+	filter_add(afi, acl[0], 5);
+	filter_add(afi, acl[0], 5);
+	access_list_batch_end();
+	assert(!acl_called());
+	access_list_batch_end();
+	assert(acl_add[0] == 1 && !acl_del[0]);
+
+	/* a list deleted in a batch is notified then, not again at the end */
+	acl_reset();
+	access_list_batch_start();
+	filter_add(afi, acl[1], 2);
+	access_list_delete(acl[1]);
+	acl[1] = NULL;
+	assert(!acl_add[1] && acl_del[1] == 1);
+	acl_reset();
+	access_list_batch_end();
+	assert(!acl_called());
+
+	access_list_delete(acl[0]);
+	acl[0] = NULL;
+}
+
+int main(int argc, char **argv)
+{
+	srandom(1);
+
+	cmd_init(1);
+	route_map_init();
+	route_map_install_match(&rmap_match_ip_cmd);
+	route_map_install_match(&rmap_match_ipv6_cmd);
+
+	prefix_list_add_hook(add_hook);
+	prefix_list_delete_hook(del_hook);
+	access_list_add_hook(acl_add_hook);
+	access_list_delete_hook(acl_del_hook);
+
+	test_afi(AFI_IP);
+	test_afi(AFI_IP6);
+	test_access_list(AFI_IP);
+	test_access_list(AFI_IP6);
+
+	route_map_finish();
+	cmd_terminate();
+	return 0;
+}
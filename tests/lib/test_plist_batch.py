@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestPlistBatch(frrtest.TestMultiOut):
+    program = "./test_plist_batch"
+
+
+TestPlistBatch.exit_cleanly()
@@ -1,14 +1,19 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
-/* Simple stream test.
+/* Simple stream test.  Run with "bench" to measure stream throughput
+ * instead.
  *
  * Copyright (C) 2006 Sun Microsystems, Inc.
  */
 
 #include <zebra.h>
+
+#include <fcntl.h>
+
 #include <stream.h>
 #include "frrevent.h"
 
 #include "printfrr.h"
+#include "monotime.h"
 
 static unsigned long long ham = 0xdeadbeefdeadbeef;
 struct event_loop *master;
@@ -31,10 +36,232 @@ static void print_stream(struct stream *s)
 	stream_set_getp(s, getp);
 }
 
-int main(void)
+/* clones share data with the original; it goes away with the last one */
+static void test_clone(void)
+{
+	struct stream *s, *c1, *c2;
+
+	s = stream_new(64);
+	stream_putl(s, 0x01020304);
+	stream_putl(s, 0x05060708);
+	stream_getl(s);
+
+	c1 = stream_clone(s);
+	assert(STREAM_DATA(c1) == STREAM_DATA(s));
+	assert(stream_get_getp(c1) == 4 && stream_get_endp(c1) == 8);
+	assert(STREAM_WRITEABLE(c1) == 0);
+	assert(stream_getl(c1) == 0x05060708);
+	assert(stream_get_getp(s) == 4);
+
+	/* the original may still be appended to */
+	stream_putw(s, 0x090a);
+	c2 = stream_clone(c1);
+	assert(STREAM_DATA(c2) == STREAM_DATA(s));
+	assert(stream_get_endp(c2) == 8);
+
+	stream_free(s);
+	stream_free(c1);
+	stream_set_getp(c2, 0);
+	assert(stream_getl(c2) == 0x01020304);
+	stream_free(c2);
+
+	/* freed the usual way once all clones are gone */
+	s = stream_new(16);
+	stream_free(stream_clone(s));
+	stream_reset(s);
+	stream_resize_inplace(&s, 8192);
+	stream_resize_inplace(&s, 128);
+	stream_free(s);
+}
+
+/* resizing within a size class keeps the data and makes room for the rest */
+static void test_resize(void)
+{
+	static const size_t sizes[] = { 100, 400, 200, 600, 4000, 8000, 5000 };
+	struct stream *s;
+	size_t i, j;
+
+	s = stream_new(sizes[0]);
+	for (i = 0; i < array_size(sizes); i++) {
+		stream_resize_inplace(&s, sizes[i]);
+		assert(STREAM_SIZE(s) == sizes[i]);
+		for (j = 0; j < stream_get_endp(s); j++)
+			assert(s->data[j] == (uint8_t)j);
+		while (STREAM_WRITEABLE(s))
+			stream_putc(s, stream_get_endp(s));
+	}
+	stream_free(s);
+}
+
+static void test_chain(void)
+{
+	struct stream_chain sc;
+	struct stream *s, *flat;
+	struct iovec iov[8];
+	uint8_t buf[300];
+	size_t i;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = i;
+
+	stream_chain_init(&sc, 128);
+	s = stream_chain_reserve(&sc, 4);
+	stream_putl(s, 0xdeadbeef);
+	stream_chain_put(&sc, buf, sizeof(buf));
+	assert(stream_chain_len(&sc) == 4 + sizeof(buf));
+	assert(stream_chain_iov(&sc, iov, array_size(iov)) == 3);
+	assert(iov[0].iov_len == 128 && iov[2].iov_len == 4 + 300 - 256);
+
+	/* big reservations get a stream of their own */
+	s = stream_chain_reserve(&sc, 1000);
+	assert(STREAM_WRITEABLE(s) >= 1000);
+	stream_chain_put(&sc, NULL, 2);
+
+	s = stream_new(16);
+	stream_putw(s, 0x1234);
+	stream_chain_append(&sc, stream_clone(s));
+	stream_free(s);
+	assert(stream_chain_len(&sc) == 4 + sizeof(buf) + 2 + 2);
+
+	flat = stream_chain_flatten(&sc);
+	assert(!sc.head && !sc.tail);
+	assert(stream_getl(flat) == 0xdeadbeef);
+	for (i = 0; i < sizeof(buf); i++)
+		assert(stream_getc(flat) == buf[i]);
+	assert(stream_getw(flat) == 0);
+	assert(stream_getw(flat) == 0x1234);
+	assert(STREAM_READABLE(flat) == 0);
+	stream_free(flat);
+}
+
+static unsigned long elapsed_us(struct timeval *start)
+{
+	struct timeval stop;
+
+	monotime(&stop);
+	return 1000000 * (stop.tv_sec - start->tv_sec) +
+	       (stop.tv_usec - start->tv_usec);
+}
+
+static void bench_report(const char *what, unsigned long t_run,
+			 unsigned long ops)
+{
+	printf("%-36s: %8lu took %lu.%03lu seconds, %lu ns each.\n", what, ops,
+	       t_run / 1000000, (t_run % 1000000) / 1000, t_run * 1000 / ops);
+	fflush(stdout);
+}
+
+#define BENCH_OPS   1000000
+#define BENCH_PEERS 64
+#define BENCH_MSG   (1 << 20)
+
+static void bench_new(size_t size)
+{
+	struct timeval start;
+	struct stream *s;
+	char what[64];
+	unsigned int i;
+
+	monotime(&start);
+	for (i = 0; i < BENCH_OPS; i++) {
+		s = stream_new(size);
+		stream_putl(s, i);
+		stream_free(s);
+	}
+	snprintf(what, sizeof(what), "stream_new/free %zu bytes", size);
+	bench_report(what, elapsed_us(&start), BENCH_OPS);
+}
+
+/* one update packet, handed to every peer of an update group */
+static void bench_fanout(bool clone)
+{
+	struct stream *pkt, *out[BENCH_PEERS];
+	struct timeval start;
+	unsigned int i, j;
+
+	pkt = stream_new(4096);
+	stream_put(pkt, NULL, 4096);
+
+	monotime(&start);
+	for (i = 0; i < BENCH_OPS / BENCH_PEERS; i++) {
+		for (j = 0; j < BENCH_PEERS; j++)
+			out[j] = clone ? stream_clone(pkt) : stream_dup(pkt);
+		for (j = 0; j < BENCH_PEERS; j++)
+			stream_free(out[j]);
+	}
+	bench_report(clone ? "4096 byte packet stream_clone" :
+			     "4096 byte packet stream_dup",
+		     elapsed_us(&start), BENCH_OPS / BENCH_PEERS * BENCH_PEERS);
+	stream_free(pkt);
+}
+
+/* encode a 1MB message in 64 byte records of unknown total size */
+static void bench_build(bool chain, int fd)
+{
+	struct stream_chain sc;
+	struct timeval start;
+	struct stream *s;
+	uint8_t rec[64] = {};
+	unsigned int i, j, rounds = 100;
+
+	monotime(&start);
+	for (i = 0; i < rounds; i++) {
+		if (chain) {
+			stream_chain_init(&sc, 4096);
+			for (j = 0; j < BENCH_MSG / sizeof(rec); j++)
+				stream_put(stream_chain_reserve(&sc, sizeof(rec)),
+					   rec, sizeof(rec));
+			while (stream_chain_len(&sc))
+				assert(stream_chain_write(&sc, fd) > 0);
+			stream_chain_fini(&sc);
+			continue;
+		}
+
+		s = stream_new(4096);
+		for (j = 0; j < BENCH_MSG / sizeof(rec); j++) {
+			if (STREAM_WRITEABLE(s) < sizeof(rec))
+				stream_resize_inplace(&s, 2 * STREAM_SIZE(s));
+			stream_put(s, rec, sizeof(rec));
+		}
+		while (STREAM_READABLE(s))
+			stream_forward_getp(s, stream_flush(s, fd));
+		stream_free(s);
+	}
+	bench_report(chain ? "1MB message, stream_chain" :
+			     "1MB message, stream_resize_inplace",
+		     elapsed_us(&start), rounds);
+}
+
+static void bench(void)
+{
+	int fd = open("/dev/null", O_WRONLY);
+
+	assert(fd >= 0);
+
+	bench_new(64);
+	bench_new(4096);
+	bench_new(65536);
+	bench_fanout(false);
+	bench_fanout(true);
+	bench_build(false, fd);
+	bench_build(true, fd);
+
+	close(fd);
+}
+
+int main(int argc, char **argv)
 {
 	struct stream *s;
 
+	if (argc > 1 && !strcmp(argv[1], "bench")) {
+		bench();
+		return 0;
+	}
+
+	test_clone();
+	test_resize();
+	test_chain();
+
 	s = stream_new(1024);
 
 	stream_putc(s, ham);
@@ -477,6 +477,143 @@ static void test_iter_pause(void)
 	route_table_finish(table);
 }
 
+/*
+ * del_node
+ *
+ * Remove the given prefix (passed in as a string) from the given table.
+ */
+static void del_node(struct route_table *table, const char *prefix_str)
+{
+	struct prefix_ipv4 p;
+	test_node_t *node;
+	struct route_node *rn;
+
+	if (str2prefix_ipv4(prefix_str, &p) <= 0)
+		assert(0);
+
+	rn = route_node_lookup(table, (struct prefix *)&p);
+	assert(rn);
+	node = rn->info;
+	rn->info = NULL;
+	route_unlock_node(rn);
+	route_unlock_node(rn);
+	free(node->prefix_str);
+	free(node);
+}
+
+/*
+ * verify_lpm
+ *
+ * Look up a range of addresses in a table using the LPM index and in one
+ * without, and make sure both find the same prefixes.
+ */
+static void verify_lpm_addr(struct route_table *table,
+			    struct route_table *plain, uint32_t addr)
+{
+	struct route_node *rn, *plain_rn;
+	struct in_addr in = { .s_addr = htonl(addr) };
+
+	rn = route_node_match_ipv4(table, &in);
+	plain_rn = route_node_match_ipv4(plain, &in);
+	assert(!rn == !plain_rn);
+	if (!rn)
+		return;
+
+	assert(prefix_same(&rn->p, &plain_rn->p));
+	route_unlock_node(rn);
+	route_unlock_node(plain_rn);
+}
+
+static void verify_lpm(struct route_table *table, struct route_table *plain)
+{
+	uint32_t i;
+
+	for (i = 0; i < 0x40000; i++)
+		verify_lpm_addr(table, plain, 0x0a000000 + i * 97);
+
+	printf("Verified LPM index on tree with %lu nodes\n",
+	       route_table_count(table));
+}
+
+/*
+ * test_lpm
+ */
+static void test_lpm(void)
+{
+	struct route_table *table, *plain;
+	struct prefix_ipv4 p;
+	struct route_node *rn;
+	char buf[PREFIX_STRLEN];
+	size_t memory;
+	int i;
+
+	printf("\n\nTesting route_node_match() with an LPM index\n");
+	table = route_table_init();
+	plain = route_table_init();
+	route_table_set_lpm(table, true);
+
+	for (i = 0; i < 2048; i++) {
+		snprintfrr(buf, sizeof(buf), "10.%d.%d.%d/%d", i % 64,
+			   (i * 37) % 256, (i * 11) % 256, 8 + i % 25);
+		str2prefix_ipv4(buf, &p);
+		apply_mask_ipv4(&p);
+		prefix2str(&p, buf, sizeof(buf));
+
+		rn = route_node_lookup(plain, (struct prefix *)&p);
+		if (rn) {
+			route_unlock_node(rn);
+			continue;
+		}
+		add_node(table, buf);
+		add_node(plain, buf);
+	}
+
+	route_table_lpm_build(table, AF_INET);
+	verify_lpm(table, plain);
+
+	/* Leave the index stale, lookups rebuild it eventually */
+	for (i = 0; i < 2048; i += 3) {
+		snprintfrr(buf, sizeof(buf), "10.%d.%d.%d/%d", i % 64,
+			   (i * 37) % 256, (i * 11) % 256, 8 + i % 25);
+		str2prefix_ipv4(buf, &p);
+		apply_mask_ipv4(&p);
+		prefix2str(&p, buf, sizeof(buf));
+
+		rn = route_node_lookup(plain, (struct prefix *)&p);
+		if (!rn)
+			continue;
+		route_unlock_node(rn);
+		del_node(table, buf);
+		del_node(plain, buf);
+	}
+	verify_lpm(table, plain);
+
+	clear_table(table);
+	clear_table(plain);
+
+	/* A few lookups in a small table don't pay for a rebuild */
+	route_table_set_lpm(table, false);
+	route_table_set_lpm(table, true);
+	memory = route_table_lpm_memory(table);
+	for (i = 0; i < 8; i++) {
+		snprintfrr(buf, sizeof(buf), "10.%d.0.0/16", i);
+		add_node(table, buf);
+		add_node(plain, buf);
+	}
+	for (i = 0; i < 1000; i++)
+		verify_lpm_addr(table, plain, 0x0a000000 + i * 97);
+	assert(route_table_lpm_memory(table) == memory);
+
+	/* but enough of them do */
+	verify_lpm(table, plain);
+	assert(route_table_lpm_memory(table) > memory);
+
+	clear_table(table);
+	clear_table(plain);
+	route_table_finish(plain);
+	route_table_finish(table);
+}
+
 /*
  * run_tests
  */
@@ -485,6 +622,7 @@ static void run_tests(void)
 	test_prefix_iter_cmp();
 	test_get_next();
 	test_iter_pause();
+	test_lpm();
 }
 
 /*
@@ -10,3 +10,5 @@ for i in range(6):
 for i in range(11):
     TestTable.onesimple("Verifying successor")
 TestTable.onesimple("Verified pausing")
+for i in range(3):
+    TestTable.onesimple("Verified LPM index")
@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures longest prefix match lookups on a route
+ * table, walking the radix tree versus using the LPM index, along with
+ * the memory both take per prefix.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+
+#include "monotime.h"
+#include "prefix.h"
+#include "table.h"
+#include "prng.h"
+
+#define IPV4_PREFIXES 1000000
+#define IPV6_PREFIXES 200000
+#define LOOKUPS 5000000
+
+static int route_info;
+
+static uint32_t prng_u32(struct prng *prng)
+{
+	return ((uint32_t)prng_rand(prng) << 16) ^ (uint32_t)prng_rand(prng);
+}
+
+/* Mostly /24s, like a full table, with shorter aggregates and hosts. */
+static void random_ipv4(struct prng *prng, struct prefix *p)
+{
+	unsigned int r = prng_rand(prng) % 100;
+
+	memset(p, 0, sizeof(*p));
+	p->family = AF_INET;
+	if (r < 60)
+		p->prefixlen = 24;
+	else if (r < 95)
+		p->prefixlen = 8 + r % 16;
+	else
+		p->prefixlen = 32;
+	p->u.prefix4.s_addr = htonl(0x01000000 + prng_u32(prng) % 0xdf000000);
+	apply_mask(p);
+}
+
+/* Mostly /48s out of 2000::/3, with shorter allocations and hosts. */
+static void random_ipv6(struct prng *prng, struct prefix *p)
+{
+	unsigned int r = prng_rand(prng) % 100, i;
+
+	memset(p, 0, sizeof(*p));
+	p->family = AF_INET6;
+	if (r < 50)
+		p->prefixlen = 48;
+	else if (r < 95)
+		p->prefixlen = 29 + r % 36;
+	else
+		p->prefixlen = 128;
+	for (i = 0; i < 4; i++)
+		p->u.prefix6.s6_addr32[i] = prng_u32(prng);
+	p->u.prefix6.s6_addr[0] = 0x20 | (p->u.prefix6.s6_addr[0] & 0x1f);
+	apply_mask(p);
+}
+
+/* Turn a prefix into a random host address within it. */
+static void random_host(struct prng *prng, struct prefix *p)
+{
+	unsigned int i, blen = prefix_blen(p);
+
+	for (i = p->prefixlen / 8; i < blen; i++) {
+		if (i == p->prefixlen / 8)
+			p->u.val[i] |= prng_rand(prng) & (0xff >> p->prefixlen % 8);
+		else
+			p->u.val[i] = prng_rand(prng);
+	}
+	p->prefixlen = blen * 8;
+}
+
+static unsigned long elapsed_msec(struct timeval *start, struct timeval *stop)
+{
+	return 1000 * (stop->tv_sec - start->tv_sec) +
+	       (stop->tv_usec - start->tv_usec) / 1000;
+}
+
+static unsigned long lookup_all(struct route_table *table,
+				struct prefix *addrs, struct route_node **res)
+{
+	struct timeval tv_start, tv_stop;
+	struct route_node *rn;
+	unsigned int i;
+
+	monotime(&tv_start);
+	for (i = 0; i < LOOKUPS; i++) {
+		rn = route_node_match(table, &addrs[i]);
+		if (rn)
+			route_unlock_node(rn);
+		res[i] = rn;
+	}
+	monotime(&tv_stop);
+
+	return elapsed_msec(&tv_start, &tv_stop);
+}
+
+static void run(const char *name, unsigned int prefixes,
+		void (*random_prefix)(struct prng *, struct prefix *))
+{
+	struct prng *prng = prng_new(0);
+	struct route_table *table = route_table_init();
+	struct prefix *addrs = calloc(LOOKUPS, sizeof(*addrs));
+	struct route_node **res_tree = calloc(LOOKUPS, sizeof(*res_tree));
+	struct route_node **res_lpm = calloc(LOOKUPS, sizeof(*res_lpm));
+	struct prefix *prefixes_added = calloc(prefixes, sizeof(struct prefix));
+	struct timeval tv_start, tv_stop;
+	unsigned long t_build, t_tree, t_lpm, found = 0;
+	struct route_node *rn;
+	unsigned int i;
+
+	for (i = 0; i < prefixes; i++) {
+		random_prefix(prng, &prefixes_added[i]);
+		rn = route_node_get(table, &prefixes_added[i]);
+		rn->info = &route_info;
+	}
+
+	/*
+	 * Host addresses inside the table's prefixes, and as many random
+	 * ones that mostly miss or only hit short prefixes.
+	 */
+	for (i = 0; i < LOOKUPS; i++) {
+		if (i & 1)
+			random_prefix(prng, &addrs[i]);
+		else
+			addrs[i] = prefixes_added[prng_u32(prng) % prefixes];
+		random_host(prng, &addrs[i]);
+	}
+
+	t_tree = lookup_all(table, addrs, res_tree);
+
+	route_table_set_lpm(table, true);
+	monotime(&tv_start);
+	route_table_lpm_build(table, addrs[0].family);
+	monotime(&tv_stop);
+	t_build = elapsed_msec(&tv_start, &tv_stop);
+
+	t_lpm = lookup_all(table, addrs, res_lpm);
+
+	for (i = 0; i < LOOKUPS; i++) {
+		assert(res_tree[i] == res_lpm[i]);
+		if (res_lpm[i])
+			found++;
+	}
+
+	printf("%s, %u prefixes, %lu table nodes:\n", name, prefixes,
+	       route_table_count(table));
+	printf("  %u tree lookups took %lu.%03lu seconds.\n", LOOKUPS,
+	       t_tree / 1000, t_tree % 1000);
+	printf("  index build took %lu.%03lu seconds.\n", t_build / 1000,
+	       t_build % 1000);
+	printf("  %u index lookups took %lu.%03lu seconds (%lu matched).\n",
+	       LOOKUPS, t_lpm / 1000, t_lpm % 1000, found);
+	printf("  tree: %zu bytes per prefix, index: %zu bytes per prefix.\n",
+	       route_table_count(table) * sizeof(struct route_node) / prefixes,
+	       route_table_lpm_memory(table) / prefixes);
+	fflush(stdout);
+
+	route_table_finish(table);
+	free(addrs);
+	free(res_tree);
+	free(res_lpm);
+	free(prefixes_added);
+	prng_free(prng);
+}
+
+int main(int argc, char **argv)
+{
+	run("IPv4", IPV4_PREFIXES, random_ipv4);
+	run("IPv6", IPV6_PREFIXES, random_ipv6);
+
+	return 0;
+}
@@ -1,7 +1,7 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
  * Test program to verify that scheduled timers are executed in the
- * correct order.
+ * correct order, on the timer heap as well as on the timer wheel.
  *
  * Copyright (C) 2013 by Open Source Routing.
  * Copyright (C) 2013 by Internet Systems Consortium, Inc. ("ISC")
@@ -23,6 +23,9 @@
 
 #define TIMESTR_LEN strlen("4294967296.999999")
 
+/* Tick of the timer wheel, timers on it run at the end of their tick */
+#define WHEEL_TICK_USEC 10000
+
 struct event_loop *master;
 
 static size_t log_buf_len;
@@ -37,36 +40,59 @@ static struct prng *prng;
 
 static struct event **timers;
 
+struct alarm {
+	struct timeval sands;
+	/* when the timer is expected to run */
+	struct timeval due;
+	int index;
+	bool cancelled;
+};
+
+static struct alarm *alarms;
+
 static int timers_pending;
 
-static void terminate_test(void)
-{
-	int exit_code;
+/* Timers far enough out to sit on the upper wheel levels, or beyond */
+static const long far_secs[] = { 60, 3 * 3600, 100 * 3600 };
+static struct event *far_timers[array_size(far_secs)];
 
+static void check_output(const char *name)
+{
 	if (strcmp(log_buf, expected_buf)) {
 		fprintf(stderr,
-			"Expected output and received output differ.\n");
+			"%s: Expected output and received output differ.\n",
+			name);
 		fprintf(stderr, "---Expected output: ---\n%s", expected_buf);
 		fprintf(stderr, "---Actual output: ---\n%s", log_buf);
-		exit_code = 1;
-	} else {
-		printf("Expected output and actual output match.\n");
-		exit_code = 0;
+		exit(1);
 	}
 
-	event_master_free(master);
-	XFREE(MTYPE_TMP, log_buf);
-	XFREE(MTYPE_TMP, expected_buf);
-	prng_free(prng);
-	XFREE(MTYPE_TMP, timers);
+	printf("%s: Expected output and actual output match.\n", name);
+}
+
+static void cancel_random(void)
+{
+	int index;
 
-	exit(exit_code);
+	index = prng_rand(prng) % SCHEDULE_TIMERS;
+	if (!timers[index])
+		return;
+
+	XFREE(MTYPE_TMP, timers[index]->arg);
+	event_cancel(&timers[index]);
+	alarms[index].cancelled = true;
+	timers_pending--;
 }
 
 static void timer_func(struct event *thread)
 {
+	struct timeval now;
 	int rv;
 
+	/* Timers may run late, but never early */
+	monotime(&now);
+	assert(!timercmp(&now, &thread->u.sands, <));
+
 	rv = snprintf(log_buf + log_buf_pos, log_buf_len - log_buf_pos, "%s\n",
 		      (char *)thread->arg);
 	assert(rv >= 0);
@@ -75,41 +101,55 @@ static void timer_func(struct event *thread)
 	XFREE(MTYPE_TMP, thread->arg);
 
 	timers_pending--;
-	if (!timers_pending)
-		terminate_test();
+
+	/* Cancel timers that have moved through the wheel already, too */
+	if (prng_rand(prng) % 8 == 0)
+		cancel_random();
+}
+
+static void far_func(struct event *thread)
+{
+	assert(0);
 }
 
-static int cmp_timeval(const void *a, const void *b)
+static int cmp_alarm(const void *a, const void *b)
 {
-	const struct timeval *ta = *(struct timeval * const *)a;
-	const struct timeval *tb = *(struct timeval * const *)b;
+	const struct alarm *aa = *(struct alarm * const *)a;
+	const struct alarm *ab = *(struct alarm * const *)b;
 
-	if (timercmp(ta, tb, <))
+	if (timercmp(&aa->due, &ab->due, <))
 		return -1;
-	if (timercmp(ta, tb, >))
+	if (timercmp(&aa->due, &ab->due, >))
 		return 1;
-	return 0;
+	/* A wheel slot runs its timers in the order they were added */
+	return aa->index - ab->index;
 }
 
-int main(int argc, char **argv)
+static void run(const char *name, enum event_io_backend backend, bool wheel)
 {
 	int i, j;
 	struct event t;
-	struct timeval **alarms;
+	struct alarm **sorted;
+	uint64_t usec;
 
-	master = event_master_create(NULL);
+	master = event_master_create_backend(name, backend);
+	event_master_set_timer_wheel(master, wheel);
 
 	log_buf_len = SCHEDULE_TIMERS * (TIMESTR_LEN + 1) + 1;
 	log_buf_pos = 0;
 	log_buf = XMALLOC(MTYPE_TMP, log_buf_len);
+	log_buf[0] = '\0';
 
 	expected_buf_len = SCHEDULE_TIMERS * (TIMESTR_LEN + 1) + 1;
 	expected_buf_pos = 0;
 	expected_buf = XMALLOC(MTYPE_TMP, expected_buf_len);
+	expected_buf[0] = '\0';
 
 	prng = prng_new(0);
 
+	timers_pending = 0;
 	timers = XCALLOC(MTYPE_TMP, SCHEDULE_TIMERS * sizeof(*timers));
+	alarms = XCALLOC(MTYPE_TMP, SCHEDULE_TIMERS * sizeof(*alarms));
 
 	for (i = 0; i < SCHEDULE_TIMERS; i++) {
 		long interval_msec;
@@ -127,47 +167,89 @@ int main(int argc, char **argv)
 		assert(ret > 0);
 		assert((size_t)ret < TIMESTR_LEN + 1);
 		timers_pending++;
+
+		alarms[i].index = i;
+		alarms[i].sands = timers[i]->u.sands;
+		alarms[i].due = timers[i]->u.sands;
+		/* timers of a second or more go on the wheel */
+		assert(!timers[i]->wheel_slot ==
+		       !(wheel && interval_msec >= 1000));
+		if (timers[i]->wheel_slot) {
+			usec = alarms[i].sands.tv_sec * 1000000ULL +
+			       alarms[i].sands.tv_usec;
+			usec = (usec + WHEEL_TICK_USEC - 1) / WHEEL_TICK_USEC *
+			       WHEEL_TICK_USEC;
+			alarms[i].due.tv_sec = usec / 1000000;
+			alarms[i].due.tv_usec = usec % 1000000;
+		}
 	}
 
-	for (i = 0; i < REMOVE_TIMERS; i++) {
-		int index;
+	for (i = 0; i < (int)array_size(far_secs); i++)
+		event_add_timer(master, far_func, NULL, far_secs[i],
+				&far_timers[i]);
 
-		index = prng_rand(prng) % SCHEDULE_TIMERS;
-		if (!timers[index])
-			continue;
+	for (i = 0; i < REMOVE_TIMERS; i++)
+		cancel_random();
 
-		XFREE(MTYPE_TMP, timers[index]->arg);
-		event_cancel(&timers[index]);
-		timers_pending--;
+	while (timers_pending && event_fetch(master, &t))
+		event_call(&t);
+
+	/* The far out timers are still there, and still as far out */
+	for (i = 0; i < (int)array_size(far_secs); i++) {
+		unsigned long remain;
+
+		assert(far_timers[i]);
+		remain = event_timer_remain_second(far_timers[i]);
+		assert(remain <= (unsigned long)far_secs[i]);
+		assert(remain + 10 >= (unsigned long)far_secs[i]);
+		event_cancel(&far_timers[i]);
 	}
 
-	/* We create an array of pointers to the alarm times and sort
-	 * that array. That sorted array is used to generate a string
-	 * representing the expected "output" of the timers when they
-	 * are run. */
+	/* We create an array of pointers to the alarms that were not
+	 * cancelled and sort that array. That sorted array is used to
+	 * generate a string representing the expected "output" of the
+	 * timers when they are run. */
 	j = 0;
-	alarms = XCALLOC(MTYPE_TMP, timers_pending * sizeof(*alarms));
+	sorted = XCALLOC(MTYPE_TMP, SCHEDULE_TIMERS * sizeof(*sorted));
 	for (i = 0; i < SCHEDULE_TIMERS; i++) {
-		if (!timers[i])
+		if (alarms[i].cancelled)
 			continue;
-		alarms[j++] = &timers[i]->u.sands;
+		sorted[j++] = &alarms[i];
 	}
-	qsort(alarms, j, sizeof(*alarms), cmp_timeval);
+	qsort(sorted, j, sizeof(*sorted), cmp_alarm);
 	for (i = 0; i < j; i++) {
 		int ret;
 
 		ret = snprintf(expected_buf + expected_buf_pos,
 			       expected_buf_len - expected_buf_pos,
-			       "%lld.%06lld\n", (long long)alarms[i]->tv_sec,
-			       (long long)alarms[i]->tv_usec);
+			       "%lld.%06lld\n",
+			       (long long)sorted[i]->sands.tv_sec,
+			       (long long)sorted[i]->sands.tv_usec);
 		assert(ret > 0);
 		expected_buf_pos += ret;
 		assert(expected_buf_pos < expected_buf_len);
 	}
+	XFREE(MTYPE_TMP, sorted);
+
+	check_output(name);
+
+	event_master_free(master);
+	XFREE(MTYPE_TMP, log_buf);
+	XFREE(MTYPE_TMP, expected_buf);
+	prng_free(prng);
+	XFREE(MTYPE_TMP, timers);
 	XFREE(MTYPE_TMP, alarms);
+}
 
-	while (event_fetch(master, &t))
-		event_call(&t);
+int main(int argc, char **argv)
+{
+	run("poll", EVENT_IO_POLL, false);
+	run("epoll", EVENT_IO_EPOLL, false);
+	/*
+	 * 5 seconds turn level 0 of the wheel over several times and
+	 * cascade timers down from level 1.
+	 */
+	run("wheel", EVENT_IO_POLL, true);
 
 	return 0;
 }
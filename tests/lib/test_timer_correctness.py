@@ -5,4 +5,6 @@ class TestTimerCorrectness(frrtest.TestMultiOut):
     program = "./test_timer_correctness"
 
 
-TestTimerCorrectness.onesimple("Expected output and actual output match.")
+TestTimerCorrectness.onesimple("poll: Expected output and actual output match.")
+TestTimerCorrectness.onesimple("epoll: Expected output and actual output match.")
+TestTimerCorrectness.onesimple("wheel: Expected output and actual output match.")
@@ -1,7 +1,8 @@
 // SPDX-License-Identifier: GPL-2.0-or-later
 /*
  * Test program which measures the time it takes to schedule and
- * remove timers.
+ * remove timers, and to rearm many per-session timers on the timer
+ * heap versus the timer wheel.
  *
  * Copyright (C) 2013 by Open Source Routing.
  * Copyright (C) 2013 by Internet Systems Consortium, Inc. ("ISC")
@@ -19,6 +20,8 @@
 
 #define SCHEDULE_TIMERS 1000000
 #define REMOVE_TIMERS    500000
+#define REARM_TIMERS     100000
+#define REARM_ROUNDS     10
 
 struct event_loop *master;
 
@@ -26,6 +29,49 @@ static void dummy_func(struct event *thread)
 {
 }
 
+/*
+ * Keepalive/holdtime style churn: every timer is cancelled and started
+ * again, over and over, without ever expiring.
+ */
+static void rearm(struct prng *prng, bool wheel)
+{
+	struct event **timers;
+	struct timeval tv_start, tv_stop;
+	unsigned long t_rearm;
+	int i, r;
+
+	event_master_set_timer_wheel(master, wheel);
+	timers = calloc(REARM_TIMERS, sizeof(*timers));
+
+	for (i = 0; i < REARM_TIMERS; i++)
+		event_add_timer(master, dummy_func, NULL,
+				1 + prng_rand(prng) % 180, &timers[i]);
+
+	monotime(&tv_start);
+
+	for (r = 0; r < REARM_ROUNDS; r++)
+		for (i = 0; i < REARM_TIMERS; i++) {
+			event_cancel(&timers[i]);
+			event_add_timer(master, dummy_func, NULL,
+					1 + prng_rand(prng) % 180, &timers[i]);
+		}
+
+	monotime(&tv_stop);
+
+	t_rearm = 1000 * (tv_stop.tv_sec - tv_start.tv_sec);
+	t_rearm += (tv_stop.tv_usec - tv_start.tv_usec) / 1000;
+
+	printf("Rearming %d timers %d times on the %s took %lu.%03lu seconds.\n",
+	       REARM_TIMERS, REARM_ROUNDS, wheel ? "wheel" : "heap",
+	       t_rearm / 1000, t_rearm % 1000);
+	fflush(stdout);
+
+	for (i = 0; i < REARM_TIMERS; i++)
+		event_cancel(&timers[i]);
+	event_master_set_timer_wheel(master, false);
+	free(timers);
+}
+
 int main(int argc, char **argv)
 {
 	struct prng *prng;
@@ -79,6 +125,12 @@ int main(int argc, char **argv)
 	       REMOVE_TIMERS, t_remove / 1000, t_remove % 1000);
 	fflush(stdout);
 
+	for (i = 0; i < SCHEDULE_TIMERS; i++)
+		event_cancel(&timers[i]);
+
+	rearm(prng, false);
+	rearm(prng, true);
+
 	free(timers);
 	event_master_free(master);
 	prng_free(prng);
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Trace ring tests: records from several pthreads, dumps them and reads
+ * the dump back.
+ */
+
+#include <zebra.h>
+
+#include <fcntl.h>
+#include <pthread.h>
+
+#include "prefix.h"
+#include "tracering.h"
+
+#define THREADS 3
+#define RECORDS 100
+#define RINGSIZE 64
+
+static pthread_barrier_t recorded, dumped;
+
+static void *record_func(void *arg)
+{
+	uintptr_t thread = (uintptr_t)arg;
+	struct prefix p = { .family = AF_INET, .prefixlen = 24 };
+	struct in_addr id = { .s_addr = htonl(0xc0000200 + thread) };
+	int i;
+
+	inet_pton(AF_INET, "198.51.100.0", &p.u.prefix4);
+
+	for (i = 0; i < RECORDS; i++)
+		tracering("test record", i, (unsigned int)thread, &p, id);
+
+	pthread_barrier_wait(&recorded);
+	pthread_barrier_wait(&dumped);
+	return NULL;
+}
+
+/* Runs after the trace ring's own key destructor, which was set up first */
+static pthread_key_t late_key;
+
+static void late_dtor(void *arg)
+{
+	struct tracering_stats before, after;
+
+	tracering_get_stats(&before);
+	tracering("test late", 1);
+	tracering_get_stats(&after);
+
+	/* no new ring that nothing would free */
+	assert(after.rings <= before.rings);
+}
+
+static void *late_func(void *arg)
+{
+	tracering("test late", 0);
+	pthread_setspecific(late_key, arg);
+	return NULL;
+}
+
+static void check_ring(const struct tracering_file_ring *fr,
+		       const struct tracering_rec *recs, uint64_t xref)
+{
+	const struct tracering_rec *rec;
+	uint64_t ts = 0;
+	int32_t i;
+	uint32_t thread, n;
+	struct in_addr id;
+
+	assert(fr->pos == RECORDS);
+	assert(fr->records == RINGSIZE);
+
+	/* the oldest records got overwritten */
+	for (n = 0; n < RINGSIZE; n++) {
+		rec = &recs[(fr->pos + n) % RINGSIZE];
+
+		assert(rec->xref == xref);
+		assert(rec->ts >= ts);
+		ts = rec->ts;
+
+		memcpy(&i, rec->data, sizeof(i));
+		assert(i == (int32_t)(RECORDS - RINGSIZE + n));
+		memcpy(&thread, rec->data + 4, sizeof(thread));
+		assert(thread < THREADS);
+
+		/* AF_INET, /24, 198.51.100.0 */
+		assert(rec->data[8] == AF_INET);
+		assert(rec->data[9] == 24);
+		assert(rec->data[10] == 198 && rec->data[11] == 51 &&
+		       rec->data[12] == 100 && rec->data[13] == 0);
+
+		memcpy(&id, rec->data + 8 + TRACERING_PREFIX_SIZE, sizeof(id));
+		assert(ntohl(id.s_addr) == 0xc0000200 + thread);
+	}
+}
+
+static void check_dump(const uint8_t *buf, size_t len)
+{
+	const struct tracering_file_hdr *hdr = (const void *)buf;
+	const struct tracering_section *sec;
+	const struct tracering_file_xref *fx;
+	const struct tracering_file_ring *fr;
+	uint64_t xref = 0;
+	size_t pos = sizeof(*hdr);
+	unsigned int rings = 0;
+
+	assert(len >= sizeof(*hdr));
+	assert(!memcmp(hdr->magic, TRACERING_MAGIC, sizeof(hdr->magic)));
+	assert(hdr->byteorder == 0x01020304);
+	assert(hdr->rec_size == sizeof(struct tracering_rec));
+	assert(hdr->pid == getpid());
+
+	while (true) {
+		assert(pos + sizeof(*sec) <= len);
+		sec = (const void *)(buf + pos);
+		pos += sizeof(*sec);
+		assert(pos + sec->len <= len);
+
+		switch (sec->type) {
+		case TRACERING_SEC_END:
+			assert(pos == len);
+			assert(xref);
+			assert(rings == THREADS);
+			return;
+
+		case TRACERING_SEC_XREF:
+			fx = (const void *)(buf + pos);
+			if (!strcmp((const char *)(fx + 1), "test record")) {
+				assert(!strcmp(fx->types, "iup4"));
+				xref = fx->xref;
+			}
+			break;
+
+		case TRACERING_SEC_RING:
+			/* xrefs come first */
+			assert(xref);
+			fr = (const void *)(buf + pos);
+			assert(sec->len == sizeof(*fr) + fr->records *
+						sizeof(struct tracering_rec));
+			check_ring(fr, (const void *)(fr + 1), xref);
+			rings++;
+			break;
+
+		default:
+			assert(!"unknown section");
+		}
+		pos += sec->len;
+	}
+}
+
+XREF_SETUP();
+
+int main(int argc, char **argv)
+{
+	pthread_t threads[THREADS];
+	struct tracering_stats stats;
+	char path[] = "/tmp/test_tracering.XXXXXX";
+	struct stat st;
+	uint8_t *buf;
+	uintptr_t i;
+	int fd;
+
+	tracering_set(50);
+	assert(tracering_get() == RINGSIZE);
+
+	pthread_barrier_init(&recorded, NULL, THREADS + 1);
+	pthread_barrier_init(&dumped, NULL, THREADS + 1);
+
+	for (i = 0; i < THREADS; i++)
+		assert(!pthread_create(&threads[i], NULL, record_func,
+				       (void *)i));
+	pthread_barrier_wait(&recorded);
+
+	tracering_get_stats(&stats);
+	assert(stats.rings == THREADS);
+	assert(stats.recorded == THREADS * RECORDS);
+	assert(stats.tracepoints >= 1);
+
+	fd = mkstemp(path);
+	assert(fd >= 0);
+	unlink(path);
+	assert(!tracering_dump(fd));
+
+	assert(!fstat(fd, &st));
+	buf = malloc(st.st_size);
+	assert(pread(fd, buf, st.st_size, 0) == st.st_size);
+	check_dump(buf, st.st_size);
+	free(buf);
+	close(fd);
+
+	pthread_barrier_wait(&dumped);
+	for (i = 0; i < THREADS; i++)
+		pthread_join(threads[i], NULL);
+
+	/* rings go away with their pthread, the counts stay */
+	tracering_get_stats(&stats);
+	assert(stats.rings == 0);
+	assert(stats.recorded == THREADS * RECORDS);
+
+	tracering_set(0);
+	tracering("test disabled", 1);
+	tracering_get_stats(&stats);
+	assert(stats.rings == 0);
+	assert(stats.recorded == THREADS * RECORDS);
+
+	tracering_set(TRACERING_RECORDS_DEFAULT);
+	tracering("test enabled", 1);
+	tracering_get_stats(&stats);
+	assert(stats.rings == 1);
+	assert(stats.recorded == THREADS * RECORDS + 1);
+
+#ifndef __OpenBSD__
+	/* OpenBSD can't tell that a pthread is exiting */
+	pthread_key_create(&late_key, late_dtor);
+	assert(!pthread_create(&threads[0], NULL, late_func, &late_key));
+	pthread_join(threads[0], NULL);
+	tracering_get_stats(&stats);
+	assert(stats.rings == 1);
+	pthread_key_delete(late_key);
+#endif
+
+	tracering_fini();
+	return 0;
+}
@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestTracering(frrtest.TestMultiOut):
+    program = "./test_tracering"
+
+
+TestTracering.exit_cleanly()
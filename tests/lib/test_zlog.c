@@ -6,8 +6,12 @@
  */
 #include <zebra.h>
 #include <memory.h>
+#include <pthread.h>
+#include "frratomic.h"
+#include "frrcu.h"
 #include "log.h"
 #include "network.h"
+#include "zlog.h"
 
 /* maximum amount of data to hexdump */
 #define MAXDATA 16384
@@ -34,16 +38,247 @@ static bool test_zlog_hexdump(void)
 	return true;
 }
 
-bool (*tests[])(void) = {
-	test_zlog_hexdump,
+/*
+ * Asynchronous output.  Messages are captured by a log target, which the
+ * tests can stall with capture_stall, so that the rings fill up.
+ */
+#define ASYNC_MSGS 2000
+#define ASYNC_PTHREADS 2
+/* over a quarter of a 4k ring, which is never queued */
+#define BIG_LEN 2000
+
+static pthread_mutex_t capture_mtx = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool capture_stall, capture_called;
+/* protected by capture_mtx */
+static unsigned int capture_seq[ASYNC_PTHREADS][ASYNC_MSGS];
+static size_t capture_count[ASYNC_PTHREADS];
+static size_t capture_big, capture_dropped;
+static bool capture_misordered;
+
+static void capture_logfn(struct zlog_target *zt, struct zlog_msg *msgs[],
+			  size_t nmsgs)
+{
+	unsigned int src, seq;
+	const char *text, *pos;
+	size_t i, len, n;
+	char c;
+
+	atomic_store_explicit(&capture_called, true, memory_order_relaxed);
+	while (atomic_load_explicit(&capture_stall, memory_order_relaxed))
+		usleep(1000);
+
+	pthread_mutex_lock(&capture_mtx);
+	for (i = 0; i < nmsgs; i++) {
+		text = zlog_msg_text(msgs[i], &len);
+
+		if (sscanf(text, "%zu log messages droppe%c", &n, &c) == 2)
+			capture_dropped += n;
+		else if (strstr(text, "big "))
+			capture_big++;
+		else if ((pos = strstr(text, "seq ")) &&
+			 sscanf(pos, "seq %u %u", &src, &seq) == 2 &&
+			 src < ASYNC_PTHREADS && capture_count[src] < ASYNC_MSGS) {
+			n = capture_count[src]++;
+			if (n && capture_seq[src][n - 1] >= seq)
+				capture_misordered = true;
+			capture_seq[src][n] = seq;
+		}
+	}
+	pthread_mutex_unlock(&capture_mtx);
+}
+
+static void capture_reset(void)
+{
+	pthread_mutex_lock(&capture_mtx);
+	memset(capture_count, 0, sizeof(capture_count));
+	capture_big = capture_dropped = 0;
+	capture_misordered = false;
+	pthread_mutex_unlock(&capture_mtx);
+}
+
+static size_t captured(void)
+{
+	size_t n;
+
+	pthread_mutex_lock(&capture_mtx);
+	n = capture_big + capture_dropped;
+	for (unsigned int i = 0; i < ASYNC_PTHREADS; i++)
+		n += capture_count[i];
+	pthread_mutex_unlock(&capture_mtx);
+	return n;
+}
+
+/* every message is either written or counted as dropped, eventually */
+static bool wait_captured(size_t total)
+{
+	for (unsigned int i = 0; i < 5000; i++) {
+		if (captured() >= total)
+			return captured() == total;
+		usleep(1000);
+	}
+	return false;
+}
+
+static size_t async_dropped(void)
+{
+	struct zlog_async_stats stats;
+
+	zlog_async_get_stats(&stats);
+	return stats.dropped;
+}
+
+static void log_big(void)
+{
+	char big[BIG_LEN + 1];
+
+	memset(big, 'x', BIG_LEN);
+	big[BIG_LEN] = '\0';
+	zlog_info("big %s", big);
+}
+
+static void log_seq(unsigned int src)
+{
+	for (unsigned int seq = 0; seq < ASYNC_MSGS; seq++)
+		zlog_info("seq %u %u", src, seq);
+}
+
+static void *log_seq_func(void *arg)
+{
+	rcu_thread_start(arg);
+	rcu_read_unlock();
+
+	log_seq(1);
+	return NULL;
+}
+
+/* Each pthread's messages come out in order, none get lost uncounted */
+static bool test_zlog_async_order(void)
+{
+	pthread_t thread;
+	size_t dropped;
+
+	capture_reset();
+	dropped = async_dropped();
+
+	assert(!pthread_create(&thread, NULL, log_seq_func,
+			       rcu_thread_prepare()));
+	log_seq(0);
+	pthread_join(thread, NULL);
+
+	if (!wait_captured(ASYNC_PTHREADS * ASYNC_MSGS))
+		return false;
+	return !capture_misordered &&
+	       async_dropped() - dropped == capture_dropped;
+}
+
+/* A stalled logging pthread makes the ring fill up and drop the rest */
+static bool test_zlog_async_drops(void)
+{
+	size_t dropped, n;
+
+	zlog_set_async(true, 4096);
+	capture_reset();
+	dropped = async_dropped();
+
+	/* the ring is resized on the first message, under zlog_async_mtx,
+	 * which the logging pthread holds while stalled below
+	 */
+	zlog_info("seq 0 0");
+	if (!wait_captured(1))
+		return false;
+
+	atomic_store_explicit(&capture_stall, true, memory_order_relaxed);
+	atomic_store_explicit(&capture_called, false, memory_order_relaxed);
+	zlog_info("seq 0 1");
+	while (!atomic_load_explicit(&capture_called, memory_order_relaxed))
+		usleep(1000);
+
+	for (unsigned int seq = 2; seq < ASYNC_MSGS; seq++)
+		zlog_info("seq 0 %u", seq);
+	log_big();
+	atomic_store_explicit(&capture_stall, false, memory_order_relaxed);
+
+	if (!wait_captured(ASYNC_MSGS + 1))
+		return false;
+
+	/* what fit is written in order, without gaps */
+	n = capture_count[0];
+	if (n < 3 || n >= ASYNC_MSGS || capture_big)
+		return false;
+	for (unsigned int i = 0; i < n; i++)
+		if (capture_seq[0][i] != i)
+			return false;
+	if (capture_dropped != ASYNC_MSGS + 1 - n ||
+	    async_dropped() - dropped != capture_dropped)
+		return false;
+
+	/* too big even for an empty ring */
+	capture_reset();
+	log_big();
+	return wait_captured(1) && capture_dropped == 1;
+}
+
+/* A new buffer size applies to the next message, keeping the order */
+static bool test_zlog_async_resize(void)
+{
+	struct zlog_async_stats stats;
+	unsigned int seq;
+
+	zlog_set_async(true, 4096);
+	capture_reset();
+
+	for (seq = 0; seq < 20; seq++)
+		zlog_info("seq 0 %u", seq);
+	log_big();
+	zlog_set_async(true, 16384);
+	for (; seq < 40; seq++)
+		zlog_info("seq 0 %u", seq);
+	log_big();
+
+	/* only the first big one is dropped */
+	if (!wait_captured(42))
+		return false;
+	if (capture_big != 1 || capture_dropped != 1 || capture_misordered)
+		return false;
+
+	/* the old ring is gone once empty */
+	zlog_async_get_stats(&stats);
+	return stats.n_rings == 1;
+}
+
+static struct {
+	const char *name;
+	bool (*func)(void);
+} tests[] = {
+	{ "hexdump", test_zlog_hexdump },
+	{ "async order", test_zlog_async_order },
+	{ "async drops", test_zlog_async_drops },
+	{ "async resize", test_zlog_async_resize },
 };
 
 int main(int argc, char **argv)
 {
+	struct zlog_target *zt;
+	bool ok, all_ok = true;
+
 	zlog_aux_init("NONE: ", ZLOG_DISABLED);
 
-	for (unsigned int i = 0; i < array_size(tests); i++)
-		if (!tests[i]())
-			return 1;
-	return 0;
+	zt = zlog_target_clone(MTYPE_TMP, NULL, sizeof(*zt));
+	zt->prio_min = LOG_DEBUG;
+	zt->logfn = capture_logfn;
+	zlog_target_replace(NULL, zt);
+
+	for (unsigned int i = 0; i < array_size(tests); i++) {
+		/* the first test runs without async output */
+		if (i == 1)
+			zlog_set_async(true, 65536);
+
+		ok = tests[i].func();
+		printf("%s: %s\n", tests[i].name, ok ? "OK" : "failed");
+		all_ok = all_ok && ok;
+	}
+
+	zlog_set_async(false, 0);
+	zlog_target_free(MTYPE_TMP, zlog_target_replace(zt, NULL));
+	return all_ok ? 0 : 1;
 }
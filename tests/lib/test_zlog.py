@@ -3,3 +3,9 @@ import frrtest
 
 class TestZlog(frrtest.TestMultiOut):
     program = "./test_zlog"
+
+
+TestZlog.okfail("hexdump:")
+TestZlog.okfail("async order:")
+TestZlog.okfail("async drops:")
+TestZlog.okfail("async resize:")
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures how many debug messages per second pthreads
+ * can log to a file, writing directly, with per-thread buffering, and with
+ * asynchronous output.
+ */
+
+#include <zebra.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "frrcu.h"
+#include "monotime.h"
+#include "zlog.h"
+#include "zlog_targets.h"
+
+#define MESSAGES 200000
+/* with pauses in between, as debug logging usually comes in bursts */
+#define BURST	 200
+#define PAUSE_NS 2000000
+
+enum mode {
+	MODE_DIRECT,
+	MODE_BUFFERED,
+	MODE_ASYNC,
+	MODE_ASYNC_1M,
+};
+
+static const char *const mode_names[] = {
+	[MODE_DIRECT] = "direct",
+	[MODE_BUFFERED] = "buffered",
+	[MODE_ASYNC] = "async",
+	[MODE_ASYNC_1M] = "async 1M",
+};
+
+struct log_thread {
+	pthread_t pthread;
+	struct rcu_thread *rcu_thread;
+	enum mode mode;
+	bool bursts;
+	unsigned int messages;
+
+	/* CPU time spent by the pthread itself */
+	unsigned long cpu_us;
+};
+
+static void *log_func(void *arg)
+{
+	struct log_thread *lt = arg;
+	struct timespec cpu;
+	unsigned int i;
+
+	rcu_thread_start(lt->rcu_thread);
+	rcu_read_unlock();
+
+	if (lt->mode == MODE_BUFFERED)
+		zlog_tls_buffer_init();
+
+	for (i = 0; i < lt->messages; i++) {
+		if (lt->bursts && i && i % BURST == 0)
+			nanosleep(&(struct timespec){ .tv_nsec = PAUSE_NS },
+				  NULL);
+
+		zlog_debug("%s: rcvd UPDATE w/ attr: nexthop 192.0.2.%u, origin %c, metric %u, path %u %u",
+			   "peer 198.51.100.1", i & 0xff, 'i', i, 64500 + i % 7,
+			   64510 + i % 13);
+	}
+
+	if (lt->mode == MODE_BUFFERED)
+		zlog_tls_buffer_fini();
+
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+	lt->cpu_us = cpu.tv_sec * 1000000 + cpu.tv_nsec / 1000;
+	return NULL;
+}
+
+static size_t dropped;
+
+static unsigned long elapsed_us(struct timeval *start)
+{
+	struct timeval stop;
+
+	monotime(&stop);
+	return 1000000 * (stop.tv_sec - start->tv_sec) +
+	       (stop.tv_usec - start->tv_usec);
+}
+
+static void run(enum mode mode, unsigned int nthreads, bool bursts)
+{
+	struct log_thread threads[nthreads];
+	struct zlog_async_stats stats;
+	struct timeval tv_start;
+	unsigned long t_run, t_flush, t_cpu = 0, ops;
+	unsigned int i;
+
+	if (mode == MODE_ASYNC)
+		zlog_set_async(true, ZLOG_ASYNC_BUFSIZE_DEFAULT);
+	else if (mode == MODE_ASYNC_1M)
+		zlog_set_async(true, 1 << 20);
+
+	monotime(&tv_start);
+	for (i = 0; i < nthreads; i++) {
+		threads[i].mode = mode;
+		threads[i].bursts = bursts;
+		threads[i].messages = bursts ? MESSAGES / 10 : MESSAGES;
+		threads[i].rcu_thread = rcu_thread_prepare();
+		assert(!pthread_create(&threads[i].pthread, NULL, log_func,
+				       &threads[i]));
+	}
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(threads[i].pthread, NULL);
+		t_cpu += threads[i].cpu_us;
+	}
+	t_run = elapsed_us(&tv_start);
+
+	/* drop counts are cumulative */
+	zlog_async_get_stats(&stats);
+	if (mode >= MODE_ASYNC)
+		zlog_set_async(false, 0);
+	t_flush = elapsed_us(&tv_start);
+
+	ops = (unsigned long)nthreads * threads[0].messages;
+	printf("%u threads, %-8s%s: %lu messages took %lu.%03lu seconds (%lu.%03lu until written), %lu/s, %lu ns CPU each in the logging threads, %zu dropped\n",
+	       nthreads, mode_names[mode], bursts ? ", bursts" : "", ops, t_run / 1000000,
+	       (t_run % 1000000) / 1000, t_flush / 1000000,
+	       (t_flush % 1000000) / 1000, ops * 1000000 / MAX(t_run, 1UL),
+	       t_cpu * 1000 / ops, stats.dropped - dropped);
+	fflush(stdout);
+
+	dropped = stats.dropped;
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int nthreads[] = { 1, 4 };
+	struct zlog_cfg_file zcf;
+	char path[] = "/tmp/test_zlog_performance.XXXXXX";
+	int fd;
+
+	/* no stderr output, in particular for dropped messages */
+	zlog_aux_init("NONE: ", ZLOG_DISABLED);
+	zlog_startup_end();
+
+	fd = mkstemp(path);
+	assert(fd >= 0);
+	unlink(path);
+
+	/* per-thread buffers are mmap'd files in this directory */
+	zlog_tmpdirfd = open("/tmp", O_RDONLY | O_DIRECTORY);
+
+	zlog_file_init(&zcf);
+	zcf.prio_min = LOG_DEBUG;
+	zlog_file_set_fd(&zcf, fd);
+
+	for (int bursts = 0; bursts <= 1; bursts++)
+		for (size_t i = 0; i < array_size(nthreads); i++)
+			for (enum mode mode = MODE_DIRECT;
+			     mode <= MODE_ASYNC_1M; mode++)
+				run(mode, nthreads[i], bursts);
+
+	zlog_file_fini(&zcf);
+	close(zlog_tmpdirfd);
+	close(fd);
+	return 0;
+}
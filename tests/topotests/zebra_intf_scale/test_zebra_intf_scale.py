@@ -0,0 +1,143 @@
+#!/usr/bin/env python
+# SPDX-License-Identifier: ISC
+
+#
+# test_zebra_intf_scale.py
+#
+
+"""
+test_zebra_intf_scale.py: Measure how long zebra takes to learn about a large
+number of interfaces at startup and to process bulk link flaps.
+
+Thousands of dummy interfaces, each with an address, are created in the
+namespace of r1 before zebra starts.  The timings are logged.
+"""
+
+import os
+import sys
+import time
+from functools import partial
+
+import pytest
+from lib import topotest
+from lib.topogen import Topogen, TopoRouter
+from lib.topolog import logger
+
+INTERFACES = 4000
+
+
+def ip_batch(router, logdir, name, cmds):
+    "Run a list of ip commands in one go"
+
+    path = os.path.join(logdir, name)
+    with open(path, "w") as f:
+        f.write("\n".join(cmds) + "\n")
+    router.cmd_raises("ip -batch {}".format(path))
+
+
+@pytest.fixture(scope="module")
+def tgen(request):
+    "Sets up the pytest environment"
+
+    topodef = {"s1": ("r1")}
+    tgen = Topogen(topodef, request.module.__name__)
+    tgen.start_topology()
+
+    r1 = tgen.gears["r1"]
+    cmds = []
+    for i in range(INTERFACES):
+        cmds.append("link add dummy{} type dummy".format(i))
+        cmds.append(
+            "address add 10.{}.{}.1/24 dev dummy{}".format(i // 256, i % 256, i)
+        )
+        cmds.append("link set dummy{} up".format(i))
+    ip_batch(r1, tgen.logdir, "r1-links.batch", cmds)
+
+    router_list = tgen.routers()
+    for rname, router in router_list.items():
+        router.load_config(TopoRouter.RD_ZEBRA, "zebra.conf")
+
+    tgen.start_time = time.time()
+    tgen.start_router()
+    yield tgen
+    tgen.stop_topology()
+
+
+@pytest.fixture(autouse=True)
+def skip_on_failure(tgen):
+    if tgen.routers_have_failure():
+        pytest.skip("skipped because of previous test failure")
+
+
+def interfaces_in_state(router, status):
+    "Return None once all dummy interfaces are known in the given state"
+
+    output = router.vtysh_cmd("show interface brief json", isjson=True)
+    missing = 0
+    for i in range(INTERFACES):
+        intf = output.get("dummy{}".format(i))
+        if not intf or intf.get("status") != status:
+            missing += 1
+
+    if missing:
+        return "{} interfaces not {}".format(missing, status)
+    return None
+
+
+def wait_for_interfaces(router, status):
+    test_func = partial(interfaces_in_state, router, status)
+    success, result = topotest.run_and_expect(test_func, None, 300, 1)
+    assert success, result
+
+
+def test_zebra_intf_startup(tgen):
+    "Time until zebra knows about all interfaces"
+
+    r1 = tgen.gears["r1"]
+    wait_for_interfaces(r1, "up")
+
+    logger.info(
+        "{} interfaces learnt in {:.3f} seconds after start".format(
+            INTERFACES, time.time() - tgen.start_time
+        )
+    )
+
+    entry = {
+        "dummy{}".format(INTERFACES - 1): {
+            "addresses": [
+                "10.{}.{}.1/24".format(
+                    (INTERFACES - 1) // 256, (INTERFACES - 1) % 256
+                )
+            ]
+        }
+    }
+    ok = topotest.router_json_cmp_retry(r1, "show int brief json", entry, False, 30)
+    assert ok, '"r1" addresses not learnt'
+
+
+def test_zebra_intf_flap(tgen):
+    "Time bulk link down and up events"
+
+    r1 = tgen.gears["r1"]
+
+    for state, status in (("down", "down"), ("up", "up")):
+        cmds = [
+            "link set dummy{} {}".format(i, state) for i in range(INTERFACES)
+        ]
+        start = time.time()
+        ip_batch(r1, tgen.logdir, "r1-flap-{}.batch".format(state), cmds)
+        wait_for_interfaces(r1, status)
+
+        logger.info(
+            "{} interfaces {} in {:.3f} seconds".format(
+                INTERFACES, state, time.time() - start
+            )
+        )
+
+    output = r1.vtysh_cmd("show zebra dplane", isjson=False)
+    logger.info(output)
+
+
+if __name__ == "__main__":
+    args = ["-s"] + sys.argv[1:]
+    sys.exit(pytest.main(args))
@@ -0,0 +1,124 @@
+#!/usr/bin/env python
+# SPDX-License-Identifier: ISC
+
+"""
+Test in-place replaces of zebra's nexthop groups ("zebra nexthop
+replace-in-place") with routes that share a group but resolve it
+differently: 192.168.0.0/16 and 172.16.0.0/16 both use 10.0.1.2 and
+192.168.1.1.  While 192.168.1.0/24 is there, 192.168.1.1 resolves through
+it for both.  Once it is gone, 192.168.1.1 resolves via 192.168.0.0/16
+itself, which isn't allowed for that route but is for 172.16.0.0/16.  The
+group must not be replaced in place for either route then, or they'd keep
+replacing it for each other.
+"""
+
+import os
+import sys
+import json
+import pytest
+import functools
+
+CWD = os.path.dirname(os.path.realpath(__file__))
+sys.path.append(os.path.join(CWD, "../"))
+
+# pylint: disable=C0413
+from lib import topotest
+from lib.topogen import Topogen, get_topogen
+from lib.common_config import step
+
+pytestmark = [pytest.mark.staticd]
+
+
+def setup_module(mod):
+    topodef = {"s1": ("r1",), "s2": ("r1",)}
+    tgen = Topogen(topodef, mod.__name__)
+    tgen.start_topology()
+
+    for rname, router in tgen.routers().items():
+        router.load_frr_config(os.path.join(CWD, "{}/frr.conf".format(rname)))
+
+    tgen.start_router()
+
+
+def teardown_module(mod):
+    tgen = get_topogen()
+    tgen.stop_topology()
+
+
+def _route(router, prefix):
+    output = json.loads(router.vtysh_cmd("show ip route {} json".format(prefix)))
+    return output.get(prefix, [{}])[0]
+
+
+def _active(route):
+    "Active nexthops of the route itself, without what they resolve to"
+    return sorted(
+        nh.get("ip")
+        for nh in route.get("nexthops", [])
+        if nh.get("active") and not nh.get("resolver")
+    )
+
+
+def _in_place_replaces(router):
+    output = json.loads(router.vtysh_cmd("show nexthop-group rib summary json"))
+    return output["inPlaceReplaces"]
+
+
+def test_zebra_nhg_replace_self_resolving():
+    tgen = get_topogen()
+
+    if tgen.routers_have_failure():
+        pytest.skip(tgen.errors)
+
+    r1 = tgen.gears["r1"]
+
+    step("Both routes share one group while 192.168.1.1 resolves elsewhere")
+
+    def _shared():
+        a = _route(r1, "192.168.0.0/16")
+        b = _route(r1, "172.16.0.0/16")
+        if not a.get("installed") or not b.get("installed"):
+            return "routes not installed"
+        if _active(a) != ["10.0.1.2", "192.168.1.1"]:
+            return "192.168.0.0/16 nexthops: {}".format(_active(a))
+        if a.get("nexthopGroupId") != b.get("nexthopGroupId"):
+            return "routes don't share a group"
+        return None
+
+    _, result = topotest.run_and_expect(_shared, None, count=30, wait=1)
+    assert result is None, result
+
+    replaces = _in_place_replaces(r1)
+
+    step("Remove 192.168.1.0/24, 192.168.1.1 now resolves via 192.168.0.0/16")
+    r1.vtysh_cmd(
+        """
+        configure terminal
+         no ip route 192.168.1.0/24 10.0.2.2
+        """
+    )
+
+    def _split():
+        a = _route(r1, "192.168.0.0/16")
+        b = _route(r1, "172.16.0.0/16")
+        if _active(a) != ["10.0.1.2"]:
+            return "192.168.0.0/16 nexthops: {}".format(_active(a))
+        if _active(b) != ["10.0.1.2", "192.168.1.1"]:
+            return "172.16.0.0/16 nexthops: {}".format(_active(b))
+        if a.get("nexthopGroupId") == b.get("nexthopGroupId"):
+            return "routes still share a group"
+        return None
+
+    _, result = topotest.run_and_expect(_split, None, count=30, wait=1)
+    assert result is None, result
+
+    step("Neither route replaced the group, nothing keeps churning")
+    assert _in_place_replaces(r1) == replaces
+    topotest.sleep(3, "waiting for any further replaces")
+    assert _in_place_replaces(r1) == replaces
+    assert _split() is None
+
+
+if __name__ == "__main__":
+    args = ["-s"] + sys.argv[1:]
+    sys.exit(pytest.main(args))
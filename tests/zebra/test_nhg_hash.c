@@ -0,0 +1,232 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program for the zebra nexthop group hash functions: checks that
+ * zebra_nhg_fingerprint() agrees with zebra_nhg_hash_equal(), then measures
+ * the cost of nexthop group hash lookups with and without a cached
+ * fingerprint.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+
+#include "hash.h"
+#include "nexthop.h"
+#include "nexthop_group.h"
+#include "vrf.h"
+#include "zebra/zebra_nhg.h"
+
+#define GROUPS 100000
+#define MAX_NEXTHOPS 8
+#define ROUNDS 5
+
+static void build_group(struct nhg_hash_entry *nhe, unsigned int idx,
+			bool miss)
+{
+	unsigned int i, count = idx % MAX_NEXTHOPS + 1;
+	struct nexthop *nh;
+
+	memset(nhe, 0, sizeof(*nhe));
+	nhe->type = ZEBRA_ROUTE_STATIC;
+	nhe->vrf_id = VRF_DEFAULT;
+	nhe->afi = AFI_IP;
+
+	for (i = 0; i < count; i++) {
+		struct in_addr gw;
+
+		/* Groups share their leading nexthops, like ECMP fabrics. */
+		gw.s_addr = htonl(0x0a000000 + (i << 16) + idx % 64);
+		if (i == count - 1)
+			gw.s_addr = htonl(0x0b000000 + idx +
+					  (miss ? GROUPS : 0));
+
+		nh = nexthop_from_ipv4_ifindex(&gw, NULL, 1 + i, VRF_DEFAULT);
+		SET_FLAG(nh->flags, NEXTHOP_FLAG_ACTIVE);
+		nexthop_group_add_sorted(&nhe->nhg, nh);
+	}
+}
+
+/*
+ * Entries that compare equal have to share their fingerprint, and entries
+ * differing in anything zebra_nhg_hash_equal() looks at should not.
+ */
+static void check_fingerprint(void)
+{
+	struct nhg_hash_entry a, b;
+	struct nhg_backup_info backup = {};
+	struct nhg_hash_entry backup_nhe;
+	uint64_t fp;
+
+	build_group(&a, 3, false);
+	build_group(&b, 3, false);
+	fp = zebra_nhg_fingerprint(&a);
+	assert(fp != 0);
+	assert(fp == zebra_nhg_fingerprint(&b));
+	assert(zebra_nhg_hash_key(&a) == (uint32_t)fp);
+	assert(zebra_nhg_hash_equal(&a, &b));
+
+	/* The cached fingerprint is what the hash key is taken from. */
+	a.fingerprint = fp;
+	b.fingerprint = fp;
+	assert(zebra_nhg_hash_key(&a) == (uint32_t)fp);
+	assert(zebra_nhg_hash_equal(&a, &b));
+
+	/* Per nexthop ACTIVE flags distinguish groups. */
+	UNSET_FLAG(b.nhg.nexthop->flags, NEXTHOP_FLAG_ACTIVE);
+	b.fingerprint = zebra_nhg_fingerprint(&b);
+	assert(b.fingerprint != fp);
+	assert(!zebra_nhg_hash_equal(&a, &b));
+	SET_FLAG(b.nhg.nexthop->flags, NEXTHOP_FLAG_ACTIVE);
+
+	/* So do the identity fields. */
+	b.afi = AFI_IP6;
+	b.fingerprint = zebra_nhg_fingerprint(&b);
+	assert(b.fingerprint != fp);
+	assert(!zebra_nhg_hash_equal(&a, &b));
+	b.afi = AFI_IP;
+
+	b.type = ZEBRA_ROUTE_BGP;
+	b.fingerprint = zebra_nhg_fingerprint(&b);
+	assert(b.fingerprint != fp);
+	assert(!zebra_nhg_hash_equal(&a, &b));
+	b.type = ZEBRA_ROUTE_STATIC;
+
+	b.nhg.nhgr.buckets = 32;
+	b.fingerprint = zebra_nhg_fingerprint(&b);
+	assert(b.fingerprint != fp);
+	assert(!zebra_nhg_hash_equal(&a, &b));
+	b.nhg.nhgr.buckets = 0;
+
+	/* And backup nexthops. */
+	build_group(&backup_nhe, 5, false);
+	backup.nhe = &backup_nhe;
+	b.backup_info = &backup;
+	b.fingerprint = zebra_nhg_fingerprint(&b);
+	assert(b.fingerprint != fp);
+	assert(!zebra_nhg_hash_equal(&a, &b));
+	b.backup_info = NULL;
+
+	/* Without a cached fingerprint the lists decide. */
+	b.fingerprint = 0;
+	assert(zebra_nhg_hash_equal(&a, &b));
+
+	nexthops_free(a.nhg.nexthop);
+	nexthops_free(b.nhg.nexthop);
+	nexthops_free(backup_nhe.nhg.nexthop);
+}
+
+static unsigned long elapsed_msec(struct timeval *start, struct timeval *stop)
+{
+	return 1000 * (stop->tv_sec - start->tv_sec) +
+	       (stop->tv_usec - start->tv_usec) / 1000;
+}
+
+/*
+ * Without a cached fingerprint zebra_nhg_hash_key() computes it on every
+ * call and zebra_nhg_hash_equal() walks the nexthop lists of every entry
+ * in the bucket, which is how the table behaved before fingerprints.
+ */
+static void run(const char *name, struct nhg_hash_entry *groups,
+		struct nhg_hash_entry *hits, struct nhg_hash_entry *misses,
+		bool fingerprint)
+{
+	struct hash *hash;
+	struct timeval tv_start, tv_stop;
+	unsigned long t_lookup, t_miss, t_release;
+	unsigned int i, r, found = 0, missed = 0, released = 0;
+
+	for (i = 0; i < GROUPS; i++)
+		groups[i].fingerprint =
+			fingerprint ? zebra_nhg_fingerprint(&groups[i]) : 0;
+
+	hash = hash_create_size(8, zebra_nhg_hash_key, zebra_nhg_hash_equal,
+				name);
+	for (i = 0; i < GROUPS; i++)
+		(void)hash_get(hash, &groups[i], hash_alloc_intern);
+	assert(hashcount(hash) == GROUPS);
+
+	/*
+	 * A lookup key is always built from scratch, so its fingerprint has
+	 * to be computed as part of the lookup, as zebra_nhe_find() does.
+	 */
+	monotime(&tv_start);
+	for (r = 0; r < ROUNDS; r++) {
+		for (i = 0; i < GROUPS; i++) {
+			if (fingerprint)
+				hits[i].fingerprint =
+					zebra_nhg_fingerprint(&hits[i]);
+			if (hash_lookup(hash, &hits[i]) == &groups[i])
+				found++;
+		}
+	}
+	monotime(&tv_stop);
+	t_lookup = elapsed_msec(&tv_start, &tv_stop);
+
+	monotime(&tv_start);
+	for (r = 0; r < ROUNDS; r++) {
+		for (i = 0; i < GROUPS; i++) {
+			if (fingerprint)
+				misses[i].fingerprint =
+					zebra_nhg_fingerprint(&misses[i]);
+			if (!hash_lookup(hash, &misses[i]))
+				missed++;
+		}
+	}
+	monotime(&tv_stop);
+	t_miss = elapsed_msec(&tv_start, &tv_stop);
+
+	assert(found == GROUPS * ROUNDS);
+	assert(missed == GROUPS * ROUNDS);
+
+	/* Releasing an entry hashes it again. */
+	monotime(&tv_start);
+	for (i = 0; i < GROUPS; i++)
+		if (hash_release(hash, &groups[i]) == &groups[i])
+			released++;
+	monotime(&tv_stop);
+	t_release = elapsed_msec(&tv_start, &tv_stop);
+
+	assert(released == GROUPS);
+	hash_free(hash);
+
+	printf("%s:\n", name);
+	printf("  %u hit lookups took %lu.%03lu seconds.\n", GROUPS * ROUNDS,
+	       t_lookup / 1000, t_lookup % 1000);
+	printf("  %u miss lookups took %lu.%03lu seconds.\n", GROUPS * ROUNDS,
+	       t_miss / 1000, t_miss % 1000);
+	printf("  %u releases took %lu.%03lu seconds.\n", GROUPS,
+	       t_release / 1000, t_release % 1000);
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	struct nhg_hash_entry *groups, *hits, *misses;
+	unsigned int i;
+
+	check_fingerprint();
+
+	groups = calloc(GROUPS, sizeof(*groups));
+	hits = calloc(GROUPS, sizeof(*hits));
+	misses = calloc(GROUPS, sizeof(*misses));
+
+	for (i = 0; i < GROUPS; i++) {
+		build_group(&groups[i], i, false);
+		build_group(&hits[i], i, false);
+		build_group(&misses[i], i, true);
+	}
+
+	run("Nexthop list hashing", groups, hits, misses, false);
+	run("Cached fingerprint", groups, hits, misses, true);
+
+	for (i = 0; i < GROUPS; i++) {
+		nexthops_free(groups[i].nhg.nexthop);
+		nexthops_free(hits[i].nhg.nexthop);
+		nexthops_free(misses[i].nhg.nexthop);
+	}
+	free(groups);
+	free(hits);
+	free(misses);
+
+	return 0;
+}
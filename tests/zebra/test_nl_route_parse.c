@@ -0,0 +1,402 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures the time it takes to decode a kernel route
+ * dump with the allocation free netlink route parser.
+ *
+ * Without arguments a dump of synthetic routes is generated in memory,
+ * otherwise the given file is decoded.  Files may either be a raw stream
+ * of netlink messages or the output of `ip route save`.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+
+#include "nexthop.h"
+#include "nexthop_group.h"
+#include "zebra/rt_netlink_parse.h"
+
+#define SYNTHETIC_ROUTES 1000000
+#define ROUNDS 5
+
+/* Upper bound of a synthetic route message. */
+#define SYNTHETIC_MSG_LEN 128
+
+/* Magic number prepended to `ip route save` dumps. */
+#define IPROUTE_DUMP_MAGIC 0x45311224
+
+struct nl_route_msg {
+	struct nlmsghdr n;
+	struct rtmsg r;
+	char buf[256];
+};
+
+static void add_attr(struct nlmsghdr *n, int type, const void *data,
+		     size_t alen)
+{
+	struct rtattr *rta = (struct rtattr *)((char *)n +
+					       NLMSG_ALIGN(n->nlmsg_len));
+
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(alen);
+	memcpy(RTA_DATA(rta), data, alen);
+	n->nlmsg_len = NLMSG_ALIGN(n->nlmsg_len) + RTA_ALIGN(rta->rta_len);
+}
+
+/*
+ * Route i of the synthetic dump lives in table syn_table(i) and leaves
+ * through syn_oif(i); multipath routes use syn_oif(i) + j for next hop j.
+ * Every 4th route goes into a table id that does not fit into rtm_table.
+ */
+static uint32_t syn_table(unsigned int i)
+{
+	return i % 4 == 3 ? 1000000 + i % 7 : RT_TABLE_MAIN;
+}
+
+static uint32_t syn_oif(unsigned int i)
+{
+	return 2 + i % 13;
+}
+
+static bool syn_is_v6(unsigned int i)
+{
+	return i % 8 == 7;
+}
+
+static bool syn_is_multipath(unsigned int i)
+{
+	return i % 16 == 14;
+}
+
+static void syn_dst4(unsigned int i, struct in_addr *dst)
+{
+	dst->s_addr = htonl(0x0a000000 + (i << 8));
+}
+
+static void syn_gw4(unsigned int i, unsigned int j, struct in_addr *gw)
+{
+	gw->s_addr = htonl(0xc0a80001 + (i % 251) * 2 + j);
+}
+
+static void syn_dst6(unsigned int i, struct in6_addr *dst)
+{
+	memset(dst, 0, sizeof(*dst));
+	dst->s6_addr32[0] = htonl(0x20010db8);
+	dst->s6_addr32[1] = htonl(i);
+}
+
+static void syn_gw6(unsigned int i, struct in6_addr *gw)
+{
+	memset(gw, 0, sizeof(*gw));
+	gw->s6_addr32[0] = htonl(0xfe800000);
+	gw->s6_addr32[3] = htonl(1 + i % 251);
+}
+
+/*
+ * Build a dump of `count` routes: mostly IPv4 single path routes, with
+ * every 8th route IPv6 and every 16th route using two next hops.
+ */
+static uint8_t *build_dump(unsigned int count, size_t *len)
+{
+	struct nl_route_msg msg;
+	uint8_t *buf, *pos;
+	unsigned int i;
+	uint32_t table, oif, prio = 20;
+
+	buf = malloc((size_t)count * SYNTHETIC_MSG_LEN);
+	assert(buf);
+	pos = buf;
+
+	for (i = 0; i < count; i++) {
+		table = syn_table(i);
+		oif = syn_oif(i);
+
+		memset(&msg, 0, sizeof(msg));
+		msg.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+		msg.n.nlmsg_type = RTM_NEWROUTE;
+		msg.n.nlmsg_flags = NLM_F_MULTI;
+		msg.n.nlmsg_seq = 1;
+		msg.r.rtm_table = table < 256 ? table : RT_TABLE_UNSPEC;
+		msg.r.rtm_protocol = RTPROT_STATIC;
+		msg.r.rtm_scope = RT_SCOPE_UNIVERSE;
+		msg.r.rtm_type = RTN_UNICAST;
+
+		add_attr(&msg.n, RTA_TABLE, &table, sizeof(table));
+		add_attr(&msg.n, RTA_PRIORITY, &prio, sizeof(prio));
+
+		if (syn_is_v6(i)) {
+			struct in6_addr dst, gw;
+
+			syn_dst6(i, &dst);
+			syn_gw6(i, &gw);
+
+			msg.r.rtm_family = AF_INET6;
+			msg.r.rtm_dst_len = 64;
+			add_attr(&msg.n, RTA_DST, &dst, sizeof(dst));
+			add_attr(&msg.n, RTA_GATEWAY, &gw, sizeof(gw));
+			add_attr(&msg.n, RTA_OIF, &oif, sizeof(oif));
+		} else {
+			struct in_addr dst, gw;
+
+			syn_dst4(i, &dst);
+			syn_gw4(i, 0, &gw);
+
+			msg.r.rtm_family = AF_INET;
+			msg.r.rtm_dst_len = 24;
+			add_attr(&msg.n, RTA_DST, &dst, sizeof(dst));
+
+			if (syn_is_multipath(i)) {
+				struct {
+					struct rtnexthop rtnh;
+					struct rtattr rta;
+					struct in_addr gw;
+				} mp[2];
+				int j;
+
+				for (j = 0; j < 2; j++) {
+					mp[j].rtnh.rtnh_len = sizeof(mp[j]);
+					mp[j].rtnh.rtnh_flags = 0;
+					mp[j].rtnh.rtnh_hops = j;
+					mp[j].rtnh.rtnh_ifindex = oif + j;
+					mp[j].rta.rta_type = RTA_GATEWAY;
+					mp[j].rta.rta_len =
+						RTA_LENGTH(sizeof(gw));
+					syn_gw4(i, j, &mp[j].gw);
+				}
+				add_attr(&msg.n, RTA_MULTIPATH, mp, sizeof(mp));
+			} else {
+				add_attr(&msg.n, RTA_GATEWAY, &gw, sizeof(gw));
+				add_attr(&msg.n, RTA_OIF, &oif, sizeof(oif));
+			}
+		}
+
+		assert(NLMSG_ALIGN(msg.n.nlmsg_len) <= SYNTHETIC_MSG_LEN);
+		memcpy(pos, &msg, msg.n.nlmsg_len);
+		pos += NLMSG_ALIGN(msg.n.nlmsg_len);
+	}
+
+	*len = pos - buf;
+	return buf;
+}
+
+/*
+ * Decode the synthetic dump once more and check every decoded field
+ * against what build_dump() put into the message.
+ */
+static void verify_dump(uint8_t *buf, size_t len, unsigned int count)
+{
+	struct nlmsghdr *h;
+	struct nl_route r;
+	struct nl_route_nh rnh;
+	struct nl_route_nh_iter it;
+	struct in_addr a4;
+	struct in6_addr a6;
+	unsigned int i = 0, j;
+	int msglen = len;
+
+	for (h = (struct nlmsghdr *)buf; NLMSG_OK(h, msglen);
+	     h = NLMSG_NEXT(h, msglen), i++) {
+		assert(nl_route_parse(h, &r) == 1);
+		assert(r.table == syn_table(i));
+		assert(r.priority == 20);
+
+		if (syn_is_v6(i)) {
+			syn_dst6(i, &a6);
+			assert(r.dst.family == AF_INET6);
+			assert(r.dst.prefixlen == 64);
+			assert(IPV6_ADDR_SAME(&r.dst.u.prefix6, &a6));
+
+			syn_gw6(i, &a6);
+			assert(r.gate && IPV6_ADDR_SAME(r.gate, &a6));
+			assert(r.oif == (int)syn_oif(i));
+			assert(!r.tb[RTA_MULTIPATH]);
+			continue;
+		}
+
+		syn_dst4(i, &a4);
+		assert(r.dst.family == AF_INET);
+		assert(r.dst.prefixlen == 24);
+		assert(IPV4_ADDR_SAME(&r.dst.u.prefix4, &a4));
+
+		if (!syn_is_multipath(i)) {
+			syn_gw4(i, 0, &a4);
+			assert(r.gate && IPV4_ADDR_SAME(r.gate, &a4));
+			assert(r.oif == (int)syn_oif(i));
+			assert(!r.tb[RTA_MULTIPATH]);
+			continue;
+		}
+
+		assert(r.gate == NULL);
+		assert(r.oif == 0);
+		assert(r.tb[RTA_MULTIPATH]);
+
+		j = 0;
+		nl_route_nh_iter_init(&r, &it);
+		while (nl_route_nh_next(&it, &rnh)) {
+			syn_gw4(i, j, &a4);
+			assert(rnh.gate && IPV4_ADDR_SAME(rnh.gate, &a4));
+			assert(rnh.ifindex == (int)(syn_oif(i) + j));
+			assert(rnh.weight == j + 1);
+			j++;
+		}
+		assert(j == 2);
+	}
+
+	assert(i == count);
+	assert(msglen == 0);
+}
+
+static uint8_t *load_dump(const char *path, size_t *len)
+{
+	FILE *fp;
+	uint8_t *buf;
+	long size;
+
+	fp = fopen(path, "r");
+	if (!fp) {
+		perror(path);
+		exit(1);
+	}
+
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	buf = malloc(size);
+	assert(buf);
+	if (fread(buf, 1, size, fp) != (size_t)size) {
+		perror(path);
+		exit(1);
+	}
+	fclose(fp);
+
+	*len = size;
+	return buf;
+}
+
+/* Decodes the whole dump, returns the number of routes. */
+static unsigned int parse_dump(uint8_t *buf, size_t len,
+			       unsigned int *nexthops)
+{
+	struct nlmsghdr *h;
+	struct nl_route r;
+	struct nl_route_nh rnh;
+	struct nl_route_nh_iter it;
+	unsigned int routes = 0;
+	int msglen = len;
+
+	*nexthops = 0;
+	for (h = (struct nlmsghdr *)buf; NLMSG_OK(h, msglen);
+	     h = NLMSG_NEXT(h, msglen)) {
+		if (h->nlmsg_type != RTM_NEWROUTE)
+			continue;
+		if (nl_route_parse(h, &r) != 1)
+			continue;
+
+		routes++;
+		if (!r.tb[RTA_MULTIPATH]) {
+			(*nexthops)++;
+			continue;
+		}
+
+		nl_route_nh_iter_init(&r, &it);
+		while (nl_route_nh_next(&it, &rnh))
+			(*nexthops)++;
+	}
+
+	return routes;
+}
+
+/*
+ * Same walk, but building the temporary next hop group the way route
+ * reads used to: one allocation per next hop and group.
+ */
+static unsigned int parse_dump_alloc(uint8_t *buf, size_t len)
+{
+	struct nlmsghdr *h;
+	struct nl_route r;
+	struct nl_route_nh rnh;
+	struct nl_route_nh_iter it;
+	struct nexthop_group *ng;
+	unsigned int routes = 0;
+	int msglen = len;
+
+	for (h = (struct nlmsghdr *)buf; NLMSG_OK(h, msglen);
+	     h = NLMSG_NEXT(h, msglen)) {
+		if (h->nlmsg_type != RTM_NEWROUTE)
+			continue;
+		if (nl_route_parse(h, &r) != 1)
+			continue;
+
+		routes++;
+		ng = nexthop_group_new();
+		if (!r.tb[RTA_MULTIPATH]) {
+			nexthop_group_add_sorted(ng, nexthop_new());
+		} else {
+			nl_route_nh_iter_init(&r, &it);
+			while (nl_route_nh_next(&it, &rnh))
+				nexthop_group_add_sorted(ng, nexthop_new());
+		}
+		nexthop_group_delete(&ng);
+	}
+
+	return routes;
+}
+
+static unsigned long elapsed_msec(struct timeval *start, struct timeval *stop)
+{
+	return 1000 * (stop->tv_sec - start->tv_sec) +
+	       (stop->tv_usec - start->tv_usec) / 1000;
+}
+
+int main(int argc, char **argv)
+{
+	uint8_t *buf, *msgs;
+	size_t len;
+	unsigned int routes = 0, nexthops = 0, i;
+	struct timeval tv_start, tv_stop;
+	unsigned long t_parse, t_alloc;
+
+	if (argc > 1) {
+		buf = load_dump(argv[1], &len);
+		msgs = buf;
+		if (len >= sizeof(uint32_t) &&
+		    *(uint32_t *)buf == IPROUTE_DUMP_MAGIC) {
+			msgs += sizeof(uint32_t);
+			len -= sizeof(uint32_t);
+		}
+	} else {
+		buf = build_dump(SYNTHETIC_ROUTES, &len);
+		msgs = buf;
+	}
+
+	monotime(&tv_start);
+	for (i = 0; i < ROUNDS; i++)
+		routes = parse_dump(msgs, len, &nexthops);
+	monotime(&tv_stop);
+	t_parse = elapsed_msec(&tv_start, &tv_stop);
+
+	if (argc <= 1) {
+		/* Every 16th route has two next hops. */
+		assert(routes == SYNTHETIC_ROUTES);
+		assert(nexthops == SYNTHETIC_ROUTES + SYNTHETIC_ROUTES / 16);
+		verify_dump(msgs, len, SYNTHETIC_ROUTES);
+	}
+
+	monotime(&tv_start);
+	for (i = 0; i < ROUNDS; i++)
+		parse_dump_alloc(msgs, len);
+	monotime(&tv_stop);
+	t_alloc = elapsed_msec(&tv_start, &tv_stop);
+
+	printf("Decoded %u routes (%u next hops, %zu bytes) %d times\n",
+	       routes, nexthops, len, ROUNDS);
+	printf("In place decoding took %lu.%03lu seconds.\n", t_parse / 1000,
+	       t_parse % 1000);
+	printf("Decoding with temporary next hop groups took %lu.%03lu seconds.\n",
+	       t_alloc / 1000, t_alloc % 1000);
+	fflush(stdout);
+
+	free(buf);
+	return 0;
+}
@@ -0,0 +1,252 @@
+#!/usr/bin/env python3
+# SPDX-License-Identifier: GPL-2.0-or-later
+"""
+Usage: frr-tracering-decode.py [-t TID] dumpfile [dumpfile ...]
+
+Turns the binary trace ring dumps written by "dump trace-ring FILENAME" or by a
+crashing daemon (into its tmpdir, e.g. /var/tmp/frr/bgpd.1234/tracering)
+into text, one line per record, ordered by time.  The dump carries the
+tracepoint names, locations and argument types, so no access to the
+binaries is needed.
+
+The file layout is described in lib/tracering.h and needs to be kept in
+sync with it.
+"""
+
+import argparse
+import datetime
+import ipaddress
+import struct
+import sys
+
+MAGIC = b"FRRTRING"
+VERSION = 1
+
+SEC_END = 0
+SEC_XREF = 1
+SEC_RING = 2
+
+AF_INET = 2
+# AF_INET6 differs between Linux, NetBSD/OpenBSD, FreeBSD and macOS
+AF_INET6 = (10, 24, 28, 30)
+
+ARG_SIZES = {
+    "i": 4,
+    "u": 4,
+    "I": 8,
+    "U": 8,
+    "x": 8,
+    "4": 4,
+    "6": 16,
+    "p": 18,
+}
+
+
+class DecodeError(Exception):
+    pass
+
+
+class Tracepoint:
+    def __init__(self, line, uid, types, name, file, func, args):
+        self.line = line
+        self.uid = uid
+        self.types = types
+        self.name = name
+        self.file = file
+        self.func = func
+        self.argnames = split_args(args)
+
+        if len(self.argnames) != len(self.types):
+            self.argnames = ["arg%d" % i for i in range(len(self.types))]
+
+
+def split_args(args):
+    """
+    split the stringified C argument list on top level commas
+    """
+    if not args.strip():
+        return []
+
+    ret, depth, cur = [], 0, ""
+    for ch in args:
+        if ch in "([":
+            depth += 1
+        elif ch in ")]":
+            depth -= 1
+        elif ch == "," and depth == 0:
+            ret.append(cur.strip())
+            cur = ""
+            continue
+        cur += ch
+    ret.append(cur.strip())
+    return ret
+
+
+def cstr(data):
+    return data.split(b"\0", 1)[0].decode("utf-8", "replace")
+
+
+def fmt_prefix(data):
+    family, plen = data[0], data[1]
+    addr = data[2:18]
+
+    if family == AF_INET:
+        return "%s/%d" % (ipaddress.IPv4Address(addr[:4]), plen)
+    if family in AF_INET6:
+        return "%s/%d" % (ipaddress.IPv6Address(addr), plen)
+    return "af%d:%s/%d" % (family, addr.hex(), plen)
+
+
+def fmt_args(endian, tracepoint, data):
+    out, pos = [], 0
+
+    for name, typ in zip(tracepoint.argnames, tracepoint.types):
+        size = ARG_SIZES[typ]
+        raw = data[pos : pos + size]
+        pos += size
+
+        if typ in "iuIU":
+            fmt = {"i": "i", "u": "I", "I": "q", "U": "Q"}[typ]
+            val = str(struct.unpack(endian + fmt, raw)[0])
+        elif typ == "x":
+            val = "0x%x" % struct.unpack(endian + "Q", raw)[0]
+        elif typ == "4":
+            val = str(ipaddress.IPv4Address(raw))
+        elif typ == "6":
+            val = str(ipaddress.IPv6Address(raw))
+        else:
+            val = fmt_prefix(raw)
+
+        out.append("%s=%s" % (name, val))
+    return " ".join(out)
+
+
+def fmt_ts(ts):
+    dt = datetime.datetime.fromtimestamp(ts // 1000000000, datetime.timezone.utc)
+    return "%s.%09d" % (dt.strftime("%Y-%m-%dT%H:%M:%S"), ts % 1000000000)
+
+
+def read_dump(filename):
+    with open(filename, "rb") as fd:
+        data = fd.read()
+
+    if data[:8] != MAGIC:
+        raise DecodeError("%s: not a trace ring dump" % filename)
+
+    byteorder = data[8:12]
+    if byteorder == b"\x04\x03\x02\x01":
+        endian = "<"
+    elif byteorder == b"\x01\x02\x03\x04":
+        endian = ">"
+    else:
+        raise DecodeError("%s: bad byte order marker" % filename)
+
+    hdr = struct.Struct(endian + "8sIIIIq32s")
+    _, _, version, rec_size, data_size, pid, progname = hdr.unpack_from(data, 0)
+    if version != VERSION:
+        raise DecodeError("%s: unsupported version %d" % (filename, version))
+
+    progname = cstr(progname)
+    sec = struct.Struct(endian + "II")
+    xref_s = struct.Struct(endian + "QI16s12s")
+    ring_s = struct.Struct(endian + "qQII")
+    rec_s = struct.Struct(endian + "QQ%ds" % data_size)
+
+    tracepoints = {}
+    records = []
+    pos = hdr.size
+
+    while True:
+        if pos + sec.size > len(data):
+            sys.stderr.write("%s: truncated dump\n" % filename)
+            break
+
+        typ, length = sec.unpack_from(data, pos)
+        pos += sec.size
+        payload = data[pos : pos + length]
+        pos += length
+
+        if typ == SEC_END:
+            break
+
+        if typ == SEC_XREF:
+            addr, line, uid, types = xref_s.unpack_from(payload, 0)
+            strings = payload[xref_s.size :].split(b"\0")
+            name, file, func, args = [
+                s.decode("utf-8", "replace") for s in strings[:4]
+            ]
+            tracepoints[addr] = Tracepoint(
+                line, cstr(uid), cstr(types), name, file, func, args
+            )
+
+        elif typ == SEC_RING:
+            tid, rpos, nrecs, _ = ring_s.unpack_from(payload, 0)
+            first = 0 if rpos <= nrecs else rpos % nrecs
+            count = min(rpos, nrecs)
+
+            for i in range(count):
+                slot = (first + i) % nrecs
+                ts, addr, argdata = rec_s.unpack_from(
+                    payload, ring_s.size + slot * rec_size
+                )
+                if addr:
+                    records.append((ts, progname, pid, tid, addr, argdata))
+
+            if rpos > nrecs:
+                sys.stderr.write(
+                    "%s: thread %d: %d older records overwritten\n"
+                    % (filename, tid, rpos - nrecs)
+                )
+
+    return endian, tracepoints, records
+
+
+def main():
+    argp = argparse.ArgumentParser(description="decode FRR trace ring dumps")
+    argp.add_argument("-t", "--tid", type=int, help="only show this thread")
+    argp.add_argument("dumpfile", nargs="+")
+    args = argp.parse_args()
+
+    records = []
+    for filename in args.dumpfile:
+        try:
+            endian, tracepoints, recs = read_dump(filename)
+        except (OSError, DecodeError, struct.error) as e:
+            sys.stderr.write("%s\n" % e)
+            sys.exit(1)
+
+        for rec in recs:
+            records.append((endian, tracepoints) + rec)
+
+    records.sort(key=lambda rec: rec[2])
+
+    for endian, tracepoints, ts, progname, pid, tid, addr, argdata in records:
+        if args.tid is not None and tid != args.tid:
+            continue
+
+        tp = tracepoints.get(addr)
+        if tp is None:
+            print(
+                "%s %s[%d/%d] unknown tracepoint 0x%x"
+                % (fmt_ts(ts), progname, pid, tid, addr)
+            )
+            continue
+
+        print(
+            "%s %s[%d/%d] %s (%s:%d %s): %s"
+            % (
+                fmt_ts(ts),
+                progname,
+                pid,
+                tid,
+                tp.name,
+                tp.file,
+                tp.line,
+                tp.func,
+                fmt_args(endian, tp, argdata),
+            )
+        )
+
+
+if __name__ == "__main__":
+    main()
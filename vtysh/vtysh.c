@@ -2949,6 +2949,16 @@ DEFUN (vtysh_show_event_poll,
 	return show_per_daemon(vty, argv, argc, "Event statistics for %s:\n");
 }
 
+DEFUN (vtysh_show_event_latency,
+       vtysh_show_event_latency_cmd,
+       "show event latency",
+       SHOW_STR
+       "Event information\n"
+       "Event run and queueing latency percentiles\n")
+{
+	return show_per_daemon(vty, argv, argc, "Event latency for %s:\n");
+}
+
 DEFUN (vtysh_show_event,
        vtysh_show_event_cpu_cmd,
        "show event cpu [FILTER]",
@@ -5133,6 +5143,7 @@ void vtysh_init_vty(void)
 	install_element(VIEW_NODE, &vtysh_show_event_cpu_cmd);
 	install_element(VIEW_NODE, &vtysh_show_event_poll_cmd);
 	install_element(VIEW_NODE, &vtysh_show_event_timer_cmd);
+	install_element(VIEW_NODE, &vtysh_show_event_latency_cmd);
 
 	/* Logging */
 	install_element(VIEW_NODE, &vtysh_show_logging_cmd);
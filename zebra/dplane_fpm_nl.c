@@ -30,6 +30,7 @@
 #include "lib/network.h"
 #include "lib/ns.h"
 #include "lib/frr_pthread.h"
+#include "lib/jhash.h"
 #include "lib/termtable.h"
 #include "zebra/debug.h"
 #include "zebra/interface.h"
@@ -70,14 +71,76 @@
 
 static const char *prov_name = "dplane_fpm_nl";
 
-struct fpm_nl_ctx {
+/*
+ * Upper bound of parallel FPM connections.  Routes are sharded across the
+ * connections by VRF/table, each connection getting its own encoding
+ * pthread so netlink encoding scales with the number of connections.
+ */
+#define FPM_NL_CONNECTIONS_MAX 16
+#define FPM_NL_CONNECTIONS_DEFAULT 1
+
+/*
+ * Change journal: with a single connection every FPM message is stamped
+ * with a sequence number (netlink `nlmsg_seq`) and the journal epoch
+ * (`nlmsg_pid`) and kept in a bounded ring.  On reconnect the FPM server
+ * may send a `RTM_GETROUTE` dump request carrying the epoch and the last
+ * sequence it applied, in which case only the missing tail is replayed.
+ * A server that stays silent for FPM_NL_RESYNC_WAIT seconds, asks for
+ * sequence 0, or whose tail was already evicted gets the full replay.
+ */
+#define FPM_NL_JOURNAL_SIZE_MAX (1 << 22)
+#define FPM_NL_RESYNC_WAIT 3
+
+DEFINE_MTYPE_STATIC(ZEBRA, FPM_JOURNAL, "FPM journal");
+
+enum fpm_nl_journal_state {
+	/* Messages are sent as they are journaled. */
+	FJS_LIVE,
+	/* Connected, waiting for the server resync request. */
+	FJS_WAIT,
+	/* Replaying the journal tail requested by the server. */
+	FJS_REPLAY,
+};
+
+struct fpm_nl_journal_entry {
+	uint32_t seq;
+	uint16_t len;
+	/* FPM header and netlink messages, ready to be written. */
+	uint8_t data[];
+};
+
+struct fpm_nl_journal {
+	/* Capacity in messages, 0 disables the journal. */
+	uint32_t size;
+	uint32_t epoch;
+	/* Next sequence number to assign. */
+	uint32_t next_seq;
+	/* Messages held: `next_seq - count` up to `next_seq - 1`. */
+	uint32_t count;
+	struct fpm_nl_journal_entry **ring;
+
+	enum fpm_nl_journal_state state;
+	/* Next sequence number to replay. */
+	uint32_t cursor;
+	/* Resync request wait, running on the FPM pthread. */
+	struct event *t_wait;
+
+	/* Statistic counters. */
+	uint32_t evicted;
+	uint32_t replayed;
+	uint32_t incremental_resyncs;
+	uint32_t full_resyncs;
+};
+
+struct fpm_nl_ctx;
+
+struct fpm_nl_conn {
+	struct fpm_nl_ctx *fnc;
+	unsigned int idx;
+
 	/* data plane connection. */
 	int socket;
-	bool disabled;
 	bool connecting;
-	bool use_nhg;
-	bool use_route_replace;
-	struct sockaddr_storage addr;
 
 	/* data plane buffers. */
 	struct stream *ibuf;
@@ -92,17 +155,54 @@ struct fpm_nl_ctx {
 	struct dplane_ctx_list_head ctxqueue;
 	pthread_mutex_t ctxqueue_mutex;
 
-	/* data plane events. */
-	struct zebra_dplane_provider *prov;
-	struct frr_pthread *fthread;
+	/* encoding pthread, started on first use of this connection. */
+	struct frr_pthread *wthread;
+
+	/* I/O events, running on the FPM pthread. */
 	struct event *t_connect;
 	struct event *t_read;
 	struct event *t_write;
-	struct event *t_event;
-	struct event *t_nhg;
+
+	/* encoding events, running on the encoding pthread. */
 	struct event *t_dequeue;
 	struct event *t_wedged;
 
+	/* Per connection statistic counters. */
+	_Atomic uint32_t bytes_sent;
+	_Atomic uint32_t obuf_bytes;
+	_Atomic uint32_t dplane_contexts;
+	_Atomic uint32_t ctxqueue_len;
+};
+
+struct fpm_nl_ctx {
+	bool disabled;
+	bool use_nhg;
+	bool use_route_replace;
+	struct sockaddr_storage addr;
+
+	/*
+	 * parallel connections, only the first conn_count ones are used.
+	 * conn_count is changed by the FPM pthread after starting the
+	 * connections and read by the dplane pthread, use
+	 * fpm_nl_conn_count().
+	 */
+	struct fpm_nl_conn conns[FPM_NL_CONNECTIONS_MAX];
+	atomic_uint conn_count;
+	/* configured connection count, applied by the FPM pthread. */
+	unsigned int conn_count_cfg;
+	/* connections established since the last reconnect. */
+	_Atomic unsigned int conns_up;
+
+	/* change journal, protected by the first connection `obuf_mutex`. */
+	struct fpm_nl_journal journal;
+
+	/* data plane events. */
+	struct zebra_dplane_provider *prov;
+	struct frr_pthread *fthread;
+	struct event *t_event;
+	struct event *t_nhg;
+	struct event *t_conns;
+
 	/* zebra events. */
 	struct event *t_lspreset;
 	struct event *t_lspwalk;
@@ -157,6 +257,8 @@ enum fpm_nl_events {
 	FNE_TOGGLE_NHG,
 	/* Reconnect request by our own code to avoid races. */
 	FNE_INTERNAL_RECONNECT,
+	/* Change the number of parallel connections. */
+	FNE_SET_CONNECTIONS,
 
 	/* LSP walk finished. */
 	FNE_LSP_FINISHED,
@@ -168,6 +270,35 @@ enum fpm_nl_events {
 	FNE_RMAC_FINISHED,
 };
 
+static inline unsigned int fpm_nl_conn_count(struct fpm_nl_ctx *fnc)
+{
+	return atomic_load_explicit(&fnc->conn_count, memory_order_acquire);
+}
+
+/* All configured connections are established. */
+static inline bool fpm_nl_connected(struct fpm_nl_ctx *fnc)
+{
+	return atomic_load_explicit(&fnc->conns_up, memory_order_relaxed) ==
+	       fpm_nl_conn_count(fnc);
+}
+
+/*
+ * With several connections there is no ordering between a next hop group
+ * and the routes using it, so routes are then encoded with their nexthops
+ * inline instead of referencing next hop group objects.
+ */
+static inline bool fpm_nl_use_nhg(struct fpm_nl_ctx *fnc)
+{
+	return fnc->use_nhg && fpm_nl_conn_count(fnc) == 1;
+}
+
+/* Journal is in use: it only covers the single connection setup. */
+static inline bool fpm_journal_active(struct fpm_nl_ctx *fnc)
+{
+	return fnc->journal.size > 0 && fpm_nl_conn_count(fnc) == 1 &&
+	       !fnc->disabled;
+}
+
 #define FPM_RECONNECT(fnc)                                                     \
 	event_add_event((fnc)->fthread->master, fpm_process_event, (fnc),      \
 			FNE_INTERNAL_RECONNECT, &(fnc)->t_event)
@@ -180,6 +311,7 @@ enum fpm_nl_events {
  * Prototypes.
  */
 static void fpm_process_event(struct event *t);
+static void fpm_process_queue(struct event *t);
 static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx);
 static void fpm_lsp_send(struct event *t);
 static void fpm_lsp_reset(struct event *t);
@@ -189,6 +321,7 @@ static void fpm_rib_send(struct event *t);
 static void fpm_rib_reset(struct event *t);
 static void fpm_rmac_send(struct event *t);
 static void fpm_rmac_reset(struct event *t);
+static void fpm_journal_resize(struct fpm_nl_ctx *fnc, uint32_t size);
 
 /*
  * CLI.
@@ -314,6 +447,49 @@ DEFUN(no_fpm_use_route_replace, no_fpm_use_route_replace_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFPY(fpm_connections, fpm_connections_cmd,
+      "[no] fpm connections ![(1-16)$count]",
+      NO_STR
+      FPM_STR
+      "Parallel connections to the FPM server\n"
+      "Number of connections\n")
+{
+	if (no)
+		count = FPM_NL_CONNECTIONS_DEFAULT;
+
+	if (gfnc->conn_count_cfg == (unsigned int)count)
+		return CMD_SUCCESS;
+
+	gfnc->conn_count_cfg = count;
+	event_add_event(gfnc->fthread->master, fpm_process_event, gfnc,
+			FNE_SET_CONNECTIONS, &gfnc->t_conns);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY(fpm_journal_size, fpm_journal_size_cmd,
+      "[no] fpm journal-size ![(1-4194304)$size]",
+      NO_STR
+      FPM_STR
+      "Journal sent messages for incremental resync\n"
+      "Number of messages to keep\n")
+{
+	if (no)
+		size = 0;
+
+	if (gfnc->journal.size == (uint32_t)size)
+		return CMD_SUCCESS;
+
+	frr_with_mutex (&gfnc->conns[0].obuf_mutex) {
+		fpm_journal_resize(gfnc, size);
+	}
+
+	/* The server sequence numbers are meaningless now: start over. */
+	FPM_RECONNECT(gfnc);
+
+	return CMD_SUCCESS;
+}
+
 DEFUN(fpm_reset_counters, fpm_reset_counters_cmd,
       "clear fpm counters",
       CLEAR_STR
@@ -330,14 +506,16 @@ DEFPY(fpm_show_status,
       "show fpm status [json]$json",
       SHOW_STR FPM_STR "FPM status\n" JSON_STR)
 {
-	struct json_object *j;
+	struct json_object *j, *jconns, *jconn;
+	struct fpm_nl_conn *conn;
 	bool connected;
 	uint16_t port;
 	struct sockaddr_in *sin;
 	struct sockaddr_in6 *sin6;
 	char buf[BUFSIZ];
+	unsigned int i;
 
-	connected = gfnc->socket > 0 ? true : false;
+	connected = fpm_nl_connected(gfnc);
 
 	switch (gfnc->addr.ss_family) {
 	case AF_INET:
@@ -367,6 +545,45 @@ DEFPY(fpm_show_status,
 		json_object_string_add(j, "address", buf);
 		json_object_int_add(j, "port", port);
 
+		jconns = json_object_new_array();
+		for (i = 0; i < fpm_nl_conn_count(gfnc); i++) {
+			conn = &gfnc->conns[i];
+			jconn = json_object_new_object();
+			json_object_int_add(jconn, "connection", i);
+			json_object_boolean_add(jconn, "connected",
+						conn->socket != -1 &&
+							!conn->connecting);
+			json_object_int_add(jconn, "bytesSent",
+					    conn->bytes_sent);
+			json_object_int_add(jconn, "obufBytes",
+					    conn->obuf_bytes);
+			json_object_int_add(jconn, "dataPlaneContexts",
+					    conn->dplane_contexts);
+			json_object_int_add(jconn, "dataPlaneContextsQueue",
+					    conn->ctxqueue_len);
+			json_object_array_add(jconns, jconn);
+		}
+		json_object_object_add(j, "connections", jconns);
+
+		if (gfnc->journal.size) {
+			jconn = json_object_new_object();
+			json_object_int_add(jconn, "size", gfnc->journal.size);
+			json_object_int_add(jconn, "entries",
+					    gfnc->journal.count);
+			json_object_int_add(jconn, "epoch", gfnc->journal.epoch);
+			json_object_int_add(jconn, "nextSequence",
+					    gfnc->journal.next_seq);
+			json_object_int_add(jconn, "evicted",
+					    gfnc->journal.evicted);
+			json_object_int_add(jconn, "replayed",
+					    gfnc->journal.replayed);
+			json_object_int_add(jconn, "incrementalResyncs",
+					    gfnc->journal.incremental_resyncs);
+			json_object_int_add(jconn, "fullResyncs",
+					    gfnc->journal.full_resyncs);
+			json_object_object_add(j, "journal", jconn);
+		}
+
 		vty_json(vty, j);
 	} else {
 		struct ttable *table = ttable_new(&ttable_styles[TTSTYLE_BLANK]);
@@ -376,18 +593,64 @@ DEFPY(fpm_show_status,
 		ttable_add_row(table, "Address to connect to|%s", buf);
 		ttable_add_row(table, "Port|%u", port);
 		ttable_add_row(table, "Connected|%s", connected ? "Yes" : "No");
+		ttable_add_row(table, "Connections|%u",
+			       fpm_nl_conn_count(gfnc));
 		ttable_add_row(table, "Use Nexthop Groups|%s",
-			       gfnc->use_nhg ? "Yes" : "No");
+			       !gfnc->use_nhg	      ? "No"
+			       : fpm_nl_use_nhg(gfnc) ? "Yes"
+						      : "No (multiple connections)");
 		ttable_add_row(table, "Use Route Replace Semantics|%s",
 			       gfnc->use_route_replace ? "Yes" : "No");
 		ttable_add_row(table, "Disabled|%s",
 			       gfnc->disabled ? "Yes" : "No");
+		if (gfnc->journal.size) {
+			ttable_add_row(table, "Journal|%u/%u messages%s",
+				       gfnc->journal.count, gfnc->journal.size,
+				       fpm_journal_active(gfnc)
+					       ? ""
+					       : " (inactive)");
+			ttable_add_row(table, "Journal epoch|%u",
+				       gfnc->journal.epoch);
+			ttable_add_row(table, "Journal next sequence|%u",
+				       gfnc->journal.next_seq);
+			ttable_add_row(table, "Journal evicted|%u",
+				       gfnc->journal.evicted);
+			ttable_add_row(table, "Journal replayed|%u",
+				       gfnc->journal.replayed);
+			ttable_add_row(table, "Resyncs incremental/full|%u/%u",
+				       gfnc->journal.incremental_resyncs,
+				       gfnc->journal.full_resyncs);
+		}
 
 		out = ttable_dump(table, "\n");
 		vty_out(vty, "%s\n", out);
 		XFREE(MTYPE_TMP, out);
 
 		ttable_del(table);
+
+		if (fpm_nl_conn_count(gfnc) <= 1)
+			return CMD_SUCCESS;
+
+		table = ttable_new(&ttable_styles[TTSTYLE_BLANK]);
+		ttable_add_row(table,
+			       "Connection|Connected|Bytes Sent|Buffered|Processed|Queued");
+		ttable_rowseps(table, 0, BOTTOM, true, '-');
+		for (i = 0; i < fpm_nl_conn_count(gfnc); i++) {
+			conn = &gfnc->conns[i];
+			ttable_add_row(table, "%u|%s|%u|%u|%u|%u", i,
+				       conn->socket != -1 && !conn->connecting
+					       ? "Yes"
+					       : "No",
+				       conn->bytes_sent, conn->obuf_bytes,
+				       conn->dplane_contexts,
+				       conn->ctxqueue_len);
+		}
+
+		out = ttable_dump(table, "\n");
+		vty_out(vty, "\n%s\n", out);
+		XFREE(MTYPE_TMP, out);
+
+		ttable_del(table);
 	}
 
 	return CMD_SUCCESS;
@@ -501,6 +764,16 @@ static int fpm_write_config(struct vty *vty)
 		written = 1;
 	}
 
+	if (gfnc->conn_count_cfg != FPM_NL_CONNECTIONS_DEFAULT) {
+		vty_out(vty, "fpm connections %u\n", gfnc->conn_count_cfg);
+		written = 1;
+	}
+
+	if (gfnc->journal.size) {
+		vty_out(vty, "fpm journal-size %u\n", gfnc->journal.size);
+		written = 1;
+	}
+
 	return written;
 }
 
@@ -515,9 +788,283 @@ static struct cmd_node fpm_node = {
  * FPM functions.
  */
 static void fpm_connect(struct event *t);
+static void fpm_write(struct event *t);
+
+/*
+ * Append to the connection output buffer and account it, the caller must
+ * hold `obuf_mutex` and have checked for space.
+ */
+static void fpm_conn_obuf_write(struct fpm_nl_conn *conn, const void *data,
+				size_t len)
+{
+	struct fpm_nl_ctx *fnc = conn->fnc;
+	uint64_t obytes, obytes_peak;
+
+	stream_write(conn->obuf, data, len);
+
+	/* Account number of bytes waiting to be written. */
+	atomic_fetch_add_explicit(&conn->obuf_bytes, len, memory_order_relaxed);
+	atomic_fetch_add_explicit(&fnc->counters.obuf_bytes, len,
+				  memory_order_relaxed);
+	obytes = atomic_load_explicit(&fnc->counters.obuf_bytes,
+				      memory_order_relaxed);
+	obytes_peak = atomic_load_explicit(&fnc->counters.obuf_peak,
+					   memory_order_relaxed);
+	if (obytes_peak < obytes)
+		atomic_store_explicit(&fnc->counters.obuf_peak, obytes,
+				      memory_order_relaxed);
+}
+
+/*
+ * Journal functions, all of them must be called with the first connection
+ * `obuf_mutex` held.
+ */
+static void fpm_journal_flush(struct fpm_nl_ctx *fnc)
+{
+	struct fpm_nl_journal *j = &fnc->journal;
+	uint32_t seq;
+
+	for (seq = j->next_seq - j->count; seq != j->next_seq; seq++)
+		XFREE(MTYPE_FPM_JOURNAL, j->ring[seq % j->size]);
+
+	/* A new epoch tells the server its sequence numbers are stale. */
+	j->epoch = (uint32_t)frr_weak_random() | 1;
+	j->next_seq = 1;
+	j->count = 0;
+	j->cursor = 0;
+	j->state = FJS_LIVE;
+}
+
+static void fpm_journal_resize(struct fpm_nl_ctx *fnc, uint32_t size)
+{
+	struct fpm_nl_journal *j = &fnc->journal;
+
+	if (j->size)
+		fpm_journal_flush(fnc);
+	XFREE(MTYPE_FPM_JOURNAL, j->ring);
+
+	j->size = size;
+	if (size == 0)
+		return;
+
+	j->ring = XCALLOC(MTYPE_FPM_JOURNAL, sizeof(*j->ring) * size);
+	fpm_journal_flush(fnc);
+}
+
+/*
+ * Record an encoded FPM message: `nl_buf` netlink headers get stamped with
+ * the sequence number and epoch before being copied into the journal.
+ */
+static void fpm_journal_add(struct fpm_nl_ctx *fnc, const uint8_t *fpm_hdr,
+			    uint8_t *nl_buf, size_t nl_buf_len)
+{
+	struct fpm_nl_journal *j = &fnc->journal;
+	struct fpm_nl_journal_entry *entry;
+	struct nlmsghdr *nlh;
+	size_t len = nl_buf_len;
+	uint32_t seq, idx;
+
+	/* Sequence 0 means "nothing applied", start over on wrap around. */
+	if (j->next_seq == 0)
+		fpm_journal_flush(fnc);
+
+	seq = j->next_seq++;
+	for (nlh = (struct nlmsghdr *)nl_buf; NLMSG_OK(nlh, len);
+	     nlh = NLMSG_NEXT(nlh, len)) {
+		nlh->nlmsg_seq = seq;
+		nlh->nlmsg_pid = j->epoch;
+	}
+
+	/* Ring is full: the oldest message uses the same slot. */
+	idx = seq % j->size;
+	if (j->count == j->size) {
+		XFREE(MTYPE_FPM_JOURNAL, j->ring[idx]);
+		j->count--;
+		j->evicted++;
+	}
+
+	entry = XMALLOC(MTYPE_FPM_JOURNAL,
+			sizeof(*entry) + FPM_HEADER_SIZE + nl_buf_len);
+	entry->seq = seq;
+	entry->len = FPM_HEADER_SIZE + nl_buf_len;
+	memcpy(entry->data, fpm_hdr, FPM_HEADER_SIZE);
+	memcpy(entry->data + FPM_HEADER_SIZE, nl_buf, nl_buf_len);
+	j->ring[idx] = entry;
+	j->count++;
+}
+
+static void fpm_journal_full_sync(struct fpm_nl_ctx *fnc)
+{
+	fnc->journal.state = FJS_LIVE;
+	fnc->journal.full_resyncs++;
+
+	event_add_timer(zrouter.master, fpm_lsp_reset, fnc, 0,
+			&fnc->t_lspreset);
+}
+
+/*
+ * Copy as much of the journal tail being replayed as fits in the output
+ * buffer.  Returns `true` if anything was added.
+ */
+static bool fpm_journal_pump(struct fpm_nl_conn *conn)
+{
+	struct fpm_nl_ctx *fnc = conn->fnc;
+	struct fpm_nl_journal *j = &fnc->journal;
+	struct fpm_nl_journal_entry *entry;
+	bool added = false;
+
+	if (conn->idx != 0 || j->state != FJS_REPLAY)
+		return false;
+
+	/* The server was too slow and the tail got evicted meanwhile. */
+	if ((int32_t)(j->cursor - (j->next_seq - j->count)) < 0) {
+		zlog_warn("%s: journal sequence %u evicted during replay, falling back to full resync",
+			  __func__, j->cursor);
+		fpm_journal_full_sync(fnc);
+		return false;
+	}
+
+	while (j->cursor != j->next_seq) {
+		entry = j->ring[j->cursor % j->size];
+		if (STREAM_WRITEABLE(conn->obuf) < entry->len)
+			break;
+
+		fpm_conn_obuf_write(conn, entry->data, entry->len);
+		j->cursor++;
+		j->replayed++;
+		added = true;
+	}
+
+	if (j->cursor == j->next_seq) {
+		if (IS_ZEBRA_DEBUG_FPM)
+			zlog_debug("%s: journal replay finished at sequence %u",
+				   __func__, j->cursor);
+		j->state = FJS_LIVE;
+	}
+
+	return added;
+}
+
+static void fpm_journal_wait_expired(struct event *t)
+{
+	struct fpm_nl_ctx *fnc = EVENT_ARG(t);
+
+	frr_mutex_lock_autounlock(&fnc->conns[0].obuf_mutex);
+	if (fnc->journal.state != FJS_WAIT)
+		return;
+
+	if (IS_ZEBRA_DEBUG_FPM)
+		zlog_debug("%s: no resync request received, doing full resync",
+			   __func__);
+
+	fpm_journal_full_sync(fnc);
+}
+
+/*
+ * The server told us the journal epoch and last sequence it applied
+ * (`RTM_GETROUTE` dump request): replay the tail if we still have it.
+ */
+static void fpm_journal_resync(struct fpm_nl_conn *conn,
+			       const struct nlmsghdr *hdr)
+{
+	struct fpm_nl_ctx *fnc = conn->fnc;
+	struct fpm_nl_journal *j = &fnc->journal;
+	uint32_t last = hdr->nlmsg_seq;
+
+	if (conn->idx != 0 || !(hdr->nlmsg_flags & NLM_F_DUMP))
+		return;
+
+	frr_mutex_lock_autounlock(&conn->obuf_mutex);
+	if (j->state != FJS_WAIT) {
+		if (IS_ZEBRA_DEBUG_FPM)
+			zlog_debug("%s: unexpected resync request, ignoring",
+				   __func__);
+		return;
+	}
+
+	EVENT_OFF(j->t_wait);
+
+	if (last == 0 || hdr->nlmsg_pid != j->epoch ||
+	    (int32_t)(last + 1 - (j->next_seq - j->count)) < 0 ||
+	    (int32_t)(j->next_seq - (last + 1)) < 0) {
+		zlog_info("%s: sequence %u (epoch %u) not in journal, doing full resync",
+			  __func__, last, hdr->nlmsg_pid);
+		fpm_journal_full_sync(fnc);
+		return;
+	}
+
+	zlog_info("%s: replaying %u journaled messages after sequence %u",
+		  __func__, j->next_seq - (last + 1), last);
+
+	j->state = FJS_REPLAY;
+	j->cursor = last + 1;
+	j->incremental_resyncs++;
+	if (fpm_journal_pump(conn))
+		event_add_write(fnc->fthread->master, fpm_write, conn,
+				conn->socket, &conn->t_write);
+}
+
+/*
+ * Connection `conn` is now usable: once every configured connection is up,
+ * start walking all FPM objects, beginning with LSPs, marking them as unsent
+ * and then replaying them.
+ */
+static void fpm_conn_established(struct fpm_nl_conn *conn)
+{
+	struct fpm_nl_ctx *fnc = conn->fnc;
+	unsigned int up;
+
+	up = atomic_fetch_add_explicit(&fnc->conns_up, 1,
+				       memory_order_relaxed) + 1;
+	if (up < fpm_nl_conn_count(fnc))
+		return;
+
+	/* Give the server a chance to ask for an incremental resync. */
+	if (fpm_journal_active(fnc)) {
+		frr_with_mutex (&fnc->conns[0].obuf_mutex) {
+			fnc->journal.state = FJS_WAIT;
+		}
+		event_add_timer(fnc->fthread->master, fpm_journal_wait_expired,
+				fnc, FPM_NL_RESYNC_WAIT, &fnc->journal.t_wait);
+		return;
+	}
+
+	event_add_timer(zrouter.master, fpm_lsp_reset, fnc, 0,
+			&fnc->t_lspreset);
+}
+
+static void fpm_conn_close(struct fpm_nl_conn *conn)
+{
+	/*
+	 * Grab the lock to empty the streams (data plane might try to
+	 * enqueue updates while we are closing).
+	 */
+	frr_mutex_lock_autounlock(&conn->obuf_mutex);
+
+	/* Avoid calling close on `-1`. */
+	if (conn->socket != -1) {
+		close(conn->socket);
+		conn->socket = -1;
+	}
+	conn->connecting = false;
+
+	atomic_fetch_sub_explicit(&conn->fnc->counters.obuf_bytes,
+				  atomic_load_explicit(&conn->obuf_bytes,
+						       memory_order_relaxed),
+				  memory_order_relaxed);
+	atomic_store_explicit(&conn->obuf_bytes, 0, memory_order_relaxed);
+
+	stream_reset(conn->ibuf);
+	stream_reset(conn->obuf);
+	EVENT_OFF(conn->t_read);
+	EVENT_OFF(conn->t_write);
+	EVENT_OFF(conn->t_connect);
+}
 
 static void fpm_reconnect(struct fpm_nl_ctx *fnc)
 {
+	unsigned int i;
+
 	/* Cancel all zebra threads first. */
 	event_cancel_async(zrouter.master, &fnc->t_lspreset, NULL);
 	event_cancel_async(zrouter.master, &fnc->t_lspwalk, NULL);
@@ -529,33 +1076,33 @@ static void fpm_reconnect(struct fpm_nl_ctx *fnc)
 	event_cancel_async(zrouter.master, &fnc->t_rmacwalk, NULL);
 
 	/*
-	 * Grab the lock to empty the streams (data plane might try to
-	 * enqueue updates while we are closing).
+	 * The replay walk is shared by all connections, so a failure on any
+	 * of them restarts all of them.
 	 */
-	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
+	for (i = 0; i < FPM_NL_CONNECTIONS_MAX; i++)
+		fpm_conn_close(&fnc->conns[i]);
 
-	/* Avoid calling close on `-1`. */
-	if (fnc->socket != -1) {
-		close(fnc->socket);
-		fnc->socket = -1;
-	}
+	atomic_store_explicit(&fnc->conns_up, 0, memory_order_relaxed);
 
-	stream_reset(fnc->ibuf);
-	stream_reset(fnc->obuf);
-	EVENT_OFF(fnc->t_read);
-	EVENT_OFF(fnc->t_write);
+	/* Keep journaling until the server tells us where it stopped. */
+	EVENT_OFF(fnc->journal.t_wait);
+	frr_with_mutex (&fnc->conns[0].obuf_mutex) {
+		fnc->journal.state = FJS_LIVE;
+	}
 
 	/* FPM is disabled, don't attempt to connect. */
 	if (fnc->disabled)
 		return;
 
-	event_add_timer(fnc->fthread->master, fpm_connect, fnc, 3,
-			&fnc->t_connect);
+	for (i = 0; i < fpm_nl_conn_count(fnc); i++)
+		event_add_timer(fnc->fthread->master, fpm_connect,
+				&fnc->conns[i], 3, &fnc->conns[i].t_connect);
 }
 
 static void fpm_read(struct event *t)
 {
-	struct fpm_nl_ctx *fnc = EVENT_ARG(t);
+	struct fpm_nl_conn *conn = EVENT_ARG(t);
+	struct fpm_nl_ctx *fnc = conn->fnc;
 	fpm_msg_hdr_t fpm;
 	ssize_t rv;
 	char buf[65535];
@@ -565,14 +1112,15 @@ static void fpm_read(struct event *t)
 	size_t hdr_available_bytes;
 
 	/* Let's ignore the input at the moment. */
-	rv = stream_read_try(fnc->ibuf, fnc->socket,
-			     STREAM_WRITEABLE(fnc->ibuf));
+	rv = stream_read_try(conn->ibuf, conn->socket,
+			     STREAM_WRITEABLE(conn->ibuf));
 	if (rv == 0) {
 		atomic_fetch_add_explicit(&fnc->counters.connection_closes, 1,
 					  memory_order_relaxed);
 
 		if (IS_ZEBRA_DEBUG_FPM)
-			zlog_debug("%s: connection closed", __func__);
+			zlog_debug("%s: connection %u closed", __func__,
+				   conn->idx);
 
 		FPM_RECONNECT(fnc);
 		return;
@@ -580,15 +1128,15 @@ static void fpm_read(struct event *t)
 	if (rv == -1) {
 		atomic_fetch_add_explicit(&fnc->counters.connection_errors, 1,
 					  memory_order_relaxed);
-		zlog_warn("%s: connection failure: %s", __func__,
+		zlog_warn("%s: connection %u failure: %s", __func__, conn->idx,
 			  strerror(errno));
 		FPM_RECONNECT(fnc);
 		return;
 	}
 
 	/* Schedule the next read */
-	event_add_read(fnc->fthread->master, fpm_read, fnc, fnc->socket,
-		       &fnc->t_read);
+	event_add_read(fnc->fthread->master, fpm_read, conn, conn->socket,
+		       &conn->t_read);
 
 	/* We've got an interruption. */
 	if (rv == -2)
@@ -599,20 +1147,20 @@ static void fpm_read(struct event *t)
 	atomic_fetch_add_explicit(&fnc->counters.bytes_read, rv,
 				  memory_order_relaxed);
 
-	available_bytes = STREAM_READABLE(fnc->ibuf);
+	available_bytes = STREAM_READABLE(conn->ibuf);
 	while (available_bytes) {
 		if (available_bytes < (ssize_t)FPM_MSG_HDR_LEN) {
-			stream_pulldown(fnc->ibuf);
+			stream_pulldown(conn->ibuf);
 			return;
 		}
 
-		fpm.version = stream_getc(fnc->ibuf);
-		fpm.msg_type = stream_getc(fnc->ibuf);
-		fpm.msg_len = stream_getw(fnc->ibuf);
+		fpm.version = stream_getc(conn->ibuf);
+		fpm.msg_type = stream_getc(conn->ibuf);
+		fpm.msg_len = stream_getw(conn->ibuf);
 
 		if (fpm.version != FPM_PROTO_VERSION &&
 		    fpm.msg_type != FPM_MSG_TYPE_NETLINK) {
-			stream_reset(fnc->ibuf);
+			stream_reset(conn->ibuf);
 			zlog_warn(
 				"%s: Received version/msg_type %u/%u, expected 1/1",
 				__func__, fpm.version, fpm.msg_type);
@@ -639,8 +1187,8 @@ static void fpm_read(struct event *t)
 		 * top.
 		 */
 		if (fpm.msg_len > available_bytes) {
-			stream_rewind_getp(fnc->ibuf, FPM_MSG_HDR_LEN);
-			stream_pulldown(fnc->ibuf);
+			stream_rewind_getp(conn->ibuf, FPM_MSG_HDR_LEN);
+			stream_pulldown(conn->ibuf);
 			return;
 		}
 
@@ -650,7 +1198,7 @@ static void fpm_read(struct event *t)
 		 * Place the data from the stream into a buffer
 		 */
 		hdr = (struct nlmsghdr *)buf;
-		stream_get(buf, fnc->ibuf, fpm.msg_len - FPM_MSG_HDR_LEN);
+		stream_get(buf, conn->ibuf, fpm.msg_len - FPM_MSG_HDR_LEN);
 		hdr_available_bytes = fpm.msg_len - FPM_MSG_HDR_LEN;
 		available_bytes -= hdr_available_bytes;
 
@@ -697,13 +1245,16 @@ static void fpm_read(struct event *t)
 			if (netlink_route_change_read_unicast_internal(
 				    hdr, 0, false, ctx) != 1) {
 				dplane_ctx_fini(&ctx);
-				stream_pulldown(fnc->ibuf);
+				stream_pulldown(conn->ibuf);
 				/*
 				 * Let's continue to read other messages
 				 * Even if we ignore this one.
 				 */
 			}
 			break;
+		case RTM_GETROUTE:
+			fpm_journal_resync(conn, hdr);
+			break;
 		default:
 			if (IS_ZEBRA_DEBUG_FPM)
 				zlog_debug(
@@ -713,26 +1264,28 @@ static void fpm_read(struct event *t)
 		}
 	}
 
-	stream_reset(fnc->ibuf);
+	stream_reset(conn->ibuf);
 }
 
 static void fpm_write(struct event *t)
 {
-	struct fpm_nl_ctx *fnc = EVENT_ARG(t);
+	struct fpm_nl_conn *conn = EVENT_ARG(t);
+	struct fpm_nl_ctx *fnc = conn->fnc;
 	socklen_t statuslen;
 	ssize_t bwritten;
 	int rv, status;
 	size_t btotal;
 
-	if (fnc->connecting == true) {
+	if (conn->connecting == true) {
 		status = 0;
 		statuslen = sizeof(status);
 
-		rv = getsockopt(fnc->socket, SOL_SOCKET, SO_ERROR, &status,
+		rv = getsockopt(conn->socket, SOL_SOCKET, SO_ERROR, &status,
 				&statuslen);
 		if (rv == -1 || status != 0) {
 			if (rv != -1)
-				zlog_warn("%s: connection failed: %s", __func__,
+				zlog_warn("%s: connection %u failed: %s",
+					  __func__, conn->idx,
 					  strerror(status));
 			else
 				zlog_warn("%s: SO_ERROR failed: %s", __func__,
@@ -746,40 +1299,38 @@ static void fpm_write(struct event *t)
 			return;
 		}
 
-		fnc->connecting = false;
+		conn->connecting = false;
 
-		/*
-		 * Starting with LSPs walk all FPM objects, marking them
-		 * as unsent and then replaying them.
-		 */
-		event_add_timer(zrouter.master, fpm_lsp_reset, fnc, 0,
-				&fnc->t_lspreset);
+		fpm_conn_established(conn);
 
 		/* Permit receiving messages now. */
-		event_add_read(fnc->fthread->master, fpm_read, fnc, fnc->socket,
-			       &fnc->t_read);
+		event_add_read(fnc->fthread->master, fpm_read, conn,
+			       conn->socket, &conn->t_read);
 	}
 
-	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
+	frr_mutex_lock_autounlock(&conn->obuf_mutex);
 
 	while (true) {
-		/* Stream is empty: reset pointers and return. */
-		if (STREAM_READABLE(fnc->obuf) == 0) {
-			stream_reset(fnc->obuf);
+		/* Stream is empty: refill from the journal or return. */
+		if (STREAM_READABLE(conn->obuf) == 0) {
+			stream_reset(conn->obuf);
+			if (fpm_journal_pump(conn))
+				continue;
 			break;
 		}
 
 		/* Try to write all at once. */
-		btotal = stream_get_endp(fnc->obuf) -
-			stream_get_getp(fnc->obuf);
-		bwritten = write(fnc->socket, stream_pnt(fnc->obuf), btotal);
+		btotal = stream_get_endp(conn->obuf) -
+			stream_get_getp(conn->obuf);
+		bwritten = write(conn->socket, stream_pnt(conn->obuf), btotal);
 		if (bwritten == 0) {
 			atomic_fetch_add_explicit(
 				&fnc->counters.connection_closes, 1,
 				memory_order_relaxed);
 
 			if (IS_ZEBRA_DEBUG_FPM)
-				zlog_debug("%s: connection closed", __func__);
+				zlog_debug("%s: connection %u closed",
+					   __func__, conn->idx);
 			break;
 		}
 		if (bwritten == -1) {
@@ -793,8 +1344,8 @@ static void fpm_write(struct event *t)
 			atomic_fetch_add_explicit(
 				&fnc->counters.connection_errors, 1,
 				memory_order_relaxed);
-			zlog_warn("%s: connection failure: %s", __func__,
-				  strerror(errno));
+			zlog_warn("%s: connection %u failure: %s", __func__,
+				  conn->idx, strerror(errno));
 
 			FPM_RECONNECT(fnc);
 			return;
@@ -803,26 +1354,31 @@ static void fpm_write(struct event *t)
 		/* Account all bytes sent. */
 		atomic_fetch_add_explicit(&fnc->counters.bytes_sent, bwritten,
 					  memory_order_relaxed);
+		atomic_fetch_add_explicit(&conn->bytes_sent, bwritten,
+					  memory_order_relaxed);
 
 		/* Account number of bytes free. */
 		atomic_fetch_sub_explicit(&fnc->counters.obuf_bytes, bwritten,
 					  memory_order_relaxed);
+		atomic_fetch_sub_explicit(&conn->obuf_bytes, bwritten,
+					  memory_order_relaxed);
 
-		stream_forward_getp(fnc->obuf, (size_t)bwritten);
+		stream_forward_getp(conn->obuf, (size_t)bwritten);
 	}
 
 	/* Stream is not empty yet, we must schedule more writes. */
-	if (STREAM_READABLE(fnc->obuf)) {
-		stream_pulldown(fnc->obuf);
-		event_add_write(fnc->fthread->master, fpm_write, fnc,
-				fnc->socket, &fnc->t_write);
+	if (STREAM_READABLE(conn->obuf)) {
+		stream_pulldown(conn->obuf);
+		event_add_write(fnc->fthread->master, fpm_write, conn,
+				conn->socket, &conn->t_write);
 		return;
 	}
 }
 
 static void fpm_connect(struct event *t)
 {
-	struct fpm_nl_ctx *fnc = EVENT_ARG(t);
+	struct fpm_nl_conn *conn = EVENT_ARG(t);
+	struct fpm_nl_ctx *fnc = conn->fnc;
 	struct sockaddr_in *sin = (struct sockaddr_in *)&fnc->addr;
 	struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&fnc->addr;
 	socklen_t slen;
@@ -833,8 +1389,8 @@ static void fpm_connect(struct event *t)
 	if (sock == -1) {
 		zlog_err("%s: fpm socket failed: %s", __func__,
 			 strerror(errno));
-		event_add_timer(fnc->fthread->master, fpm_connect, fnc, 3,
-				&fnc->t_connect);
+		event_add_timer(fnc->fthread->master, fpm_connect, conn, 3,
+				&conn->t_connect);
 		return;
 	}
 
@@ -849,8 +1405,8 @@ static void fpm_connect(struct event *t)
 	}
 
 	if (IS_ZEBRA_DEBUG_FPM)
-		zlog_debug("%s: attempting to connect to %s:%d", __func__,
-			   addrstr, ntohs(sin->sin_port));
+		zlog_debug("%s: connection %u attempting to connect to %s:%d",
+			   __func__, conn->idx, addrstr, ntohs(sin->sin_port));
 
 	rv = connect(sock, (struct sockaddr *)&fnc->addr, slen);
 	if (rv == -1 && errno != EINPROGRESS) {
@@ -859,33 +1415,59 @@ static void fpm_connect(struct event *t)
 		close(sock);
 		zlog_warn("%s: fpm connection failed: %s", __func__,
 			  strerror(errno));
-		event_add_timer(fnc->fthread->master, fpm_connect, fnc, 3,
-				&fnc->t_connect);
+		event_add_timer(fnc->fthread->master, fpm_connect, conn, 3,
+				&conn->t_connect);
 		return;
 	}
 
-	fnc->connecting = (errno == EINPROGRESS);
-	fnc->socket = sock;
-	if (!fnc->connecting)
-		event_add_read(fnc->fthread->master, fpm_read, fnc, sock,
-			       &fnc->t_read);
-	event_add_write(fnc->fthread->master, fpm_write, fnc, sock,
-			&fnc->t_write);
+	conn->connecting = (errno == EINPROGRESS);
+	conn->socket = sock;
+	if (!conn->connecting)
+		event_add_read(fnc->fthread->master, fpm_read, conn, sock,
+			       &conn->t_read);
+	event_add_write(fnc->fthread->master, fpm_write, conn, sock,
+			&conn->t_write);
 
 	/*
-	 * Starting with LSPs walk all FPM objects, marking them
-	 * as unsent and then replaying them.
-	 *
-	 * If we are not connected, then delay the objects reset/send.
+	 * If we are not connected, then delay the objects reset/send until
+	 * the connection completes.
 	 */
-	if (!fnc->connecting)
-		event_add_timer(zrouter.master, fpm_lsp_reset, fnc, 0,
-				&fnc->t_lspreset);
+	if (!conn->connecting)
+		fpm_conn_established(conn);
+}
+
+/*
+ * Pick the connection carrying `ctx`: routes are spread over the
+ * connections by VRF and table, everything else uses the first one.
+ */
+static struct fpm_nl_conn *fpm_nl_conn_select(struct fpm_nl_ctx *fnc,
+					      struct zebra_dplane_ctx *ctx)
+{
+	unsigned int count = fpm_nl_conn_count(fnc);
+	uint32_t key;
+
+	if (count <= 1)
+		return &fnc->conns[0];
+
+	switch (dplane_ctx_get_op(ctx)) {
+	case DPLANE_OP_ROUTE_INSTALL:
+	case DPLANE_OP_ROUTE_UPDATE:
+	case DPLANE_OP_ROUTE_DELETE:
+		key = jhash_2words(dplane_ctx_get_vrf(ctx),
+				   dplane_ctx_get_table(ctx), 0xf9a11c0d);
+		return &fnc->conns[key % count];
+	default:
+		return &fnc->conns[0];
+	}
 }
 
 /**
  * Encode data plane operation context into netlink and enqueue it in the FPM
- * output buffer.
+ * output buffer of the connection it is sharded to.
+ *
+ * Encoding happens without holding the output buffer lock, so the encoding
+ * pthreads of several connections (and the zebra replay walks) can work in
+ * parallel.
  *
  * @param fnc the netlink FPM context.
  * @param ctx the data plane operation context data.
@@ -894,24 +1476,25 @@ static void fpm_connect(struct event *t)
 static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 {
 	uint8_t nl_buf[NL_PKT_BUF_SIZE];
+	uint8_t fpm_hdr[FPM_HEADER_SIZE];
 	size_t nl_buf_len;
 	ssize_t rv;
-	uint64_t obytes, obytes_peak;
 	enum dplane_op_e op = dplane_ctx_get_op(ctx);
+	struct fpm_nl_conn *conn = fpm_nl_conn_select(fnc, ctx);
+	bool use_nhg = fpm_nl_use_nhg(fnc);
+	bool journal, live;
 
 	/*
 	 * If we were configured to not use next hop groups, then quit as soon
 	 * as possible.
 	 */
-	if ((!fnc->use_nhg)
+	if ((!use_nhg)
 	    && (op == DPLANE_OP_NH_DELETE || op == DPLANE_OP_NH_INSTALL
 		|| op == DPLANE_OP_NH_UPDATE))
 		return 0;
 
 	nl_buf_len = 0;
 
-	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
-
 	/*
 	 * If route replace is enabled then directly encode the install which
 	 * is going to use `NLM_F_REPLACE` (instead of delete/add operations).
@@ -924,7 +1507,7 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 	case DPLANE_OP_ROUTE_DELETE:
 		rv = netlink_route_multipath_msg_encode(RTM_DELROUTE, ctx,
 							nl_buf, sizeof(nl_buf),
-							true, fnc->use_nhg,
+							true, use_nhg,
 							false);
 		if (rv <= 0) {
 			zlog_err(
@@ -945,7 +1528,7 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 							&nl_buf[nl_buf_len],
 							sizeof(nl_buf) -
 								nl_buf_len,
-							true, fnc->use_nhg,
+							true, use_nhg,
 							fnc->use_route_replace);
 		if (rv <= 0) {
 			zlog_err(
@@ -1063,47 +1646,59 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 	/* We must know if someday a message goes beyond 65KiB. */
 	assert((nl_buf_len + FPM_HEADER_SIZE) <= UINT16_MAX);
 
+	/*
+	 * Fill in the FPM header information.
+	 *
+	 * See FPM_HEADER_SIZE definition for more information.
+	 */
+	fpm_hdr[0] = 1;
+	fpm_hdr[1] = 1;
+	fpm_hdr[2] = (nl_buf_len + FPM_HEADER_SIZE) >> 8;
+	fpm_hdr[3] = (nl_buf_len + FPM_HEADER_SIZE) & 0xff;
+
+	frr_mutex_lock_autounlock(&conn->obuf_mutex);
+
+	/*
+	 * Journaled messages are kept while disconnected or while the
+	 * server resync is pending, they get sent by the journal replay.
+	 */
+	journal = conn->idx == 0 && fpm_journal_active(fnc);
+	live = conn->socket != -1 &&
+	       (!journal || fnc->journal.state == FJS_LIVE);
+
+	/* Connection went away meanwhile, the replay walk will resend. */
+	if (!journal && conn->socket == -1)
+		return 0;
+
 	/* Check if we have enough buffer space. */
-	if (STREAM_WRITEABLE(fnc->obuf) < (nl_buf_len + FPM_HEADER_SIZE)) {
+	if (live &&
+	    STREAM_WRITEABLE(conn->obuf) < (nl_buf_len + FPM_HEADER_SIZE)) {
 		atomic_fetch_add_explicit(&fnc->counters.buffer_full, 1,
 					  memory_order_relaxed);
 
 		if (IS_ZEBRA_DEBUG_FPM)
 			zlog_debug(
-				"%s: buffer full: wants to write %zu but has %zu",
-				__func__, nl_buf_len + FPM_HEADER_SIZE,
-				STREAM_WRITEABLE(fnc->obuf));
+				"%s: connection %u buffer full: wants to write %zu but has %zu",
+				__func__, conn->idx,
+				nl_buf_len + FPM_HEADER_SIZE,
+				STREAM_WRITEABLE(conn->obuf));
 
 		return -1;
 	}
 
-	/*
-	 * Fill in the FPM header information.
-	 *
-	 * See FPM_HEADER_SIZE definition for more information.
-	 */
-	stream_putc(fnc->obuf, 1);
-	stream_putc(fnc->obuf, 1);
-	stream_putw(fnc->obuf, nl_buf_len + FPM_HEADER_SIZE);
+	if (journal)
+		fpm_journal_add(fnc, fpm_hdr, nl_buf, nl_buf_len);
 
-	/* Write current data. */
-	stream_write(fnc->obuf, nl_buf, (size_t)nl_buf_len);
+	if (!live)
+		return 0;
 
-	/* Account number of bytes waiting to be written. */
-	atomic_fetch_add_explicit(&fnc->counters.obuf_bytes,
-				  nl_buf_len + FPM_HEADER_SIZE,
-				  memory_order_relaxed);
-	obytes = atomic_load_explicit(&fnc->counters.obuf_bytes,
-				      memory_order_relaxed);
-	obytes_peak = atomic_load_explicit(&fnc->counters.obuf_peak,
-					   memory_order_relaxed);
-	if (obytes_peak < obytes)
-		atomic_store_explicit(&fnc->counters.obuf_peak, obytes,
-				      memory_order_relaxed);
+	/* Write current data. */
+	fpm_conn_obuf_write(conn, fpm_hdr, FPM_HEADER_SIZE);
+	fpm_conn_obuf_write(conn, nl_buf, nl_buf_len);
 
 	/* Tell the thread to start writing. */
-	event_add_write(fnc->fthread->master, fpm_write, fnc, fnc->socket,
-			&fnc->t_write);
+	event_add_write(fnc->fthread->master, fpm_write, conn, conn->socket,
+			&conn->t_write);
 
 	return 0;
 }
@@ -1149,7 +1744,7 @@ static void fpm_lsp_send(struct event *t)
 	fla.ctx = dplane_ctx_alloc();
 	fla.complete = true;
 
-	hash_walk(zvrf->lsp_table, fpm_lsp_send_cb, &fla);
+	zebra_mpls_lsp_table_walk(zvrf, fpm_lsp_send_cb, &fla);
 
 	dplane_ctx_fini(&fla.ctx);
 
@@ -1209,7 +1804,7 @@ static void fpm_nhg_send(struct event *t)
 	fna.complete = true;
 
 	/* Send next hops. */
-	if (fnc->use_nhg)
+	if (fpm_nl_use_nhg(fnc))
 		hash_walk(zrouter.nhgs_id, fpm_nhg_send_cb, &fna);
 
 	/* `free()` allocated memory. */
@@ -1384,7 +1979,7 @@ static void fpm_lsp_reset(struct event *t)
 	struct fpm_nl_ctx *fnc = EVENT_ARG(t);
 	struct zebra_vrf *zvrf = zebra_vrf_lookup_by_id(VRF_DEFAULT);
 
-	hash_iterate(zvrf->lsp_table, fpm_lsp_reset_cb, NULL);
+	zebra_mpls_lsp_table_iterate(zvrf, fpm_lsp_reset_cb, NULL);
 
 	/* Schedule next step: send LSPs */
 	event_add_event(zrouter.master, fpm_lsp_send, fnc, 0, &fnc->t_lspwalk);
@@ -1447,39 +2042,49 @@ static void fpm_rmac_reset(struct event *t)
 
 static void fpm_process_wedged(struct event *t)
 {
-	struct fpm_nl_ctx *fnc = EVENT_ARG(t);
+	struct fpm_nl_conn *conn = EVENT_ARG(t);
 
-	zlog_warn("%s: Connection unable to write to peer for over %u seconds, resetting",
-		  __func__, DPLANE_FPM_NL_WEDGIE_TIME);
+	zlog_warn("%s: Connection %u unable to write to peer for over %u seconds, resetting",
+		  __func__, conn->idx, DPLANE_FPM_NL_WEDGIE_TIME);
 
-	atomic_fetch_add_explicit(&fnc->counters.connection_errors, 1,
+	atomic_fetch_add_explicit(&conn->fnc->counters.connection_errors, 1,
 				  memory_order_relaxed);
-	FPM_RECONNECT(fnc);
+	FPM_RECONNECT(conn->fnc);
 }
 
+/*
+ * Runs on the connection's encoding pthread: drain its context queue,
+ * encoding each context into the connection's output buffer.
+ */
 static void fpm_process_queue(struct event *t)
 {
-	struct fpm_nl_ctx *fnc = EVENT_ARG(t);
+	struct fpm_nl_conn *conn = EVENT_ARG(t);
+	struct fpm_nl_ctx *fnc = conn->fnc;
 	struct zebra_dplane_ctx *ctx;
 	bool no_bufs = false;
 	uint64_t processed_contexts = 0;
 
 	while (true) {
 		size_t writeable_amount;
-
-		frr_with_mutex (&fnc->obuf_mutex) {
-			writeable_amount = STREAM_WRITEABLE(fnc->obuf);
+		bool connected, journal, live;
+
+		frr_with_mutex (&conn->obuf_mutex) {
+			writeable_amount = STREAM_WRITEABLE(conn->obuf);
+			connected = conn->socket != -1;
+			journal = conn->idx == 0 && fpm_journal_active(fnc);
+			live = connected &&
+			       (!journal || fnc->journal.state == FJS_LIVE);
 		}
 
 		/* No space available yet. */
-		if (writeable_amount < NL_PKT_BUF_SIZE) {
+		if (live && writeable_amount < NL_PKT_BUF_SIZE) {
 			no_bufs = true;
 			break;
 		}
 
 		/* Dequeue next item or quit processing. */
-		frr_with_mutex (&fnc->ctxqueue_mutex) {
-			ctx = dplane_ctx_dequeue(&fnc->ctxqueue);
+		frr_with_mutex (&conn->ctxqueue_mutex) {
+			ctx = dplane_ctx_dequeue(&conn->ctxqueue);
 		}
 		if (ctx == NULL)
 			break;
@@ -1490,11 +2095,13 @@ static void fpm_process_queue(struct event *t)
 		 * the output data in the STREAM_WRITEABLE
 		 * check above, so we can ignore the return
 		 */
-		if (fnc->socket != -1)
+		if (connected || journal)
 			(void)fpm_nl_enqueue(fnc, ctx);
 
 		/* Account the processed entries. */
 		processed_contexts++;
+		atomic_fetch_sub_explicit(&conn->ctxqueue_len, 1,
+					  memory_order_relaxed);
 		atomic_fetch_sub_explicit(&fnc->counters.ctxqueue_len, 1,
 					  memory_order_relaxed);
 
@@ -1503,17 +2110,19 @@ static void fpm_process_queue(struct event *t)
 	}
 
 	/* Update count of processed contexts */
+	atomic_fetch_add_explicit(&conn->dplane_contexts, processed_contexts,
+				  memory_order_relaxed);
 	atomic_fetch_add_explicit(&fnc->counters.dplane_contexts,
 				  processed_contexts, memory_order_relaxed);
 
 	/* Re-schedule if we ran out of buffer space */
 	if (no_bufs) {
-		event_add_event(fnc->fthread->master, fpm_process_queue, fnc, 0,
-				&fnc->t_dequeue);
-		event_add_timer(fnc->fthread->master, fpm_process_wedged, fnc,
-				DPLANE_FPM_NL_WEDGIE_TIME, &fnc->t_wedged);
+		event_add_event(conn->wthread->master, fpm_process_queue, conn,
+				0, &conn->t_dequeue);
+		event_add_timer(conn->wthread->master, fpm_process_wedged, conn,
+				DPLANE_FPM_NL_WEDGIE_TIME, &conn->t_wedged);
 	} else
-		EVENT_OFF(fnc->t_wedged);
+		EVENT_OFF(conn->t_wedged);
 
 	/*
 	 * Let the dataplane thread know if there are items in the
@@ -1525,6 +2134,23 @@ static void fpm_process_queue(struct event *t)
 		dplane_provider_work_ready();
 }
 
+/*
+ * Start the encoding pthread of a connection the first time it is used;
+ * it then stays around until shutdown so that queued contexts always
+ * drain, even after the connection count is lowered.
+ */
+static void fpm_conn_start(struct fpm_nl_conn *conn)
+{
+	char name[16];
+
+	if (conn->wthread)
+		return;
+
+	snprintf(name, sizeof(name), "fpmenc%u", conn->idx);
+	conn->wthread = frr_pthread_new(NULL, name, name);
+	assert(frr_pthread_run(conn->wthread, NULL) == 0);
+}
+
 /**
  * Handles external (e.g. CLI, data plane or others) events.
  */
@@ -1567,6 +2193,19 @@ static void fpm_process_event(struct event *t)
 		fpm_reconnect(fnc);
 		break;
 
+	case FNE_SET_CONNECTIONS:
+		zlog_info("%s: FPM connections changed from %u to %u",
+			  __func__, fpm_nl_conn_count(fnc), fnc->conn_count_cfg);
+		/* Set up new connections before the dplane can pick them */
+		for (unsigned int i = 0; i < fnc->conn_count_cfg; i++)
+			fpm_conn_start(&fnc->conns[i]);
+		atomic_store_explicit(&fnc->conn_count, fnc->conn_count_cfg,
+				      memory_order_release);
+
+		/* Sharding changed: start over on all connections. */
+		fpm_reconnect(fnc);
+		break;
+
 	case FNE_NHG_FINISHED:
 		if (IS_ZEBRA_DEBUG_FPM)
 			zlog_debug("%s: next hop groups walk finished",
@@ -1593,29 +2232,44 @@ static void fpm_process_event(struct event *t)
 static int fpm_nl_start(struct zebra_dplane_provider *prov)
 {
 	struct fpm_nl_ctx *fnc;
+	struct fpm_nl_conn *conn;
+	unsigned int i;
 
 	fnc = dplane_provider_get_data(prov);
 	fnc->fthread = frr_pthread_new(NULL, prov_name, prov_name);
 	assert(frr_pthread_run(fnc->fthread, NULL) == 0);
-	fnc->ibuf = stream_new(NL_PKT_BUF_SIZE);
-	fnc->obuf = stream_new(NL_PKT_BUF_SIZE * 128);
-	pthread_mutex_init(&fnc->obuf_mutex, NULL);
-	fnc->socket = -1;
 	fnc->disabled = true;
 	fnc->prov = prov;
-	dplane_ctx_q_init(&fnc->ctxqueue);
-	pthread_mutex_init(&fnc->ctxqueue_mutex, NULL);
+
+	for (i = 0; i < FPM_NL_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		conn->fnc = fnc;
+		conn->idx = i;
+		conn->socket = -1;
+		conn->ibuf = stream_new(NL_PKT_BUF_SIZE);
+		conn->obuf = stream_new(NL_PKT_BUF_SIZE * 128);
+		pthread_mutex_init(&conn->obuf_mutex, NULL);
+		dplane_ctx_q_init(&conn->ctxqueue);
+		pthread_mutex_init(&conn->ctxqueue_mutex, NULL);
+	}
 
 	/* Set default values. */
 	fnc->use_nhg = true;
 	fnc->use_route_replace = true;
+	fnc->conn_count_cfg = FPM_NL_CONNECTIONS_DEFAULT;
+	fpm_conn_start(&fnc->conns[0]);
+	atomic_store_explicit(&fnc->conn_count, FPM_NL_CONNECTIONS_DEFAULT,
+			      memory_order_release);
 
 	return 0;
 }
 
 static int fpm_nl_finish_early(struct fpm_nl_ctx *fnc)
 {
-	/* Disable all events and close socket. */
+	struct fpm_nl_conn *conn;
+	unsigned int i;
+
+	/* Disable all events and close sockets. */
 	EVENT_OFF(fnc->t_lspreset);
 	EVENT_OFF(fnc->t_lspwalk);
 	EVENT_OFF(fnc->t_nhgreset);
@@ -1626,13 +2280,26 @@ static int fpm_nl_finish_early(struct fpm_nl_ctx *fnc)
 	EVENT_OFF(fnc->t_rmacwalk);
 	EVENT_OFF(fnc->t_event);
 	EVENT_OFF(fnc->t_nhg);
-	event_cancel_async(fnc->fthread->master, &fnc->t_read, NULL);
-	event_cancel_async(fnc->fthread->master, &fnc->t_write, NULL);
-	event_cancel_async(fnc->fthread->master, &fnc->t_connect, NULL);
+	EVENT_OFF(fnc->t_conns);
+	event_cancel_async(fnc->fthread->master, &fnc->journal.t_wait, NULL);
+
+	for (i = 0; i < FPM_NL_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		event_cancel_async(fnc->fthread->master, &conn->t_read, NULL);
+		event_cancel_async(fnc->fthread->master, &conn->t_write, NULL);
+		event_cancel_async(fnc->fthread->master, &conn->t_connect,
+				   NULL);
+		if (conn->wthread) {
+			event_cancel_async(conn->wthread->master,
+					   &conn->t_dequeue, NULL);
+			event_cancel_async(conn->wthread->master,
+					   &conn->t_wedged, NULL);
+		}
 
-	if (fnc->socket != -1) {
-		close(fnc->socket);
-		fnc->socket = -1;
+		if (conn->socket != -1) {
+			close(conn->socket);
+			conn->socket = -1;
+		}
 	}
 
 	return 0;
@@ -1640,14 +2307,27 @@ static int fpm_nl_finish_early(struct fpm_nl_ctx *fnc)
 
 static int fpm_nl_finish_late(struct fpm_nl_ctx *fnc)
 {
-	/* Stop the running thread. */
+	struct fpm_nl_conn *conn;
+	unsigned int i;
+
+	/* Stop the running threads. */
 	frr_pthread_stop(fnc->fthread, NULL);
 
 	/* Free all allocated resources. */
-	pthread_mutex_destroy(&fnc->obuf_mutex);
-	pthread_mutex_destroy(&fnc->ctxqueue_mutex);
-	stream_free(fnc->ibuf);
-	stream_free(fnc->obuf);
+	fpm_journal_resize(fnc, 0);
+	for (i = 0; i < FPM_NL_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		if (conn->wthread) {
+			frr_pthread_stop(conn->wthread, NULL);
+			frr_pthread_destroy(conn->wthread);
+			conn->wthread = NULL;
+		}
+
+		pthread_mutex_destroy(&conn->obuf_mutex);
+		pthread_mutex_destroy(&conn->ctxqueue_mutex);
+		stream_free(conn->ibuf);
+		stream_free(conn->obuf);
+	}
 	free(gfnc);
 	gfnc = NULL;
 
@@ -1669,6 +2349,8 @@ static int fpm_nl_process(struct zebra_dplane_provider *prov)
 {
 	struct zebra_dplane_ctx *ctx;
 	struct fpm_nl_ctx *fnc;
+	struct fpm_nl_conn *conn;
+	unsigned int i;
 	int counter, limit;
 	uint64_t cur_queue, peak_queue = 0, stored_peak_queue;
 
@@ -1681,18 +2363,22 @@ static int fpm_nl_process(struct zebra_dplane_provider *prov)
 
 		/*
 		 * Skip all notifications if not connected, we'll walk the RIB
-		 * anyway.
+		 * anyway.  The journal however must see every change.
 		 */
-		if (fnc->socket != -1 && fnc->connecting == false) {
+		if (fpm_nl_connected(fnc) || fpm_journal_active(fnc)) {
+			conn = fpm_nl_conn_select(fnc, ctx);
+
 			/*
 			 * Update the number of queued contexts *before*
 			 * enqueueing, to ensure counter consistency.
 			 */
+			atomic_fetch_add_explicit(&conn->ctxqueue_len, 1,
+						  memory_order_relaxed);
 			atomic_fetch_add_explicit(&fnc->counters.ctxqueue_len,
 						  1, memory_order_relaxed);
 
-			frr_with_mutex (&fnc->ctxqueue_mutex) {
-				dplane_ctx_enqueue_tail(&fnc->ctxqueue, ctx);
+			frr_with_mutex (&conn->ctxqueue_mutex) {
+				dplane_ctx_enqueue_tail(&conn->ctxqueue, ctx);
 			}
 
 			cur_queue = atomic_load_explicit(
@@ -1714,11 +2400,21 @@ static int fpm_nl_process(struct zebra_dplane_provider *prov)
 		atomic_store_explicit(&fnc->counters.ctxqueue_len_peak,
 				      peak_queue, memory_order_relaxed);
 
-	if (atomic_load_explicit(&fnc->counters.ctxqueue_len,
-				 memory_order_relaxed)
-	    > 0)
-		event_add_event(fnc->fthread->master, fpm_process_queue, fnc, 0,
-				&fnc->t_dequeue);
+	/*
+	 * Kick every encoder with pending work, including connections
+	 * above the current count that still hold contexts from before
+	 * the count was lowered.
+	 */
+	for (i = 0; i < FPM_NL_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		if (conn->wthread == NULL)
+			continue;
+		if (atomic_load_explicit(&conn->ctxqueue_len,
+					 memory_order_relaxed) > 0)
+			event_add_event(conn->wthread->master,
+					fpm_process_queue, conn, 0,
+					&conn->t_dequeue);
+	}
 
 	/* Ensure dataplane thread is rescheduled if we hit the work limit */
 	if (counter >= limit)
@@ -1752,6 +2448,8 @@ static int fpm_nl_new(struct event_loop *tm)
 	install_element(CONFIG_NODE, &no_fpm_use_nhg_cmd);
 	install_element(CONFIG_NODE, &fpm_use_route_replace_cmd);
 	install_element(CONFIG_NODE, &no_fpm_use_route_replace_cmd);
+	install_element(CONFIG_NODE, &fpm_connections_cmd);
+	install_element(CONFIG_NODE, &fpm_journal_size_cmd);
 
 	return 0;
 }
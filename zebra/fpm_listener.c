@@ -28,6 +28,8 @@
 #include <assert.h>
 #include <err.h>
 #include <sys/types.h>
+#include <pthread.h>
+#include <time.h>
 
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
@@ -40,6 +42,21 @@ struct glob {
 	int server_sock;
 	int sock;
 	bool reflect;
+
+	/*
+	 * Incremental resync: remember the journal epoch and last sequence
+	 * applied, and report them to zebra on every new connection.
+	 */
+	bool resync;
+	uint32_t resync_epoch;
+	uint32_t resync_seq;
+
+	/* Benchmark mode: count messages instead of decoding them. */
+	bool benchmark;
+	unsigned int interval;
+	_Atomic uint64_t bench_msgs;
+	_Atomic uint64_t bench_bytes;
+	_Atomic unsigned int bench_conns;
 };
 
 struct glob glob_space;
@@ -137,7 +154,7 @@ static int accept_conn(int listen_sock)
  * read_fpm_msg
  */
 static fpm_msg_hdr_t *
-read_fpm_msg(char *buf, size_t buf_len)
+read_fpm_msg(int sock, char *buf, size_t buf_len)
 {
 	char *cur, *end;
 	long need_len, bytes_read, have_len;
@@ -165,7 +182,7 @@ read_fpm_msg(char *buf, size_t buf_len)
 			reading_full_msg = 1;
 		}
 
-		bytes_read = read(glob->sock, cur, need_len);
+		bytes_read = read(sock, cur, need_len);
 
 		if (bytes_read == 0) {
 			fprintf(stdout,
@@ -587,6 +604,11 @@ static void parse_netlink_msg(char *buf, size_t buf_len, fpm_msg_hdr_t *fpm)
 		netlink_msg_ctx_init(ctx);
 		ctx->hdr = (struct nlmsghdr *)buf;
 
+		if (glob->resync && hdr->nlmsg_seq) {
+			glob->resync_epoch = hdr->nlmsg_pid;
+			glob->resync_seq = hdr->nlmsg_seq;
+		}
+
 		switch (hdr->nlmsg_type) {
 
 		case RTM_DELROUTE:
@@ -637,6 +659,36 @@ static void process_fpm_msg(fpm_msg_hdr_t *hdr)
 	parse_netlink_msg(fpm_msg_data(hdr), fpm_msg_data_len(hdr), hdr);
 }
 
+/*
+ * send_resync_request
+ *
+ * Ask zebra to only replay the messages after the last one we applied.
+ */
+static void send_resync_request(void)
+{
+	struct {
+		fpm_msg_hdr_t fpm;
+		struct nlmsghdr n;
+		struct rtmsg r;
+	} __attribute__((packed)) req;
+
+	memset(&req, 0, sizeof(req));
+	req.fpm.version = FPM_PROTO_VERSION;
+	req.fpm.msg_type = FPM_MSG_TYPE_NETLINK;
+	req.fpm.msg_len = htons(sizeof(req));
+	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(req.r));
+	req.n.nlmsg_type = RTM_GETROUTE;
+	req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.n.nlmsg_seq = glob->resync_seq;
+	req.n.nlmsg_pid = glob->resync_epoch;
+
+	fprintf(stdout, "Requesting resync after sequence %u (epoch %u)\n",
+		glob->resync_seq, glob->resync_epoch);
+	if (write(glob->sock, &req, sizeof(req)) != sizeof(req))
+		fprintf(stderr, "Failed to send resync request: %s\n",
+			strerror(errno));
+}
+
 /*
  * fpm_serve
  */
@@ -645,9 +697,12 @@ static void fpm_serve(void)
 	char buf[FPM_MAX_MSG_LEN * 4];
 	fpm_msg_hdr_t *hdr;
 
+	if (glob->resync)
+		send_resync_request();
+
 	while (1) {
 
-		hdr = read_fpm_msg(buf, sizeof(buf));
+		hdr = read_fpm_msg(glob->sock, buf, sizeof(buf));
 		if (!hdr)
 			return;
 
@@ -655,6 +710,114 @@ static void fpm_serve(void)
 	}
 }
 
+/*
+ * fpm_bench_serve
+ *
+ * Benchmark mode connection handler: zebra may open several FPM
+ * connections, each one is drained by its own thread and only the
+ * number of netlink messages and bytes received is accounted.
+ */
+static void *fpm_bench_serve(void *arg)
+{
+	int sock = (intptr_t)arg;
+	char buf[FPM_MAX_MSG_LEN * 4];
+	size_t have = 0, pos, msg_len, len;
+	fpm_msg_hdr_t *fpm;
+	struct nlmsghdr *hdr;
+	ssize_t nread;
+
+	atomic_fetch_add(&glob->bench_conns, 1);
+	while (1) {
+		/* TCP hands out whatever has arrived, messages may be split */
+		nread = read(sock, buf + have, sizeof(buf) - have);
+		if (nread < 0 && errno == EINTR)
+			continue;
+		if (nread <= 0)
+			break;
+		have += nread;
+
+		for (pos = 0; have - pos >= FPM_MSG_HDR_LEN; pos += msg_len) {
+			fpm = (fpm_msg_hdr_t *)(buf + pos);
+			msg_len = fpm_msg_len(fpm);
+			if (!fpm_msg_hdr_ok(fpm)) {
+				fprintf(stderr, "Malformed fpm message\n");
+				goto out;
+			}
+
+			/* rest of the message is still on its way */
+			if (msg_len > have - pos)
+				break;
+
+			atomic_fetch_add(&glob->bench_bytes, msg_len);
+			if (fpm->msg_type != FPM_MSG_TYPE_NETLINK)
+				continue;
+
+			len = fpm_msg_data_len(fpm);
+			for (hdr = (struct nlmsghdr *)fpm_msg_data(fpm);
+			     NLMSG_OK(hdr, len); hdr = NLMSG_NEXT(hdr, len))
+				atomic_fetch_add(&glob->bench_msgs, 1);
+		}
+
+		have -= pos;
+		memmove(buf, buf + pos, have);
+	}
+out:
+	atomic_fetch_sub(&glob->bench_conns, 1);
+
+	close(sock);
+	return NULL;
+}
+
+/*
+ * fpm_bench_report
+ *
+ * Prints the message rate observed over each interval.
+ */
+static void *fpm_bench_report(void *arg)
+{
+	uint64_t msgs, bytes, last_msgs = 0, last_bytes = 0;
+
+	while (1) {
+		sleep(glob->interval);
+
+		msgs = atomic_load(&glob->bench_msgs);
+		bytes = atomic_load(&glob->bench_bytes);
+		fprintf(stdout,
+			"connections %u, messages %" PRIu64 " (%.0f msgs/s, %.2f MB/s)\n",
+			atomic_load(&glob->bench_conns), msgs,
+			(double)(msgs - last_msgs) / glob->interval,
+			(double)(bytes - last_bytes) / glob->interval /
+				(1024 * 1024));
+		fflush(stdout);
+		last_msgs = msgs;
+		last_bytes = bytes;
+	}
+
+	return NULL;
+}
+
+static void fpm_bench_run(void)
+{
+	pthread_t thread;
+	int sock;
+
+	if (pthread_create(&thread, NULL, fpm_bench_report, NULL))
+		err(1, "pthread_create");
+	pthread_detach(thread);
+
+	while (1) {
+		sock = accept_conn(glob->server_sock);
+		if (pthread_create(&thread, NULL, fpm_bench_serve,
+				   (void *)(intptr_t)sock)) {
+			fprintf(stderr, "Failed to create thread: %s\n",
+				strerror(errno));
+			close(sock);
+			continue;
+		}
+		pthread_detach(thread);
+	}
+}
+
 int main(int argc, char **argv)
 {
 	pid_t daemon;
@@ -662,8 +825,9 @@ int main(int argc, char **argv)
 	bool fork_daemon = false;
 
 	memset(glob, 0, sizeof(*glob));
+	glob->interval = 1;
 
-	while ((r = getopt(argc, argv, "rd")) != -1) {
+	while ((r = getopt(argc, argv, "rdbi:s")) != -1) {
 		switch (r) {
 		case 'r':
 			glob->reflect = true;
@@ -671,9 +835,25 @@ int main(int argc, char **argv)
 		case 'd':
 			fork_daemon = true;
 			break;
+		case 'b':
+			glob->benchmark = true;
+			break;
+		case 's':
+			glob->resync = true;
+			break;
+		case 'i':
+			glob->interval = strtoul(optarg, NULL, 10);
+			if (glob->interval == 0)
+				glob->interval = 1;
+			break;
 		}
 	}
 
+	if (glob->benchmark && glob->reflect) {
+		fprintf(stderr, "Reflection is not supported in benchmark mode\n");
+		exit(1);
+	}
+
 	if (fork_daemon) {
 		daemon = fork();
 
@@ -684,6 +864,9 @@ int main(int argc, char **argv)
 	if (!create_listen_sock(FPM_DEFAULT_PORT, &glob->server_sock))
 		exit(1);
 
+	if (glob->benchmark)
+		fpm_bench_run();
+
 	/*
 	 * Server forever.
 	 */
@@ -285,20 +285,24 @@ struct interface *if_lookup_by_index_per_ns(struct zebra_ns *ns,
 	return ifp;
 }
 
-/* Look up an interface by name within a NS */
+/*
+ * Look up an interface by name within a NS.  Names are unique system wide
+ * with VRF-lite, with netns VRFs each NS is a VRF of the same id; either
+ * way the lib name hash finds the interface without walking the NS.
+ */
 struct interface *if_lookup_by_name_per_ns(struct zebra_ns *ns,
 					   const char *ifname)
 {
-	struct route_node *rn;
 	struct interface *ifp;
 
-	for (rn = route_top(ns->if_table); rn; rn = route_next(rn)) {
-		ifp = (struct interface *)rn->info;
-		if (ifp && strcmp(ifp->name, ifname) == 0) {
-			route_unlock_node(rn);
-			return (ifp);
-		}
-	}
+	if (vrf_is_backend_netns())
+		ifp = if_lookup_by_name(ifname, (vrf_id_t)ns->ns_id);
+	else
+		ifp = if_lookup_by_name_all_vrf(ifname);
+
+	/* Only interfaces the NS knows about by ifindex */
+	if (ifp && ifp->node && ifp->node->table == ns->if_table)
+		return ifp;
 
 	return NULL;
 }
@@ -26,6 +26,7 @@
 #include "mpls.h"
 #include "lib_errors.h"
 #include "hash.h"
+#include "json.h"
 
 #include "zebra/zebra_router.h"
 #include "zebra/zebra_ns.h"
@@ -40,6 +41,7 @@
 #include "zebra/netconf_netlink.h"
 #include "zebra/zebra_errors.h"
 #include "zebra/ge_netlink.h"
+#include "zebra/zebra_dplane.h"
 
 #ifndef SO_RCVBUFFORCE
 #define SO_RCVBUFFORCE  (33)
@@ -81,6 +83,38 @@
  */
 #define NL_DEFAULT_BATCH_SEND_THRESHOLD (15 * NL_PKT_BUF_SIZE)
 
+/*
+ * Batches are sent back to back without reading the acknowledgments in
+ * between. The kernel handles rtnetlink requests synchronously in sendmsg(),
+ * so the ACKs of the batches in flight simply queue up in the socket's
+ * receive buffer until they are drained. Every outstanding message is
+ * accounted with NL_BATCH_ACK_TRUESIZE bytes of that buffer, and the ACKs
+ * are drained well before it could overflow.
+ */
+#define NL_DEFAULT_BATCH_INFLIGHT 4
+#define NL_BATCH_INFLIGHT_MAX 16
+#define NL_BATCH_ACK_TRUESIZE 1024
+
+/*
+ * Adaptive batch sizing: the send threshold moves between
+ * NL_BATCH_ADAPT_MIN and the configured threshold. It is halved when the
+ * average ACK latency goes over NL_BATCH_ADAPT_TARGET_USEC per batch in
+ * flight, or when more than NL_BATCH_ADAPT_ERR_PCT percent of a batch
+ * failed, and grows by NL_BATCH_ADAPT_STEP otherwise.
+ */
+#define NL_BATCH_ADAPT_MIN NL_PKT_BUF_SIZE
+#define NL_BATCH_ADAPT_STEP NL_PKT_BUF_SIZE
+#define NL_BATCH_ADAPT_TARGET_USEC 10000
+#define NL_BATCH_ADAPT_ERR_PCT 10
+
+/*
+ * ACK latency histogram, bucket 0 counts batches acknowledged within
+ * NL_BATCH_HIST_BASE_USEC, every following bucket doubles that, and the last
+ * one counts everything slower.
+ */
+#define NL_BATCH_HIST_BUCKETS 16
+#define NL_BATCH_HIST_BASE_USEC 32
+
 static const struct message nlmsg_str[] = {
 	{ RTM_NEWROUTE, "RTM_NEWROUTE" },
 	{ RTM_DELROUTE, "RTM_DELROUTE" },
@@ -188,6 +222,41 @@ char *nl_batch_tx_buf;
 
 _Atomic uint32_t nl_batch_bufsize = NL_DEFAULT_BATCH_BUFSIZE;
 _Atomic uint32_t nl_batch_send_threshold = NL_DEFAULT_BATCH_SEND_THRESHOLD;
+_Atomic uint32_t nl_batch_inflight = NL_DEFAULT_BATCH_INFLIGHT;
+_Atomic bool nl_batch_adaptive = true;
+
+/*
+ * Batch statistics, updated by the dataplane pthread and read by the vty.
+ */
+static struct nl_batch_stats {
+	_Atomic uint64_t batches;
+	_Atomic uint64_t msgs;
+	_Atomic uint64_t bytes;
+	_Atomic uint64_t errors;
+	_Atomic uint64_t drains;
+
+	/* Time spent with batches in flight, used for the throughput. */
+	_Atomic uint64_t busy_usecs;
+
+	/* Moving average of the ACK latency. */
+	_Atomic uint32_t latency_avg;
+	_Atomic uint32_t latency_max;
+
+	/* Current adaptive send threshold, 0 until the first batch. */
+	_Atomic uint32_t limit;
+	_Atomic uint32_t inflight_max;
+
+	_Atomic uint64_t hist[NL_BATCH_HIST_BUCKETS];
+} nl_batch_stats;
+
+/* A batch which was sent and whose ACKs were not read yet. */
+struct nl_batch_sent {
+	struct timeval sent;
+	int last_seq;
+	size_t msgcnt;
+	size_t bytes;
+	size_t errors;
+};
 
 struct nl_batch {
 	void *buf;
@@ -197,11 +266,29 @@ struct nl_batch {
 	void *buf_head;
 	size_t curlen;
 	size_t msgcnt;
+	int last_seq;
 
 	const struct zebra_dplane_info *zns;
 
 	struct dplane_ctx_list_head ctx_list;
 
+	/* Contexts of the batches in flight, in the order they were sent. */
+	struct dplane_ctx_list_head inflight_list;
+	struct nlsock *inflight_nl;
+	bool inflight_is_cmd;
+	ns_id_t inflight_ns_id;
+	size_t inflight_msgs;
+	struct timeval inflight_start;
+
+	struct nl_batch_sent sent[NL_BATCH_INFLIGHT_MAX];
+	unsigned int sent_head;
+	unsigned int sent_cnt;
+
+	/* Configuration snapshot taken by nl_batch_init(). */
+	size_t limit_max;
+	unsigned int inflight_cfg;
+	bool adaptive;
+
 	/*
 	 * Pointer to the queue of completed contexts outbound back
 	 * towards the dataplane module.
@@ -215,12 +302,21 @@ int netlink_config_write_helper(struct vty *vty)
 		atomic_load_explicit(&nl_batch_bufsize, memory_order_relaxed);
 	uint32_t threshold = atomic_load_explicit(&nl_batch_send_threshold,
 						  memory_order_relaxed);
+	uint32_t inflight =
+		atomic_load_explicit(&nl_batch_inflight, memory_order_relaxed);
 
 	if (size != NL_DEFAULT_BATCH_BUFSIZE
 	    || threshold != NL_DEFAULT_BATCH_SEND_THRESHOLD)
 		vty_out(vty, "zebra kernel netlink batch-tx-buf %u %u\n", size,
 			threshold);
 
+	if (inflight != NL_DEFAULT_BATCH_INFLIGHT)
+		vty_out(vty, "zebra kernel netlink batch-inflight %u\n",
+			inflight);
+
+	if (!atomic_load_explicit(&nl_batch_adaptive, memory_order_relaxed))
+		vty_out(vty, "no zebra kernel netlink batch-adaptive\n");
+
 	if (if_netlink_frr_protodown_r_bit_is_set())
 		vty_out(vty, "zebra protodown reason-bit %u\n",
 			if_netlink_get_frr_protodown_r_bit());
@@ -240,6 +336,119 @@ void netlink_set_batch_buffer_size(uint32_t size, uint32_t threshold, bool set)
 			      memory_order_relaxed);
 }
 
+void netlink_set_batch_inflight(uint32_t inflight, bool set)
+{
+	if (!set)
+		inflight = NL_DEFAULT_BATCH_INFLIGHT;
+
+	atomic_store_explicit(&nl_batch_inflight, inflight,
+			      memory_order_relaxed);
+}
+
+void netlink_set_batch_adaptive(bool adaptive)
+{
+	atomic_store_explicit(&nl_batch_adaptive, adaptive,
+			      memory_order_relaxed);
+}
+
+static uint64_t nl_batch_hist_bound(unsigned int bucket)
+{
+	return (uint64_t)NL_BATCH_HIST_BASE_USEC << bucket;
+}
+
+int netlink_batch_show_helper(struct vty *vty, bool use_json)
+{
+	struct nl_batch_stats *st = &nl_batch_stats;
+	uint64_t batches, msgs, bytes, errors, drains, busy, hist, rate;
+	uint32_t limit, threshold, avg, max, inflight, inflight_max;
+	bool adaptive;
+	json_object *json = NULL, *json_hist = NULL;
+	char label[32];
+	unsigned int i;
+
+	batches = atomic_load_explicit(&st->batches, memory_order_relaxed);
+	msgs = atomic_load_explicit(&st->msgs, memory_order_relaxed);
+	bytes = atomic_load_explicit(&st->bytes, memory_order_relaxed);
+	errors = atomic_load_explicit(&st->errors, memory_order_relaxed);
+	drains = atomic_load_explicit(&st->drains, memory_order_relaxed);
+	busy = atomic_load_explicit(&st->busy_usecs, memory_order_relaxed);
+	avg = atomic_load_explicit(&st->latency_avg, memory_order_relaxed);
+	max = atomic_load_explicit(&st->latency_max, memory_order_relaxed);
+	inflight_max =
+		atomic_load_explicit(&st->inflight_max, memory_order_relaxed);
+	threshold = atomic_load_explicit(&nl_batch_send_threshold,
+					 memory_order_relaxed);
+	inflight =
+		atomic_load_explicit(&nl_batch_inflight, memory_order_relaxed);
+	adaptive =
+		atomic_load_explicit(&nl_batch_adaptive, memory_order_relaxed);
+	limit = atomic_load_explicit(&st->limit, memory_order_relaxed);
+	if (limit == 0 || !adaptive)
+		limit = threshold;
+
+	rate = busy ? msgs * 1000000 / busy : 0;
+
+	if (use_json) {
+		json = json_object_new_object();
+		json_hist = json_object_new_object();
+
+		json_object_int_add(json, "sendThreshold", limit);
+		json_object_int_add(json, "sendThresholdConfigured", threshold);
+		json_object_boolean_add(json, "adaptive", adaptive);
+		json_object_int_add(json, "inflightLimit", inflight);
+		json_object_int_add(json, "inflightMax", inflight_max);
+		json_object_int_add(json, "batches", batches);
+		json_object_int_add(json, "messages", msgs);
+		json_object_int_add(json, "bytes", bytes);
+		json_object_int_add(json, "errors", errors);
+		json_object_int_add(json, "drains", drains);
+		json_object_int_add(json, "latencyAvgUsec", avg);
+		json_object_int_add(json, "latencyMaxUsec", max);
+		json_object_int_add(json, "messagesPerSec", rate);
+		json_object_object_add(json, "latencyHistogram", json_hist);
+	} else {
+		vty_out(vty, "Netlink batches:\n");
+		vty_out(vty, "  Send threshold: %u (configured %u, %s)\n", limit,
+			threshold, adaptive ? "adaptive" : "static");
+		vty_out(vty, "  In flight limit: %u, max seen: %u\n", inflight,
+			inflight_max);
+		vty_out(vty,
+			"  Batches: %" PRIu64 ", messages: %" PRIu64
+			", bytes: %" PRIu64 ", errors: %" PRIu64 "\n",
+			batches, msgs, bytes, errors);
+		vty_out(vty, "  ACK drains: %" PRIu64 "\n", drains);
+		vty_out(vty, "  ACK latency: avg %u usecs, max %u usecs\n", avg,
+			max);
+		vty_out(vty, "  Throughput: %" PRIu64 " messages/sec\n", rate);
+		vty_out(vty, "ACK latency histogram (usecs):\n");
+	}
+
+	for (i = 0; i < NL_BATCH_HIST_BUCKETS; i++) {
+		hist = atomic_load_explicit(&st->hist[i], memory_order_relaxed);
+
+		if (i == 0)
+			snprintf(label, sizeof(label), "<%" PRIu64,
+				 nl_batch_hist_bound(0));
+		else if (i == NL_BATCH_HIST_BUCKETS - 1)
+			snprintf(label, sizeof(label), ">=%" PRIu64,
+				 nl_batch_hist_bound(i - 1));
+		else
+			snprintf(label, sizeof(label), "%" PRIu64 "-%" PRIu64,
+				 nl_batch_hist_bound(i - 1),
+				 nl_batch_hist_bound(i) - 1);
+
+		if (json)
+			json_object_int_add(json_hist, label, hist);
+		else if (hist)
+			vty_out(vty, "  %-16s %" PRIu64 "\n", label, hist);
+	}
+
+	if (json)
+		vty_json(vty, json);
+
+	return CMD_SUCCESS;
+}
+
 int netlink_talk_filter(struct nlmsghdr *h, ns_id_t ns_id, int startup)
 {
 	/*
@@ -1055,22 +1264,11 @@ static int netlink_parse_error(const struct nlsock *nl, struct nlmsghdr *h,
 	return -1;
 }
 
-/*
- * netlink_parse_info
- *
- * Receive message from netlink interface and pass those information
- *  to the given function.
- *
- * filter  -> Function to call to read the results
- * nl      -> netlink socket information
- * zns     -> The zebra namespace data
- * count   -> How many we should read in, 0 means as much as possible
- * startup -> Are we reading in under startup conditions? passed to
- *            the filter.
- */
-int netlink_parse_info(int (*filter)(struct nlmsghdr *, ns_id_t, int),
-		       struct nlsock *nl, const struct zebra_dplane_info *zns,
-		       int count, bool startup)
+/* Worker of netlink_parse_info() */
+static int netlink_parse_msgs(int (*filter)(struct nlmsghdr *, ns_id_t, int),
+			      struct nlsock *nl,
+			      const struct zebra_dplane_info *zns, int count,
+			      bool startup)
 {
 	int status;
 	int ret = 0;
@@ -1168,6 +1366,36 @@ int netlink_parse_info(int (*filter)(struct nlmsghdr *, ns_id_t, int),
 	return ret;
 }
 
+/*
+ * netlink_parse_info
+ *
+ * Receive message from netlink interface and pass those information
+ *  to the given function.
+ *
+ * filter  -> Function to call to read the results
+ * nl      -> netlink socket information
+ * zns     -> The zebra namespace data
+ * count   -> How many we should read in, 0 means as much as possible
+ * startup -> Are we reading in under startup conditions? passed to
+ *            the filter.
+ */
+int netlink_parse_info(int (*filter)(struct nlmsghdr *, ns_id_t, int),
+		       struct nlsock *nl, const struct zebra_dplane_info *zns,
+		       int count, bool startup)
+{
+	int ret;
+
+	/*
+	 * Interface and address messages are handed to zebra main as
+	 * contexts, pass on everything read here in one go.
+	 */
+	dplane_zebra_batch_begin();
+	ret = netlink_parse_msgs(filter, nl, zns, count, startup);
+	dplane_zebra_batch_end();
+
+	return ret;
+}
+
 /*
  * netlink_talk_info
  *
@@ -1280,6 +1508,108 @@ int netlink_request(struct nlsock *nl, void *req)
 	return 0;
 }
 
+static unsigned int nl_batch_hist_bucket(int64_t usecs)
+{
+	unsigned int bucket = 0;
+	uint64_t v = usecs / NL_BATCH_HIST_BASE_USEC;
+
+	while (v && bucket < NL_BATCH_HIST_BUCKETS - 1) {
+		v >>= 1;
+		bucket++;
+	}
+
+	return bucket;
+}
+
+/*
+ * Adjust the send threshold after a batch was acknowledged. The latency
+ * target scales with the number of batches allowed in flight, as a batch's
+ * ACKs are only read once the following ones were sent.
+ */
+static void nl_batch_adapt(struct nl_batch *bth,
+			   const struct nl_batch_sent *sent, uint32_t avg)
+{
+	size_t limit = bth->limit;
+	size_t floor = MIN(NL_BATCH_ADAPT_MIN, bth->limit_max);
+
+	if (!bth->adaptive)
+		return;
+
+	if (avg > (uint32_t)NL_BATCH_ADAPT_TARGET_USEC * bth->inflight_cfg ||
+	    sent->errors * 100 > sent->msgcnt * NL_BATCH_ADAPT_ERR_PCT)
+		limit = MAX(limit / 2, floor);
+	else
+		limit = MIN(limit + NL_BATCH_ADAPT_STEP, bth->limit_max);
+
+	if (limit != bth->limit && IS_ZEBRA_DEBUG_KERNEL)
+		zlog_debug("%s: send threshold %zu -> %zu (avg latency %u usecs, %zu/%zu errors)",
+			   __func__, bth->limit, limit, avg, sent->errors,
+			   sent->msgcnt);
+
+	bth->limit = limit;
+	atomic_store_explicit(&nl_batch_stats.limit, limit,
+			      memory_order_relaxed);
+}
+
+/* All ACKs of the oldest batch in flight were read. */
+static void nl_batch_sent_done(struct nl_batch *bth)
+{
+	struct nl_batch_stats *st = &nl_batch_stats;
+	struct nl_batch_sent *sent = &bth->sent[bth->sent_head];
+	int64_t usecs = monotime_since(&sent->sent, NULL);
+	uint32_t avg, max;
+
+	atomic_fetch_add_explicit(&st->batches, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&st->msgs, sent->msgcnt,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&st->bytes, sent->bytes,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&st->errors, sent->errors,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&st->hist[nl_batch_hist_bucket(usecs)], 1,
+				  memory_order_relaxed);
+
+	avg = atomic_load_explicit(&st->latency_avg, memory_order_relaxed);
+	avg = avg ? (7 * (uint64_t)avg + usecs) / 8 : usecs;
+	atomic_store_explicit(&st->latency_avg, avg, memory_order_relaxed);
+
+	max = atomic_load_explicit(&st->latency_max, memory_order_relaxed);
+	if (usecs > max)
+		atomic_store_explicit(&st->latency_max, usecs,
+				      memory_order_relaxed);
+
+	nl_batch_adapt(bth, sent, avg);
+
+	bth->sent_head = (bth->sent_head + 1) % NL_BATCH_INFLIGHT_MAX;
+	bth->sent_cnt--;
+}
+
+/*
+ * Account a response with sequence number 'seq'. Responses arrive in the
+ * order the messages were sent, so every batch in flight ending before 'seq'
+ * is complete.
+ */
+static void nl_batch_ack(struct nl_batch *bth, int seq, bool failed)
+{
+	struct nl_batch_sent *sent = NULL;
+
+	while (bth->sent_cnt) {
+		sent = &bth->sent[bth->sent_head];
+		if (sent->last_seq >= seq)
+			break;
+		nl_batch_sent_done(bth);
+	}
+
+	if (!bth->sent_cnt)
+		return;
+
+	if (failed)
+		sent->errors++;
+
+	if (sent->last_seq == seq)
+		nl_batch_sent_done(bth);
+}
+
 static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 {
 	struct nlmsghdr *h;
@@ -1307,7 +1637,7 @@ static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 		 *
 		 */
 		if (status == -1 || status == 0) {
-			while ((ctx = dplane_ctx_dequeue(&(bth->ctx_list))) !=
+			while ((ctx = dplane_ctx_dequeue(&(bth->inflight_list))) !=
 			       NULL) {
 				if (status == -1)
 					dplane_ctx_set_status(
@@ -1315,6 +1645,8 @@ static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 						ZEBRA_DPLANE_REQUEST_FAILURE);
 				dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
 			}
+			while (bth->sent_cnt)
+				nl_batch_sent_done(bth);
 			return status;
 		}
 
@@ -1328,7 +1660,7 @@ static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 		 * requests at same time.
 		 */
 		while (true) {
-			ctx = dplane_ctx_get_head(&(bth->ctx_list));
+			ctx = dplane_ctx_get_head(&(bth->inflight_list));
 			if (ctx == NULL) {
 				/*
 				 * This is a situation where we have gotten
@@ -1355,7 +1687,7 @@ static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 				break;
 			}
 
-			ctx = dplane_ctx_dequeue(&(bth->ctx_list));
+			ctx = dplane_ctx_dequeue(&(bth->inflight_list));
 			dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
 
 			/* We have found corresponding context object. */
@@ -1376,11 +1708,12 @@ static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 			 * message for our operator to understand
 			 * what is going on
 			 */
-			int err = netlink_parse_error(nl, h, bth->zns->is_cmd,
+			int err = netlink_parse_error(nl, h, bth->inflight_is_cmd,
 						      false);
 
 			zlog_debug("%s: netlink error message seq=%d %d",
 				   __func__, h->nlmsg_seq, err);
+			nl_batch_ack(bth, seq, false);
 			continue;
 		}
 
@@ -1393,17 +1726,18 @@ static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 				zlog_debug(
 					"%s: skipping unassociated response, seq number %d NS %u",
 					__func__, h->nlmsg_seq,
-					bth->zns->ns_id);
+					bth->inflight_ns_id);
 			continue;
 		}
 
 		if (h->nlmsg_type == NLMSG_ERROR) {
-			int err = netlink_parse_error(nl, h, bth->zns->is_cmd,
+			int err = netlink_parse_error(nl, h, bth->inflight_is_cmd,
 						      false);
 
 			if (err == -1)
 				dplane_ctx_set_status(
 					ctx, ZEBRA_DPLANE_REQUEST_FAILURE);
+			nl_batch_ack(bth, seq, err == -1);
 
 			if (IS_ZEBRA_DEBUG_KERNEL)
 				zlog_debug("%s: netlink error message seq=%d ",
@@ -1420,7 +1754,7 @@ static int nl_batch_read_resp(struct nl_batch *bth, struct nlsock *nl)
 			zlog_debug("%s: ignoring message type 0x%04x(%s) NS %u",
 				   __func__, h->nlmsg_type,
 				   nl_msg_type_to_str(h->nlmsg_type),
-				   bth->zns->ns_id);
+				   bth->inflight_ns_id);
 	}
 
 	return 0;
@@ -1431,6 +1765,7 @@ static void nl_batch_reset(struct nl_batch *bth)
 	bth->buf_head = bth->buf;
 	bth->curlen = 0;
 	bth->msgcnt = 0;
+	bth->last_seq = 0;
 	bth->zns = NULL;
 
 	dplane_ctx_q_init(&(bth->ctx_list));
@@ -1439,6 +1774,8 @@ static void nl_batch_reset(struct nl_batch *bth)
 static void nl_batch_init(struct nl_batch *bth,
 			  struct dplane_ctx_list_head *ctx_out_q)
 {
+	uint32_t limit;
+
 	/*
 	 * If the size of the buffer has changed, free and then allocate a new
 	 * one.
@@ -1455,38 +1792,118 @@ static void nl_batch_init(struct nl_batch *bth,
 
 	bth->buf = nl_batch_tx_buf;
 	bth->bufsiz = bufsize;
-	bth->limit = atomic_load_explicit(&nl_batch_send_threshold,
-					  memory_order_relaxed);
+	bth->limit_max = atomic_load_explicit(&nl_batch_send_threshold,
+					      memory_order_relaxed);
+	bth->inflight_cfg = atomic_load_explicit(&nl_batch_inflight,
+						 memory_order_relaxed);
+	bth->adaptive = atomic_load_explicit(&nl_batch_adaptive,
+					     memory_order_relaxed);
+
+	/* Carry the adapted threshold over from the previous run. */
+	limit = atomic_load_explicit(&nl_batch_stats.limit,
+				     memory_order_relaxed);
+	if (bth->adaptive && limit != 0)
+		bth->limit = MIN(limit, bth->limit_max);
+	else
+		bth->limit = bth->limit_max;
 
 	bth->ctx_out_q = ctx_out_q;
 
+	dplane_ctx_q_init(&(bth->inflight_list));
+	bth->inflight_nl = NULL;
+	bth->inflight_msgs = 0;
+	bth->sent_head = 0;
+	bth->sent_cnt = 0;
+
 	nl_batch_reset(bth);
 }
 
+/*
+ * Read the ACKs of all the batches in flight and hand their contexts back to
+ * the dataplane.
+ */
+static void nl_batch_drain(struct nl_batch *bth)
+{
+	struct zebra_dplane_ctx *ctx;
+
+	if (bth->inflight_nl) {
+		nl_batch_read_resp(bth, bth->inflight_nl);
+
+		atomic_fetch_add_explicit(&nl_batch_stats.drains, 1,
+					  memory_order_relaxed);
+		atomic_fetch_add_explicit(
+			&nl_batch_stats.busy_usecs,
+			monotime_since(&bth->inflight_start, NULL),
+			memory_order_relaxed);
+	}
+
+	while ((ctx = dplane_ctx_dequeue(&(bth->inflight_list))) != NULL)
+		dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+
+	while (bth->sent_cnt)
+		nl_batch_sent_done(bth);
+
+	bth->inflight_nl = NULL;
+	bth->inflight_msgs = 0;
+}
+
 static void nl_batch_send(struct nl_batch *bth)
 {
 	struct zebra_dplane_ctx *ctx;
+	struct nl_batch_sent *sent;
+	struct nlsock *nl = NULL;
 	bool err = false;
 
 	if (bth->curlen != 0 && bth->zns != NULL) {
-		struct nlsock *nl =
-			kernel_netlink_nlsock_lookup(bth->zns->sock);
+		nl = kernel_netlink_nlsock_lookup(bth->zns->sock);
 
 		if (IS_ZEBRA_DEBUG_KERNEL)
-			zlog_debug("%s: %s, batch size=%zu, msg cnt=%zu",
+			zlog_debug("%s: %s, batch size=%zu, msg cnt=%zu, in flight=%u",
 				   __func__, nl->name, bth->curlen,
-				   bth->msgcnt);
+				   bth->msgcnt, bth->sent_cnt);
+
+		/* ACKs can only be read in order from a single socket. */
+		if (bth->inflight_nl && bth->inflight_nl != nl)
+			nl_batch_drain(bth);
 
-		if (netlink_send_msg(nl, bth->buf, bth->curlen) == -1)
+		if (bth->sent_cnt == 0)
+			monotime(&bth->inflight_start);
+
+		sent = &bth->sent[(bth->sent_head + bth->sent_cnt) %
+				  NL_BATCH_INFLIGHT_MAX];
+		monotime(&sent->sent);
+
+		if (netlink_send_msg(nl, bth->buf, bth->curlen) == -1) {
 			err = true;
+		} else {
+			sent->last_seq = bth->last_seq;
+			sent->msgcnt = bth->msgcnt;
+			sent->bytes = bth->curlen;
+			sent->errors = 0;
+			bth->sent_cnt++;
 
-		if (!err) {
-			if (nl_batch_read_resp(bth, nl) == -1)
-				err = true;
+			/*
+			 * nl_batch_reset() drops bth->zns below, the ACKs are
+			 * read with the namespace of the batches sent.
+			 */
+			bth->inflight_nl = nl;
+			bth->inflight_is_cmd = bth->zns->is_cmd;
+			bth->inflight_ns_id = bth->zns->ns_id;
+			bth->inflight_msgs += bth->msgcnt;
+
+			if (bth->sent_cnt >
+			    atomic_load_explicit(&nl_batch_stats.inflight_max,
+						 memory_order_relaxed))
+				atomic_store_explicit(
+					&nl_batch_stats.inflight_max,
+					bth->sent_cnt, memory_order_relaxed);
 		}
 	}
 
-	/* Move remaining contexts to the outbound queue. */
+	/*
+	 * Queue the contexts behind the ones already in flight, so they are
+	 * handed back in order once the ACKs are read.
+	 */
 	while (true) {
 		ctx = dplane_ctx_dequeue(&(bth->ctx_list));
 		if (ctx == NULL)
@@ -1496,10 +1913,25 @@ static void nl_batch_send(struct nl_batch *bth)
 			dplane_ctx_set_status(ctx,
 					      ZEBRA_DPLANE_REQUEST_FAILURE);
 
-		dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+		if (bth->inflight_nl)
+			dplane_ctx_enqueue_tail(&(bth->inflight_list), ctx);
+		else
+			dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
 	}
 
 	nl_batch_reset(bth);
+
+	if (bth->sent_cnt >= bth->inflight_cfg ||
+	    bth->sent_cnt >= NL_BATCH_INFLIGHT_MAX ||
+	    bth->inflight_msgs * NL_BATCH_ACK_TRUESIZE > rcvbufsize)
+		nl_batch_drain(bth);
+}
+
+/* Send the current batch and wait for everything in flight. */
+static void nl_batch_flush(struct nl_batch *bth)
+{
+	nl_batch_send(bth);
+	nl_batch_drain(bth);
 }
 
 enum netlink_msg_status netlink_batch_add_msg(
@@ -1547,6 +1979,8 @@ enum netlink_msg_status netlink_batch_add_msg(
 	msgh->nlmsg_seq = seq;
 	msgh->nlmsg_pid = nl->snl.nl_pid;
 
+	if (seq > bth->last_seq)
+		bth->last_seq = seq;
 	bth->zns = dplane_ctx_get_ns(ctx);
 	bth->buf_head = ((char *)bth->buf_head) + size;
 	bth->curlen += size;
@@ -1693,7 +2127,7 @@ void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
 			nl_batch_send(&batch);
 	}
 
-	nl_batch_send(&batch);
+	nl_batch_flush(&batch);
 
 	dplane_ctx_q_init(ctx_list);
 	dplane_ctx_list_append(ctx_list, &handled_list);
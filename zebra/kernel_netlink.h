@@ -144,6 +144,20 @@ extern int netlink_config_write_helper(struct vty *vty);
 extern void netlink_set_batch_buffer_size(uint32_t size, uint32_t threshold,
 					  bool set);
 
+/*
+ * Configure how many batches may be sent before their acknowledgments are
+ * read. If 'unset', reset to default value.
+ */
+extern void netlink_set_batch_inflight(uint32_t inflight, bool set);
+
+/*
+ * Enable or disable adapting the send threshold to the measured ACK latency
+ * and error rate.
+ */
+extern void netlink_set_batch_adaptive(bool adaptive);
+
+extern int netlink_batch_show_helper(struct vty *vty, bool use_json);
+
 extern struct nlsock *kernel_netlink_nlsock_lookup(int sock);
 #endif /* HAVE_NETLINK */
 
@@ -85,6 +85,12 @@ struct route_entry {
 	 */
 	struct nhg_hash_entry *nhe;
 
+	/* Entry on the nhe's list of routes using it */
+	struct nhe_route_list_item nhe_item;
+
+	/* Route node this entry is linked to, NULL when not linked */
+	struct route_node *rn;
+
 	/* Nexthop group hash entry IDs. The "installed" id is the id
 	 * used in linux/netlink, if available.
 	 */
@@ -137,6 +143,12 @@ struct route_entry {
  * used for nexthops
  */
 #define ROUTE_ENTRY_ROUTE_REPLACING 0x80
+/*
+ * The route's nexthop group was rewritten in place under the same ID, see
+ * zebra_nhg_replace_group(): the kernel already uses the new nexthops, so
+ * the next update of this route skips the kernel.
+ */
+#define ROUTE_ENTRY_NHG_IN_PLACE 0x100
 
 	/* Sequence value incremented for each dataplane operation */
 	uint32_t dplane_sequence;
@@ -235,6 +247,7 @@ typedef struct rib_dest_t_ {
 
 DECLARE_LIST(rnh_list, struct rnh, rnh_list_item);
 DECLARE_LIST(re_list, struct route_entry, next);
+DECLARE_DLIST(nhe_route_list, struct route_entry, nhe_item);
 
 #define RIB_ROUTE_QUEUED(x)	(1 << (x))
 // If MQ_SIZE is modified this value needs to be updated.
@@ -414,14 +427,20 @@ extern void rib_update(enum rib_update_event event);
 extern void rib_update_table(struct route_table *table,
 			     enum rib_update_event event, int rtype);
 extern void rib_sweep_route(struct event *t);
-extern void rib_sweep_table(struct route_table *table);
 extern void rib_close_table(struct route_table *table);
 extern void zebra_rib_init(void);
 extern void zebra_rib_terminate(void);
-extern unsigned long rib_score_proto(uint8_t proto, unsigned short instance);
-extern unsigned long rib_score_proto_table(uint8_t proto,
-					   unsigned short instance,
-					   struct route_table *table);
+
+/*
+ * Route sweeps run in the background, yielding to the event loop every
+ * few thousand route nodes.
+ */
+extern void rib_score_proto(uint8_t proto, unsigned short instance);
+extern void rib_sweep_proto_finish(uint8_t proto, unsigned short instance);
+extern void rib_sweep_gr_stale(afi_t afi, vrf_id_t vrf_id, uint8_t proto,
+			       unsigned short instance, time_t restart_time);
+struct ttable;
+extern void rib_sweep_show(struct ttable *tt);
 
 extern int rib_queue_add(struct route_node *rn);
 
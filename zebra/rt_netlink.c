@@ -59,6 +59,7 @@
 #include "zebra/zebra_mpls.h"
 #include "zebra/kernel_netlink.h"
 #include "zebra/rt_netlink.h"
+#include "zebra/rt_netlink_parse.h"
 #include "zebra/zebra_nhg.h"
 #include "zebra/zebra_mroute.h"
 #include "zebra/zebra_vxlan.h"
@@ -593,9 +594,7 @@ parse_nexthop_unicast(ns_id_t ns_id, struct rtmsg *rtm, struct rtattr **tb,
 
 static uint8_t parse_multipath_nexthops_unicast(ns_id_t ns_id,
 						struct nexthop_group *ng,
-						struct rtmsg *rtm,
-						struct rtnexthop *rtnh,
-						struct rtattr **tb,
+						const struct nl_route *r,
 						void *prefsrc, vrf_id_t vrf_id)
 {
 	void *gate = NULL;
@@ -608,18 +607,17 @@ static uint8_t parse_multipath_nexthops_unicast(ns_id_t ns_id,
 	struct seg6local_context seg6l_ctx = {};
 	struct in6_addr segs[SRV6_MAX_SIDS] = {};
 	int num_segs = 0;
-	struct rtattr *rtnh_tb[RTA_MAX + 1] = {};
+	struct nl_route_nh rnh;
+	struct nl_route_nh_iter it;
+	struct rtattr **rtnh_tb = rnh.tb;
 
-	int len = RTA_PAYLOAD(tb[RTA_MULTIPATH]);
 	vrf_id_t nh_vrf_id = vrf_id;
 
-	for (;;) {
+	nl_route_nh_iter_init(r, &it);
+	while (nl_route_nh_next(&it, &rnh)) {
 		struct nexthop *nh = NULL;
 
-		if (len < (int)sizeof(*rtnh) || rtnh->rtnh_len > len)
-			break;
-
-		index = rtnh->rtnh_ifindex;
+		index = rnh.ifindex;
 		if (index) {
 			/*
 			 * Yes we are looking this up
@@ -641,39 +639,34 @@ static uint8_t parse_multipath_nexthops_unicast(ns_id_t ns_id,
 		} else
 			nh_vrf_id = vrf_id;
 
-		if (rtnh->rtnh_len > sizeof(*rtnh)) {
-			netlink_parse_rtattr(rtnh_tb, RTA_MAX, RTNH_DATA(rtnh),
-					     rtnh->rtnh_len - sizeof(*rtnh));
-			if (rtnh_tb[RTA_GATEWAY])
-				gate = RTA_DATA(rtnh_tb[RTA_GATEWAY]);
-			if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
-			    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
-				       == LWTUNNEL_ENCAP_MPLS) {
-				num_labels = parse_encap_mpls(
-					rtnh_tb[RTA_ENCAP], labels);
-			}
-			if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
-			    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
-				       == LWTUNNEL_ENCAP_SEG6_LOCAL) {
-				seg6l_act = parse_encap_seg6local(
-					rtnh_tb[RTA_ENCAP], &seg6l_ctx);
-			}
-			if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
-			    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
-				       == LWTUNNEL_ENCAP_SEG6) {
-				num_segs = parse_encap_seg6(rtnh_tb[RTA_ENCAP],
-							    segs);
-			}
+		if (rnh.gate)
+			gate = rnh.gate;
+		if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
+		    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
+			       == LWTUNNEL_ENCAP_MPLS) {
+			num_labels = parse_encap_mpls(rtnh_tb[RTA_ENCAP],
+						      labels);
+		}
+		if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
+		    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
+			       == LWTUNNEL_ENCAP_SEG6_LOCAL) {
+			seg6l_act = parse_encap_seg6local(rtnh_tb[RTA_ENCAP],
+							  &seg6l_ctx);
+		}
+		if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
+		    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
+			       == LWTUNNEL_ENCAP_SEG6) {
+			num_segs = parse_encap_seg6(rtnh_tb[RTA_ENCAP], segs);
 		}
 
-		if (gate && rtm->rtm_family == AF_INET) {
+		if (gate && r->rtm->rtm_family == AF_INET) {
 			if (index)
 				nh = nexthop_from_ipv4_ifindex(
 					gate, prefsrc, index, nh_vrf_id);
 			else
 				nh = nexthop_from_ipv4(gate, prefsrc,
 						       nh_vrf_id);
-		} else if (gate && rtm->rtm_family == AF_INET6) {
+		} else if (gate && r->rtm->rtm_family == AF_INET6) {
 			if (index)
 				nh = nexthop_from_ipv6_ifindex(
 					gate, index, nh_vrf_id);
@@ -683,7 +676,7 @@ static uint8_t parse_multipath_nexthops_unicast(ns_id_t ns_id,
 			nh = nexthop_from_ifindex(index, nh_vrf_id);
 
 		if (nh) {
-			nh->weight = rtnh->rtnh_hops + 1;
+			nh->weight = rnh.weight;
 
 			if (num_labels)
 				nexthop_add_labels(nh, ZEBRA_LSP_STATIC,
@@ -707,18 +700,12 @@ static uint8_t parse_multipath_nexthops_unicast(ns_id_t ns_id,
 			if (num_segs)
 				nexthop_add_srv6_seg6(nh, segs, num_segs);
 
-			if (rtnh->rtnh_flags & RTNH_F_ONLINK)
+			if (rnh.flags & RTNH_F_ONLINK)
 				SET_FLAG(nh->flags, NEXTHOP_FLAG_ONLINK);
 
 			/* Add to temporary list */
 			nexthop_group_add_sorted(ng, nh);
 		}
-
-		if (rtnh->rtnh_len == 0)
-			break;
-
-		len -= NLMSG_ALIGN(rtnh->rtnh_len);
-		rtnh = RTNH_NEXT(rtnh);
 	}
 
 	uint8_t nhop_num = nexthop_group_nexthop_num(ng);
@@ -726,35 +713,43 @@ static uint8_t parse_multipath_nexthops_unicast(ns_id_t ns_id,
 	return nhop_num;
 }
 
+/*
+ * Release what a stack allocated nexthop, as returned by
+ * parse_nexthop_unicast(), may point to.
+ */
+static void parse_nexthop_release(struct nexthop *nh)
+{
+	nexthop_del_labels(nh);
+	nexthop_del_srv6_seg6local(nh);
+	nexthop_del_srv6_seg6(nh);
+}
+
 /* Looking up routing table by netlink interface. */
 int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 					       ns_id_t ns_id, int startup,
 					       struct zebra_dplane_ctx *ctx)
 {
-	int len;
+	int rv;
 	struct rtmsg *rtm;
-	struct rtattr *tb[RTA_MAX + 1];
+	struct nl_route r;
+	struct rtattr **tb = r.tb;
 	uint32_t flags = 0;
-	struct prefix p;
-	struct prefix_ipv6 src_p = {};
+	struct prefix *p = &r.dst;
+	struct prefix_ipv6 *src_p = &r.src;
 	vrf_id_t vrf_id;
 	bool selfroute;
 
-	char anyaddr[16] = {0};
-
 	int proto = ZEBRA_ROUTE_KERNEL;
-	int index = 0;
+	int index;
 	int table;
-	int metric = 0;
-	uint32_t mtu = 0;
+	int metric;
+	uint32_t mtu;
 	uint8_t distance = 0;
 	route_tag_t tag = 0;
-	uint32_t nhe_id = 0;
+	uint32_t nhe_id;
 
-	void *dest = NULL;
-	void *gate = NULL;
-	void *prefsrc = NULL; /* IPv4 preferred source host address */
-	void *src = NULL;     /* IPv6 srcdest   source prefix */
+	void *gate;
+	void *prefsrc; /* IPv4 preferred source host address */
 	enum blackhole_type bh_type = BLACKHOLE_UNSPEC;
 
 	frrtrace(3, frr_zebra, netlink_route_change_read_unicast, h, ns_id,
@@ -784,17 +779,19 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 		return 0;
 	}
 
-	len = h->nlmsg_len - NLMSG_LENGTH(sizeof(struct rtmsg));
-	if (len < 0) {
+	/*
+	 * Decode in place, straight from the receive buffer: nothing below
+	 * allocates until the route is handed over to the RIB.
+	 */
+	rv = nl_route_parse(h, &r);
+	if (rv < 0) {
 		zlog_err(
-			"%s: Message received from netlink is of a broken size %d %zu",
-			__func__, h->nlmsg_len,
-			(size_t)NLMSG_LENGTH(sizeof(struct rtmsg)));
+			"%s: Message received from netlink is malformed: length %u, prefix length %u/%u",
+			__func__, h->nlmsg_len, rtm->rtm_dst_len,
+			rtm->rtm_src_len);
 		return -1;
 	}
 
-	netlink_parse_rtattr(tb, RTA_MAX, RTM_RTA(rtm), len);
-
 	if (rtm->rtm_flags & RTM_F_CLONED)
 		return 0;
 	if (rtm->rtm_protocol == RTPROT_REDIRECT)
@@ -802,6 +799,18 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 	if (rtm->rtm_protocol == RTPROT_KERNEL)
 		return 0;
 
+	/* We only handle the AFs we handle... */
+	if (rv == 0) {
+		/* We don't care about change notifications for the MPLS
+		 * table.
+		 */
+		/* TODO: Revisit this. */
+		if (rtm->rtm_family != AF_MPLS && IS_ZEBRA_DEBUG_KERNEL)
+			zlog_debug("%s: unknown address-family %u", __func__,
+				   rtm->rtm_family);
+		return 0;
+	}
+
 	selfroute = is_selfroute(rtm->rtm_protocol);
 
 	if (!startup && selfroute && h->nlmsg_type == RTM_NEWROUTE &&
@@ -812,16 +821,8 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 		return 0;
 	}
 
-	/* We don't care about change notifications for the MPLS table. */
-	/* TODO: Revisit this. */
-	if (rtm->rtm_family == AF_MPLS)
-		return 0;
-
 	/* Table corresponding to route. */
-	if (tb[RTA_TABLE])
-		table = *(int *)RTA_DATA(tb[RTA_TABLE]);
-	else
-		table = rtm->rtm_table;
+	table = r.table;
 
 	/* Map to VRF */
 	vrf_id = zebra_vrf_lookup_by_table(table, ns_id);
@@ -846,92 +847,22 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 		flags |= ZEBRA_FLAG_SELFROUTE;
 		proto = proto2zebra(rtm->rtm_protocol, rtm->rtm_family, false);
 	}
-	if (tb[RTA_OIF])
-		index = *(int *)RTA_DATA(tb[RTA_OIF]);
 
-	if (tb[RTA_DST])
-		dest = RTA_DATA(tb[RTA_DST]);
-	else
-		dest = anyaddr;
-
-	if (tb[RTA_SRC])
-		src = RTA_DATA(tb[RTA_SRC]);
-	else
-		src = anyaddr;
-
-	if (tb[RTA_PREFSRC])
-		prefsrc = RTA_DATA(tb[RTA_PREFSRC]);
-
-	if (tb[RTA_GATEWAY])
-		gate = RTA_DATA(tb[RTA_GATEWAY]);
-
-	if (tb[RTA_NH_ID])
-		nhe_id = *(uint32_t *)RTA_DATA(tb[RTA_NH_ID]);
-
-	if (tb[RTA_PRIORITY])
-		metric = *(int *)RTA_DATA(tb[RTA_PRIORITY]);
+	index = r.oif;
+	prefsrc = r.prefsrc;
+	gate = r.gate;
+	nhe_id = r.nhe_id;
+	metric = r.priority;
+	mtu = r.mtu;
 
 #if defined(SUPPORT_REALMS)
-	if (tb[RTA_FLOW])
-		tag = *(uint32_t *)RTA_DATA(tb[RTA_FLOW]);
+	tag = r.realm;
 #endif
 
-	if (tb[RTA_METRICS]) {
-		struct rtattr *mxrta[RTAX_MAX + 1];
-
-		netlink_parse_rtattr(mxrta, RTAX_MAX, RTA_DATA(tb[RTA_METRICS]),
-				     RTA_PAYLOAD(tb[RTA_METRICS]));
-
-		if (mxrta[RTAX_MTU])
-			mtu = *(uint32_t *)RTA_DATA(mxrta[RTAX_MTU]);
-	}
-
-	if (rtm->rtm_family == AF_INET) {
-		p.family = AF_INET;
-		if (rtm->rtm_dst_len > IPV4_MAX_BITLEN) {
-			zlog_err(
-				"Invalid destination prefix length: %u received from kernel route change",
-				rtm->rtm_dst_len);
-			return -1;
-		}
-		memcpy(&p.u.prefix4, dest, 4);
-		p.prefixlen = rtm->rtm_dst_len;
-
-		if (rtm->rtm_src_len != 0) {
-			flog_warn(
-				EC_ZEBRA_UNSUPPORTED_V4_SRCDEST,
-				"unsupported IPv4 sourcedest route (dest %pFX vrf %u)",
-				&p, vrf_id);
-			return 0;
-		}
-
-		/* Force debug below to not display anything for source */
-		src_p.prefixlen = 0;
-	} else if (rtm->rtm_family == AF_INET6) {
-		p.family = AF_INET6;
-		if (rtm->rtm_dst_len > IPV6_MAX_BITLEN) {
-			zlog_err(
-				"Invalid destination prefix length: %u received from kernel route change",
-				rtm->rtm_dst_len);
-			return -1;
-		}
-		memcpy(&p.u.prefix6, dest, 16);
-		p.prefixlen = rtm->rtm_dst_len;
-
-		src_p.family = AF_INET6;
-		if (rtm->rtm_src_len > IPV6_MAX_BITLEN) {
-			zlog_err(
-				"Invalid source prefix length: %u received from kernel route change",
-				rtm->rtm_src_len);
-			return -1;
-		}
-		memcpy(&src_p.prefix, src, 16);
-		src_p.prefixlen = rtm->rtm_src_len;
-	} else {
-		/* We only handle the AFs we handle... */
-		if (IS_ZEBRA_DEBUG_KERNEL)
-			zlog_debug("%s: unknown address-family %u", __func__,
-				   rtm->rtm_family);
+	if (rtm->rtm_family == AF_INET && rtm->rtm_src_len != 0) {
+		flog_warn(EC_ZEBRA_UNSUPPORTED_V4_SRCDEST,
+			  "unsupported IPv4 sourcedest route (dest %pFX vrf %u)",
+			  p, vrf_id);
 		return 0;
 	}
 
@@ -962,10 +893,10 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 
 		zlog_debug(
 			"%s %pFX%s%s vrf %s(%u) table_id: %u metric: %d Admin Distance: %d",
-			nl_msg_type_to_str(h->nlmsg_type), &p,
-			src_p.prefixlen ? " from " : "",
-			src_p.prefixlen ? prefix2str(&src_p, buf2, sizeof(buf2))
-					: "",
+			nl_msg_type_to_str(h->nlmsg_type), p,
+			src_p->prefixlen ? " from " : "",
+			src_p->prefixlen ? prefix2str(src_p, buf2, sizeof(buf2))
+					 : "",
 			vrf_id_to_name(vrf_id), vrf_id, table, metric,
 			distance);
 	}
@@ -977,43 +908,52 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 	if (h->nlmsg_type == RTM_NEWROUTE) {
 		struct route_entry *re;
 		struct nexthop_group *ng = NULL;
+		struct nexthop_group sng = {};
+		struct nexthop nh;
 
 		re = zebra_rib_route_entry_new(vrf_id, proto, 0, flags, nhe_id,
 					       table, metric, mtu, distance,
 					       tag);
-		if (!nhe_id)
-			ng = nexthop_group_new();
 
-		if (!tb[RTA_MULTIPATH]) {
-			struct nexthop *nexthop, nh;
+		/*
+		 * A dataplane context (FPM notification) only carries the
+		 * route itself, don't bother building next hops for it.
+		 */
+		if (ctx) {
+			dplane_rib_add_multipath(afi, SAFI_UNICAST, p, src_p,
+						 re, NULL, startup, ctx);
+			zebra_rib_route_entry_free(re);
+			return 1;
+		}
 
+		if (!tb[RTA_MULTIPATH]) {
 			if (!nhe_id) {
+				/*
+				 * The RIB copies the next hops, so the single
+				 * path case can stay on the stack.
+				 */
 				nh = parse_nexthop_unicast(
 					ns_id, rtm, tb, bh_type, index, prefsrc,
 					gate, afi, vrf_id);
-
-				nexthop = nexthop_new();
-				*nexthop = nh;
-				nexthop_group_add_sorted(ng, nexthop);
+				sng.nexthop = &nh;
+				ng = &sng;
 			}
 		} else {
 			/* This is a multipath route */
-			struct rtnexthop *rtnh =
-				(struct rtnexthop *)RTA_DATA(tb[RTA_MULTIPATH]);
-
 			if (!nhe_id) {
 				uint8_t nhop_num;
 
+				ng = nexthop_group_new();
+
 				/* Use temporary list of nexthops; parse
 				 * message payload's nexthops.
 				 */
 				nhop_num =
 					parse_multipath_nexthops_unicast(
-						ns_id, ng, rtm, rtnh, tb,
-						prefsrc, vrf_id);
+						ns_id, ng, &r, prefsrc, vrf_id);
 
 				zserv_nexthop_num_warn(
-					__func__, (const struct prefix *)&p,
+					__func__, (const struct prefix *)p,
 					nhop_num);
 
 				if (nhop_num == 0) {
@@ -1023,12 +963,12 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 			}
 		}
 		if (nhe_id || ng) {
-			dplane_rib_add_multipath(afi, SAFI_UNICAST, &p, &src_p,
+			dplane_rib_add_multipath(afi, SAFI_UNICAST, p, src_p,
 						 re, ng, startup, ctx);
-			if (ng)
+			if (ng == &sng)
+				parse_nexthop_release(&nh);
+			else if (ng)
 				nexthop_group_delete(&ng);
-			if (ctx)
-				zebra_rib_route_entry_free(re);
 		} else {
 			/*
 			 * I really don't see how this is possible
@@ -1039,20 +979,20 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 			 */
 			zlog_err(
 				"%s: %pFX multipath RTM_NEWROUTE has a invalid nexthop group from the kernel",
-				__func__, &p);
+				__func__, p);
 			XFREE(MTYPE_RE, re);
 		}
 	} else {
 		if (ctx) {
 			zlog_err(
 				"%s: %pFX RTM_DELROUTE received but received a context as well",
-				__func__, &p);
+				__func__, p);
 			return 0;
 		}
 
 		if (nhe_id) {
 			rib_delete(afi, SAFI_UNICAST, vrf_id, proto, 0, flags,
-				   &p, &src_p, NULL, nhe_id, table, metric,
+				   p, src_p, NULL, nhe_id, table, metric,
 				   distance, true);
 		} else {
 			if (!tb[RTA_MULTIPATH]) {
@@ -1062,13 +1002,14 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 					ns_id, rtm, tb, bh_type, index, prefsrc,
 					gate, afi, vrf_id);
 				rib_delete(afi, SAFI_UNICAST, vrf_id, proto, 0,
-					   flags, &p, &src_p, &nh, 0, table,
+					   flags, p, src_p, &nh, 0, table,
 					   metric, distance, true);
+				parse_nexthop_release(&nh);
 			} else {
 				/* XXX: need to compare the entire list of
 				 * nexthops here for NLM_F_APPEND stupidity */
 				rib_delete(afi, SAFI_UNICAST, vrf_id, proto, 0,
-					   flags, &p, &src_p, NULL, 0, table,
+					   flags, p, src_p, NULL, 0, table,
 					   metric, distance, true);
 			}
 		}
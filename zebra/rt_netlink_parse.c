@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Allocation free netlink route message decoding.
+ *
+ * Kernel route dumps at startup can carry millions of routes; the helpers
+ * here decode them in place, straight from the netlink receive buffer, so
+ * that the only allocations left are the ones the RIB keeps.
+ */
+
+#include <zebra.h>
+
+#ifdef HAVE_NETLINK
+
+#include "zebra/rt_netlink_parse.h"
+
+static void nl_route_parse_rtattr(struct rtattr **tb, struct rtattr *rta,
+				  int len)
+{
+	memset(tb, 0, sizeof(struct rtattr *) * (RTA_MAX + 1));
+	while (RTA_OK(rta, len)) {
+		if (rta->rta_type <= RTA_MAX)
+			tb[rta->rta_type] = rta;
+		rta = RTA_NEXT(rta, len);
+	}
+}
+
+static inline uint32_t nl_route_u32(const struct rtattr *rta)
+{
+	if (rta == NULL || RTA_PAYLOAD(rta) < sizeof(uint32_t))
+		return 0;
+
+	return *(const uint32_t *)RTA_DATA(rta);
+}
+
+/* Copy an address attribute, absent or short attributes read as zero. */
+static inline void nl_route_addr(void *dst, const struct rtattr *rta,
+				 size_t alen)
+{
+	if (rta && RTA_PAYLOAD(rta) >= alen)
+		memcpy(dst, RTA_DATA(rta), alen);
+	else
+		memset(dst, 0, alen);
+}
+
+int nl_route_parse(struct nlmsghdr *h, struct nl_route *r)
+{
+	struct rtmsg *rtm;
+	struct rtattr *rta;
+	int len;
+
+	len = h->nlmsg_len - NLMSG_LENGTH(sizeof(struct rtmsg));
+	if (len < 0)
+		return -1;
+
+	rtm = NLMSG_DATA(h);
+	r->h = h;
+	r->rtm = rtm;
+
+	switch (rtm->rtm_family) {
+	case AF_INET:
+		if (rtm->rtm_dst_len > IPV4_MAX_BITLEN)
+			return -1;
+		break;
+	case AF_INET6:
+		if (rtm->rtm_dst_len > IPV6_MAX_BITLEN ||
+		    rtm->rtm_src_len > IPV6_MAX_BITLEN)
+			return -1;
+		break;
+	default:
+		return 0;
+	}
+
+	nl_route_parse_rtattr(r->tb, RTM_RTA(rtm), len);
+
+	r->table = r->tb[RTA_TABLE] ? nl_route_u32(r->tb[RTA_TABLE])
+				    : rtm->rtm_table;
+	r->oif = (int)nl_route_u32(r->tb[RTA_OIF]);
+	r->priority = nl_route_u32(r->tb[RTA_PRIORITY]);
+	r->nhe_id = nl_route_u32(r->tb[RTA_NH_ID]);
+	r->realm = nl_route_u32(r->tb[RTA_FLOW]);
+	r->gate = r->tb[RTA_GATEWAY] ? RTA_DATA(r->tb[RTA_GATEWAY]) : NULL;
+	r->prefsrc = r->tb[RTA_PREFSRC] ? RTA_DATA(r->tb[RTA_PREFSRC]) : NULL;
+
+	r->mtu = 0;
+	rta = r->tb[RTA_METRICS];
+	if (rta) {
+		struct rtattr *mx = RTA_DATA(rta);
+		int mxlen = RTA_PAYLOAD(rta);
+
+		/* Only the MTU is of interest, don't build a table for it. */
+		while (RTA_OK(mx, mxlen)) {
+			if (mx->rta_type == RTAX_MTU) {
+				r->mtu = nl_route_u32(mx);
+				break;
+			}
+			mx = RTA_NEXT(mx, mxlen);
+		}
+	}
+
+	memset(&r->dst, 0, sizeof(r->dst));
+	memset(&r->src, 0, sizeof(r->src));
+	r->dst.family = rtm->rtm_family;
+	r->dst.prefixlen = rtm->rtm_dst_len;
+	if (rtm->rtm_family == AF_INET) {
+		nl_route_addr(&r->dst.u.prefix4, r->tb[RTA_DST],
+			      IPV4_MAX_BYTELEN);
+	} else {
+		nl_route_addr(&r->dst.u.prefix6, r->tb[RTA_DST],
+			      IPV6_MAX_BYTELEN);
+		r->src.family = AF_INET6;
+		r->src.prefixlen = rtm->rtm_src_len;
+		nl_route_addr(&r->src.prefix, r->tb[RTA_SRC], IPV6_MAX_BYTELEN);
+	}
+
+	return 1;
+}
+
+void nl_route_nh_iter_init(const struct nl_route *r,
+			   struct nl_route_nh_iter *it)
+{
+	struct rtattr *mp = r->tb[RTA_MULTIPATH];
+
+	it->rtnh = mp ? RTA_DATA(mp) : NULL;
+	it->len = mp ? (int)RTA_PAYLOAD(mp) : 0;
+}
+
+bool nl_route_nh_next(struct nl_route_nh_iter *it, struct nl_route_nh *nh)
+{
+	struct rtnexthop *rtnh = it->rtnh;
+
+	if (rtnh == NULL || it->len < (int)sizeof(*rtnh) ||
+	    rtnh->rtnh_len < sizeof(*rtnh) || rtnh->rtnh_len > it->len)
+		return false;
+
+	nh->ifindex = rtnh->rtnh_ifindex;
+	nh->flags = rtnh->rtnh_flags;
+	nh->weight = rtnh->rtnh_hops + 1;
+	nl_route_parse_rtattr(nh->tb, RTNH_DATA(rtnh),
+			      rtnh->rtnh_len - sizeof(*rtnh));
+	nh->gate = nh->tb[RTA_GATEWAY] ? RTA_DATA(nh->tb[RTA_GATEWAY]) : NULL;
+
+	it->len -= NLMSG_ALIGN(rtnh->rtnh_len);
+	it->rtnh = RTNH_NEXT(rtnh);
+
+	return true;
+}
+
+#endif /* HAVE_NETLINK */
@@ -0,0 +1,83 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Allocation free netlink route message decoding.
+ */
+
+#ifndef _ZEBRA_RT_NETLINK_PARSE_H
+#define _ZEBRA_RT_NETLINK_PARSE_H
+
+#ifdef HAVE_NETLINK
+
+#include <linux/rtnetlink.h>
+
+#include "prefix.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Decoded view of a RTM_NEWROUTE / RTM_DELROUTE message.  All pointers
+ * reference the message itself (i.e. the netlink receive buffer), so the
+ * structure can live on the stack and be reused for every message of a
+ * dump without any allocation.
+ */
+struct nl_route {
+	struct nlmsghdr *h;
+	struct rtmsg *rtm;
+
+	/* All top level attributes, indexed by type. */
+	struct rtattr *tb[RTA_MAX + 1];
+
+	struct prefix dst;
+	struct prefix_ipv6 src;
+
+	uint32_t table;
+	int oif;
+	uint32_t priority;
+	uint32_t mtu;
+	uint32_t nhe_id;
+	uint32_t realm;
+
+	/* Address attributes, NULL when absent. */
+	void *gate;
+	void *prefsrc;
+};
+
+/* Single next hop of a RTA_MULTIPATH attribute. */
+struct nl_route_nh {
+	int ifindex;
+	uint8_t flags;
+	uint8_t weight;
+	void *gate;
+
+	/* Next hop attributes, indexed by type. */
+	struct rtattr *tb[RTA_MAX + 1];
+};
+
+/* Iterator over the RTA_MULTIPATH next hops of a decoded route. */
+struct nl_route_nh_iter {
+	struct rtnexthop *rtnh;
+	int len;
+};
+
+/*
+ * Decode an AF_INET / AF_INET6 route message.
+ *
+ * Returns 1 when decoded, 0 for messages of other address families and -1
+ * for malformed messages.
+ */
+extern int nl_route_parse(struct nlmsghdr *h, struct nl_route *r);
+
+extern void nl_route_nh_iter_init(const struct nl_route *r,
+				  struct nl_route_nh_iter *it);
+extern bool nl_route_nh_next(struct nl_route_nh_iter *it,
+			     struct nl_route_nh *nh);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAVE_NETLINK */
+
+#endif /* _ZEBRA_RT_NETLINK_PARSE_H */
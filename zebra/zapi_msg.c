@@ -611,11 +611,26 @@ int zsend_redistribute_route(int cmd, struct zserv *client,
 	SET_FLAG(api.message, ZAPI_MESSAGE_MTU);
 	api.mtu = re->mtu;
 
-	struct stream *s = stream_new(stream_size);
+	/*
+	 * Clients accepting batches get the route copied into their pending
+	 * batch, so encode into a scratch stream instead of allocating one
+	 * per route.
+	 */
+	static struct stream *batch_s;
+	struct stream *s;
+
+	if (client->redist_batch) {
+		if (!batch_s)
+			batch_s = stream_new(stream_size);
+		s = batch_s;
+		stream_reset(s);
+	} else
+		s = stream_new(stream_size);
 
 	/* Encode route and send. */
 	if (zapi_route_encode(cmd, s, &api) < 0) {
-		stream_free(s);
+		if (s != batch_s)
+			stream_free(s);
 		return -1;
 	}
 
@@ -625,6 +640,10 @@ int zsend_redistribute_route(int cmd, struct zserv *client,
 			   zebra_route_string(client->proto),
 			   zebra_route_string(api.type), api.vrf_id,
 			   &api.prefix);
+
+	if (s == batch_s)
+		return zserv_redist_batch_add(client, s);
+
 	return zserv_send_message(client, s);
 }
 
@@ -2394,6 +2413,14 @@ static void zread_hello(ZAPI_HANDLER_ARGS)
 	if (synchronous)
 		client->synchronous = true;
 
+	/* Older clients don't send the batching capability. */
+	if (STREAM_READABLE(msg)) {
+		uint8_t redist_batch;
+
+		STREAM_GETC(msg, redist_batch);
+		client->redist_batch = !!redist_batch;
+	}
+
 	/* accept only dynamic routing protocols */
 	if ((proto < ZEBRA_ROUTE_MAX) && (proto > ZEBRA_ROUTE_LOCAL)) {
 		zlog_notice(
@@ -2407,6 +2434,9 @@ static void zread_hello(ZAPI_HANDLER_ARGS)
 		client->instance = instance;
 		client->session_id = session_id;
 
+		/* Finish removing routes from a previous session first */
+		rib_sweep_proto_finish(proto, instance);
+
 		/* Graceful restart processing for client connect */
 		zebra_gr_client_reconnect(client);
 	}
@@ -2414,6 +2444,7 @@ static void zread_hello(ZAPI_HANDLER_ARGS)
 	if (!client->synchronous) {
 		zsend_capabilities(client, zvrf);
 		zebra_vrf_update_all(client);
+		zserv_backpressure_hello(client);
 	}
 stream_failure:
 	return;
@@ -2718,6 +2749,21 @@ int zsend_client_close_notify(struct zserv *client, struct zserv *closed_client)
 	return zserv_send_message(client, s);
 }
 
+int zsend_backpressure(struct zserv *client, bool engaged, uint32_t window,
+		       uint32_t depth)
+{
+	struct stream *s = stream_new(ZEBRA_SMALL_PACKET_SIZE);
+	struct zapi_backpressure bp = {
+		.engaged = engaged,
+		.window = window,
+		.depth = depth,
+	};
+
+	zapi_backpressure_encode(s, &bp);
+
+	return zserv_send_message(client, s);
+}
+
 int zsend_srv6_manager_get_locator_chunk_response(struct zserv *client,
 						  vrf_id_t vrf_id,
 						  struct srv6_locator *loc)
@@ -97,6 +97,8 @@ extern void zsend_neighbor_notify(int cmd, struct interface *ifp,
 
 extern int zsend_client_close_notify(struct zserv *client,
 				     struct zserv *closed_client);
+extern int zsend_backpressure(struct zserv *client, bool engaged,
+			      uint32_t window, uint32_t depth);
 
 int zsend_nhg_notify(uint16_t type, uint16_t instance, uint32_t session_id,
 		     uint32_t id, enum zapi_nhg_notify_owner note);
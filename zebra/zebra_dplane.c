@@ -594,6 +594,12 @@ static struct zebra_dplane_globals {
 
 	_Atomic uint32_t dg_update_yields;
 
+	_Atomic uint32_t dg_batches_in;
+	_Atomic uint32_t dg_batched_updates;
+
+	_Atomic uint32_t dg_notif_batches;
+	_Atomic uint32_t dg_notif_batched;
+
 	_Atomic uint32_t dg_iptable_in;
 	_Atomic uint32_t dg_iptable_errors;
 
@@ -4189,6 +4195,60 @@ dplane_ctx_ipset_entry_init(struct zebra_dplane_ctx *ctx, enum dplane_op_e op,
 }
 
 
+/*
+ * Bulk enqueueing.  Within a batch, updates from the main pthread are
+ * collected on a local list and handed over with a single lock round trip
+ * and wakeup.  The providers then see the whole burst at once, e.g. all the
+ * FDB entries of a remote VTEP, and can fill netlink batches with it.
+ */
+static struct {
+	unsigned int depth;
+	struct dplane_ctx_list_head list;
+} dplane_batch;
+
+static bool dplane_batch_active(void)
+{
+	return pthread_equal(pthread_self(), zrouter.master->owner) &&
+	       dplane_batch.depth > 0;
+}
+
+static void dplane_batch_flush(void)
+{
+	struct zebra_dplane_ctx *ctx;
+	uint32_t count = dplane_ctx_list_count(&dplane_batch.list);
+
+	if (!count)
+		return;
+
+	DPLANE_LOCK();
+	{
+		while ((ctx = dplane_ctx_list_pop(&dplane_batch.list)))
+			dplane_ctx_list_add_tail(&zdplane_info.dg_update_list,
+						 ctx);
+	}
+	DPLANE_UNLOCK();
+
+	atomic_fetch_add_explicit(&zdplane_info.dg_batches_in, 1,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&zdplane_info.dg_batched_updates, count,
+				  memory_order_relaxed);
+
+	dplane_provider_work_ready();
+}
+
+void dplane_batch_begin(void)
+{
+	dplane_batch.depth++;
+}
+
+void dplane_batch_end(void)
+{
+	assert(dplane_batch.depth > 0);
+
+	if (--dplane_batch.depth == 0)
+		dplane_batch_flush();
+}
+
 /*
  * Enqueue a new update,
  * and ensure an event is active for the dataplane pthread.
@@ -4198,12 +4258,21 @@ static int dplane_update_enqueue(struct zebra_dplane_ctx *ctx)
 	int ret = EINVAL;
 	uint32_t high, curr;
 
-	/* Enqueue for processing by the dataplane pthread */
-	DPLANE_LOCK();
-	{
-		dplane_ctx_list_add_tail(&zdplane_info.dg_update_list, ctx);
+	/*
+	 * Enqueue for processing by the dataplane pthread.  The queue depth
+	 * is accounted for right away, even for batched updates, as it is
+	 * used to throttle route processing.
+	 */
+	if (dplane_batch_active()) {
+		dplane_ctx_list_add_tail(&dplane_batch.list, ctx);
+	} else {
+		DPLANE_LOCK();
+		{
+			dplane_ctx_list_add_tail(&zdplane_info.dg_update_list,
+						 ctx);
+		}
+		DPLANE_UNLOCK();
 	}
-	DPLANE_UNLOCK();
 
 	curr = atomic_fetch_add_explicit(
 		&(zdplane_info.dg_routes_queued),
@@ -4224,7 +4293,10 @@ static int dplane_update_enqueue(struct zebra_dplane_ctx *ctx)
 	}
 
 	/* Ensure that an event for the dataplane thread is active */
-	ret = dplane_provider_work_ready();
+	if (dplane_batch_active())
+		ret = AOK;
+	else
+		ret = dplane_provider_work_ready();
 
 	return ret;
 }
@@ -4324,6 +4396,15 @@ dplane_route_update_internal(struct route_node *rn,
 			return ZEBRA_DPLANE_REQUEST_SUCCESS;
 		}
 
+		/*
+		 * The route's group was rewritten in place under the same ID,
+		 * the kernel already forwards with the new nexthops: only the
+		 * providers and the result handling need to see the update.
+		 */
+		if ((op == DPLANE_OP_ROUTE_UPDATE) && (old_re == re) &&
+		    CHECK_FLAG(re->status, ROUTE_ENTRY_NHG_IN_PLACE))
+			dplane_ctx_set_skip_kernel(ctx);
+
 		/* Enqueue context for processing */
 		ret = dplane_update_enqueue(ctx);
 	}
@@ -6000,6 +6081,20 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 	vty_out(vty, "Route update queue max:   %"PRIu64"\n", queue_max);
 	vty_out(vty, "Dplane update yields:     %"PRIu64"\n", yields);
 
+	incoming = atomic_load_explicit(&zdplane_info.dg_batches_in,
+					memory_order_relaxed);
+	queued = atomic_load_explicit(&zdplane_info.dg_batched_updates,
+				      memory_order_relaxed);
+	vty_out(vty, "Bulk enqueues:            %" PRIu64 " (%" PRIu64 " updates)\n",
+		incoming, queued);
+
+	incoming = atomic_load_explicit(&zdplane_info.dg_notif_batches,
+					memory_order_relaxed);
+	queued = atomic_load_explicit(&zdplane_info.dg_notif_batched,
+				      memory_order_relaxed);
+	vty_out(vty, "Notification batches:     %" PRIu64 " (%" PRIu64 " contexts)\n",
+		incoming, queued);
+
 	incoming = atomic_load_explicit(&zdplane_info.dg_lsps_in,
 					memory_order_relaxed);
 	errs = atomic_load_explicit(&zdplane_info.dg_lsp_errors,
@@ -6503,6 +6598,48 @@ int dplane_provider_work_ready(void)
 	return AOK;
 }
 
+/*
+ * Contexts for zebra main built while reading OS notifications, e.g. link
+ * and address changes.  Within a batch they are collected per pthread and
+ * passed on as one list, rather than taking the results lock and waking up
+ * zebra main for every message.
+ */
+#ifndef thread_local
+#define thread_local __thread
+#endif
+
+static thread_local struct {
+	unsigned int depth;
+	struct dplane_ctx_list_head list;
+} dplane_zebra_batch;
+
+void dplane_zebra_batch_begin(void)
+{
+	if (dplane_zebra_batch.depth++ == 0)
+		dplane_ctx_list_init(&dplane_zebra_batch.list);
+}
+
+void dplane_zebra_batch_end(void)
+{
+	uint32_t count;
+
+	assert(dplane_zebra_batch.depth > 0);
+
+	if (--dplane_zebra_batch.depth > 0)
+		return;
+
+	count = dplane_ctx_list_count(&dplane_zebra_batch.list);
+	if (!count)
+		return;
+
+	atomic_fetch_add_explicit(&zdplane_info.dg_notif_batches, 1,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&zdplane_info.dg_notif_batched, count,
+				  memory_order_relaxed);
+
+	(zdplane_info.dg_results_cb)(&dplane_zebra_batch.list);
+}
+
 /*
  * Enqueue a context directly to zebra main.
  */
@@ -6510,6 +6647,11 @@ void dplane_provider_enqueue_to_zebra(struct zebra_dplane_ctx *ctx)
 {
 	struct dplane_ctx_list_head temp_list;
 
+	if (dplane_zebra_batch.depth > 0) {
+		dplane_ctx_list_add_tail(&dplane_zebra_batch.list, ctx);
+		return;
+	}
+
 	/* Zebra's api takes a list, so we need to use a temporary list */
 	dplane_ctx_list_init(&temp_list);
 
@@ -7118,6 +7260,10 @@ int dplane_clean_ctx_queue(bool (*context_cb)(struct zebra_dplane_ctx *ctx,
 	if (context_cb == NULL)
 		return AOK;
 
+	/* Batched contexts have to be visible to the walk. */
+	if (dplane_batch_active())
+		dplane_batch_flush();
+
 	/* Walk the pending context queue under the dplane lock. */
 	DPLANE_LOCK();
 
@@ -7543,6 +7689,7 @@ static void zebra_dplane_init_internal(void)
 	dplane_prov_list_init(&zdplane_info.dg_providers);
 
 	dplane_ctx_list_init(&zdplane_info.dg_update_list);
+	dplane_ctx_list_init(&dplane_batch.list);
 	zns_info_list_init(&zdplane_info.dg_zns_list);
 
 	zdplane_info.dg_updates_per_cycle = DPLANE_DEFAULT_NEW_WORK;
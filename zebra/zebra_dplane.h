@@ -299,6 +299,14 @@ void dplane_ctx_reset(struct zebra_dplane_ctx *ctx);
 int dplane_clean_ctx_queue(bool (*context_cb)(struct zebra_dplane_ctx *ctx,
 					      void *arg), void *val);
 
+/*
+ * Bulk enqueueing: updates enqueued between dplane_batch_begin() and the
+ * matching dplane_batch_end() are handed to the dataplane pthread at once.
+ * Calls may nest; main pthread only.
+ */
+void dplane_batch_begin(void);
+void dplane_batch_end(void);
+
 /* Return a dataplane results context block after use; the caller's pointer will
  * be cleared.
  */
@@ -1186,6 +1194,13 @@ void dplane_provider_enqueue_out_ctx(struct zebra_dplane_provider *prov,
 /* Enqueue a context directly to zebra main. */
 void dplane_provider_enqueue_to_zebra(struct zebra_dplane_ctx *ctx);
 
+/*
+ * Contexts enqueued to zebra main by the calling pthread between these two
+ * calls are handed over as one list.  Calls may nest.
+ */
+void dplane_zebra_batch_begin(void);
+void dplane_zebra_batch_end(void);
+
 /* Enable collection of extra info about interfaces in route updates;
  * this allows a provider/plugin to see some extra info in route update
  * context objects.
@@ -928,7 +928,9 @@ void zebra_evpn_rem_mac_uninstall_all(struct zebra_evpn *zevpn)
 	wctx.upd_client = 0;
 	wctx.flags = ZEBRA_MAC_REMOTE;
 
+	dplane_batch_begin();
 	hash_iterate(zevpn->mac_table, zebra_evpn_uninstall_mac_hash, &wctx);
+	dplane_batch_end();
 }
 
 /*
@@ -947,7 +949,9 @@ void zebra_evpn_rem_mac_install_all(struct zebra_evpn *zevpn)
 	wctx.upd_client = 0;
 	wctx.flags = ZEBRA_MAC_REMOTE;
 
+	dplane_batch_begin();
 	hash_iterate(zevpn->mac_table, zebra_evpn_install_mac_hash, &wctx);
+	dplane_batch_end();
 }
 
 /*
@@ -1084,6 +1088,10 @@ struct zebra_evpn *zebra_evpn_add(vni_t vni)
 	/* Create hash table for MAC */
 	zevpn->mac_table = zebra_mac_db_create(buffer);
 
+	snprintf(buffer, sizeof(buffer), "Zebra EVPN MAC VTEP Table vni: %u",
+		 vni);
+	zevpn->mac_vtep_table = zebra_mac_vtep_db_create(buffer);
+
 	snprintf(buffer, sizeof(buffer), "Zebra EVPN Neighbor Table vni: %u", vni);
 	/* Create hash table for neighbors */
 	zevpn->neigh_table = zebra_neigh_db_create(buffer);
@@ -1110,6 +1118,7 @@ int zebra_evpn_del(struct zebra_evpn *zevpn)
 	/* Free the MAC hash table. */
 	hash_free(zevpn->mac_table);
 	zevpn->mac_table = NULL;
+	zebra_mac_vtep_db_free(&zevpn->mac_vtep_table);
 
 	/* Remove references to the zevpn in the MH databases */
 	if (zevpn->vxlan_if)
@@ -28,6 +28,7 @@
 #include "zebra/zebra_evpn_neigh.h"
 
 DEFINE_MTYPE_STATIC(ZEBRA, MAC, "EVPN MAC");
+DEFINE_MTYPE_STATIC(ZEBRA, MAC_VTEP, "EVPN MAC VTEP index");
 
 /*
  * Return number of valid MACs in an EVPN's MAC hash table - all
@@ -166,10 +167,106 @@ static void zebra_evpn_mac_ifp_link(struct zebra_mac *zmac,
 	listnode_add(zif->mac_list, &zmac->ifp_listnode);
 }
 
+/* Remove a remote mac from the per-VTEP index of its EVPN */
+static void zebra_evpn_mac_vtep_unlink(struct zebra_mac *zmac)
+{
+	struct zebra_mac_vtep *mvtep = zmac->vtep_idx;
+	struct hash *mac_vtep_table;
+
+	if (!mvtep)
+		return;
+
+	zebra_mac_vtep_list_del(&mvtep->macs, zmac);
+	zmac->vtep_idx = NULL;
+
+	if (zebra_mac_vtep_list_count(&mvtep->macs))
+		return;
+
+	mac_vtep_table = zmac->zevpn ? zmac->zevpn->mac_vtep_table : NULL;
+	if (mac_vtep_table)
+		hash_release(mac_vtep_table, mvtep);
+	zebra_mac_vtep_list_fini(&mvtep->macs);
+	XFREE(MTYPE_MAC_VTEP, mvtep);
+}
+
+static void *zebra_mac_vtep_alloc(void *p)
+{
+	const struct zebra_mac_vtep *tmp = p;
+	struct zebra_mac_vtep *mvtep;
+
+	mvtep = XCALLOC(MTYPE_MAC_VTEP, sizeof(*mvtep));
+	mvtep->vtep_ip = tmp->vtep_ip;
+	zebra_mac_vtep_list_init(&mvtep->macs);
+
+	return mvtep;
+}
+
+/* Add a remote mac to the per-VTEP index of its EVPN */
+static void zebra_evpn_mac_vtep_link(struct zebra_mac *zmac)
+{
+	struct zebra_mac_vtep tmp;
+	struct hash *mac_vtep_table;
+
+	if (zmac->vtep_idx) {
+		if (IPV4_ADDR_SAME(&zmac->vtep_idx->vtep_ip,
+				   &zmac->fwd_info.r_vtep_ip))
+			return;
+		zebra_evpn_mac_vtep_unlink(zmac);
+	}
+
+	mac_vtep_table = zmac->zevpn ? zmac->zevpn->mac_vtep_table : NULL;
+	if (!mac_vtep_table)
+		return;
+
+	memset(&tmp, 0, sizeof(tmp));
+	tmp.vtep_ip = zmac->fwd_info.r_vtep_ip;
+	zmac->vtep_idx = hash_get(mac_vtep_table, &tmp, zebra_mac_vtep_alloc);
+	zebra_mac_vtep_list_add_tail(&zmac->vtep_idx->macs, zmac);
+}
+
+/*
+ * Walk the remote MACs learnt from a VTEP.  The callback gets a bucket
+ * of its own for each MAC so that the MAC hash walkers can be reused, and
+ * may delete the MAC.
+ */
+void zebra_evpn_mac_vtep_iterate(struct zebra_evpn *zevpn,
+				 struct in_addr vtep_ip,
+				 void (*func)(struct hash_bucket *, void *),
+				 void *arg)
+{
+	struct zebra_mac_vtep tmp, *mvtep;
+	struct zebra_mac *zmac;
+	struct hash_bucket bucket = {};
+
+	if (!zevpn->mac_vtep_table)
+		return;
+
+	memset(&tmp, 0, sizeof(tmp));
+	tmp.vtep_ip = vtep_ip;
+	mvtep = hash_lookup(zevpn->mac_vtep_table, &tmp);
+	if (!mvtep)
+		return;
+
+	/*
+	 * The last MAC leaving frees the index entry, so don't touch the
+	 * list again once the callback has seen it.
+	 */
+	zmac = zebra_mac_vtep_list_first(&mvtep->macs);
+	while (zmac) {
+		struct zebra_mac *next;
+
+		next = zebra_mac_vtep_list_next(&mvtep->macs, zmac);
+		bucket.data = zmac;
+		func(&bucket, arg);
+		zmac = next;
+	}
+}
+
 /* If the mac is a local mac clear links to destination access port */
 void zebra_evpn_mac_clear_fwd_info(struct zebra_mac *zmac)
 {
 	zebra_evpn_mac_ifp_unlink(zmac);
+	zebra_evpn_mac_vtep_unlink(zmac);
 	memset(&zmac->fwd_info, 0, sizeof(zmac->fwd_info));
 }
 
@@ -1200,7 +1297,9 @@ void zebra_evpn_mac_del_all(struct zebra_evpn *zevpn, int uninstall,
 	wctx.upd_client = upd_client;
 	wctx.flags = flags;
 
+	dplane_batch_begin();
 	hash_iterate(zevpn->mac_table, zebra_evpn_mac_del_hash_entry, &wctx);
+	dplane_batch_end();
 }
 
 /*
@@ -1287,6 +1386,45 @@ struct hash *zebra_mac_db_create(const char *desc)
 	return hash_create_size(8, mac_hash_keymake, mac_cmp, desc);
 }
 
+static unsigned int mac_vtep_hash_keymake(const void *p)
+{
+	const struct zebra_mac_vtep *mvtep = p;
+
+	return jhash_1word(mvtep->vtep_ip.s_addr, 0);
+}
+
+static bool mac_vtep_cmp(const void *p1, const void *p2)
+{
+	const struct zebra_mac_vtep *mvtep1 = p1;
+	const struct zebra_mac_vtep *mvtep2 = p2;
+
+	return IPV4_ADDR_SAME(&mvtep1->vtep_ip, &mvtep2->vtep_ip);
+}
+
+/*
+ * wrapper to create the per-VTEP index of remote MACs
+ */
+struct hash *zebra_mac_vtep_db_create(const char *desc)
+{
+	return hash_create_size(8, mac_vtep_hash_keymake, mac_vtep_cmp, desc);
+}
+
+static void mac_vtep_free(void *p)
+{
+	struct zebra_mac_vtep *mvtep = p;
+	struct zebra_mac *zmac;
+
+	while ((zmac = zebra_mac_vtep_list_pop(&mvtep->macs)))
+		zmac->vtep_idx = NULL;
+	zebra_mac_vtep_list_fini(&mvtep->macs);
+	XFREE(MTYPE_MAC_VTEP, mvtep);
+}
+
+void zebra_mac_vtep_db_free(struct hash **mac_vtep_table)
+{
+	hash_clean_and_free(mac_vtep_table, mac_vtep_free);
+}
+
 /* program sync mac flags in the dataplane  */
 int zebra_evpn_sync_mac_dp_install(struct zebra_mac *mac, bool set_inactive,
 				   bool force_clear_static, const char *caller)
@@ -2010,6 +2148,7 @@ int zebra_evpn_mac_remote_macip_add(struct zebra_evpn *zevpn,
 		UNSET_FLAG(mac->flags, ZEBRA_MAC_ALL_LOCAL_FLAGS);
 		SET_FLAG(mac->flags, ZEBRA_MAC_REMOTE);
 		mac->fwd_info.r_vtep_ip = vtep_ip;
+		zebra_evpn_mac_vtep_link(mac);
 
 		if (sticky)
 			SET_FLAG(mac->flags, ZEBRA_MAC_STICKY);
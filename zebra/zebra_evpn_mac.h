@@ -23,6 +23,19 @@ struct host_rb_entry {
 RB_HEAD(host_rb_tree_entry, host_rb_entry);
 RB_PROTOTYPE(host_rb_tree_entry, host_rb_entry, hl_entry,
 	     host_rb_entry_compare);
+
+PREDECL_DLIST(zebra_mac_vtep_list);
+
+/*
+ * Remote MACs of a VNI, indexed by the VTEP they were learnt from, so that
+ * walks over the MACs of one VTEP don't have to visit every MAC of the VNI.
+ */
+struct zebra_mac_vtep {
+	struct in_addr vtep_ip;
+
+	struct zebra_mac_vtep_list_head macs;
+};
+
 /*
  * MAC hash table.
  *
@@ -86,6 +99,10 @@ struct zebra_mac {
 		struct in_addr r_vtep_ip;
 	} fwd_info;
 
+	/* Per-VTEP index entry of a remote MAC, NULL if not linked */
+	struct zebra_mac_vtep *vtep_idx;
+	struct zebra_mac_vtep_list_item vtep_item;
+
 	/* Local or remote ES */
 	struct zebra_evpn_es *es;
 	/* memory used to link the mac to the es */
@@ -131,6 +148,8 @@ struct zebra_mac {
 	time_t uptime;
 };
 
+DECLARE_DLIST(zebra_mac_vtep_list, struct zebra_mac, vtep_item);
+
 /*
  * Context for MAC hash walk - used by callbacks.
  */
@@ -194,6 +213,12 @@ static inline bool zebra_evpn_mac_in_use(struct zebra_mac *mac)
 }
 
 struct hash *zebra_mac_db_create(const char *desc);
+struct hash *zebra_mac_vtep_db_create(const char *desc);
+void zebra_mac_vtep_db_free(struct hash **mac_vtep_table);
+void zebra_evpn_mac_vtep_iterate(struct zebra_evpn *zevpn,
+				 struct in_addr vtep_ip,
+				 void (*func)(struct hash_bucket *, void *),
+				 void *arg);
 uint32_t num_valid_macs(struct zebra_evpn *zevi);
 uint32_t num_dup_detected_macs(struct zebra_evpn *zevi);
 int zebra_evpn_rem_mac_uninstall(struct zebra_evpn *zevi, struct zebra_mac *mac,
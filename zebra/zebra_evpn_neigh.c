@@ -882,8 +882,10 @@ void zebra_evpn_neigh_del_all(struct zebra_evpn *zevpn, int uninstall,
 	wctx.upd_client = upd_client;
 	wctx.flags = flags;
 
+	dplane_batch_begin();
 	hash_iterate(zevpn->neigh_table, zebra_evpn_neigh_del_hash_entry,
 		     &wctx);
+	dplane_batch_end();
 }
 
 /*
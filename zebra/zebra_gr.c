@@ -43,7 +43,6 @@ static void zebra_gr_route_stale_delete_timer_expiry(struct event *thread);
 static int32_t zebra_gr_delete_stale_routes(struct client_gr_info *info);
 static void zebra_gr_process_client_stale_routes(struct zserv *client,
 						 struct client_gr_info *info);
-static void zebra_gr_delete_stale_route_table_afi(struct event *event);
 /*
  * Debug macros.
  */
@@ -285,15 +284,6 @@ void zebra_gr_client_reconnect(struct zserv *client)
 	zserv_client_delete(old_client);
 }
 
-struct zebra_gr_afi_clean {
-	struct client_gr_info *info;
-	afi_t afi;
-	uint8_t proto;
-	uint8_t instance;
-
-	struct event *t_gac;
-};
-
 /*
  * Functions to deal with capabilities
  */
@@ -480,81 +470,6 @@ static void zebra_gr_route_stale_delete_timer_expiry(struct event *thread)
 }
 
 
-/*
- * Function to process to check if route entry is stale
- * or has been updated.
- *
- * Returns true when a node is deleted else false
- */
-static bool zebra_gr_process_route_entry(struct zserv *client,
-					 struct route_node *rn,
-					 struct route_entry *re)
-{
-	/* If the route is not refreshed after restart, delete the entry */
-	if (re->uptime < client->restart_time) {
-		if (IS_ZEBRA_DEBUG_RIB)
-			zlog_debug("%s: Client %s stale route %pFX is deleted",
-				   __func__, zebra_route_string(client->proto),
-				   &rn->p);
-		rib_delnode(rn, re);
-
-		return true;
-	}
-
-	return false;
-}
-
-static void zebra_gr_delete_stale_route_table_afi(struct event *event)
-{
-	struct zebra_gr_afi_clean *gac = EVENT_ARG(event);
-	struct route_table *table;
-	struct route_node *rn;
-	struct route_entry *re, *next;
-	struct zebra_vrf *zvrf = zebra_vrf_lookup_by_id(gac->info->vrf_id);
-	int32_t n = 0;
-
-	if (!zvrf)
-		goto done;
-
-	table = zvrf->table[gac->afi][SAFI_UNICAST];
-	if (!table)
-		goto done;
-
-	for (rn = route_top(table); rn; rn = srcdest_route_next(rn)) {
-		RNODE_FOREACH_RE_SAFE (rn, re, next) {
-			if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
-				continue;
-
-			/* If the route refresh is received
-			 * after restart then do not delete
-			 * the route
-			 */
-
-			if (re->type == gac->proto &&
-			    re->instance == gac->instance &&
-			    zebra_gr_process_route_entry(
-				    gac->info->stale_client_ptr, rn, re))
-				n++;
-
-			/* If the max route count is reached
-			 * then timer thread will be restarted
-			 * Store the current prefix and afi
-			 */
-			if ((n >= ZEBRA_MAX_STALE_ROUTE_COUNT) &&
-			    (gac->info->do_delete == false)) {
-				event_add_timer(
-					zrouter.master,
-					zebra_gr_delete_stale_route_table_afi,
-					gac, ZEBRA_DEFAULT_STALE_UPDATE_DELAY,
-					&gac->t_gac);
-			}
-		}
-	}
-
-done:
-	XFREE(MTYPE_ZEBRA_GR, gac);
-}
-
 /*
  * This function walks through the route table for all vrf and deletes
  * the stale routes for the restarted client specified by the protocol
@@ -658,7 +573,6 @@ void zebra_gr_process_client(afi_t afi, vrf_id_t vrf_id, uint8_t proto,
 {
 	struct zserv *client = zserv_find_client(proto, instance);
 	struct client_gr_info *info = NULL;
-	struct zebra_gr_afi_clean *gac;
 
 	if (client == NULL)
 		return;
@@ -671,12 +585,6 @@ void zebra_gr_process_client(afi_t afi, vrf_id_t vrf_id, uint8_t proto,
 	if (info == NULL)
 		return;
 
-	gac = XCALLOC(MTYPE_ZEBRA_GR, sizeof(*gac));
-	gac->info = info;
-	gac->afi = afi;
-	gac->proto = proto;
-	gac->instance = instance;
-
-	event_add_event(zrouter.master, zebra_gr_delete_stale_route_table_afi,
-			gac, 0, &gac->t_gac);
+	/* Runs in the background, yielding every few thousand routes */
+	rib_sweep_gr_stale(afi, vrf_id, proto, instance, client->restart_time);
 }
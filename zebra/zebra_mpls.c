@@ -35,6 +35,7 @@
 #include "zebra/zebra_errors.h"
 
 DEFINE_MTYPE_STATIC(ZEBRA, LSP, "MPLS LSP object");
+DEFINE_MTYPE_STATIC(ZEBRA, LSP_BLOCK, "MPLS LSP block");
 DEFINE_MTYPE_STATIC(ZEBRA, FEC, "MPLS FEC object");
 DEFINE_MTYPE_STATIC(ZEBRA, NHLFE, "MPLS nexthop object");
 
@@ -74,14 +75,23 @@ static void lsp_schedule(struct hash_bucket *bucket, void *ctxt);
 static wq_item_status lsp_process(struct work_queue *wq, void *data);
 static void lsp_processq_del(struct work_queue *wq, void *data);
 static void lsp_processq_complete(struct work_queue *wq);
+static void lsp_processq_run_begin(struct work_queue *wq);
+static void lsp_processq_run_end(struct work_queue *wq);
 static int lsp_processq_add(struct zebra_lsp *lsp);
 static void *lsp_alloc(void *p);
 
+/* Label forwarding table access, see struct zebra_lsp_block */
+static struct zebra_lsp *lsp_table_lookup(struct zebra_vrf *zvrf,
+					  mpls_label_t label);
+static struct zebra_lsp *lsp_table_get(struct zebra_vrf *zvrf,
+				       mpls_label_t label);
+static void lsp_table_release(struct zebra_vrf *zvrf, struct zebra_lsp *lsp);
+
 /* Check whether lsp can be freed - no nhlfes, e.g., and call free api */
-static void lsp_check_free(struct hash *lsp_table, struct zebra_lsp **plsp);
+static void lsp_check_free(struct zebra_vrf *zvrf, struct zebra_lsp **plsp);
 
 /* Free lsp; sets caller's pointer to NULL */
-static void lsp_free(struct hash *lsp_table, struct zebra_lsp **plsp);
+static void lsp_free(struct zebra_vrf *zvrf, struct zebra_lsp **plsp);
 
 static char *nhlfe2str(const struct zebra_nhlfe *nhlfe, char *buf, int size);
 static char *nhlfe_config_str(const struct zebra_nhlfe *nhlfe, char *buf,
@@ -103,8 +113,8 @@ static int nhlfe_del(struct zebra_nhlfe *nhlfe);
 static void nhlfe_free(struct zebra_nhlfe *nhlfe);
 static void nhlfe_out_label_update(struct zebra_nhlfe *nhlfe,
 				   struct mpls_label_stack *nh_label);
-static int mpls_lsp_uninstall_all(struct hash *lsp_table, struct zebra_lsp *lsp,
-				  enum lsp_types_t type);
+static int mpls_lsp_uninstall_all(struct zebra_vrf *zvrf,
+				  struct zebra_lsp *lsp, enum lsp_types_t type);
 static int mpls_static_lsp_uninstall_all(struct zebra_vrf *zvrf,
 					 mpls_label_t in_label);
 static void nhlfe_print(struct zebra_nhlfe *nhlfe, struct vty *vty,
@@ -153,8 +163,6 @@ static void clear_nhlfe_installed(struct zebra_lsp *lsp)
 static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 		       struct route_node *rn, struct route_entry *re)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 	struct nexthop *nexthop;
@@ -163,16 +171,14 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 	int added, changed;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	lsp_type = lsp_type_from_re_type(re->type);
 	added = changed = 0;
 
 	/* Locate or allocate LSP entry. */
-	tmp_ile.in_label = label;
-	lsp = hash_get(lsp_table, &tmp_ile, lsp_alloc);
+	lsp = lsp_table_get(zvrf, label);
 
 	/* For each active nexthop, create NHLFE. Note that we deliberately skip
 	 * recursive nexthops right now, because intermediate hops won't
@@ -244,7 +250,7 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
 		if (lsp_processq_add(lsp))
 			return -1;
 	} else {
-		lsp_check_free(lsp_table, &lsp);
+		lsp_check_free(zvrf, &lsp);
 	}
 
 	return 0;
@@ -256,20 +262,16 @@ static int lsp_install(struct zebra_vrf *zvrf, mpls_label_t label,
  */
 static int lsp_uninstall(struct zebra_vrf *zvrf, mpls_label_t label)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 	char buf[BUFSIZ];
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_table_lookup(zvrf, label);
 	if (!lsp || (nhlfe_list_first(&lsp->nhlfe_list) == NULL))
 		return 0;
 
@@ -300,7 +302,7 @@ static int lsp_uninstall(struct zebra_vrf *zvrf, mpls_label_t label)
 		if (lsp_processq_add(lsp))
 			return -1;
 	} else {
-		lsp_check_free(lsp_table, &lsp);
+		lsp_check_free(zvrf, &lsp);
 	}
 
 	return 0;
@@ -1020,7 +1022,6 @@ static void lsp_processq_del(struct work_queue *wq, void *data)
 {
 	struct zebra_vrf *zvrf;
 	struct zebra_lsp *lsp;
-	struct hash *lsp_table;
 	struct zebra_nhlfe *nhlfe;
 
 	/* If zebra is shutting down, don't delete any structs,
@@ -1031,8 +1032,7 @@ static void lsp_processq_del(struct work_queue *wq, void *data)
 		return;
 
 	zvrf = zebra_vrf_lookup_by_id(VRF_DEFAULT);
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table) // unexpected
+	if (!zvrf->lsp_table) // unexpected
 		return;
 
 	lsp = (struct zebra_lsp *)data;
@@ -1055,7 +1055,7 @@ static void lsp_processq_del(struct work_queue *wq, void *data)
 			nhlfe_del(nhlfe);
 	}
 
-	lsp_check_free(lsp_table, &lsp);
+	lsp_check_free(zvrf, &lsp);
 }
 
 /*
@@ -1067,6 +1067,21 @@ static void lsp_processq_complete(struct work_queue *wq)
 	/* Nothing to do for now. */
 }
 
+/*
+ * Each run of the LSP queue may install or remove thousands of LSPs,
+ * e.g. after an IGP change; hand their dataplane updates over as one
+ * batch so the kernel provider can pack them into few netlink messages.
+ */
+static void lsp_processq_run_begin(struct work_queue *wq)
+{
+	dplane_batch_begin();
+}
+
+static void lsp_processq_run_end(struct work_queue *wq)
+{
+	dplane_batch_end();
+}
+
 /*
  * Add LSP forwarding entry to queue for subsequent processing.
  */
@@ -1109,7 +1124,7 @@ static void *lsp_alloc(void *p)
 /*
  * Check whether lsp can be freed - no nhlfes, e.g., and call free api
  */
-static void lsp_check_free(struct hash *lsp_table, struct zebra_lsp **plsp)
+static void lsp_check_free(struct zebra_vrf *zvrf, struct zebra_lsp **plsp)
 {
 	struct zebra_lsp *lsp;
 
@@ -1121,7 +1136,7 @@ static void lsp_check_free(struct hash *lsp_table, struct zebra_lsp **plsp)
 	if ((nhlfe_list_first(&lsp->nhlfe_list) == NULL) &&
 	    (nhlfe_list_first(&lsp->backup_nhlfe_list) == NULL) &&
 	    !CHECK_FLAG(lsp->flags, LSP_FLAG_SCHEDULED))
-		lsp_free(lsp_table, plsp);
+		lsp_free(zvrf, plsp);
 }
 
 static void lsp_free_nhlfe(struct zebra_lsp *lsp)
@@ -1140,10 +1155,10 @@ static void lsp_free_nhlfe(struct zebra_lsp *lsp)
 }
 
 /*
- * Dtor for an LSP: remove from ile hash, release any internal allocations,
+ * Dtor for an LSP: remove from label table, release any internal allocations,
  * free LSP object.
  */
-static void lsp_free(struct hash *lsp_table, struct zebra_lsp **plsp)
+static void lsp_free(struct zebra_vrf *zvrf, struct zebra_lsp **plsp)
 {
 	struct zebra_lsp *lsp;
 
@@ -1158,12 +1173,194 @@ static void lsp_free(struct hash *lsp_table, struct zebra_lsp **plsp)
 
 	lsp_free_nhlfe(lsp);
 
-	hash_release(lsp_table, &lsp->ile);
+	lsp_table_release(zvrf, lsp);
 	XFREE(MTYPE_LSP, lsp);
 
 	*plsp = NULL;
 }
 
+/*
+ * Label forwarding table. LSPs for labels inside the SRGB live in the
+ * lsp_block array, all others in the lsp_table hash.
+ */
+static inline bool lsp_block_covers(const struct zebra_lsp_block *block,
+				    mpls_label_t label)
+{
+	return label - block->base < block->size;
+}
+
+static struct zebra_lsp *lsp_table_lookup(struct zebra_vrf *zvrf,
+					  mpls_label_t label)
+{
+	struct zebra_lsp_block *block = &zvrf->lsp_block;
+	struct zebra_ile tmp_ile;
+
+	if (lsp_block_covers(block, label))
+		return block->lsps ? block->lsps[label - block->base] : NULL;
+
+	tmp_ile.in_label = label;
+	return hash_lookup(zvrf->lsp_table, &tmp_ile);
+}
+
+static void lsp_block_insert(struct zebra_lsp_block *block,
+			     struct zebra_lsp *lsp)
+{
+	if (!block->lsps)
+		block->lsps = XCALLOC(MTYPE_LSP_BLOCK,
+				      block->size * sizeof(*block->lsps));
+
+	block->lsps[lsp->ile.in_label - block->base] = lsp;
+	block->count++;
+}
+
+/* Locate or allocate the LSP for a label */
+static struct zebra_lsp *lsp_table_get(struct zebra_vrf *zvrf,
+				       mpls_label_t label)
+{
+	struct zebra_lsp_block *block = &zvrf->lsp_block;
+	struct zebra_ile tmp_ile;
+	struct zebra_lsp *lsp;
+
+	tmp_ile.in_label = label;
+	if (!lsp_block_covers(block, label))
+		return hash_get(zvrf->lsp_table, &tmp_ile, lsp_alloc);
+
+	lsp = block->lsps ? block->lsps[label - block->base] : NULL;
+	if (!lsp) {
+		lsp = lsp_alloc(&tmp_ile);
+		lsp_block_insert(block, lsp);
+	}
+
+	return lsp;
+}
+
+static void lsp_table_release(struct zebra_vrf *zvrf, struct zebra_lsp *lsp)
+{
+	struct zebra_lsp_block *block = &zvrf->lsp_block;
+	mpls_label_t label = lsp->ile.in_label;
+
+	if (!lsp_block_covers(block, label)) {
+		hash_release(zvrf->lsp_table, &lsp->ile);
+		return;
+	}
+
+	if (!block->lsps || block->lsps[label - block->base] != lsp)
+		return;
+
+	block->lsps[label - block->base] = NULL;
+	if (--block->count == 0)
+		XFREE(MTYPE_LSP_BLOCK, block->lsps);
+}
+
+/*
+ * Same semantics as hash_iterate()/hash_walk(): the callbacks get a bucket
+ * whose data is the LSP and may free that LSP.
+ */
+void zebra_mpls_lsp_table_iterate(struct zebra_vrf *zvrf,
+				  void (*func)(struct hash_bucket *, void *),
+				  void *arg)
+{
+	struct zebra_lsp_block *block = &zvrf->lsp_block;
+	struct hash_bucket bucket = {};
+	uint32_t i;
+
+	hash_iterate(zvrf->lsp_table, func, arg);
+
+	for (i = 0; i < block->size && block->lsps; i++) {
+		if (!block->lsps[i])
+			continue;
+
+		bucket.data = block->lsps[i];
+		(*func)(&bucket, arg);
+	}
+}
+
+struct lsp_table_walk_ctx {
+	int (*func)(struct hash_bucket *, void *);
+	void *arg;
+	bool aborted;
+};
+
+static int lsp_table_walk_cb(struct hash_bucket *hb, void *arg)
+{
+	struct lsp_table_walk_ctx *ctx = arg;
+
+	if ((*ctx->func)(hb, ctx->arg) == HASHWALK_ABORT) {
+		ctx->aborted = true;
+		return HASHWALK_ABORT;
+	}
+
+	return HASHWALK_CONTINUE;
+}
+
+void zebra_mpls_lsp_table_walk(struct zebra_vrf *zvrf,
+			       int (*func)(struct hash_bucket *, void *),
+			       void *arg)
+{
+	struct zebra_lsp_block *block = &zvrf->lsp_block;
+	struct lsp_table_walk_ctx ctx = { .func = func, .arg = arg };
+	struct hash_bucket bucket = {};
+	uint32_t i;
+
+	/* The block is only walked if the hash walk ran to completion. */
+	hash_walk(zvrf->lsp_table, lsp_table_walk_cb, &ctx);
+	if (ctx.aborted)
+		return;
+
+	for (i = 0; i < block->size && block->lsps; i++) {
+		if (!block->lsps[i])
+			continue;
+
+		bucket.data = block->lsps[i];
+		if ((*func)(&bucket, arg) == HASHWALK_ABORT)
+			return;
+	}
+}
+
+static void lsp_block_move_in(struct hash_bucket *bucket, void *arg)
+{
+	struct zebra_vrf *zvrf = arg;
+	struct zebra_lsp *lsp = bucket->data;
+
+	if (!lsp_block_covers(&zvrf->lsp_block, lsp->ile.in_label))
+		return;
+
+	hash_release(zvrf->lsp_table, &lsp->ile);
+	lsp_block_insert(&zvrf->lsp_block, lsp);
+}
+
+/*
+ * (Re)size the array part of the label table to the current SRGB, moving
+ * LSPs between the array and the hash as needed.
+ */
+static void lsp_block_update(struct zebra_vrf *zvrf)
+{
+	struct zebra_lsp_block *block = &zvrf->lsp_block;
+	uint32_t i;
+
+	if (zvrf->mpls_srgb.start_label == block->base &&
+	    zvrf->mpls_srgb.end_label - zvrf->mpls_srgb.start_label + 1 ==
+		    block->size)
+		return;
+
+	for (i = 0; i < block->size && block->lsps; i++) {
+		if (block->lsps[i])
+			(void)hash_get(zvrf->lsp_table, block->lsps[i],
+				       hash_alloc_intern);
+	}
+	XFREE(MTYPE_LSP_BLOCK, block->lsps);
+	block->count = 0;
+
+	block->base = zvrf->mpls_srgb.start_label;
+	if (zvrf->mpls_srgb.end_label >= zvrf->mpls_srgb.start_label)
+		block->size = zvrf->mpls_srgb.end_label -
+			      zvrf->mpls_srgb.start_label + 1;
+	else
+		block->size = 0;
+
+	hash_iterate(zvrf->lsp_table, lsp_block_move_in, zvrf);
+}
+
 /*
  * Create printable string for NHLFE entry.
  */
@@ -1401,8 +1598,8 @@ static void nhlfe_out_label_update(struct zebra_nhlfe *nhlfe,
 	nhlfe->nexthop->nh_label->label[0] = nh_label->label[0];
 }
 
-static int mpls_lsp_uninstall_all(struct hash *lsp_table, struct zebra_lsp *lsp,
-				  enum lsp_types_t type)
+static int mpls_lsp_uninstall_all(struct zebra_vrf *zvrf,
+				  struct zebra_lsp *lsp, enum lsp_types_t type)
 {
 	struct zebra_nhlfe *nhlfe;
 	int schedule_lsp = 0;
@@ -1463,7 +1660,7 @@ static int mpls_lsp_uninstall_all(struct hash *lsp_table, struct zebra_lsp *lsp,
 		if (lsp_processq_add(lsp))
 			return -1;
 	} else {
-		lsp_check_free(lsp_table, &lsp);
+		lsp_check_free(zvrf, &lsp);
 	}
 
 	return 0;
@@ -1476,22 +1673,18 @@ static int mpls_lsp_uninstall_all(struct hash *lsp_table, struct zebra_lsp *lsp,
 static int mpls_static_lsp_uninstall_all(struct zebra_vrf *zvrf,
 					 mpls_label_t in_label)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_table_lookup(zvrf, in_label);
 	if (!lsp || (nhlfe_list_first(&lsp->nhlfe_list) == NULL))
 		return 0;
 
-	return mpls_lsp_uninstall_all(lsp_table, lsp, ZEBRA_LSP_STATIC);
+	return mpls_lsp_uninstall_all(zvrf, lsp, ZEBRA_LSP_STATIC);
 }
 
 static json_object *nhlfe_json(struct zebra_nhlfe *nhlfe)
@@ -1730,6 +1923,35 @@ static int lsp_cmp(const struct zebra_lsp *lsp1, const struct zebra_lsp *lsp2)
 	return 0;
 }
 
+/* Return a sorted linked list of the label forwarding table */
+static struct list *lsp_table_get_sorted_list(struct zebra_vrf *zvrf)
+{
+	struct zebra_lsp_block *block = &zvrf->lsp_block;
+	struct list *hash_list, *sorted_list;
+	struct listnode *node;
+	struct zebra_lsp *lsp;
+	uint32_t i;
+
+	hash_list = hash_get_sorted_list(zvrf->lsp_table, lsp_cmp);
+	sorted_list = list_new();
+
+	/* The block is contiguous and already in label order */
+	for (ALL_LIST_ELEMENTS_RO(hash_list, node, lsp))
+		if (lsp->ile.in_label < block->base)
+			listnode_add(sorted_list, lsp);
+
+	for (i = 0; i < block->size && block->lsps; i++)
+		if (block->lsps[i])
+			listnode_add(sorted_list, block->lsps[i]);
+
+	for (ALL_LIST_ELEMENTS_RO(hash_list, node, lsp))
+		if (lsp->ile.in_label >= block->base)
+			listnode_add(sorted_list, lsp);
+
+	list_delete(&hash_list);
+	return sorted_list;
+}
+
 /*
  * Initialize work queue for processing changed LSPs.
  */
@@ -1740,6 +1962,8 @@ static void mpls_processq_init(void)
 	zrouter.lsp_process_q->spec.workfunc = &lsp_process;
 	zrouter.lsp_process_q->spec.del_item_data = &lsp_processq_del;
 	zrouter.lsp_process_q->spec.completion_func = &lsp_processq_complete;
+	zrouter.lsp_process_q->spec.run_begin = &lsp_processq_run_begin;
+	zrouter.lsp_process_q->spec.run_end = &lsp_processq_run_end;
 	zrouter.lsp_process_q->spec.max_retries = 0;
 	zrouter.lsp_process_q->spec.hold = 10;
 }
@@ -1752,8 +1976,6 @@ void zebra_mpls_lsp_dplane_result(struct zebra_dplane_ctx *ctx)
 {
 	struct zebra_vrf *zvrf;
 	mpls_label_t label;
-	struct zebra_ile tmp_ile;
-	struct hash *lsp_table;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 	struct nexthop *nexthop;
@@ -1775,10 +1997,7 @@ void zebra_mpls_lsp_dplane_result(struct zebra_dplane_ctx *ctx)
 	if (op == DPLANE_OP_LSP_INSTALL || op == DPLANE_OP_LSP_UPDATE) {
 		/* Look for zebra LSP object */
 		zvrf = zebra_vrf_lookup_by_id(VRF_DEFAULT);
-		lsp_table = zvrf->lsp_table;
-
-		tmp_ile.in_label = label;
-		lsp = hash_lookup(lsp_table, &tmp_ile);
+		lsp = lsp_table_lookup(zvrf, label);
 		if (lsp == NULL) {
 			if (IS_ZEBRA_DEBUG_DPLANE)
 				zlog_debug("LSP ctx %p: in-label %u not found",
@@ -2016,8 +2235,6 @@ static int update_nhlfes_from_ctx(struct nhlfe_list_head *nhlfe_head,
 void zebra_mpls_process_dplane_notify(struct zebra_dplane_ctx *ctx)
 {
 	struct zebra_vrf *zvrf;
-	struct zebra_ile tmp_ile;
-	struct hash *lsp_table;
 	struct zebra_lsp *lsp;
 	const struct nhlfe_list_head *ctx_list;
 	int start_count = 0, end_count = 0; /* Installed counts */
@@ -2031,10 +2248,7 @@ void zebra_mpls_process_dplane_notify(struct zebra_dplane_ctx *ctx)
 
 	/* Look for zebra LSP object */
 	zvrf = zebra_vrf_lookup_by_id(VRF_DEFAULT);
-	lsp_table = zvrf->lsp_table;
-
-	tmp_ile.in_label = dplane_ctx_get_in_label(ctx);
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_table_lookup(zvrf, dplane_ctx_get_in_label(ctx));
 	if (lsp == NULL) {
 		if (is_debug)
 			zlog_debug("dplane LSP notif: in-label %u not found",
@@ -2433,7 +2647,7 @@ static int zebra_mpls_cleanup_fecs_for_client(struct zserv *client)
 }
 
 struct lsp_uninstall_args {
-	struct hash *lsp_table;
+	struct zebra_vrf *zvrf;
 	enum lsp_types_t type;
 };
 
@@ -2453,10 +2667,10 @@ static int zebra_mpls_cleanup_zclient_labels(struct zserv *client)
 			continue;
 
 		/* Cleanup LSPs. */
-		args.lsp_table = zvrf->lsp_table;
+		args.zvrf = zvrf;
 		args.type = lsp_type_from_re_type(client->proto);
-		hash_iterate(zvrf->lsp_table, mpls_lsp_uninstall_all_type,
-			     &args);
+		zebra_mpls_lsp_table_iterate(zvrf, mpls_lsp_uninstall_all_type,
+					     &args);
 
 		/* Cleanup FTNs. */
 		mpls_ftn_uninstall_all(zvrf, AFI_IP,
@@ -2864,20 +3078,16 @@ void zebra_mpls_zapi_labels_process(bool add_p, struct zebra_vrf *zvrf,
 	bool found;
 	afi_t afi = AFI_IP;
 	const struct prefix *prefix = NULL;
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp = NULL;
 
 	/* Prep LSP for add case */
 	if (add_p) {
 		/* Lookup table. */
-		lsp_table = zvrf->lsp_table;
-		if (!lsp_table)
+		if (!zvrf->lsp_table)
 			return;
 
 		/* Find or create LSP object */
-		tmp_ile.in_label = zl->local_label;
-		lsp = hash_get(lsp_table, &tmp_ile, lsp_alloc);
+		lsp = lsp_table_get(zvrf, zl->local_label);
 	}
 
 	/* Prep for route/FEC update if requested */
@@ -3150,19 +3360,15 @@ int mpls_lsp_install(struct zebra_vrf *zvrf, enum lsp_types_t type,
 		     const mpls_label_t *out_labels, enum nexthop_types_t gtype,
 		     const union g_addr *gate, ifindex_t ifindex)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* Find or create LSP object */
-	tmp_ile.in_label = in_label;
-	lsp = hash_get(lsp_table, &tmp_ile, lsp_alloc);
+	lsp = lsp_table_get(zvrf, in_label);
 
 	nhlfe = lsp_add_nhlfe(lsp, type, num_out_labels, out_labels, gtype,
 			      gate, ifindex, VRF_DEFAULT, false /*backup*/);
@@ -3241,17 +3447,13 @@ static int lsp_backup_znh_install(struct zebra_lsp *lsp, enum lsp_types_t type,
 
 struct zebra_lsp *mpls_lsp_find(struct zebra_vrf *zvrf, mpls_label_t in_label)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return NULL;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	return hash_lookup(lsp_table, &tmp_ile);
+	return lsp_table_lookup(zvrf, in_label);
 }
 
 /*
@@ -3263,21 +3465,17 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 		       const union g_addr *gate, ifindex_t ifindex,
 		       bool backup_p)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 	struct zebra_nhlfe *nhlfe;
 	char buf[NEXTHOP_STRLEN];
 	bool schedule_lsp = false;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_table_lookup(zvrf, in_label);
 	if (!lsp)
 		return 0;
 
@@ -3314,7 +3512,7 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 		nhlfe_del(nhlfe);
 
 		/* Free LSP entry if no other NHLFEs and not scheduled. */
-		lsp_check_free(lsp_table, &lsp);
+		lsp_check_free(zvrf, &lsp);
 	}
 	return 0;
 }
@@ -3322,22 +3520,18 @@ int mpls_lsp_uninstall(struct zebra_vrf *zvrf, enum lsp_types_t type,
 int mpls_lsp_uninstall_all_vrf(struct zebra_vrf *zvrf, enum lsp_types_t type,
 			       mpls_label_t in_label)
 {
-	struct hash *lsp_table;
-	struct zebra_ile tmp_ile;
 	struct zebra_lsp *lsp;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table)
+	if (!zvrf->lsp_table)
 		return -1;
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = in_label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_table_lookup(zvrf, in_label);
 	if (!lsp)
 		return 0;
 
-	return mpls_lsp_uninstall_all(lsp_table, lsp, type);
+	return mpls_lsp_uninstall_all(zvrf, lsp, type);
 }
 
 /*
@@ -3348,17 +3542,15 @@ static void mpls_lsp_uninstall_all_type(struct hash_bucket *bucket, void *ctxt)
 {
 	struct lsp_uninstall_args *args = ctxt;
 	struct zebra_lsp *lsp;
-	struct hash *lsp_table;
 
 	lsp = (struct zebra_lsp *)bucket->data;
 	if (nhlfe_list_first(&lsp->nhlfe_list) == NULL)
 		return;
 
-	lsp_table = args->lsp_table;
-	if (!lsp_table)
+	if (!args->zvrf->lsp_table)
 		return;
 
-	mpls_lsp_uninstall_all(lsp_table, lsp, args->type);
+	mpls_lsp_uninstall_all(args->zvrf, lsp, args->type);
 }
 
 /*
@@ -3658,7 +3850,7 @@ void zebra_mpls_lsp_schedule(struct zebra_vrf *zvrf)
 {
 	if (!zvrf)
 		return;
-	hash_iterate(zvrf->lsp_table, lsp_schedule, NULL);
+	zebra_mpls_lsp_table_iterate(zvrf, lsp_schedule, NULL);
 }
 
 /*
@@ -3668,22 +3860,18 @@ void zebra_mpls_lsp_schedule(struct zebra_vrf *zvrf)
 void zebra_mpls_print_lsp(struct vty *vty, struct zebra_vrf *zvrf,
 			  mpls_label_t label, bool use_json)
 {
-	struct hash *lsp_table;
 	struct zebra_lsp *lsp;
-	struct zebra_ile tmp_ile;
 	json_object *json = NULL;
 
 	/* Lookup table. */
-	lsp_table = zvrf->lsp_table;
-	if (!lsp_table) {
+	if (!zvrf->lsp_table) {
 		if (use_json)
 			vty_out(vty, "{}\n");
 		return;
 	}
 
 	/* If entry is not present, exit. */
-	tmp_ile.in_label = label;
-	lsp = hash_lookup(lsp_table, &tmp_ile);
+	lsp = lsp_table_lookup(zvrf, label);
 	if (!lsp) {
 		if (use_json)
 			vty_out(vty, "{}\n");
@@ -3708,7 +3896,7 @@ void zebra_mpls_print_lsp_table(struct vty *vty, struct zebra_vrf *zvrf,
 	struct zebra_lsp *lsp = NULL;
 	struct zebra_nhlfe *nhlfe = NULL;
 	struct listnode *node = NULL;
-	struct list *lsp_list = hash_get_sorted_list(zvrf->lsp_table, lsp_cmp);
+	struct list *lsp_list = lsp_table_get_sorted_list(zvrf);
 
 	if (use_json) {
 		json = json_object_new_object();
@@ -3888,6 +4076,7 @@ int zebra_mpls_label_block_add(struct zebra_vrf *zvrf, uint32_t start_label,
 {
 	zvrf->mpls_srgb.start_label = start_label;
 	zvrf->mpls_srgb.end_label = end_label;
+	lsp_block_update(zvrf);
 
 	/* Evaluate registered FECs to see if any get a label or not. */
 	fec_evaluate(zvrf);
@@ -3901,6 +4090,7 @@ int zebra_mpls_label_block_del(struct zebra_vrf *zvrf)
 {
 	zvrf->mpls_srgb.start_label = MPLS_DEFAULT_MIN_SRGB_LABEL;
 	zvrf->mpls_srgb.end_label = MPLS_DEFAULT_MAX_SRGB_LABEL;
+	lsp_block_update(zvrf);
 
 	/* Process registered FECs to clear their local label, if needed. */
 	fec_evaluate(zvrf);
@@ -3934,7 +4124,8 @@ void zebra_mpls_cleanup_tables(struct zebra_vrf *zvrf)
 	afi_t afi;
 
 	if (zvrf_id(zvrf) == VRF_DEFAULT)
-		hash_iterate(zvrf->lsp_table, lsp_uninstall_from_kernel, NULL);
+		zebra_mpls_lsp_table_iterate(zvrf, lsp_uninstall_from_kernel,
+					     NULL);
 	else {
 		/*
 		 * For other vrfs, we try to remove associated LSPs; we locate
@@ -3996,6 +4187,18 @@ static void lsp_table_free(void *p)
 	XFREE(MTYPE_LSP, lsp);
 }
 
+static void lsp_block_free(struct zebra_lsp_block *block)
+{
+	uint32_t i;
+
+	for (i = 0; i < block->size && block->lsps; i++) {
+		if (block->lsps[i])
+			lsp_table_free(block->lsps[i]);
+	}
+	XFREE(MTYPE_LSP_BLOCK, block->lsps);
+	block->count = 0;
+}
+
 /*
  * Called upon process exiting, need to delete LSP forwarding
  * entries from the kernel.
@@ -4003,7 +4206,8 @@ static void lsp_table_free(void *p)
  */
 void zebra_mpls_close_tables(struct zebra_vrf *zvrf)
 {
-	hash_iterate(zvrf->lsp_table, lsp_uninstall_from_kernel, NULL);
+	zebra_mpls_lsp_table_iterate(zvrf, lsp_uninstall_from_kernel, NULL);
+	lsp_block_free(&zvrf->lsp_block);
 	hash_clean_and_free(&zvrf->lsp_table, lsp_table_free);
 	hash_clean_and_free(&zvrf->slsp_table, lsp_table_free);
 	route_table_finish(zvrf->fec_table[AFI_IP]);
@@ -4033,6 +4237,7 @@ void zebra_mpls_init_tables(struct zebra_vrf *zvrf)
 	zvrf->mpls_flags = 0;
 	zvrf->mpls_srgb.start_label = MPLS_DEFAULT_MIN_SRGB_LABEL;
 	zvrf->mpls_srgb.end_label = MPLS_DEFAULT_MAX_SRGB_LABEL;
+	lsp_block_update(zvrf);
 }
 
 void zebra_mpls_turned_on(void)
@@ -355,6 +355,17 @@ void zebra_mpls_process_dplane_notify(struct zebra_dplane_ctx *ctx);
  */
 void zebra_mpls_lsp_schedule(struct zebra_vrf *zvrf);
 
+/*
+ * Walk all entries of the MPLS label forwarding table; the bucket data is
+ * the struct zebra_lsp. Same semantics as hash_iterate() and hash_walk().
+ */
+void zebra_mpls_lsp_table_iterate(struct zebra_vrf *zvrf,
+				  void (*func)(struct hash_bucket *, void *),
+				  void *arg);
+void zebra_mpls_lsp_table_walk(struct zebra_vrf *zvrf,
+			       int (*func)(struct hash_bucket *, void *),
+			       void *arg);
+
 /*
  * Display MPLS label forwarding table for a specific LSP
  * (VTY command handler).
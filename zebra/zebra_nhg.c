@@ -10,7 +10,6 @@
 #include "lib/nexthop_group_private.h"
 #include "lib/routemap.h"
 #include "lib/mpls.h"
-#include "lib/jhash.h"
 #include "lib/debug.h"
 #include "lib/lib_errors.h"
 
@@ -51,6 +50,9 @@ uint32_t id_counter;
 static bool g_nexthops_enabled = true;
 static bool proto_nexthops_only;
 static bool use_recursive_backups = true;
+static bool replace_in_place;
+
+static struct zebra_nhg_stats nhg_stats;
 
 static struct nhg_hash_entry *depends_find(const struct nexthop *nh, afi_t afi,
 					   int type, bool from_dplane);
@@ -385,6 +387,7 @@ struct nhg_hash_entry *zebra_nhg_alloc(void)
 	struct nhg_hash_entry *nhe;
 
 	nhe = XCALLOC(MTYPE_NHG, sizeof(struct nhg_hash_entry));
+	nhe_route_list_init(&nhe->routes);
 
 	return nhe;
 }
@@ -424,6 +427,7 @@ static void *zebra_nhg_hash_alloc(void *arg)
 	struct nhg_hash_entry *copy = arg;
 
 	nhe = zebra_nhe_copy(copy, copy->id);
+	nhe->fingerprint = copy->fingerprint;
 
 	/* Mark duplicate nexthops in a group at creation time. */
 	nexthop_group_mark_duplicates(&(nhe->nhg));
@@ -453,156 +457,6 @@ static void *zebra_nhg_hash_alloc(void *arg)
 	return nhe;
 }
 
-uint32_t zebra_nhg_hash_key(const void *arg)
-{
-	const struct nhg_hash_entry *nhe = arg;
-	uint32_t key = 0x5a351234;
-	uint32_t primary = 0;
-	uint32_t backup = 0;
-
-	primary = nexthop_group_hash(&(nhe->nhg));
-	if (nhe->backup_info)
-		backup = nexthop_group_hash(&(nhe->backup_info->nhe->nhg));
-
-	key = jhash_3words(primary, backup, nhe->type, key);
-
-	key = jhash_2words(nhe->vrf_id, nhe->afi, key);
-
-	return key;
-}
-
-uint32_t zebra_nhg_id_key(const void *arg)
-{
-	const struct nhg_hash_entry *nhe = arg;
-
-	return nhe->id;
-}
-
-/* Helper with common nhg/nhe nexthop comparison logic */
-static bool nhg_compare_nexthops(const struct nexthop *nh1,
-				 const struct nexthop *nh2)
-{
-	assert(nh1 != NULL && nh2 != NULL);
-
-	/*
-	 * We have to check the active flag of each individual one,
-	 * not just the overall active_num. This solves the special case
-	 * issue of a route with a nexthop group with one nexthop
-	 * resolving to itself and thus marking it inactive. If we
-	 * have two different routes each wanting to mark a different
-	 * nexthop inactive, they need to hash to two different groups.
-	 *
-	 * If we just hashed on num_active, they would hash the same
-	 * which is incorrect.
-	 *
-	 * ex)
-	 *      1.1.1.0/24
-	 *           -> 1.1.1.1 dummy1 (inactive)
-	 *           -> 1.1.2.1 dummy2
-	 *
-	 *      1.1.2.0/24
-	 *           -> 1.1.1.1 dummy1
-	 *           -> 1.1.2.1 dummy2 (inactive)
-	 *
-	 * Without checking each individual one, they would hash to
-	 * the same group and both have 1.1.1.1 dummy1 marked inactive.
-	 *
-	 */
-	if (CHECK_FLAG(nh1->flags, NEXTHOP_FLAG_ACTIVE)
-	    != CHECK_FLAG(nh2->flags, NEXTHOP_FLAG_ACTIVE))
-		return false;
-
-	if (!nexthop_same(nh1, nh2))
-		return false;
-
-	return true;
-}
-
-bool zebra_nhg_hash_equal(const void *arg1, const void *arg2)
-{
-	const struct nhg_hash_entry *nhe1 = arg1;
-	const struct nhg_hash_entry *nhe2 = arg2;
-	struct nexthop *nexthop1;
-	struct nexthop *nexthop2;
-
-	/* No matter what if they equal IDs, assume equal */
-	if (nhe1->id && nhe2->id && (nhe1->id == nhe2->id))
-		return true;
-
-	if (nhe1->type != nhe2->type)
-		return false;
-
-	if (nhe1->vrf_id != nhe2->vrf_id)
-		return false;
-
-	if (nhe1->afi != nhe2->afi)
-		return false;
-
-	if (nhe1->nhg.nhgr.buckets != nhe2->nhg.nhgr.buckets)
-		return false;
-
-	if (nhe1->nhg.nhgr.idle_timer != nhe2->nhg.nhgr.idle_timer)
-		return false;
-
-	if (nhe1->nhg.nhgr.unbalanced_timer != nhe2->nhg.nhgr.unbalanced_timer)
-		return false;
-
-	/* Nexthops should be in-order, so we simply compare them in-place */
-	for (nexthop1 = nhe1->nhg.nexthop, nexthop2 = nhe2->nhg.nexthop;
-	     nexthop1 && nexthop2;
-	     nexthop1 = nexthop1->next, nexthop2 = nexthop2->next) {
-
-		if (!nhg_compare_nexthops(nexthop1, nexthop2))
-			return false;
-	}
-
-	/* Check for unequal list lengths */
-	if (nexthop1 || nexthop2)
-		return false;
-
-	/* If there's no backup info, comparison is done. */
-	if ((nhe1->backup_info == NULL) && (nhe2->backup_info == NULL))
-		return true;
-
-	/* Compare backup info also - test the easy things first */
-	if (nhe1->backup_info && (nhe2->backup_info == NULL))
-		return false;
-	if (nhe2->backup_info && (nhe1->backup_info == NULL))
-		return false;
-
-	/* Compare number of backups before actually comparing any */
-	for (nexthop1 = nhe1->backup_info->nhe->nhg.nexthop,
-	     nexthop2 = nhe2->backup_info->nhe->nhg.nexthop;
-	     nexthop1 && nexthop2;
-	     nexthop1 = nexthop1->next, nexthop2 = nexthop2->next) {
-		;
-	}
-
-	/* Did we find the end of one list before the other? */
-	if (nexthop1 || nexthop2)
-		return false;
-
-	/* Have to compare the backup nexthops */
-	for (nexthop1 = nhe1->backup_info->nhe->nhg.nexthop,
-	     nexthop2 = nhe2->backup_info->nhe->nhg.nexthop;
-	     nexthop1 && nexthop2;
-	     nexthop1 = nexthop1->next, nexthop2 = nexthop2->next) {
-
-		if (!nhg_compare_nexthops(nexthop1, nexthop2))
-			return false;
-	}
-
-	return true;
-}
-
-bool zebra_nhg_hash_id_equal(const void *arg1, const void *arg2)
-{
-	const struct nhg_hash_entry *nhe1 = arg1;
-	const struct nhg_hash_entry *nhe2 = arg2;
-
-	return nhe1->id == nhe2->id;
-}
-
 static int zebra_nhg_process_grp(struct nexthop_group *nhg,
 				 struct nhg_connected_tree_head *depends,
 				 struct nh_grp *grp, uint8_t count,
@@ -681,6 +535,9 @@ static bool zebra_nhe_find(struct nhg_hash_entry **nhe, /* return value */
 	struct nexthop *nh = NULL;
 
 
+	/* 'lookup' may have been modified since it was last hashed. */
+	lookup->fingerprint = zebra_nhg_fingerprint(lookup);
+
 	if (lookup->id)
 		(*nhe) = zebra_nhg_lookup_id(lookup->id);
 	else
@@ -2868,6 +2725,118 @@ static uint32_t proto_nhg_nexthop_active_update(struct nexthop_group *nhg)
 	return curr_active;
 }
 
+/*
+ * Whether a route using the group being replaced computes the same active
+ * nexthops as curr.  Resolution also depends on the route itself (its own
+ * prefix, type and flags), routes that disagree would keep replacing the
+ * group for each other.
+ */
+static bool zebra_nhg_route_agrees(struct route_entry *re,
+				   const struct nhg_hash_entry *curr)
+{
+	struct nhg_hash_entry *check;
+	uint32_t status = re->status;
+	uint32_t mtu = re->nexthop_mtu;
+	bool same;
+
+	check = zebra_nhe_copy(re->nhe, 0);
+	nexthop_list_active_update(re->rn, re, check, false);
+	check->fingerprint = zebra_nhg_fingerprint(check);
+	same = zebra_nhg_hash_equal(check, curr);
+	zebra_nhg_free(check);
+
+	/* only a dry run, the route gets processed for real later */
+	re->status = status;
+	re->nexthop_mtu = mtu;
+	return same;
+}
+
+/*
+ * Rewrite a zebra-created ECMP group whose active members changed under its
+ * existing ID. All routes using the group are moved to the rewritten entry
+ * and queued for processing with ROUTE_ENTRY_NHG_IN_PLACE: they go through
+ * the usual change handling (notifications, redistribution, FIB flags and
+ * dataplane providers), only the kernel route update is skipped since the
+ * kernel sees the nexthop replace.
+ *
+ * Returns true if the group was replaced.
+ */
+static bool zebra_nhg_replace_group(struct route_entry *re,
+				    struct nhg_hash_entry *curr, afi_t afi)
+{
+	struct nhg_hash_entry *old = re->nhe;
+	struct nhg_hash_entry *new;
+	struct nhg_connected *rb_node_dep = NULL;
+	struct route_entry *other;
+
+	if (!replace_in_place || !g_nexthops_enabled || proto_nexthops_only)
+		return false;
+
+	if (!ZEBRA_OWNED(old) || PROTO_OWNED(old))
+		return false;
+
+	/* Only groups that nothing else depends on */
+	if (!old->nhg.nexthop || !old->nhg.nexthop->next ||
+	    zebra_nhg_get_backup_nhg(old) ||
+	    !zebra_nhg_dependents_is_empty(old))
+		return false;
+
+	if (!CHECK_FLAG(old->flags, NEXTHOP_GROUP_INSTALLED) ||
+	    CHECK_FLAG(old->flags, NEXTHOP_GROUP_QUEUED))
+		return false;
+
+	/* If the new state is already known, just share it */
+	curr->fingerprint = zebra_nhg_fingerprint(curr);
+	if (hash_lookup(zrouter.nhgs, curr))
+		return false;
+
+	frr_each (nhe_route_list, &old->routes, other) {
+		if (other == re || !other->rn)
+			continue;
+		if (!zebra_nhg_route_agrees(other, curr))
+			return false;
+	}
+
+	if (IS_ZEBRA_DEBUG_NHG_DETAIL)
+		zlog_debug("%s: replacing nhe %p (%pNG) in place", __func__,
+			   old, old);
+
+	hash_release(zrouter.nhgs, old);
+	hash_release(zrouter.nhgs_id, old);
+	zebra_nhg_release_all_deps(old);
+
+	curr->id = old->id;
+	new = zebra_nhg_rib_find_nhe(curr, afi);
+	curr->id = 0;
+
+	/* Keep the old entry around until every route is moved over */
+	zebra_nhg_increment_ref(old);
+
+	zebra_nhg_install_kernel(new);
+
+	frr_each (nhe_route_list, &old->routes, other) {
+		SET_FLAG(other->status, ROUTE_ENTRY_NHG_IN_PLACE);
+		if (other == re || !other->rn)
+			continue;
+
+		SET_FLAG(other->status, ROUTE_ENTRY_CHANGED);
+		rib_queue_add(other->rn);
+	}
+
+	rib_handle_nhg_replace(old, new);
+
+	frr_each (nhg_connected_tree, &old->nhg_depends, rb_node_dep)
+		zebra_nhg_decrement_ref(rb_node_dep->nhe);
+
+	/* Dont call the dec API, we dont want to uninstall the ID */
+	old->refcnt = 0;
+	EVENT_OFF(old->timer);
+	zebra_nhg_free(old);
+
+	nhg_stats.in_place_replaces++;
+	return true;
+}
+
 /*
  * Iterate over all nexthops of the given RIB entry and refresh their
  * ACTIVE flag.  If any nexthop is found to toggle the ACTIVE flag,
@@ -2929,6 +2898,18 @@ backups_done:
 	if (CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED)) {
 		struct nhg_hash_entry *new_nhe = NULL;
 
+		/*
+		 * The group is rewritten under the same ID and re already
+		 * points at it, the route stays changed for the rest of
+		 * its processing.
+		 */
+		if (curr_active &&
+		    zebra_nhg_replace_group(re, curr_nhe, rt_afi))
+			goto replaced;
+
+		/* Moving to another group does need a kernel update */
+		UNSET_FLAG(re->status, ROUTE_ENTRY_NHG_IN_PLACE);
+
 		new_nhe = zebra_nhg_rib_find_nhe(curr_nhe, rt_afi);
 
 		if (IS_ZEBRA_DEBUG_NHG_DETAIL)
@@ -2938,9 +2919,16 @@ backups_done:
 				new_nhe);
 
 		route_entry_update_nhe(re, new_nhe);
+	} else if (CHECK_FLAG(re->status, ROUTE_ENTRY_NHG_IN_PLACE)) {
+		/*
+		 * Moved over by the in place replace of another route: the
+		 * nexthops are current, but the change still has to be
+		 * handled for this route.
+		 */
+		SET_FLAG(re->status, ROUTE_ENTRY_CHANGED);
 	}
 
-
+replaced:
 	/* Walk the NHE depends tree and toggle NEXTHOP_GROUP_VALID
 	 * flag where appropriate.
 	 */
@@ -3184,6 +3172,8 @@ void zebra_nhg_dplane_result(struct zebra_dplane_ctx *ctx)
 		switch (status) {
 		case ZEBRA_DPLANE_REQUEST_SUCCESS:
 			SET_FLAG(nhe->flags, NEXTHOP_GROUP_INSTALLED);
+			nhe->install_count++;
+			nhg_stats.installs++;
 			zebra_nhg_handle_install(nhe, true);
 
 			/* If daemon nhg, send it an update */
@@ -3194,6 +3184,7 @@ void zebra_nhg_dplane_result(struct zebra_dplane_ctx *ctx)
 			break;
 		case ZEBRA_DPLANE_REQUEST_FAILURE:
 			UNSET_FLAG(nhe->flags, NEXTHOP_GROUP_INSTALLED);
+			nhg_stats.install_failures++;
 			/* If daemon nhg, send it an update */
 			if (PROTO_OWNED(nhe))
 				zsend_nhg_notify(nhe->type, nhe->zapi_instance,
@@ -3345,6 +3336,27 @@ bool zebra_nhg_proto_nexthops_only(void)
 	return proto_nexthops_only;
 }
 
+/*
+ * Global control to replace zebra-created ECMP groups in place.
+ *
+ * Default is off: the new member set of a group is computed per route, and
+ * a route-map may make routes sharing a group disagree about it.
+ */
+void zebra_nhg_set_replace_in_place(bool set)
+{
+	replace_in_place = set;
+}
+
+bool zebra_nhg_replace_in_place(void)
+{
+	return replace_in_place;
+}
+
+const struct zebra_nhg_stats *zebra_nhg_get_stats(void)
+{
+	return &nhg_stats;
+}
+
 /* Add NHE from upper level proto */
 struct nhg_hash_entry *zebra_nhg_proto_add(uint32_t id, int type,
 					   uint16_t instance, uint32_t session,
@@ -26,6 +26,7 @@ struct nh_grp {
 };
 
 PREDECL_RBTREE_UNIQ(nhg_connected_tree);
+PREDECL_DLIST(nhe_route_list);
 
 /*
  * Hashtables containing nhg entries is in `zebra_router`.
@@ -50,6 +51,13 @@ struct nhg_hash_entry {
 	/* If supported, a mapping of backup nexthops. */
 	struct nhg_backup_info *backup_info;
 
+	/*
+	 * Fingerprint of the nexthops, backups and identity of this entry,
+	 * see zebra_nhg_fingerprint(). Computed when the entry is looked up
+	 * in or added to the hash, 0 if not known.
+	 */
+	uint64_t fingerprint;
+
 	/* If this is not a group, it
 	 * will be a single nexthop
 	 * and must have an interface
@@ -61,6 +69,9 @@ struct nhg_hash_entry {
 	uint32_t refcnt;
 	uint32_t dplane_ref;
 
+	/* Number of successful installs/replaces in the dataplane */
+	uint32_t install_count;
+
 	uint32_t flags;
 
 	/* Dependency trees for other entries.
@@ -89,6 +100,9 @@ struct nhg_hash_entry {
 	 */
 	struct nhg_connected_tree_head nhg_depends, nhg_dependents;
 
+	/* Route entries using this entry, see route_entry_update_nhe() */
+	struct nhe_route_list_head routes;
+
 	struct event *timer;
 
 /*
@@ -241,6 +255,23 @@ bool zebra_nhg_proto_nexthops_only(void);
 void zebra_nhg_set_recursive_use_backups(bool set);
 bool zebra_nhg_recursive_use_backups(void);
 
+/*
+ * Global control to rewrite zebra-created ECMP groups under their existing
+ * ID when their active members change, instead of moving every route that
+ * uses the group over to a new one.
+ */
+void zebra_nhg_set_replace_in_place(bool set);
+bool zebra_nhg_replace_in_place(void);
+
+/* Dataplane counters, for show nexthop-group rib summary */
+struct zebra_nhg_stats {
+	uint64_t installs;
+	uint64_t install_failures;
+	uint64_t in_place_replaces;
+};
+
+const struct zebra_nhg_stats *zebra_nhg_get_stats(void);
+
 /**
  * NHE abstracted tree functions.
  * Use these where possible instead of direct access.
@@ -282,7 +313,8 @@ extern bool zebra_nhg_dependents_is_empty(const struct nhg_hash_entry *nhe);
 /* Lookup ID, doesn't create */
 extern struct nhg_hash_entry *zebra_nhg_lookup_id(uint32_t id);
 
-/* Hash functions */
+/* Hash functions, see zebra_nhg_hash.c */
+extern uint64_t zebra_nhg_fingerprint(const struct nhg_hash_entry *nhe);
 extern uint32_t zebra_nhg_hash_key(const void *arg);
 extern uint32_t zebra_nhg_id_key(const void *arg);
 
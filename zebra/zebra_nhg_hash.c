@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Zebra nexthop group hashing and comparison.
+ *
+ * Kept apart from zebra_nhg.c so that the hash functions the nexthop group
+ * tables use can be exercised on their own.
+ */
+
+#include <zebra.h>
+
+#include "lib/jhash.h"
+#include "lib/nexthop.h"
+#include "lib/nexthop_group.h"
+#include "zebra/zebra_nhg.h"
+
+uint64_t zebra_nhg_fingerprint(const struct nhg_hash_entry *nhe)
+{
+	uint64_t primary, backup = 0;
+	uint32_t lo, hi;
+
+	primary = nexthop_group_fingerprint(&(nhe->nhg));
+	if (nhe->backup_info)
+		backup = nexthop_group_fingerprint(
+			&(nhe->backup_info->nhe->nhg));
+
+	lo = jhash_3words(primary, backup, nhe->type, 0x5a351234);
+	lo = jhash_2words(nhe->vrf_id, nhe->afi, lo);
+	hi = jhash_3words(primary >> 32, backup >> 32, lo, 0x3c6ef372);
+
+	return ((uint64_t)hi << 32) | lo;
+}
+
+uint32_t zebra_nhg_hash_key(const void *arg)
+{
+	const struct nhg_hash_entry *nhe = arg;
+	uint64_t fingerprint = nhe->fingerprint;
+
+	if (!fingerprint)
+		fingerprint = zebra_nhg_fingerprint(nhe);
+
+	return (uint32_t)fingerprint;
+}
+
+uint32_t zebra_nhg_id_key(const void *arg)
+{
+	const struct nhg_hash_entry *nhe = arg;
+
+	return nhe->id;
+}
+
+/* Helper with common nhg/nhe nexthop comparison logic */
+static bool nhg_compare_nexthops(const struct nexthop *nh1,
+				 const struct nexthop *nh2)
+{
+	assert(nh1 != NULL && nh2 != NULL);
+
+	/*
+	 * We have to check the active flag of each individual one,
+	 * not just the overall active_num. This solves the special case
+	 * issue of a route with a nexthop group with one nexthop
+	 * resolving to itself and thus marking it inactive. If we
+	 * have two different routes each wanting to mark a different
+	 * nexthop inactive, they need to hash to two different groups.
+	 *
+	 * If we just hashed on num_active, they would hash the same
+	 * which is incorrect.
+	 *
+	 * ex)
+	 *      1.1.1.0/24
+	 *           -> 1.1.1.1 dummy1 (inactive)
+	 *           -> 1.1.2.1 dummy2
+	 *
+	 *      1.1.2.0/24
+	 *           -> 1.1.1.1 dummy1
+	 *           -> 1.1.2.1 dummy2 (inactive)
+	 *
+	 * Without checking each individual one, they would hash to
+	 * the same group and both have 1.1.1.1 dummy1 marked inactive.
+	 *
+	 */
+	if (CHECK_FLAG(nh1->flags, NEXTHOP_FLAG_ACTIVE)
+	    != CHECK_FLAG(nh2->flags, NEXTHOP_FLAG_ACTIVE))
+		return false;
+
+	if (!nexthop_same(nh1, nh2))
+		return false;
+
+	return true;
+}
+
+bool zebra_nhg_hash_equal(const void *arg1, const void *arg2)
+{
+	const struct nhg_hash_entry *nhe1 = arg1;
+	const struct nhg_hash_entry *nhe2 = arg2;
+	struct nexthop *nexthop1;
+	struct nexthop *nexthop2;
+
+	/* No matter what if they equal IDs, assume equal */
+	if (nhe1->id && nhe2->id && (nhe1->id == nhe2->id))
+		return true;
+
+	/*
+	 * Equal entries always have equal fingerprints, most lookups that are
+	 * going to fail stop here without walking the nexthops.
+	 */
+	if (nhe1->fingerprint && nhe2->fingerprint &&
+	    nhe1->fingerprint != nhe2->fingerprint)
+		return false;
+
+	if (nhe1->type != nhe2->type)
+		return false;
+
+	if (nhe1->vrf_id != nhe2->vrf_id)
+		return false;
+
+	if (nhe1->afi != nhe2->afi)
+		return false;
+
+	if (nhe1->nhg.nhgr.buckets != nhe2->nhg.nhgr.buckets)
+		return false;
+
+	if (nhe1->nhg.nhgr.idle_timer != nhe2->nhg.nhgr.idle_timer)
+		return false;
+
+	if (nhe1->nhg.nhgr.unbalanced_timer != nhe2->nhg.nhgr.unbalanced_timer)
+		return false;
+
+	/* Nexthops should be in-order, so we simply compare them in-place */
+	for (nexthop1 = nhe1->nhg.nexthop, nexthop2 = nhe2->nhg.nexthop;
+	     nexthop1 && nexthop2;
+	     nexthop1 = nexthop1->next, nexthop2 = nexthop2->next) {
+
+		if (!nhg_compare_nexthops(nexthop1, nexthop2))
+			return false;
+	}
+
+	/* Check for unequal list lengths */
+	if (nexthop1 || nexthop2)
+		return false;
+
+	/* If there's no backup info, comparison is done. */
+	if ((nhe1->backup_info == NULL) && (nhe2->backup_info == NULL))
+		return true;
+
+	/* Compare backup info also - test the easy things first */
+	if (nhe1->backup_info && (nhe2->backup_info == NULL))
+		return false;
+	if (nhe2->backup_info && (nhe1->backup_info == NULL))
+		return false;
+
+	/* Compare number of backups before actually comparing any */
+	for (nexthop1 = nhe1->backup_info->nhe->nhg.nexthop,
+	     nexthop2 = nhe2->backup_info->nhe->nhg.nexthop;
+	     nexthop1 && nexthop2;
+	     nexthop1 = nexthop1->next, nexthop2 = nexthop2->next) {
+		;
+	}
+
+	/* Did we find the end of one list before the other? */
+	if (nexthop1 || nexthop2)
+		return false;
+
+	/* Have to compare the backup nexthops */
+	for (nexthop1 = nhe1->backup_info->nhe->nhg.nexthop,
+	     nexthop2 = nhe2->backup_info->nhe->nhg.nexthop;
+	     nexthop1 && nexthop2;
+	     nexthop1 = nexthop1->next, nexthop2 = nexthop2->next) {
+
+		if (!nhg_compare_nexthops(nexthop1, nexthop2))
+			return false;
+	}
+
+	return true;
+}
+
+bool zebra_nhg_hash_id_equal(const void *arg1, const void *arg2)
+{
+	const struct nhg_hash_entry *nhe1 = arg1;
+	const struct nhg_hash_entry *nhe2 = arg2;
+
+	return nhe1->id == nhe2->id;
+}
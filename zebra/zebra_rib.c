@@ -30,6 +30,8 @@
 #include "printfrr.h"
 #include "frrscript.h"
 #include "frrdistance.h"
+#include "termtable.h"
+#include "tracering.h"
 
 #include "zebra/zebra_router.h"
 #include "zebra/connected.h"
@@ -56,6 +58,7 @@ DEFINE_MTYPE(ZEBRA, RE,       "Route Entry");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_DEST,       "RIB destination");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_UPDATE_CTX, "Rib update context object");
 DEFINE_MTYPE_STATIC(ZEBRA, WQ_WRAPPER, "WQ wrapper");
+DEFINE_MTYPE_STATIC(ZEBRA, RIB_SWEEP, "RIB sweep");
 
 /*
  * Event, list, and mutex for delivery of dataplane results
@@ -332,7 +335,7 @@ static char *_dump_re_status(const struct route_entry *re, char *buf,
 	}
 
 	snprintfrr(
-		buf, len, "%s%s%s%s%s%s%s%s",
+		buf, len, "%s%s%s%s%s%s%s%s%s",
 		CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED) ? "Removed " : "",
 		CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED) ? "Changed " : "",
 		CHECK_FLAG(re->status, ROUTE_ENTRY_LABELS_CHANGED)
@@ -346,7 +349,9 @@ static char *_dump_re_status(const struct route_entry *re, char *buf,
 							      : "",
 		CHECK_FLAG(re->status, ROUTE_ENTRY_FAILED) ? "Failed " : "",
 		CHECK_FLAG(re->status, ROUTE_ENTRY_USE_FIB_NHG) ? "Fib NHG "
-								: "");
+								: "",
+		CHECK_FLAG(re->status, ROUTE_ENTRY_NHG_IN_PLACE) ? "NHG In Place "
+								 : "");
 	return buf;
 }
 
@@ -407,6 +412,7 @@ static void route_entry_attach_ref(struct route_entry *re,
 	re->nhe = new;
 	re->nhe_id = new->id;
 	re->nhe_installed_id = 0;
+	nhe_route_list_add_tail(&new->routes, re);
 
 	zebra_nhg_increment_ref(new);
 }
@@ -420,6 +426,8 @@ int route_entry_update_nhe(struct route_entry *re,
 
 	if (new_nhghe == NULL) {
 		old_nhg = re->nhe;
+		if (old_nhg)
+			nhe_route_list_del(&old_nhg->routes, re);
 
 		re->nhe_id = 0;
 		re->nhe_installed_id = 0;
@@ -430,6 +438,7 @@ int route_entry_update_nhe(struct route_entry *re,
 	if ((re->nhe_id != 0) && re->nhe && (re->nhe != new_nhghe)) {
 		/* Capture previous nhg, if any */
 		old_nhg = re->nhe;
+		nhe_route_list_del(&old_nhg->routes, re);
 
 		route_entry_attach_ref(re, new_nhghe);
 	} else if (!re->nhe)
@@ -457,26 +466,19 @@ done:
 int rib_handle_nhg_replace(struct nhg_hash_entry *old_entry,
 			   struct nhg_hash_entry *new_entry)
 {
-	struct zebra_router_table *zrt;
-	struct route_node *rn;
-	struct route_entry *re, *next;
+	struct route_entry *re;
 	int ret = 0;
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED || IS_ZEBRA_DEBUG_NHG_DETAIL)
 		zlog_debug("%s: replacing routes nhe (%u) OLD %p NEW %p",
 			   __func__, new_entry->id, new_entry, old_entry);
 
-	/* We have to do them ALL */
-	RB_FOREACH (zrt, zebra_router_table_head, &zrouter.tables) {
-		for (rn = route_top(zrt->table); rn;
-		     rn = srcdest_route_next(rn)) {
-			RNODE_FOREACH_RE_SAFE (rn, re, next) {
-				if (re->nhe && re->nhe == old_entry)
-					ret += route_entry_update_nhe(re,
-								      new_entry);
-			}
-		}
-	}
+	/*
+	 * Each update takes the route off the old entry's list; once the
+	 * last reference is dropped old_entry is gone.
+	 */
+	while (!ret && (re = nhe_route_list_first(&old_entry->routes)))
+		ret += route_entry_update_nhe(re, new_entry);
 
 	/*
 	 * if ret > 0, some previous re->nhe has freed the address to which
@@ -823,8 +825,11 @@ void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq,
 				    bool rt_delete)
 {
 	rib_dest_t *dest = rib_dest_from_rnode(rn);
+	struct route_node *changed = rn;
 	struct rnh *rnh;
 
+	zrouter.nht_stats.route_events++;
+
 	/*
 	 * We are storing the rnh's associated withb
 	 * the tracked nexthop as a list of the rn's.
@@ -882,10 +887,28 @@ void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq,
 			 * we were originally as such we know that
 			 * that sequence number is ok to respect.
 			 */
+			zrouter.nht_stats.rnh_examined++;
 			if (rnh->seqno == seq) {
 				if (IS_ZEBRA_DEBUG_NHT_DETAILED)
 					zlog_debug(
 						"    Node processed and moved already");
+				zrouter.nht_stats.rnh_skipped++;
+				continue;
+			}
+
+			/*
+			 * An rnh hanging off a less specific node resolves
+			 * via that node.  The changed route can only take
+			 * over (or stop being a candidate for) its resolution
+			 * if it covers the tracked prefix, everything else
+			 * is left alone.
+			 */
+			if (rn != changed &&
+			    !prefix_match(&changed->p, &rnh->node->p)) {
+				if (IS_ZEBRA_DEBUG_NHT_DETAILED)
+					zlog_debug("    Not covered by %pRN, skipping",
+						   changed);
+				zrouter.nht_stats.rnh_skipped++;
 				continue;
 			}
 
@@ -1472,6 +1495,9 @@ static void rib_process(struct route_node *rn)
 
 	/* Remove all RE entries queued for removal */
 	RNODE_FOREACH_RE_SAFE (rn, re, next) {
+		/* Only applies to the install done by this run */
+		UNSET_FLAG(re->status, ROUTE_ENTRY_NHG_IN_PLACE);
+
 		if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED)) {
 			if (IS_ZEBRA_DEBUG_RIB) {
 				rnode_debug(rn, vrf_id, "rn %p, removing re %p",
@@ -2640,6 +2666,7 @@ static void process_subq_route(struct listnode *lnode, uint8_t qindex)
 
 	rib_process(rnode);
 
+	tracering("zebra rib processed", &rnode->p, zvrf_id(zvrf), qindex);
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED) {
 		struct route_entry *re = NULL;
 
@@ -2832,6 +2859,7 @@ static void process_subq_early_route_add(struct zebra_early_route *ere)
 			 * but an earlier response was just handed
 			 * back.  Drop it on the floor
 			 */
+			route_entry_update_nhe(re, NULL);
 			early_route_memory_free(ere);
 			return;
 		}
@@ -3317,6 +3345,7 @@ static int rib_meta_queue_add(struct meta_queue *mq, void *data)
 	route_lock_node(rn);
 	mq->size++;
 
+	tracering("zebra rib queued", &rn->p, re->vrf_id, re->type, qindex);
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 		rnode_debug(rn, re->vrf_id, "queued rn %p into sub-queue %s",
 			    (void *)rn, subqueue2str(qindex));
@@ -4000,6 +4029,7 @@ static void rib_link(struct route_node *rn, struct route_entry *re, int process)
 	}
 
 	re_list_add_head(&dest->routes, re);
+	re->rn = rn;
 
 	afi = (rn->p.family == AF_INET)
 		      ? AFI_IP
@@ -4054,6 +4084,7 @@ void rib_unlink(struct route_node *rn, struct route_entry *re)
 	dest = rib_dest_from_rnode(rn);
 
 	re_list_del(&dest->routes, re);
+	re->rn = NULL;
 
 	if (dest->selected_fib == re)
 		dest->selected_fib = NULL;
@@ -4623,29 +4654,119 @@ void rib_update(enum rib_update_event event)
 			   rib_update_event2str(event));
 }
 
-/* Delete self installed routes after zebra is relaunched.  */
-void rib_sweep_table(struct route_table *table)
+/*
+ * Route sweeps.
+ *
+ * Removing the routes left over from a previous zebra run, from a
+ * disconnected client or from a client whose graceful restart timed out
+ * can mean walking millions of routes.  Sweeps walk their tables with a
+ * route_table_iter_t and handle at most RIB_SWEEP_NODES_PER_RUN nodes per
+ * event, pausing the iterator and yielding to the event loop in between.
+ *
+ * A paused iterator only holds on to a prefix, the table itself is checked
+ * to still exist before resuming and skipped if it went away.
+ */
+#define RIB_SWEEP_NODES_PER_RUN 10000
+
+enum rib_sweep_type {
+	/* Self installed routes read back from the kernel at startup */
+	RIB_SWEEP_SELFROUTE,
+	/* All routes of a disconnected client */
+	RIB_SWEEP_PROTO,
+	/* Routes not refreshed by a client after a graceful restart */
+	RIB_SWEEP_GR_STALE,
+};
+
+PREDECL_DLIST(rib_sweeps);
+
+struct rib_sweep {
+	enum rib_sweep_type type;
+	uint8_t proto;
+	unsigned short instance;
+	time_t restart_time;
+
+	/* Tables to walk, tables[table_idx] is the current one */
+	struct route_table **tables;
+	unsigned int table_cnt;
+	unsigned int table_idx;
+	route_table_iter_t iter;
+
+	/* Progress */
+	unsigned long nodes;
+	unsigned long removed;
+	unsigned int runs;
+	time_t started;
+
+	struct event *t_run;
+	struct rib_sweeps_item item;
+};
+
+DECLARE_DLIST(rib_sweeps, struct rib_sweep, item);
+
+static struct rib_sweeps_head rib_sweeps[1] = {INIT_DLIST(rib_sweeps[0])};
+
+static const char *rib_sweep_type2str(enum rib_sweep_type type)
+{
+	switch (type) {
+	case RIB_SWEEP_SELFROUTE:
+		return "Self Routes";
+	case RIB_SWEEP_PROTO:
+		return "Client Routes";
+	case RIB_SWEEP_GR_STALE:
+		return "GR Stale Routes";
+	}
+
+	return "Unknown";
+}
+
+static void rib_sweep_add_table(struct rib_sweep *sweep,
+				struct route_table *table)
 {
-	struct route_node *rn;
-	struct route_entry *re;
-	struct route_entry *next;
-	struct nexthop *nexthop;
+	unsigned int i;
 
 	if (!table)
 		return;
 
-	if (IS_ZEBRA_DEBUG_RIB)
-		zlog_debug("%s: starting", __func__);
+	for (i = 0; i < sweep->table_cnt; i++)
+		if (sweep->tables[i] == table)
+			return;
 
-	for (rn = route_top(table); rn; rn = srcdest_route_next(rn)) {
-		RNODE_FOREACH_RE_SAFE (rn, re, next) {
+	sweep->tables = XREALLOC(MTYPE_RIB_SWEEP, sweep->tables,
+				 (sweep->table_cnt + 1) *
+					 sizeof(*sweep->tables));
+	sweep->tables[sweep->table_cnt++] = table;
+}
+
+/* Tables may be freed (e.g. VRF deletion) while a sweep is paused. */
+static bool rib_sweep_table_exists(struct route_table *table)
+{
+	struct zebra_router_table *zrt;
 
+	RB_FOREACH (zrt, zebra_router_table_head, &zrouter.tables)
+		if (zrt->table == table)
+			return true;
+
+	return false;
+}
+
+/* Returns the number of route entries removed from rn. */
+static unsigned long rib_sweep_node(struct rib_sweep *sweep,
+				    struct route_node *rn)
+{
+	struct route_entry *re;
+	struct route_entry *next;
+	struct nexthop *nexthop;
+	unsigned long n = 0;
+
+	RNODE_FOREACH_RE_SAFE (rn, re, next) {
+		if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
+			continue;
+
+		switch (sweep->type) {
+		case RIB_SWEEP_SELFROUTE:
 			if (IS_ZEBRA_DEBUG_RIB)
 				route_entry_dump(&rn->p, NULL, re);
 
-			if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
-				continue;
-
 			if (!CHECK_FLAG(re->flags, ZEBRA_FLAG_SELFROUTE))
 				continue;
 
@@ -4671,7 +4792,7 @@ void rib_sweep_table(struct route_table *table)
 			 * mark them as active when we receive them
 			 * This is startup only so probably ok.
 			 *
-			 * If we ever decide to move rib_sweep_table
+			 * If we ever decide to move the self route sweep
 			 * to a different spot (ie startup )
 			 * this decision needs to be revisited
 			 */
@@ -4680,12 +4801,172 @@ void rib_sweep_table(struct route_table *table)
 				SET_FLAG(nexthop->flags, NEXTHOP_FLAG_FIB);
 
 			rib_uninstall_kernel(rn, re);
-			rib_delnode(rn, re);
+			break;
+		case RIB_SWEEP_PROTO:
+			if (re->type != sweep->proto ||
+			    re->instance != sweep->instance)
+				continue;
+			break;
+		case RIB_SWEEP_GR_STALE:
+			if (re->type != sweep->proto ||
+			    re->instance != sweep->instance)
+				continue;
+
+			/* Refreshed after the restart, keep it */
+			if (re->uptime >= sweep->restart_time)
+				continue;
+
+			if (IS_ZEBRA_DEBUG_RIB)
+				zlog_debug("%s: Client %s stale route %pRN is deleted",
+					   __func__,
+					   zebra_route_string(sweep->proto),
+					   rn);
+			break;
 		}
+
+		rib_delnode(rn, re);
+		n++;
 	}
 
-	if (IS_ZEBRA_DEBUG_RIB)
-		zlog_debug("%s: ends", __func__);
+	return n;
+}
+
+static void rib_sweep_done(struct rib_sweep *sweep)
+{
+	rib_sweeps_del(rib_sweeps, sweep);
+	EVENT_OFF(sweep->t_run);
+
+	zrouter.sweep_stats.done++;
+	zrouter.sweep_stats.nodes += sweep->nodes;
+	zrouter.sweep_stats.removed += sweep->removed;
+
+	if (sweep->type == RIB_SWEEP_PROTO)
+		zlog_notice("%lu %s routes of disconnected client removed from the rib",
+			    sweep->removed, zebra_route_string(sweep->proto));
+	else if (IS_ZEBRA_DEBUG_RIB || IS_ZEBRA_DEBUG_EVENT)
+		zlog_debug("%s: %s sweep of %s done, %lu routes removed, %lu nodes in %u runs",
+			   __func__, rib_sweep_type2str(sweep->type),
+			   zebra_route_string(sweep->proto), sweep->removed,
+			   sweep->nodes, sweep->runs);
+
+	if (sweep->type == RIB_SWEEP_SELFROUTE)
+		zebra_router_sweep_nhgs();
+
+	XFREE(MTYPE_RIB_SWEEP, sweep->tables);
+	XFREE(MTYPE_RIB_SWEEP, sweep);
+}
+
+/*
+ * Walk the sweep's tables, at most `budget` nodes (0 for no limit).
+ * Returns true once all tables have been swept.
+ */
+static bool rib_sweep_walk(struct rib_sweep *sweep, unsigned long budget)
+{
+	struct route_table *table, *src_table;
+	struct route_node *rn, *srn;
+	unsigned long n = 0;
+
+	sweep->runs++;
+
+	while (sweep->table_idx < sweep->table_cnt) {
+		table = sweep->tables[sweep->table_idx];
+
+		if (rib_sweep_table_exists(table)) {
+			while ((rn = route_table_iter_next(&sweep->iter))) {
+				sweep->removed += rib_sweep_node(sweep, rn);
+
+				src_table = srcdest_srcnode_table(rn);
+				if (src_table)
+					for (srn = route_top(src_table); srn;
+					     srn = route_next(srn))
+						sweep->removed +=
+							rib_sweep_node(sweep,
+								       srn);
+
+				sweep->nodes++;
+				if (budget && ++n >= budget) {
+					route_table_iter_pause(&sweep->iter);
+					return false;
+				}
+			}
+
+			route_table_iter_cleanup(&sweep->iter);
+		}
+
+		sweep->table_idx++;
+		if (sweep->table_idx < sweep->table_cnt)
+			route_table_iter_init(&sweep->iter,
+					      sweep->tables[sweep->table_idx]);
+	}
+
+	return true;
+}
+
+static void rib_sweep_run(struct event *thread)
+{
+	struct rib_sweep *sweep = EVENT_ARG(thread);
+
+	if (!rib_sweep_walk(sweep, RIB_SWEEP_NODES_PER_RUN)) {
+		event_add_event(zrouter.master, rib_sweep_run, sweep, 0,
+				&sweep->t_run);
+		return;
+	}
+
+	rib_sweep_done(sweep);
+}
+
+static struct rib_sweep *rib_sweep_new(enum rib_sweep_type type,
+				       uint8_t proto, unsigned short instance)
+{
+	struct rib_sweep *sweep;
+
+	sweep = XCALLOC(MTYPE_RIB_SWEEP, sizeof(*sweep));
+	sweep->type = type;
+	sweep->proto = proto;
+	sweep->instance = instance;
+	sweep->started = monotime(NULL);
+
+	return sweep;
+}
+
+static void rib_sweep_start(struct rib_sweep *sweep)
+{
+	if (!sweep->table_cnt) {
+		rib_sweeps_add_tail(rib_sweeps, sweep);
+		rib_sweep_done(sweep);
+		return;
+	}
+
+	route_table_iter_init(&sweep->iter, sweep->tables[0]);
+	rib_sweeps_add_tail(rib_sweeps, sweep);
+
+	/* Nothing else is going to run anymore, don't bother yielding */
+	if (zebra_router_in_shutdown()) {
+		rib_sweep_walk(sweep, 0);
+		rib_sweep_done(sweep);
+		return;
+	}
+
+	event_add_event(zrouter.master, rib_sweep_run, sweep, 0,
+			&sweep->t_run);
+}
+
+/*
+ * Complete pending client route sweeps of proto/instance right away, a
+ * reconnecting client must not lose the routes it is about to send.
+ */
+void rib_sweep_proto_finish(uint8_t proto, unsigned short instance)
+{
+	struct rib_sweep *sweep;
+
+	frr_each_safe (rib_sweeps, rib_sweeps, sweep) {
+		if (sweep->type != RIB_SWEEP_PROTO || sweep->proto != proto ||
+		    sweep->instance != instance)
+			continue;
+
+		rib_sweep_walk(sweep, 0);
+		rib_sweep_done(sweep);
+	}
 }
 
 /* Sweep all RIB tables.  */
@@ -4693,66 +4974,100 @@ void rib_sweep_route(struct event *t)
 {
 	struct vrf *vrf;
 	struct zebra_vrf *zvrf;
+	struct zebra_router_table *zrt;
+	struct rib_sweep *sweep;
+
+	sweep = rib_sweep_new(RIB_SWEEP_SELFROUTE, ZEBRA_ROUTE_KERNEL, 0);
 
 	RB_FOREACH (vrf, vrf_id_head, &vrfs_by_id) {
 		if ((zvrf = vrf->info) == NULL)
 			continue;
 
-		rib_sweep_table(zvrf->table[AFI_IP][SAFI_UNICAST]);
-		rib_sweep_table(zvrf->table[AFI_IP6][SAFI_UNICAST]);
+		rib_sweep_add_table(sweep, zvrf->table[AFI_IP][SAFI_UNICAST]);
+		rib_sweep_add_table(sweep, zvrf->table[AFI_IP6][SAFI_UNICAST]);
 	}
 
-	zebra_router_sweep_route();
-	zebra_router_sweep_nhgs();
-}
-
-/* Remove specific by protocol routes from 'table'. */
-unsigned long rib_score_proto_table(uint8_t proto, unsigned short instance,
-				    struct route_table *table)
-{
-	struct route_node *rn;
-	struct route_entry *re;
-	struct route_entry *next;
-	unsigned long n = 0;
+	RB_FOREACH (zrt, zebra_router_table_head, &zrouter.tables) {
+		if (zrt->ns_id != NS_DEFAULT)
+			continue;
+		rib_sweep_add_table(sweep, zrt->table);
+	}
 
-	if (table)
-		for (rn = route_top(table); rn; rn = srcdest_route_next(rn))
-			RNODE_FOREACH_RE_SAFE (rn, re, next) {
-				if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
-					continue;
-				if (re->type == proto
-				    && re->instance == instance) {
-					rib_delnode(rn, re);
-					n++;
-				}
-			}
-	return n;
+	rib_sweep_start(sweep);
 }
 
 /* Remove specific by protocol routes. */
-unsigned long rib_score_proto(uint8_t proto, unsigned short instance)
+void rib_score_proto(uint8_t proto, unsigned short instance)
 {
 	struct vrf *vrf;
 	struct zebra_vrf *zvrf;
 	struct other_route_table *ort;
-	unsigned long cnt = 0;
+	struct rib_sweep *sweep;
+
+	sweep = rib_sweep_new(RIB_SWEEP_PROTO, proto, instance);
 
 	RB_FOREACH (vrf, vrf_id_head, &vrfs_by_id) {
 		zvrf = vrf->info;
 		if (!zvrf)
 			continue;
 
-		cnt += rib_score_proto_table(proto, instance,
-					     zvrf->table[AFI_IP][SAFI_UNICAST])
-		       + rib_score_proto_table(
-			       proto, instance,
-			       zvrf->table[AFI_IP6][SAFI_UNICAST]);
+		rib_sweep_add_table(sweep, zvrf->table[AFI_IP][SAFI_UNICAST]);
+		rib_sweep_add_table(sweep, zvrf->table[AFI_IP6][SAFI_UNICAST]);
 
-		frr_each(otable, &zvrf->other_tables, ort) cnt +=
-			rib_score_proto_table(proto, instance, ort->table);
+		frr_each(otable, &zvrf->other_tables, ort)
+			rib_sweep_add_table(sweep, ort->table);
 	}
 
-	return cnt;
+	rib_sweep_start(sweep);
+}
+
+/* Remove the routes of proto/instance not refreshed since restart_time. */
+void rib_sweep_gr_stale(afi_t afi, vrf_id_t vrf_id, uint8_t proto,
+			unsigned short instance, time_t restart_time)
+{
+	struct zebra_vrf *zvrf = zebra_vrf_lookup_by_id(vrf_id);
+	struct rib_sweep *sweep;
+
+	if (!zvrf)
+		return;
+
+	sweep = rib_sweep_new(RIB_SWEEP_GR_STALE, proto, instance);
+	sweep->restart_time = restart_time;
+	rib_sweep_add_table(sweep, zvrf->table[afi][SAFI_UNICAST]);
+
+	rib_sweep_start(sweep);
+}
+
+void rib_sweep_show(struct ttable *tt)
+{
+	struct rib_sweep *sweep;
+
+	ttable_add_row(tt, "Route Sweeps Active|%zu",
+		       rib_sweeps_count(rib_sweeps));
+	frr_each (rib_sweeps, rib_sweeps, sweep)
+		ttable_add_row(tt,
+			       "  %s %s|table %u/%u, %lu nodes, %lu removed, %llds",
+			       rib_sweep_type2str(sweep->type),
+			       zebra_route_string(sweep->proto),
+			       sweep->table_idx + 1, sweep->table_cnt,
+			       sweep->nodes, sweep->removed,
+			       (long long)(monotime(NULL) - sweep->started));
+	ttable_add_row(tt,
+		       "Route Sweeps Done (Nodes, Removed)|%" PRIu64
+		       " (%" PRIu64 ", %" PRIu64 ")",
+		       zrouter.sweep_stats.done, zrouter.sweep_stats.nodes,
+		       zrouter.sweep_stats.removed);
+}
+
+static void rib_sweep_terminate(void)
+{
+	struct rib_sweep *sweep;
+
+	while ((sweep = rib_sweeps_pop(rib_sweeps))) {
+		EVENT_OFF(sweep->t_run);
+		XFREE(MTYPE_RIB_SWEEP, sweep->tables);
+		XFREE(MTYPE_RIB_SWEEP, sweep);
+	}
 }
 
 /* Close RIB and clean up kernel routes. */
@@ -4822,7 +5137,13 @@ static void rib_process_dplane_results(struct event *thread)
 	}
 #endif /* HAVE_SCRIPTING */
 
-	/* Dequeue a list of completed updates with one lock/unlock cycle */
+	/*
+	 * Dequeue a list of completed updates with one lock/unlock cycle.
+	 * Updates resulting from them, e.g. nexthop groups reinstalled
+	 * after a batch of interfaces came up, go back to the dataplane
+	 * in one go as well.
+	 */
+	dplane_batch_begin();
 
 	do {
 		dplane_ctx_q_init(&ctxlist);
@@ -4975,6 +5296,8 @@ static void rib_process_dplane_results(struct event *thread)
 
 	} while (1);
 
+	dplane_batch_end();
+
 #ifdef HAVE_SCRIPTING
 	if (fs)
 		frrscript_delete(fs);
@@ -5041,6 +5364,8 @@ void zebra_rib_terminate(void)
 
 	EVENT_OFF(t_dplane);
 
+	rib_sweep_terminate();
+
 	ctx = dplane_ctx_dequeue(&rib_dplane_q);
 	while (ctx) {
 		dplane_ctx_fini(&ctx);
@@ -687,6 +687,9 @@ static void zebra_rnh_eval_nexthop_entry(struct zebra_vrf *zvrf, afi_t afi,
 	}
 	zebra_rnh_store_in_routing_table(rnh);
 
+	if (state_changed)
+		zrouter.nht_stats.rnh_changed++;
+
 	if (state_changed || force) {
 		/* NOTE: Use the "copy" of resolving route stored in 'rnh' i.e.,
 		 * rnh->state.
@@ -715,6 +718,7 @@ static void zebra_rnh_evaluate_entry(struct zebra_vrf *zvrf, afi_t afi,
 	}
 
 	rnh = nrn->info;
+	zrouter.nht_stats.rnh_evaluated++;
 
 	/* Identify route entry (RE) resolving this tracked entry. */
 	re = zebra_rnh_resolve_nexthop_entry(zvrf, afi, nrn, rnh, &prn);
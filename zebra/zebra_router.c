@@ -167,17 +167,6 @@ void zebra_router_show_table_summary(struct vty *vty)
 	}
 }
 
-void zebra_router_sweep_route(void)
-{
-	struct zebra_router_table *zrt;
-
-	RB_FOREACH (zrt, zebra_router_table_head, &zrouter.tables) {
-		if (zrt->ns_id != NS_DEFAULT)
-			continue;
-		rib_sweep_table(zrt->table);
-	}
-}
-
 void zebra_router_sweep_nhgs(void)
 {
 	zebra_nhg_sweep_table(zrouter.nhgs_id);
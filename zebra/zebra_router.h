@@ -177,6 +177,19 @@ struct zebra_router {
 #define ZEBRA_ZAPI_PACKETS_TO_PROCESS 1000
 	_Atomic uint32_t packets_to_process;
 
+	/*
+	 * ZAPI backpressure: once the combined meta-queue and dataplane
+	 * depth reaches the high watermark, route producing clients are
+	 * throttled until it drains below the low watermark.  A high
+	 * watermark of 0 disables backpressure.
+	 */
+#define ZEBRA_BACKPRESSURE_INTERVAL_MSEC 100
+	uint32_t bp_high_watermark;
+	uint32_t bp_low_watermark;
+	bool bp_engaged;
+	uint32_t bp_engage_cnt;
+	struct event *t_backpressure;
+
 	/* Mlag information for the router */
 	struct zebra_mlag_info mlag_info;
 
@@ -235,6 +248,25 @@ struct zebra_router {
 	uint8_t protodown_r_bit;
 
 	uint64_t nexthop_weight_scale_value;
+
+	/*
+	 * Nexthop tracking work done in response to route changes, see
+	 * zebra_rib_evaluate_rn_nexthops().
+	 */
+	struct {
+		uint64_t route_events;
+		uint64_t rnh_examined;
+		uint64_t rnh_skipped;
+		uint64_t rnh_evaluated;
+		uint64_t rnh_changed;
+	} nht_stats;
+
+	/* Completed route sweeps, see rib_sweep_route() */
+	struct {
+		uint64_t done;
+		uint64_t nodes;
+		uint64_t removed;
+	} sweep_stats;
 };
 
 #define GRACEFUL_RESTART_TIME 60
@@ -264,7 +296,6 @@ extern void zebra_router_release_table(struct zebra_vrf *zvrf, uint32_t tableid,
 
 extern int zebra_router_config_write(struct vty *vty);
 
-extern void zebra_router_sweep_route(void);
 extern void zebra_router_sweep_nhgs(void);
 
 extern void zebra_router_show_table_summary(struct vty *vty);
@@ -30,6 +30,18 @@ struct mpls_srgb {
 	uint32_t end_label;
 };
 
+/*
+ * Labels inside the SRGB are allocated densely by the SR protocols; the LSPs
+ * for them are kept in a flat array indexed by (label - base) instead of the
+ * lsp_table hash.
+ */
+struct zebra_lsp_block {
+	mpls_label_t base;
+	uint32_t size;
+	uint32_t count;
+	struct zebra_lsp **lsps;
+};
+
 struct zebra_rmap {
 	char *name;
 	struct route_map *map;
@@ -100,8 +112,9 @@ struct zebra_vrf {
 	/* MPLS static LSP config table */
 	struct hash *slsp_table;
 
-	/* MPLS label forwarding table */
+	/* MPLS label forwarding table: labels outside lsp_block */
 	struct hash *lsp_table;
+	struct zebra_lsp_block lsp_block;
 
 	/* MPLS FEC binding table */
 	struct route_table *fec_table[AFI_MAX];
@@ -1196,6 +1196,7 @@ static void show_nexthop_group_out(struct vty *vty, struct nhg_hash_entry *nhe,
 		json_object_string_add(json, "type",
 				       zebra_route_string(nhe->type));
 		json_object_int_add(json, "refCount", nhe->refcnt);
+		json_object_int_add(json, "installCount", nhe->install_count);
 		if (event_is_scheduled(nhe->timer))
 			json_object_string_add(
 				json, "timeToDeletion",
@@ -1219,6 +1220,7 @@ static void show_nexthop_group_out(struct vty *vty, struct nhg_hash_entry *nhe,
 
 		vty_out(vty, "     Uptime: %s\n", up_str);
 		vty_out(vty, "     VRF: %s\n", vrf_id_to_name(nhe->vrf_id));
+		vty_out(vty, "     Install count: %u\n", nhe->install_count);
 	}
 
 	if (CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_VALID)) {
@@ -1483,6 +1485,81 @@ static void show_nexthop_group_cmd_helper(struct vty *vty,
 	hash_walk(zrouter.nhgs_id, nhe_show_walker, &ctx);
 }
 
+struct nhe_summary_context {
+	uint32_t groups;
+	uint32_t installed;
+	uint32_t proto;
+	uint32_t referenced;
+	uint64_t references;
+};
+
+static int nhe_summary_walker(struct hash_bucket *bucket, void *arg)
+{
+	struct nhe_summary_context *ctx = arg;
+	struct nhg_hash_entry *nhe = bucket->data;
+	int64_t refs;
+
+	ctx->groups++;
+	if (CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_INSTALLED))
+		ctx->installed++;
+	if (PROTO_OWNED(nhe))
+		ctx->proto++;
+
+	/* References held by routes, not by the groups containing this one */
+	refs = (int64_t)nhe->refcnt -
+	       nhg_connected_tree_count(&nhe->nhg_dependents);
+	if (refs > 0) {
+		ctx->referenced++;
+		ctx->references += refs;
+	}
+
+	return HASHWALK_CONTINUE;
+}
+
+static void show_nexthop_group_summary_out(struct vty *vty,
+					   json_object *json)
+{
+	const struct zebra_nhg_stats *stats = zebra_nhg_get_stats();
+	struct nhe_summary_context ctx = {};
+	double ratio = 0;
+
+	hash_walk(zrouter.nhgs_id, nhe_summary_walker, &ctx);
+
+	if (ctx.referenced)
+		ratio = (double)ctx.references / ctx.referenced;
+
+	if (json) {
+		json_object_int_add(json, "nexthopGroups", ctx.groups);
+		json_object_int_add(json, "installed", ctx.installed);
+		json_object_int_add(json, "protoOwned", ctx.proto);
+		json_object_int_add(json, "referencedGroups", ctx.referenced);
+		json_object_int_add(json, "routeReferences", ctx.references);
+		json_object_double_add(json, "sharingRatio", ratio);
+		json_object_int_add(json, "installs", stats->installs);
+		json_object_int_add(json, "installFailures",
+				    stats->install_failures);
+		json_object_int_add(json, "inPlaceReplaces",
+				    stats->in_place_replaces);
+		json_object_boolean_add(json, "replaceInPlace",
+					zebra_nhg_replace_in_place());
+		return;
+	}
+
+	vty_out(vty, "Nexthop groups: %u (installed %u, proto-owned %u)\n",
+		ctx.groups, ctx.installed, ctx.proto);
+	vty_out(vty,
+		"Route references: %" PRIu64
+		" to %u groups, sharing ratio %.2f\n",
+		ctx.references, ctx.referenced, ratio);
+	vty_out(vty,
+		"Dataplane installs: %" PRIu64 ", failures: %" PRIu64
+		", in-place replaces: %" PRIu64 "\n",
+		stats->installs, stats->install_failures,
+		stats->in_place_replaces);
+	vty_out(vty, "Replace in place: %s\n",
+		zebra_nhg_replace_in_place() ? "enabled" : "disabled");
+}
+
 static void if_nexthop_group_dump_vty(struct vty *vty, struct interface *ifp)
 {
 	struct zebra_if *zebra_if = NULL;
@@ -1536,6 +1613,29 @@ DEFPY (show_interface_nexthop_group,
 	return CMD_SUCCESS;
 }
 
+DEFPY(show_nexthop_group_summary,
+      show_nexthop_group_summary_cmd,
+      "show nexthop-group rib summary [json]",
+      SHOW_STR
+      "Show Nexthop Groups\n"
+      "RIB information\n"
+      "Nexthop group sharing and dataplane statistics\n"
+      JSON_STR)
+{
+	bool uj = use_json(argc, argv);
+	json_object *json = NULL;
+
+	if (uj)
+		json = json_object_new_object();
+
+	show_nexthop_group_summary_out(vty, json);
+
+	if (uj)
+		vty_json(vty, json);
+
+	return CMD_SUCCESS;
+}
+
 DEFPY(show_nexthop_group,
       show_nexthop_group_cmd,
       "show nexthop-group rib <(0-4294967295)$id|[singleton <ip$v4|ipv6$v6>] [<kernel|zebra|bgp|sharp>$type_str] [vrf <NAME$vrf_name|all$vrf_all>]> [json]",
@@ -1662,6 +1762,16 @@ DEFPY_HIDDEN(proto_nexthop_group_only, proto_nexthop_group_only_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFPY(nexthop_group_replace_in_place, nexthop_group_replace_in_place_cmd,
+      "[no] zebra nexthop replace-in-place",
+      NO_STR ZEBRA_STR
+      "Nexthop configuration\n"
+      "Rewrite nexthop groups in place when their active members change\n")
+{
+	zebra_nhg_set_replace_in_place(!no);
+	return CMD_SUCCESS;
+}
+
 DEFPY_HIDDEN(backup_nexthop_recursive_use_enable,
 	     backup_nexthop_recursive_use_enable_cmd,
 	     "[no] zebra nexthop resolve-via-backup",
@@ -3716,6 +3826,50 @@ DEFUN_HIDDEN (no_zebra_packet_process,
 	return CMD_SUCCESS;
 }
 
+DEFPY (zebra_zapi_backpressure,
+       zebra_zapi_backpressure_cmd,
+       "zebra zapi-backpressure high-watermark (1-4294967295)$high [low-watermark (0-4294967295)$low]",
+       ZEBRA_STR
+       "Throttle ZAPI route updates when zebra queues are deep\n"
+       "Combined meta-queue and dataplane depth to engage backpressure at\n"
+       "Number of queued items\n"
+       "Depth to release backpressure at (default: half the high watermark)\n"
+       "Number of queued items\n")
+{
+	if (!low_str)
+		low = high / 2;
+
+	if (low >= high) {
+		vty_out(vty,
+			"%% Low watermark must be below the high watermark\n");
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	zrouter.bp_high_watermark = high;
+	zrouter.bp_low_watermark = low;
+	zserv_backpressure_check();
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_zebra_zapi_backpressure,
+       no_zebra_zapi_backpressure_cmd,
+       "no zebra zapi-backpressure [high-watermark (1-4294967295) [low-watermark (0-4294967295)]]",
+       NO_STR
+       ZEBRA_STR
+       "Throttle ZAPI route updates when zebra queues are deep\n"
+       "Combined meta-queue and dataplane depth to engage backpressure at\n"
+       "Number of queued items\n"
+       "Depth to release backpressure at (default: half the high watermark)\n"
+       "Number of queued items\n")
+{
+	zrouter.bp_high_watermark = 0;
+	zrouter.bp_low_watermark = 0;
+	zserv_backpressure_check();
+
+	return CMD_SUCCESS;
+}
+
 DEFUN_HIDDEN (zebra_workqueue_timer,
 	      zebra_workqueue_timer_cmd,
 	      "zebra work-queue (0-10000)",
@@ -3808,6 +3962,15 @@ static int config_write_protocol(struct vty *vty)
 		vty_out(vty, "zebra zapi-packets %u\n",
 			zrouter.packets_to_process);
 
+	if (zrouter.bp_high_watermark) {
+		vty_out(vty, "zebra zapi-backpressure high-watermark %u",
+			zrouter.bp_high_watermark);
+		if (zrouter.bp_low_watermark != zrouter.bp_high_watermark / 2)
+			vty_out(vty, " low-watermark %u",
+				zrouter.bp_low_watermark);
+		vty_out(vty, "\n");
+	}
+
 	enum multicast_mode ipv4_multicast_mode = multicast_mode_ipv4_get();
 
 	if (ipv4_multicast_mode != MCAST_NO_CONFIG)
@@ -3841,6 +4004,9 @@ static int config_write_protocol(struct vty *vty)
 	if (zebra_nhg_proto_nexthops_only())
 		vty_out(vty, "zebra nexthop proto only\n");
 
+	if (zebra_nhg_replace_in_place())
+		vty_out(vty, "zebra nexthop replace-in-place\n");
+
 	if (!zebra_nhg_recursive_use_backups())
 		vty_out(vty, "no zebra nexthop resolve-via-backup\n");
 
@@ -3943,6 +4109,17 @@ DEFUN (show_zebra,
 	ttable_add_row(table, "v6 Default MC Forwarding|%s",
 		       zrouter.default_mc_forwardingv6 ? "On" : "Off");
 
+	ttable_add_row(table, "NHT Route Events|%" PRIu64,
+		       zrouter.nht_stats.route_events);
+	ttable_add_row(table, "NHT Evaluated (Changed)|%" PRIu64 " (%" PRIu64 ")",
+		       zrouter.nht_stats.rnh_evaluated,
+		       zrouter.nht_stats.rnh_changed);
+	ttable_add_row(table, "NHT Skipped (Examined)|%" PRIu64 " (%" PRIu64 ")",
+		       zrouter.nht_stats.rnh_skipped,
+		       zrouter.nht_stats.rnh_examined);
+
+	rib_sweep_show(table);
+
 	out = ttable_dump(table, "\n");
 	vty_out(vty, "%s\n", out);
 	XFREE(MTYPE_TMP, out);
@@ -4295,6 +4472,48 @@ DEFUN_HIDDEN(no_zebra_kernel_netlink_batch_tx_buf,
 	return CMD_SUCCESS;
 }
 
+DEFPY (zebra_kernel_netlink_batch_inflight,
+       zebra_kernel_netlink_batch_inflight_cmd,
+       "[no] zebra kernel netlink batch-inflight ![(1-16)$inflight]",
+       NO_STR
+       ZEBRA_STR
+       "Zebra kernel interface\n"
+       "Set Netlink parameters\n"
+       "Set the number of batches sent before reading their acknowledgments\n"
+       "Number of batches\n")
+{
+	netlink_set_batch_inflight(inflight, !no);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (zebra_kernel_netlink_batch_adaptive,
+       zebra_kernel_netlink_batch_adaptive_cmd,
+       "[no] zebra kernel netlink batch-adaptive",
+       NO_STR
+       ZEBRA_STR
+       "Zebra kernel interface\n"
+       "Set Netlink parameters\n"
+       "Adapt the batch send threshold to the kernel's ACK latency\n")
+{
+	netlink_set_batch_adaptive(!no);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (show_zebra_kernel_netlink_batch,
+       show_zebra_kernel_netlink_batch_cmd,
+       "show zebra kernel netlink batch [json]$json",
+       SHOW_STR
+       ZEBRA_STR
+       "Zebra kernel interface\n"
+       "Netlink information\n"
+       "Batch statistics and ACK latency histogram\n"
+       JSON_STR)
+{
+	return netlink_batch_show_helper(vty, !!json);
+}
+
 DEFPY (zebra_protodown_bit,
        zebra_protodown_bit_cmd,
        "zebra protodown reason-bit (0-31)$bit",
@@ -4414,11 +4633,15 @@ void zebra_vty_init(void)
 	install_element(CONFIG_NODE, &no_zebra_workqueue_timer_cmd);
 	install_element(CONFIG_NODE, &zebra_packet_process_cmd);
 	install_element(CONFIG_NODE, &no_zebra_packet_process_cmd);
+	install_element(CONFIG_NODE, &zebra_zapi_backpressure_cmd);
+	install_element(CONFIG_NODE, &no_zebra_zapi_backpressure_cmd);
 	install_element(CONFIG_NODE, &nexthop_group_use_enable_cmd);
 	install_element(CONFIG_NODE, &proto_nexthop_group_only_cmd);
+	install_element(CONFIG_NODE, &nexthop_group_replace_in_place_cmd);
 	install_element(CONFIG_NODE, &backup_nexthop_recursive_use_enable_cmd);
 
 	install_element(VIEW_NODE, &show_nexthop_group_cmd);
+	install_element(VIEW_NODE, &show_nexthop_group_summary_cmd);
 	install_element(VIEW_NODE, &show_interface_nexthop_group_cmd);
 
 	install_element(VIEW_NODE, &show_vrf_cmd);
@@ -4493,6 +4716,9 @@ void zebra_vty_init(void)
 #ifdef HAVE_NETLINK
 	install_element(CONFIG_NODE, &zebra_kernel_netlink_batch_tx_buf_cmd);
 	install_element(CONFIG_NODE, &no_zebra_kernel_netlink_batch_tx_buf_cmd);
+	install_element(CONFIG_NODE, &zebra_kernel_netlink_batch_inflight_cmd);
+	install_element(CONFIG_NODE, &zebra_kernel_netlink_batch_adaptive_cmd);
+	install_element(VIEW_NODE, &show_zebra_kernel_netlink_batch_cmd);
 	install_element(CONFIG_NODE, &zebra_protodown_bit_cmd);
 	install_element(CONFIG_NODE, &no_zebra_protodown_bit_cmd);
 #endif /* HAVE_NETLINK */
@@ -485,6 +485,9 @@ static void zevpn_print_mac_hash_all_evpn(struct hash_bucket *bucket, void *ctxt
 	if (wctx->print_dup)
 		hash_iterate(zevpn->mac_table, zebra_evpn_print_dad_mac_hash,
 			     wctx);
+	else if (CHECK_FLAG(wctx->flags, SHOW_REMOTE_MAC_FROM_VTEP))
+		zebra_evpn_mac_vtep_iterate(zevpn, wctx->r_vtep_ip,
+					    zebra_evpn_print_mac_hash, wctx);
 	else
 		hash_iterate(zevpn->mac_table, zebra_evpn_print_mac_hash, wctx);
 	wctx->json = json;
@@ -3794,7 +3797,8 @@ void zebra_vxlan_print_macs_vni_vtep(struct vty *vty, struct zebra_vrf *zvrf,
 	wctx.flags = SHOW_REMOTE_MAC_FROM_VTEP;
 	wctx.r_vtep_ip = vtep_ip;
 	wctx.json = json_mac;
-	hash_iterate(zevpn->mac_table, zebra_evpn_print_mac_hash, &wctx);
+	zebra_evpn_mac_vtep_iterate(zevpn, vtep_ip, zebra_evpn_print_mac_hash,
+				    &wctx);
 
 	if (use_json) {
 		json_object_int_add(json, "numMacs", wctx.count);
@@ -5084,8 +5088,10 @@ int zebra_vxlan_svi_up(struct interface *ifp, struct interface *link_if)
 		/* Install any remote neighbors for this VNI. */
 		memset(&n_wctx, 0, sizeof(n_wctx));
 		n_wctx.zevpn = zevpn;
+		dplane_batch_begin();
 		hash_iterate(zevpn->neigh_table, zebra_evpn_install_neigh_hash,
 			     &n_wctx);
+		dplane_batch_end();
 
 		/* Link the SVI from the access VLAN */
 		zebra_evpn_acc_bd_svi_set(ifp->info, link_if->info, true);
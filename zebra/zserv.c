@@ -50,6 +50,7 @@
 #include "zebra/zserv.h"          /* for zserv */
 #include "zebra/zebra_router.h"
 #include "zebra/zebra_errors.h"   /* for error messages */
+#include "zebra/zebra_dplane.h"   /* for dplane_get_in_queue_len */
 /* clang-format on */
 
 /* privileges */
@@ -543,12 +544,21 @@ static void zserv_process_messages(struct event *thread)
 			need_resched = true;
 	}
 
-	/* Process the batch of messages */
-	if (stream_fifo_head(cache))
+	/*
+	 * Process the batch of messages, handing the resulting dataplane
+	 * updates over in one go.
+	 */
+	if (stream_fifo_head(cache)) {
+		dplane_batch_begin();
 		zserv_handle_commands(client, cache);
+		dplane_batch_end();
+	}
 
 	stream_fifo_free(cache);
 
+	/* The batch may have pushed the rib/dataplane queues too deep */
+	zserv_backpressure_check();
+
 	/* Reschedule ourselves if necessary */
 	if (need_resched)
 		zserv_event(client, ZSERV_PROCESS_MESSAGES);
@@ -557,8 +567,22 @@ static void zserv_process_messages(struct event *thread)
 	zserv_client_event(client, ZSERV_CLIENT_READ);
 }
 
+/*
+ * Messages to a client must not overtake the redistribution batch pending
+ * for it.  Batches are only built on the main pthread, messages sent from
+ * other pthreads (e.g. zebra_opaque) are not ordered against them anyway.
+ */
+static inline void zserv_redist_batch_order(struct zserv *client)
+{
+	if (client->redist_batch_s &&
+	    pthread_equal(pthread_self(), zrouter.master->owner))
+		zserv_redist_batch_flush(client);
+}
+
 int zserv_send_message(struct zserv *client, struct stream *msg)
 {
+	zserv_redist_batch_order(client);
+
 	frr_with_mutex (&client->obuf_mtx) {
 		stream_fifo_push(client->obuf_fifo, msg);
 	}
@@ -575,6 +599,8 @@ int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo)
 {
 	struct stream *msg;
 
+	zserv_redist_batch_order(client);
+
 	frr_with_mutex (&client->obuf_mtx) {
 		msg = stream_fifo_pop(fifo);
 		while (msg) {
@@ -588,6 +614,57 @@ int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo)
 	return 0;
 }
 
+void zserv_redist_batch_flush(struct zserv *client)
+{
+	struct stream *s = client->redist_batch_s;
+
+	EVENT_OFF(client->t_redist_batch);
+	if (!s)
+		return;
+
+	client->redist_batch_s = NULL;
+	stream_putw_at(s, ZEBRA_HEADER_SIZE, client->redist_batch_cnt);
+	stream_putw_at(s, 0, stream_get_endp(s));
+	client->redist_batch_cnt = 0;
+	client->redist_batch_sent_cnt++;
+
+	zserv_send_message(client, s);
+}
+
+static void zserv_redist_batch_timer(struct event *thread)
+{
+	zserv_redist_batch_flush(EVENT_ARG(thread));
+}
+
+int zserv_redist_batch_add(struct zserv *client, struct stream *msg)
+{
+	size_t len = stream_get_endp(msg);
+
+	/* Batch header plus the message count. */
+	if (len > ZEBRA_MAX_PACKET_SIZ - ZEBRA_HEADER_SIZE - 2)
+		return zserv_send_message(client, stream_dup(msg));
+
+	if (client->redist_batch_s &&
+	    (STREAM_WRITEABLE(client->redist_batch_s) < len ||
+	     client->redist_batch_cnt == UINT16_MAX))
+		zserv_redist_batch_flush(client);
+
+	if (!client->redist_batch_s) {
+		client->redist_batch_s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+		zclient_create_header(client->redist_batch_s,
+				      ZEBRA_REDISTRIBUTE_ROUTE_BATCH,
+				      VRF_DEFAULT);
+		stream_putw(client->redist_batch_s, 0);
+		event_add_event(zrouter.master, zserv_redist_batch_timer,
+				client, 0, &client->t_redist_batch);
+	}
+
+	stream_put(client->redist_batch_s, STREAM_DATA(msg), len);
+	client->redist_batch_cnt++;
+
+	return 0;
+}
+
 /* Hooks for client connect / disconnect */
 DEFINE_HOOK(zserv_client_connect, (struct zserv *client), (client));
 DEFINE_KOOH(zserv_client_close, (struct zserv *client), (client));
@@ -613,7 +690,6 @@ static void zserv_client_free(struct zserv *client)
 
 	/* Close file descriptor. */
 	if (client->sock) {
-		unsigned long nroutes = 0;
 		unsigned long nnhgs = 0;
 
 		close(client->sock);
@@ -623,13 +699,13 @@ static void zserv_client_free(struct zserv *client)
 				zebra_mpls_client_cleanup_vrf_label(
 					client->proto);
 
-				nroutes = rib_score_proto(client->proto,
-							  client->instance);
+				/* Logs the number of routes once done */
+				rib_score_proto(client->proto,
+						client->instance);
 			}
 			zlog_notice(
-				"client %d disconnected %lu %s routes removed from the rib",
-				client->sock, nroutes,
-				zebra_route_string(client->proto));
+				"client %d disconnected, removing %s routes from the rib",
+				client->sock, zebra_route_string(client->proto));
 
 			/* Not worrying about instance for now */
 			if (!client->synchronous)
@@ -651,6 +727,10 @@ static void zserv_client_free(struct zserv *client)
 		stream_fifo_free(client->ibuf_fifo);
 	if (client->obuf_fifo)
 		stream_fifo_free(client->obuf_fifo);
+	if (client->redist_batch_s) {
+		stream_free(client->redist_batch_s);
+		client->redist_batch_s = NULL;
+	}
 	if (client->wb)
 		buffer_free(client->wb);
 
@@ -710,6 +790,7 @@ void zserv_close_client(struct zserv *client)
 
 		event_cancel_event(zrouter.master, client);
 		EVENT_OFF(client->t_cleanup);
+		EVENT_OFF(client->t_redist_batch);
 		EVENT_OFF(client->t_process);
 
 		/* destroy pthread */
@@ -1004,6 +1085,164 @@ void zserv_event(struct zserv *client, enum zserv_event event)
 }
 
 
+/* ZAPI backpressure -------------------------------------------------------- */
+
+/*
+ * Outstanding work in zebra that route updates from clients feed into:
+ * rib meta-queue entries plus contexts queued towards the dataplane.
+ */
+static uint32_t zserv_backpressure_depth(void)
+{
+	return (zrouter.mq ? zrouter.mq->size : 0) + dplane_get_in_queue_len();
+}
+
+/*
+ * Clients that only talk to us synchronously (label manager, etc) never
+ * read unsolicited messages, so they are left out of flow control.
+ */
+static bool zserv_backpressure_client(const struct zserv *client)
+{
+	return !client->synchronous && client->sock >= 0;
+}
+
+static void zserv_backpressure_timer(struct event *thread);
+
+static void zserv_backpressure_send_client(struct zserv *client, bool engaged,
+					   uint32_t window, uint32_t depth,
+					   time_t now)
+{
+	/* Nothing to tell a client that was never throttled */
+	if (!engaged && !client->bp_engaged)
+		return;
+
+	if (engaged && !client->bp_engaged) {
+		client->bp_engage_cnt++;
+		client->bp_engage_time = now;
+	} else if (!engaged) {
+		client->bp_throttled_time += now - client->bp_engage_time;
+	}
+
+	client->bp_engaged = engaged;
+	client->bp_window = window;
+	client->bp_update_cnt++;
+
+	zsend_backpressure(client, engaged, window, depth);
+}
+
+static void zserv_backpressure_send(bool engaged, uint32_t window,
+				    uint32_t depth)
+{
+	struct listnode *node;
+	struct zserv *client;
+	time_t now = monotime(NULL);
+
+	for (ALL_LIST_ELEMENTS_RO(zrouter.client_list, node, client)) {
+		if (!zserv_backpressure_client(client))
+			continue;
+
+		zserv_backpressure_send_client(client, engaged, window, depth,
+					       now);
+	}
+}
+
+/*
+ * Credit for the room left below the high watermark, split between the
+ * throttled clients so that together they can't push the queues past it.
+ */
+static uint32_t zserv_backpressure_window(uint32_t depth)
+{
+	struct listnode *node;
+	struct zserv *client;
+	uint32_t clients = 0;
+
+	if (depth >= zrouter.bp_high_watermark)
+		return 0;
+
+	for (ALL_LIST_ELEMENTS_RO(zrouter.client_list, node, client))
+		if (zserv_backpressure_client(client))
+			clients++;
+
+	if (!clients)
+		return 0;
+
+	return (zrouter.bp_high_watermark - depth) / clients;
+}
+
+void zserv_backpressure_check(void)
+{
+	uint32_t depth;
+
+	if (!zrouter.bp_engaged) {
+		if (!zrouter.bp_high_watermark)
+			return;
+
+		depth = zserv_backpressure_depth();
+		if (depth < zrouter.bp_high_watermark)
+			return;
+
+		zrouter.bp_engaged = true;
+		zrouter.bp_engage_cnt++;
+
+		if (IS_ZEBRA_DEBUG_EVENT)
+			zlog_debug("ZAPI backpressure engaged, queue depth %u (high watermark %u)",
+				   depth, zrouter.bp_high_watermark);
+
+		zserv_backpressure_send(true, 0, depth);
+		event_add_timer_msec(zrouter.master, zserv_backpressure_timer,
+				     NULL, ZEBRA_BACKPRESSURE_INTERVAL_MSEC,
+				     &zrouter.t_backpressure);
+		return;
+	}
+
+	depth = zserv_backpressure_depth();
+
+	/* Also release immediately if backpressure was unconfigured */
+	if (!zrouter.bp_high_watermark || depth <= zrouter.bp_low_watermark) {
+		zrouter.bp_engaged = false;
+		EVENT_OFF(zrouter.t_backpressure);
+
+		if (IS_ZEBRA_DEBUG_EVENT)
+			zlog_debug("ZAPI backpressure released, queue depth %u",
+				   depth);
+
+		zserv_backpressure_send(false, 0, depth);
+	}
+
+	/* Still draining: window updates only go out from the timer */
+}
+
+void zserv_backpressure_hello(struct zserv *client)
+{
+	if (!zrouter.bp_engaged || !zserv_backpressure_client(client))
+		return;
+
+	/* Credit follows with the next window update */
+	zserv_backpressure_send_client(client, true, 0,
+				       zserv_backpressure_depth(),
+				       monotime(NULL));
+}
+
+/*
+ * While throttled, hand out credit for whatever room is left below the
+ * high watermark every interval, so clients trickle updates in rather than
+ * stalling completely until the low watermark is reached.
+ */
+static void zserv_backpressure_timer(struct event *thread)
+{
+	uint32_t depth;
+
+	zserv_backpressure_check();
+	if (!zrouter.bp_engaged)
+		return;
+
+	depth = zserv_backpressure_depth();
+	zserv_backpressure_send(true, zserv_backpressure_window(depth), depth);
+	event_add_timer_msec(zrouter.master, zserv_backpressure_timer, NULL,
+			     ZEBRA_BACKPRESSURE_INTERVAL_MSEC,
+			     &zrouter.t_backpressure);
+}
+
+
 /* General purpose ---------------------------------------------------------- */
 
 #define ZEBRA_TIME_BUF 32
@@ -1124,10 +1363,28 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client)
 		0, client->local_es_del_cnt);
 	vty_out(vty, "ES-EVI      %-12u%-12u%-12u\n",
 		client->local_es_evi_add_cnt, 0, client->local_es_evi_del_cnt);
+	if (client->redist_batch)
+		vty_out(vty, "Redist batches: %u\n",
+			client->redist_batch_sent_cnt);
 	vty_out(vty, "Errors: %u\n", client->error_cnt);
 	vty_out(vty, "Input Fifo: %zu:%zu Output Fifo: %zu:%zu\n",
 		client->ibuf_fifo->count, client->ibuf_fifo->max_count,
 		client->obuf_fifo->count, client->obuf_fifo->max_count);
+	if (zserv_backpressure_client(client)) {
+		time_t throttled = client->bp_throttled_time;
+
+		if (client->bp_engaged)
+			throttled += monotime(NULL) - client->bp_engage_time;
+
+		vty_out(vty, "Backpressure: %s",
+			client->bp_engaged ? "Engaged" : "Released");
+		if (client->bp_engaged)
+			vty_out(vty, " (window %u)", client->bp_window);
+		vty_out(vty,
+			", Engaged %u times, Updates %u, Throttled %lld secs\n",
+			client->bp_engage_cnt, client->bp_update_cnt,
+			(long long)throttled);
+	}
 
 	vty_out(vty, "\n");
 }
@@ -1290,6 +1547,13 @@ DEFUN (show_zebra_client,
 	struct listnode *node;
 	struct zserv *client;
 
+	if (zrouter.bp_high_watermark)
+		vty_out(vty,
+			"ZAPI backpressure: %s, queue depth %u (high %u low %u), engaged %u times\n\n",
+			zrouter.bp_engaged ? "Engaged" : "Released",
+			zserv_backpressure_depth(), zrouter.bp_high_watermark,
+			zrouter.bp_low_watermark, zrouter.bp_engage_cnt);
+
 	for (ALL_LIST_ELEMENTS_RO(zrouter.client_list, node, client)) {
 		zebra_show_client_detail(vty, client);
 		/* Show GR info if present */
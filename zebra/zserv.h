@@ -40,9 +40,6 @@ struct zebra_vrf;
 /* Stale route marker timer */
 #define ZEBRA_DEFAULT_STALE_UPDATE_DELAY 1
 
-/* Count of stale routes processed in timer context */
-#define ZEBRA_MAX_STALE_ROUTE_COUNT 50000
-
 /* Graceful Restart information */
 struct client_gr_info {
 	/* VRF for which GR enabled */
@@ -107,6 +104,9 @@ struct zserv {
 	/* Event for the main pthread */
 	struct event *t_cleanup;
 
+	/* Flush of pending batched redistribution, main pthread only */
+	struct event *t_redist_batch;
+
 	/* This client's redistribute flag. */
 	struct redist_proto mi_redist[AFI_MAX][ZEBRA_ROUTE_MAX];
 	vrf_bitmap_t redist[AFI_MAX][ZEBRA_ROUTE_MAX];
@@ -125,6 +125,14 @@ struct zserv {
 	/* Indicates if client is synchronous. */
 	bool synchronous;
 
+	/*
+	 * Client accepts ZEBRA_REDISTRIBUTE_ROUTE_BATCH; redist_batch_s is
+	 * the batch being built, redist_batch_cnt its message count.
+	 */
+	bool redist_batch;
+	struct stream *redist_batch_s;
+	uint16_t redist_batch_cnt;
+
 	/* client's protocol and session info */
 	uint8_t proto;
 	uint16_t instance;
@@ -142,6 +150,7 @@ struct zserv {
 	uint32_t redist_v4_del_cnt;
 	uint32_t redist_v6_add_cnt;
 	uint32_t redist_v6_del_cnt;
+	uint32_t redist_batch_sent_cnt;
 	uint32_t v4_route_add_cnt;
 	uint32_t v4_route_upd8_cnt;
 	uint32_t v4_route_del_cnt;
@@ -186,6 +195,14 @@ struct zserv {
 	uint32_t nhg_upd8_cnt;
 	uint32_t nhg_del_cnt;
 
+	/* ZAPI backpressure state and statistics, main pthread only */
+	bool bp_engaged;
+	uint32_t bp_window;
+	uint32_t bp_engage_cnt;
+	uint32_t bp_update_cnt;
+	time_t bp_engage_time;
+	time_t bp_throttled_time;
+
 	time_t nh_reg_time;
 	time_t nh_dereg_time;
 	time_t nh_last_upd_time;
@@ -286,6 +303,27 @@ extern int zserv_send_message(struct zserv *client, struct stream *msg);
  */
 extern int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo);
 
+/*
+ * Queue a redistribution message for a client that accepts batches.
+ *
+ * The message is copied into the client's pending
+ * ZEBRA_REDISTRIBUTE_ROUTE_BATCH, which is sent once full, before any
+ * other message to the client, or when the current main pthread task is
+ * done.  The caller keeps ownership of msg.  Main pthread only.
+ *
+ * client
+ *    the client to send to
+ *
+ * msg
+ *    the complete message, header included
+ */
+extern int zserv_redist_batch_add(struct zserv *client, struct stream *msg);
+
+/*
+ * Send the pending redistribution batch of a client, if any.
+ */
+extern void zserv_redist_batch_flush(struct zserv *client);
+
 /*
  * Retrieve a client by its protocol and instance number.
  *
@@ -350,6 +388,18 @@ extern void zserv_release_client(struct zserv *client);
  */
 extern void zserv_close_client(struct zserv *client);
 
+/*
+ * Re-evaluate ZAPI backpressure against the current meta-queue and
+ * dataplane depth, engaging or releasing the throttle on route producing
+ * clients as needed.  Must be called from the zebra main pthread.
+ */
+extern void zserv_backpressure_check(void);
+
+/*
+ * Throttle a client that said hello while backpressure is engaged.
+ */
+extern void zserv_backpressure_hello(struct zserv *client);
+
 /*
  * Free memory for a zserv client object - note that this does not
  * clean up the internal allocations associated with the zserv client,